@@ -14,9 +14,15 @@ LOCAL_SRC_FILES := $(SDL_GPU_DIR)/src/SDL_gpu.c \
 				   $(SDL_GPU_DIR)/src/SDL_gpu_matrix.c \
 				   $(SDL_GPU_DIR)/src/SDL_gpu_renderer.c \
 				   $(SDL_GPU_DIR)/src/SDL_gpu_shapes.c \
+				   $(SDL_GPU_DIR)/src/SDL_gpu_simd.c \
+				   $(SDL_GPU_DIR)/src/SDL_gpu_recorder.c \
+				   $(SDL_GPU_DIR)/src/SDL_gpu_tilemap.c \
+				   $(SDL_GPU_DIR)/src/SDL_gpu_loader.c \
 				   $(SDL_GPU_DIR)/src/renderer_GLES_1.c \
 				   $(SDL_GPU_DIR)/src/renderer_GLES_2.c \
 				   $(SDL_GPU_DIR)/src/renderer_GLES_3.c \
+				   $(SDL_GPU_DIR)/src/renderer_Null.c \
+				   $(SDL_GPU_DIR)/src/renderer_Software.c \
 				   $(STB_IMAGE_DIR)/stb_image.c \
 				   $(STB_IMAGE_WRITE_DIR)/stb_image_write.c
 
@@ -155,6 +155,8 @@ static const GPU_RendererEnum GPU_RENDERER_GLES_3 = 13;
 static const GPU_RendererEnum GPU_RENDERER_D3D9 = 21;
 static const GPU_RendererEnum GPU_RENDERER_D3D10 = 22;
 static const GPU_RendererEnum GPU_RENDERER_D3D11 = 23;
+static const GPU_RendererEnum GPU_RENDERER_NULL = 31;  // No GPU: tracks state and counts work for benchmarking.  Never chosen by default.
+static const GPU_RendererEnum GPU_RENDERER_SOFTWARE = 32;  // No GPU: rasterizes into SDL_Surfaces on the CPU.  Never chosen by default.
 #define GPU_RENDERER_CUSTOM_0 1000
 
 /*! \ingroup Initialization
@@ -384,7 +386,8 @@ typedef struct GPU_Camera
 	float z_near, z_far;  // z clipping planes
 	GPU_bool use_centered_origin;  // move rotation/scaling origin to the center of the camera's view
 	
-	GPU_PAD_7_TO_64
+	GPU_PAD_3_TO_32
+	Uint32 generation;  // Renewed by GPU_SetCamera() when the camera changes.  Assign cameras with GPU_SetCamera() instead of writing to GPU_Target::camera directly.
 } GPU_Camera;
 
 
@@ -403,6 +406,10 @@ typedef struct GPU_ShaderBlock
     int modelViewProjection_loc;
 } GPU_ShaderBlock;
 
+/*! Number of texture units that the default textured shader can sample from in one draw call.
+ * The shaders pick the sampler with constant indices, since GLSL before 4.0 can't index samplers dynamically. */
+#define GPU_MAX_TEXTURE_SLOTS 8
+
 
 
 
@@ -418,9 +425,94 @@ typedef struct GPU_MatrixStack
     unsigned int storage_size;
     unsigned int size;
     float** matrix;
+    Uint32 generation;  // Renewed whenever the top matrix may have changed, so renderers can skip rebuilding and re-uploading unchanged transforms
+    
+    GPU_PAD_4_TO_64
 } GPU_MatrixStack;
 
 
+/*! \ingroup ContextControls
+ * Reasons for the blit buffer to be flushed, which splits the pending blits and shapes into another draw call.
+ * \see GPU_FrameStats
+ * \see GPU_GetFrameStats()
+ */
+typedef enum {
+    GPU_FLUSH_EXPLICIT = 0,  // GPU_FlushBlitBuffer(), GPU_Flip(), GPU_Clear(), sorted batches, and anything else that always flushes
+    GPU_FLUSH_TEXTURE_CHANGE = 1,  // A different image was bound, or an image in use was modified
+    GPU_FLUSH_BLEND_CHANGE = 2,
+    GPU_FLUSH_SHADER_CHANGE = 3,
+    GPU_FLUSH_UNIFORM_SET = 4,  // Uniforms, attributes, and shader images
+    GPU_FLUSH_TARGET_SWITCH = 5,  // A different render target or window
+    GPU_FLUSH_BUFFER_FULL = 6,
+    GPU_FLUSH_READBACK = 7,  // Reading pixels back from a target or image
+    GPU_FLUSH_MATRIX_CHANGE = 8,  // GPU_PopMatrix() and the other matrix and camera functions
+    GPU_FLUSH_CLIP_CHANGE = 9,
+    GPU_FLUSH_SHAPE_CHANGE = 10,  // Switching between blits, shapes, primitive types, or instanced sprites
+    GPU_FLUSH_STATE_CHANGE = 11,  // Other render state: depth, line thickness, resolution
+    GPU_FLUSH_NUM_CAUSES = 12
+} GPU_FlushCauseEnum;
+
+/*! \ingroup ContextControls
+ * Render counters for a context, collected after GPU_EnableFrameStats() until the next GPU_ResetFrameStats().
+ * \see GPU_GetFrameStats()
+ */
+typedef struct GPU_FrameStats
+{
+    Uint32 draw_calls;
+    Uint32 vertices;  // Vertices sent with those draw calls
+    Uint64 bytes_uploaded;  // Vertex, index, and attribute data uploaded to buffer objects
+    Uint32 texture_binds;
+    Uint32 program_switches;
+    Uint32 target_switches;  // Framebuffer and window changes
+    Uint32 flushes[GPU_FLUSH_NUM_CAUSES];  // Blit buffer flushes that had something to draw, indexed by GPU_FlushCauseEnum
+} GPU_FrameStats;
+
+/*! \ingroup Rendering
+ * Draws recorded by GPU_BeginCommandList() and GPU_EndCommandList(), for replaying with GPU_ExecuteCommandList().
+ * \see GPU_FreeCommandList()
+ */
+typedef struct GPU_CommandList
+{
+    GPU_Renderer* renderer;
+    void* data;  // Renderer-specific
+} GPU_CommandList;
+
+/*! \ingroup Rendering
+ * Vertices of blits and shapes recorded on any thread.  \see GPU_CreateRecorder()
+ */
+typedef struct GPU_Recorder GPU_Recorder;
+
+/*! \ingroup Rendering
+ * A grid of tiles from one tileset image, drawn a chunk at a time.  \see GPU_CreateTilemap()
+ */
+typedef struct GPU_Tilemap GPU_Tilemap;
+
+/*! \ingroup ImageControls
+ * An image file being loaded in the background.  \see GPU_LoadImageAsync()
+ */
+typedef struct GPU_PendingImage GPU_PendingImage;
+
+/*! \ingroup Conversions
+ * Pixels being read back from a target without waiting for the GPU.  The pixels are 8-bit RGBA.
+ * \see GPU_ReadPixelsAsync()
+ */
+typedef struct GPU_Readback
+{
+    GPU_Renderer* renderer;
+    int w, h;  // Size of the region that was read
+    void* data;  // Renderer-specific
+} GPU_Readback;
+
+/*! \ingroup ImageControls
+ * Progress of a GPU_PendingImage
+ * \see GPU_GetPendingImageStatus()
+ */
+typedef enum {
+    GPU_PENDING_LOADING = 0,
+    GPU_PENDING_DONE = 1,
+    GPU_PENDING_FAILED = 2
+} GPU_PendingStatusEnum;
+
 /*! \ingroup ContextControls
  * Rendering context data.  Only GPU_Targets which represent windows will store this. */
 typedef struct GPU_Context
@@ -466,6 +558,16 @@ typedef struct GPU_Context
 	
 	GPU_BlendMode shapes_blend_mode;
 	float line_thickness;
+	
+	/*! Blits and shapes submitted since GPU_ResetCullingStats(), and how many of those were culled */
+	Uint32 num_submitted_primitives;
+	Uint32 num_culled_primitives;
+	
+	/*! Counters since GPU_ResetFrameStats(), only updated while use_frame_stats is set */
+	GPU_FrameStats frame_stats;
+	GPU_bool use_frame_stats;
+	/*! Why the next blit buffer flush happens.  Set internally. */
+	GPU_FlushCauseEnum flush_cause;
     
 	int refcount;
 	
@@ -525,8 +627,7 @@ struct GPU_Target
 	GPU_bool use_depth_test;
 	GPU_bool use_depth_write;
 	GPU_bool is_alias;
-	
-	GPU_PAD_1_TO_64
+	GPU_bool use_culling;
 };
 
 /*! \ingroup Initialization
@@ -549,6 +650,7 @@ static const GPU_FeatureEnum GPU_FEATURE_PIXEL_SHADER = 0x200;
 static const GPU_FeatureEnum GPU_FEATURE_GEOMETRY_SHADER = 0x400;
 static const GPU_FeatureEnum GPU_FEATURE_WRAP_REPEAT_MIRRORED = 0x800;
 static const GPU_FeatureEnum GPU_FEATURE_CORE_FRAMEBUFFER_OBJECTS = 0x1000;
+static const GPU_FeatureEnum GPU_FEATURE_TIMER_QUERIES = 0x2000;
 
 /*! Combined feature flags */
 #define GPU_FEATURE_ALL_BASE GPU_FEATURE_RENDER_TARGETS
@@ -574,10 +676,26 @@ static const GPU_InitFlagEnum GPU_INIT_DISABLE_AUTO_VIRTUAL_RESOLUTION = 0x8;
 static const GPU_InitFlagEnum GPU_INIT_REQUEST_COMPATIBILITY_PROFILE = 0x10;
 static const GPU_InitFlagEnum GPU_INIT_USE_ROW_BY_ROW_TEXTURE_UPLOAD_FALLBACK = 0x20;
 static const GPU_InitFlagEnum GPU_INIT_USE_COPY_TEXTURE_UPLOAD_FALLBACK = 0x40;
+static const GPU_InitFlagEnum GPU_INIT_USE_INSTANCED_SPRITES = 0x80;  // Draw GPU_Blit*() sprites with one instance record each (OpenGL 3.3+, OpenGL 4, GLES 3)
+static const GPU_InitFlagEnum GPU_INIT_CALIBRATE_BUFFER_UPLOAD = 0x100;  // Time each vertex buffer upload method when a context is created and keep the fastest (see GPU_CalibrateBufferUpload())
 
 #define GPU_DEFAULT_INIT_FLAGS 0
 
 
+/*! \ingroup Rendering
+ * Ways of uploading buffered vertices to the GPU.  GPU_BUFFER_UPLOAD_NONE is reported by renderers that don't use vertex buffer objects.
+ * \see GPU_SetBufferUploadMethod()
+ * \see GPU_GetBufferUploadMethod()
+ * \see GPU_CalibrateBufferUpload()
+ */
+typedef Uint32 GPU_BufferUploadEnum;
+static const GPU_BufferUploadEnum GPU_BUFFER_UPLOAD_NONE = 0x0;
+static const GPU_BufferUploadEnum GPU_BUFFER_UPLOAD_RESET = 0x1;  // Reallocate (orphan) the buffer with glBufferData()
+static const GPU_BufferUploadEnum GPU_BUFFER_UPLOAD_UPDATE = 0x2;  // Overwrite the buffer with glBufferSubData()
+static const GPU_BufferUploadEnum GPU_BUFFER_UPLOAD_MAPPING = 0x3;  // Copy into the mapped buffer (not GLES 2)
+static const GPU_BufferUploadEnum GPU_BUFFER_UPLOAD_PERSISTENT = 0x4;  // Write straight into a persistently mapped buffer ring (OpenGL 4.4 or ARB_buffer_storage)
+
+
 static const Uint32 GPU_NONE = 0x0;
 
 /*! \ingroup Rendering
@@ -625,6 +743,35 @@ static const GPU_BatchFlagEnum GPU_BATCH_RGBA8 = 0x40;
 #define GPU_BATCH_XY_ST_RGBA8 (GPU_BATCH_XY | GPU_BATCH_ST | GPU_BATCH_RGBA8)
 #define GPU_BATCH_XYZ_ST_RGBA8 (GPU_BATCH_XYZ | GPU_BATCH_ST | GPU_BATCH_RGBA8)
 
+/*! \ingroup Rendering
+ * Geometry that stays on the GPU between frames.  \see GPU_CreateVertexBuffer()
+ */
+typedef struct GPU_VertexBuffer
+{
+    GPU_Renderer* renderer;
+    GPU_BatchFlagEnum flags;
+    unsigned int num_vertices;
+    unsigned int num_indices;  // 0 if the vertices are drawn in order
+    void* data;  // Renderer-specific
+} GPU_VertexBuffer;
+
+
+/*! Bit flags for sprite batching.
+ * The PASSTHROUGH flags mean that the data is given per vertex (4 per sprite) and is used as-is: 8 floats of x, y; 8 floats of normalized s, t; or 16 floats of normalized r, g, b, a.
+ * The USE_DEFAULT flags ignore that part of the data: positions default to (0, 0), source rects to the whole image, and colors to the image/target color.
+ * \see GPU_BlitBatch()
+ * \see GPU_BlitBatchSeparate()
+ */
+typedef Uint32 GPU_BlitFlagEnum;
+static const GPU_BlitFlagEnum GPU_PASSTHROUGH_VERTICES = 0x1;
+static const GPU_BlitFlagEnum GPU_PASSTHROUGH_TEXCOORDS = 0x2;
+static const GPU_BlitFlagEnum GPU_PASSTHROUGH_COLORS = 0x4;
+static const GPU_BlitFlagEnum GPU_USE_DEFAULT_POSITIONS = 0x8;
+static const GPU_BlitFlagEnum GPU_USE_DEFAULT_SRC_RECTS = 0x10;
+static const GPU_BlitFlagEnum GPU_USE_DEFAULT_COLORS = 0x20;
+
+#define GPU_PASSTHROUGH_ALL (GPU_PASSTHROUGH_VERTICES | GPU_PASSTHROUGH_TEXCOORDS | GPU_PASSTHROUGH_COLORS)
+
 
 /*! Bit flags for blitting into a rectangular region.
  * \see GPU_BlitRect
@@ -1180,9 +1327,69 @@ DECLSPEC void SDLCALL GPU_SetDepthWrite(GPU_Target* target, GPU_bool enable);
 /*! Sets the operation to perform when depth testing. */
 DECLSPEC void SDLCALL GPU_SetDepthFunction(GPU_Target* target, GPU_ComparisonEnum compare_operation);
 
+/*! Enables or disables CPU culling of blits and shapes drawn to the given target.  Disabled by default.
+ *  When enabled, anything whose bounding box lands entirely outside of the target's viewport and clip rect (after the model, view/camera, and projection transforms) is dropped before any vertices are generated.
+ *  The test is conservative, so nothing visible is ever culled.  Custom shaders that move vertices around should leave this disabled.
+ *  \see GPU_GetCullingStats()
+ */
+DECLSPEC void SDLCALL GPU_SetCulling(GPU_Target* target, GPU_bool enable);
+
+/*! Returns GPU_TRUE if CPU culling is enabled for the given target. */
+DECLSPEC GPU_bool SDLCALL GPU_IsCullingEnabled(GPU_Target* target);
+
+/*! Gets the number of blits and shapes submitted to the current context since the last GPU_ResetCullingStats() and how many of those were culled.  Either pointer may be NULL. */
+DECLSPEC void SDLCALL GPU_GetCullingStats(Uint32* num_submitted, Uint32* num_culled);
+
+/*! Resets the current context's culling counters to zero. */
+DECLSPEC void SDLCALL GPU_ResetCullingStats(void);
+
+/*! Enables or disables collection of render statistics for the current context.  Disabled by default, which leaves only a flag test where the counters would be updated.
+ *  Defining SDL_GPU_DISABLE_FRAME_STATS when building SDL_gpu compiles the counters out entirely.
+ *  \see GPU_GetFrameStats()
+ */
+DECLSPEC void SDLCALL GPU_EnableFrameStats(GPU_bool enable);
+
+/*! Copies the current context's render statistics into 'stats'.  These count everything since the last GPU_ResetFrameStats(), so call both once per frame (e.g. right after GPU_Flip()) to see per-frame numbers.
+ *  The flush counts show why batches were broken up. */
+DECLSPEC void SDLCALL GPU_GetFrameStats(GPU_FrameStats* stats);
+
+/*! Resets the current context's render statistics to zero. */
+DECLSPEC void SDLCALL GPU_ResetFrameStats(void);
+
+/*! Enables or disables GPU timing for the current context.  Requires GPU_FEATURE_TIMER_QUERIES.
+ *  While enabled, timestamp queries measure how long the GPU spends on each frame (ending at GPU_Flip()), on each render target, and on each GPU_BeginGPUScope() range.
+ *  Results are read a few frames later, once the GPU has finished, so measuring never stalls the pipeline.
+ *  \return GPU_TRUE if timing is now enabled.
+ *  \see GPU_GetGPUFrameTime()
+ */
+DECLSPEC GPU_bool SDLCALL GPU_EnableGPUTiming(GPU_bool enable);
+
+/*! Starts a named GPU timing scope in the current frame.  Scopes can nest and should be ended with GPU_EndGPUScope() before GPU_Flip(), which ends any that are left open.
+ *  Scopes flush the blit buffer so that their draws are timed separately.  Nothing happens unless GPU timing is enabled.
+ *  \param name The scope name, e.g. "shadows".  Scopes with the same name are added together. */
+DECLSPEC void SDLCALL GPU_BeginGPUScope(const char* name);
+
+/*! Ends the innermost scope started by GPU_BeginGPUScope(). */
+DECLSPEC void SDLCALL GPU_EndGPUScope(void);
+
+/*! \return The GPU time in milliseconds of the most recent frame with finished timing results, or a negative value if there are none yet. */
+DECLSPEC float SDLCALL GPU_GetGPUFrameTime(void);
+
+/*! \return The GPU time in milliseconds spent in scopes named 'name' during the most recently timed frame, or a negative value if there were none. */
+DECLSPEC float SDLCALL GPU_GetGPUScopeTime(const char* name);
+
+/*! \return The GPU time in milliseconds spent rendering to 'target' during the most recently timed frame, or a negative value if it wasn't used. */
+DECLSPEC float SDLCALL GPU_GetGPUTargetTime(GPU_Target* target);
+
 /*! \return The RGBA color of a pixel. */
 DECLSPEC SDL_Color SDLCALL GPU_GetPixel(GPU_Target* target, Sint16 x, Sint16 y);
 
+/*! Gets the RGBA colors of many pixels at once.  The target is read only once, so this is much faster than calling GPU_GetPixel() for each one.
+ * \param num_points Number of points (and colors)
+ * \param points Pixel coordinates in the same space as GPU_GetPixel(), e.g. [x0, y0, x1, y1, ...]
+ * \param colors Filled with the color of each point.  Points outside of the target get {0, 0, 0, 0}. */
+DECLSPEC void SDLCALL GPU_GetPixels(GPU_Target* target, unsigned int num_points, const Sint16* points, SDL_Color* colors);
+
 /*! Sets the clipping rect for the given render target. */
 DECLSPEC GPU_Rect SDLCALL GPU_SetClipRect(GPU_Target* target, GPU_Rect rect);
 
@@ -1275,6 +1482,31 @@ DECLSPEC GPU_Image* SDLCALL GPU_LoadImage(const char* filename);
 /*! Load image from an image file in memory.  Don't forget to GPU_FreeImage() it. */
 DECLSPEC GPU_Image* SDLCALL GPU_LoadImage_RW(SDL_RWops* rwops, GPU_bool free_rwops);
 
+/*! Starts loading an image file in the background.  The file is read and decoded by a pool of worker threads, then GPU_ProcessPendingUploads() creates the image.
+ * \return A handle to poll with GPU_GetPendingImageStatus(), or NULL on failure.  Free it with GPU_FreePendingImage().
+ * \see GPU_LoadImage */
+DECLSPEC GPU_PendingImage* SDLCALL GPU_LoadImageAsync(const char* filename);
+
+/*! Sets the number of threads that decode files for GPU_LoadImageAsync().  The default (-1) is one per CPU core after the first.
+ * With 0, or without SDL 2, files are decoded by GPU_ProcessPendingUploads() instead.  Running threads finish their current file and are replaced with the next load. */
+DECLSPEC void SDLCALL GPU_SetImageLoaderThreads(int num_threads);
+
+/*! Creates and uploads the images that the loader threads have decoded, oldest first.  Call it on the rendering thread, e.g. once per frame.
+ * Large images are uploaded a band of rows at a time, so they can take several calls.  At least one band is uploaded per call.
+ * \param max_bytes Pixel bytes to upload before returning, or 0 for no limit
+ * \param max_ms Milliseconds to spend before returning, or 0 for no limit
+ * \return The number of images that finished loading. */
+DECLSPEC int SDLCALL GPU_ProcessPendingUploads(Uint32 max_bytes, Uint32 max_ms);
+
+/*! \return GPU_PENDING_DONE once the image is ready, or GPU_PENDING_FAILED if the file couldn't be loaded (an error is pushed when that is found). */
+DECLSPEC GPU_PendingStatusEnum SDLCALL GPU_GetPendingImageStatus(GPU_PendingImage* pending);
+
+/*! \return The loaded image, or NULL until its status is GPU_PENDING_DONE.  The image belongs to the caller: GPU_FreePendingImage() does not free it. */
+DECLSPEC GPU_Image* SDLCALL GPU_GetPendingImage(GPU_PendingImage* pending);
+
+/*! Frees the handle.  A load that hasn't finished is cancelled. */
+DECLSPEC void SDLCALL GPU_FreePendingImage(GPU_PendingImage* pending);
+
 /*! Creates an image that aliases the given image.  Aliases can be used to store image settings (e.g. modulation color) for easy switching.
  * GPU_FreeImage() frees the alias's memory, but does not affect the original. */
 DECLSPEC GPU_Image* SDLCALL GPU_CreateAliasImage(GPU_Image* image);
@@ -1297,6 +1529,12 @@ DECLSPEC void SDLCALL GPU_UpdateImage(GPU_Image* image, const GPU_Rect* image_re
 /*! Update an image from an array of pixel data.  Ignores virtual resolution on the image so the number of pixels needed from the surface is known. */
 DECLSPEC void SDLCALL GPU_UpdateImageBytes(GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row);
 
+/*! Update an image from an array of pixel data without waiting for the GPU to finish with the texture.
+ * The bytes are copied into a pixel unpack buffer and the GPU does the transfer later, so \p bytes can be reused as soon as this returns.
+ * Meant for data that is streamed every frame, like video frames.  Falls back to GPU_UpdateImageBytes() when the renderer has no pixel unpack buffers.
+ * \see GPU_UpdateImageBytes */
+DECLSPEC void SDLCALL GPU_UpdateImageBytesAsync(GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row);
+
 /*! Update an image from surface data, replacing its underlying texture to allow for size changes.  Ignores virtual resolution on the image so the number of pixels needed from the surface is known. */
 DECLSPEC GPU_bool SDLCALL GPU_ReplaceImage(GPU_Image* image, SDL_Surface* surface, const GPU_Rect* surface_rect);
 
@@ -1385,6 +1623,26 @@ DECLSPEC SDL_Surface* SDLCALL GPU_CopySurfaceFromTarget(GPU_Target* target);
 /*! Copy GPU_Image data into a new SDL_Surface.  Don't forget to SDL_FreeSurface() the surface and GPU_FreeImage() the image.*/
 DECLSPEC SDL_Surface* SDLCALL GPU_CopySurfaceFromImage(GPU_Image* image);
 
+/*! Starts reading a region of the target into GPU memory and returns without waiting for it.  Poll GPU_IsReadbackReady() on later frames, then get the pixels with GPU_MapReadback() or GPU_CopySurfaceFromReadback().
+ * Renderers without pixel pack buffers read the pixels right away, so their readbacks are always ready.
+ * \param rect The region to read, or NULL for the whole target.  It is clipped to the target.
+ * \return A readback to free with GPU_FreeReadback(), or NULL on failure. */
+DECLSPEC GPU_Readback* SDLCALL GPU_ReadPixelsAsync(GPU_Target* target, const GPU_Rect* rect);
+
+/*! \return GPU_TRUE if the GPU has finished the readback, so mapping it won't stall.  Without sync objects, this is always GPU_TRUE. */
+DECLSPEC GPU_bool SDLCALL GPU_IsReadbackReady(GPU_Readback* readback);
+
+/*! Gets the pixels of a readback, waiting for the GPU if it isn't ready.  The pixels stay valid until GPU_FreeReadback().
+ * \param bytes_per_row Set to the distance between rows.  This is negative when the rows are stored bottom-up, so row y is always at (returned pointer + y*bytes_per_row).
+ * \return The top row of pixels, or NULL on failure. */
+DECLSPEC const unsigned char* SDLCALL GPU_MapReadback(GPU_Readback* readback, int* bytes_per_row);
+
+/*! Copies the pixels of a readback into a new 32-bit RGBA SDL_Surface, waiting for the GPU if it isn't ready.  Don't forget to SDL_FreeSurface() the surface. */
+DECLSPEC SDL_Surface* SDLCALL GPU_CopySurfaceFromReadback(GPU_Readback* readback);
+
+/*! Frees a readback and its pixels. */
+DECLSPEC void SDLCALL GPU_FreeReadback(GPU_Readback* readback);
+
 // End of Conversions
 /*! @} */
 
@@ -1463,10 +1721,12 @@ DECLSPEC void SDLCALL GPU_MultiplyAndAssign(float* result, const float* B);
 /*! Returns an internal string that represents the contents of matrix A. */
 DECLSPEC const char* SDLCALL GPU_GetMatrixString(const float* A);
 
-/*! Returns the current matrix from the active target.  Returns NULL if stack is empty. */
+/*! Returns the current matrix from the active target.  Returns NULL if stack is empty.
+ * The matrix is treated as changed, so write to it before drawing again rather than keeping the pointer around. */
 DECLSPEC float* SDLCALL GPU_GetCurrentMatrix(void);
 
-/*! Returns the current matrix from the top of the matrix stack.  Returns NULL if stack is empty. */
+/*! Returns the current matrix from the top of the matrix stack.  Returns NULL if stack is empty.
+ * The matrix is treated as changed, so write to it before drawing again rather than keeping the pointer around. */
 DECLSPEC float* SDLCALL GPU_GetTopMatrix(GPU_MatrixStack* stack);
 
 /*! Returns the current model matrix from the active target.  Returns NULL if stack is empty. */
@@ -1639,6 +1899,36 @@ DECLSPEC void SDLCALL GPU_BlitRect(GPU_Image* image, GPU_Rect* src_rect, GPU_Tar
     */
 DECLSPEC void SDLCALL GPU_BlitRectX(GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, GPU_Rect* dest_rect, float degrees, float pivot_x, float pivot_y, GPU_FlipEnum flip_direction);
 
+/*! Draws many sprites of the given image at once.  This is much cheaper than calling GPU_Blit() for each one, since the render state is only set up once.
+ * Each sprite is placed like GPU_Blit() does, using the image's anchor and snap mode.
+ * \param num_sprites Number of sprites to draw.
+ * \param values Interleaved sprite data.  By default each sprite has a position (x, y), a source rect in pixels (x, y, w, h), and a color (r, g, b, a in 0 - 255), for 10 floats per sprite.  See GPU_BlitFlagEnum for the other layouts.  Pass NULL to use defaults for everything.
+ * \param flags Bit flags (GPU_BlitFlagEnum) that control the interpretation of 'values'.
+ */
+DECLSPEC void SDLCALL GPU_BlitBatch(GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* values, GPU_BlitFlagEnum flags);
+
+/*! Draws many sprites of the given image at once, with the sprite data in separate arrays.  See GPU_BlitBatch().
+ * \param positions Sprite positions (x, y), or NULL for (0, 0).
+ * \param src_rects Source rects in pixels (x, y, w, h), or NULL for the whole image.
+ * \param colors Sprite colors (r, g, b, a in 0 - 255), or NULL for the image/target color.
+ * \param flags Bit flags (GPU_BlitFlagEnum).  Only the GPU_PASSTHROUGH_* flags apply here.
+ */
+DECLSPEC void SDLCALL GPU_BlitBatchSeparate(GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* positions, float* src_rects, float* colors, GPU_BlitFlagEnum flags);
+
+/*! Draws many rotated and scaled sprites of the given image at once, with the sprite data in separate arrays (one entry per sprite).  Each sprite is transformed about the image's anchor like GPU_BlitTransform() does.
+ * The quad corners are computed several sprites at a time with SSE2, AVX2, or NEON when the CPU supports it.
+ * \param x Sprite x positions.
+ * \param y Sprite y positions.
+ * \param degrees Rotation angles in degrees, or NULL for no rotation.
+ * \param scale_x Horizontal scales, or NULL for 1.
+ * \param scale_y Vertical scales, or NULL for 1.
+ * \param num_src_rects Number of rects in 'src_rects'.
+ * \param src_rects A table of source rects in pixels (e.g. the frames of a texture atlas), or NULL for the whole image.
+ * \param src_rect_indices Index into 'src_rects' for each sprite, or NULL to use the first rect for every sprite.  Sprites with out-of-range indices are skipped.
+ * \param colors Sprite colors, or NULL for the image/target color.
+ */
+DECLSPEC void SDLCALL GPU_BlitTransformBatch(GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* x, float* y, float* degrees, float* scale_x, float* scale_y, unsigned int num_src_rects, GPU_Rect* src_rects, Uint16* src_rect_indices, SDL_Color* colors);
+
 
 /*! Renders triangles from the given set of vertices.  This lets you render arbitrary geometry.  It is a direct path to the GPU, so the format is different than typical SDL_gpu calls.
  * \param values A tightly-packed array of vertex position (e.g. x,y), texture coordinates (e.g. s,t), and color (e.g. r,g,b,a) values.  Texture coordinates and color values are expected to be already normalized to 0.0 - 1.0.  Pass NULL to render with only custom shader attributes.
@@ -1670,9 +1960,154 @@ DECLSPEC void SDLCALL GPU_PrimitiveBatch(GPU_Image* image, GPU_Target* target, G
  */
 DECLSPEC void SDLCALL GPU_PrimitiveBatchV(GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned short num_vertices, void* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags);
 
+/*! Renders primitives from the given set of vertices, like GPU_PrimitiveBatchV(), but with 32-bit vertex counts and indices so that large meshes can go out in a single draw call.
+ * Renderers without GL_UNSIGNED_INT index support (GLES 1 and 2) narrow the indices to 16 bits and reject batches of more than 65536 vertices.
+ * \param primitive_type The kind of primitive to render.
+ * \param values A tightly-packed array of vertex position (e.g. x,y), texture coordinates (e.g. s,t), and color (e.g. r,g,b,a) values.  Texture coordinates and color values are expected to be already normalized to 0.0 - 1.0 (or 0 - 255 for 8-bit color components).  Pass NULL to render with only custom shader attributes.
+ * \param indices If not NULL, this is used to specify which vertices to use and in what order (i.e. it indexes the vertices in the 'values' array).
+ * \param flags Bit flags to control the interpretation of the 'values' array parameters.
+ */
+DECLSPEC void SDLCALL GPU_PrimitiveBatchV32(GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned int num_vertices, void* values, unsigned int num_indices, unsigned int* indices, GPU_BatchFlagEnum flags);
+
+/*! Creates a vertex buffer that keeps geometry on the GPU, so drawing it each frame doesn't upload it again.  It belongs to the current context.
+ * \param flags Bit flags for the layout of 'values', as for GPU_PrimitiveBatchV().
+ * \param num_vertices The number of vertices in 'values'.
+ * \param values The vertices, laid out as for GPU_PrimitiveBatchV().  May be NULL to allocate the storage without filling it.
+ * \param num_indices The number of indices in 'indices'.
+ * \param indices If not NULL, the vertices drawn and their order.  Renderers without GL_UNSIGNED_INT index support narrow them to 16 bits and reject buffers of more than 65536 vertices.
+ * \return The new buffer, or NULL on failure.  Free it with GPU_FreeVertexBuffer().
+ */
+DECLSPEC GPU_VertexBuffer* SDLCALL GPU_CreateVertexBuffer(GPU_BatchFlagEnum flags, unsigned int num_vertices, void* values, unsigned int num_indices, unsigned int* indices);
+
+/*! Replaces some of the vertices of a vertex buffer.
+ * \param first_vertex The first vertex to replace.
+ * \param num_vertices The number of vertices in 'values'.
+ * \param values The new vertices, in the layout the buffer was created with.
+ */
+DECLSPEC void SDLCALL GPU_UpdateVertexBuffer(GPU_VertexBuffer* buffer, unsigned int first_vertex, unsigned int num_vertices, void* values);
+
+/*! Draws a range of a vertex buffer in one draw call, the way GPU_PrimitiveBatchV() would draw the same vertices.
+ * \param primitive_type The kind of primitive to render.
+ * \param first The first index to draw, or the first vertex if the buffer has no indices.
+ * \param count The number of indices (or vertices) to draw.  0 draws to the end of the buffer.
+ */
+DECLSPEC void SDLCALL GPU_DrawVertexBuffer(GPU_Image* image, GPU_Target* target, GPU_VertexBuffer* buffer, GPU_PrimitiveEnum primitive_type, unsigned int first, unsigned int count);
+
+/*! Frees a vertex buffer. */
+DECLSPEC void SDLCALL GPU_FreeVertexBuffer(GPU_VertexBuffer* buffer);
+
+/*! Creates a tilemap, which draws a grid of tiles from a tileset image.  The grid is split into chunks of 32x32 tiles, each kept in a vertex buffer (see GPU_CreateVertexBuffer()) that is only rebuilt when its tiles change.  Drawing skips the chunks that can't be seen.
+ * All tiles start out empty.  The tileset must stay allocated for as long as the tilemap.
+ * \param tileset The image that holds the tiles, left to right and then top to bottom, with no spacing.
+ * \param tile_w The width of a tile, in pixels.
+ * \param tile_h The height of a tile, in pixels.
+ * \param columns The width of the grid, in tiles.
+ * \param rows The height of the grid, in tiles.
+ * \return The new tilemap, or NULL on failure.  Free it with GPU_FreeTilemap().
+ */
+DECLSPEC GPU_Tilemap* SDLCALL GPU_CreateTilemap(GPU_Image* tileset, int tile_w, int tile_h, int columns, int rows);
+
+/*! Frees a tilemap and its vertex buffers. */
+DECLSPEC void SDLCALL GPU_FreeTilemap(GPU_Tilemap* tilemap);
+
+/*! Sets one tile of a tilemap.
+ * \param tile The index of the tile in the tileset, or -1 for an empty cell.
+ */
+DECLSPEC void SDLCALL GPU_SetTile(GPU_Tilemap* tilemap, int column, int row, int tile);
+
+/*! \return The tileset index of a tile, or -1 if the cell is empty or out of range. */
+DECLSPEC int SDLCALL GPU_GetTile(GPU_Tilemap* tilemap, int column, int row);
+
+/*! Sets every tile of a tilemap from an array of tileset indices, row by row. */
+DECLSPEC void SDLCALL GPU_SetTiles(GPU_Tilemap* tilemap, const int* tiles);
+
+/*! Draws the chunks of a tilemap that intersect the target's view, with one draw per chunk.  The tileset's color, blending, and filter apply as for a blit.
+ * \param x The position of the top-left corner of the grid.
+ * \param y The position of the top-left corner of the grid.
+ */
+DECLSPEC void SDLCALL GPU_DrawTilemap(GPU_Tilemap* tilemap, GPU_Target* target, float x, float y);
+
 /*! Send all buffered blitting data to the current context target. */
 DECLSPEC void SDLCALL GPU_FlushBlitBuffer(void);
 
+/*! Starts recording the blits and shapes drawn to the given target instead of drawing them right away.  Each draw is queued with a sort key (layer, shader, texture, blend mode, depth state), and the queue is drawn in key order so that interleaved textures and blend modes need as few state changes as possible.
+ * Draws within a layer may be reordered, so use GPU_SetSortedBatchLayer() where overlap order matters.  Anything else that flushes the blit buffer (e.g. matrix, camera, clip, or uniform changes, batch/primitive calls, or drawing to another target) first draws the queue recorded so far.
+ * \param target The render target whose draws get sorted.
+ */
+DECLSPEC void SDLCALL GPU_BeginSortedBatch(GPU_Target* target);
+
+/*! Draws everything queued since GPU_BeginSortedBatch() in sorted order and goes back to drawing immediately. */
+DECLSPEC void SDLCALL GPU_EndSortedBatch(void);
+
+/*! Sets the layer for subsequent draws in the current sorted batch.  Lower layers are drawn first, and draws are never reordered across layers.  GPU_BeginSortedBatch() resets the layer to 0.
+ * \param layer A layer from -32768 to 32767.
+ */
+DECLSPEC void SDLCALL GPU_SetSortedBatchLayer(int layer);
+
+/*! Starts recording the blits, shapes, primitive batches, and uniform sets for the given target into a command list instead of drawing them.  Each draw is stored with its render state (image, shader, blend mode, depth state) and the vertices as they would be sent to the GPU, so GPU_ExecuteCommandList() can replay the list without redoing that work.
+ * The camera, viewport, and clip rect are not recorded, so a replay uses those of the target it draws to.  The model matrix of each draw is kept (see GPU_ExecuteCommandList()).  Images drawn by the list stay allocated until the list is freed.
+ * Command lists are not supported by every renderer, and can't be recorded during a sorted batch.
+ * \param target The render target whose draws get recorded.
+ */
+DECLSPEC void SDLCALL GPU_BeginCommandList(GPU_Target* target);
+
+/*! Stops recording and returns the recorded command list, or NULL if none was being recorded.  Free it with GPU_FreeCommandList(). */
+DECLSPEC GPU_CommandList* SDLCALL GPU_EndCommandList(void);
+
+/*! Draws a command list to the given target, which may differ from the one it was recorded for.  The render state is put back afterward.
+ * \param list The command list to draw.
+ * \param target The render target to draw to.
+ * \param transform A 4x4 matrix placed between the target's model matrix and the model matrix of each recorded draw, or NULL for the identity.
+ */
+DECLSPEC void SDLCALL GPU_ExecuteCommandList(GPU_CommandList* list, GPU_Target* target, const float* transform);
+
+/*! Frees a command list and releases the images it draws. */
+DECLSPEC void SDLCALL GPU_FreeCommandList(GPU_CommandList* list);
+
+/*! Creates a recorder, which builds the vertices of blits and filled shapes in CPU memory without touching the renderer.  Any thread can record into its own recorder while the rendering thread does something else.  Recorders are drawn by GPU_SubmitRecorders().
+ * A recorder may only be used by one thread at a time.  Its record functions don't push errors, since the error queue is not thread-safe.
+ * \return The new recorder, or NULL if it can't be allocated.  Free it with GPU_FreeRecorder().
+ */
+DECLSPEC GPU_Recorder* SDLCALL GPU_CreateRecorder(void);
+
+/*! Frees a recorder and its storage. */
+DECLSPEC void SDLCALL GPU_FreeRecorder(GPU_Recorder* recorder);
+
+/*! Forgets what a recorder holds, keeping its storage so the next frame doesn't allocate. */
+DECLSPEC void SDLCALL GPU_ResetRecorder(GPU_Recorder* recorder);
+
+/*! Records a blit like GPU_Blit().  The image's color is kept with the vertices, but the color of the target it is submitted to is not applied.  The image must not be freed before the recorder is submitted.
+ * \return GPU_FALSE if the recorder or image is NULL or the recorder can't grow.
+ */
+DECLSPEC GPU_bool SDLCALL GPU_RecordBlit(GPU_Recorder* recorder, GPU_Image* image, GPU_Rect* src_rect, float x, float y);
+
+/*! Records a blit like GPU_BlitTransformX().  \see GPU_RecordBlit() */
+DECLSPEC GPU_bool SDLCALL GPU_RecordBlitTransformX(GPU_Recorder* recorder, GPU_Image* image, GPU_Rect* src_rect, float x, float y, float pivot_x, float pivot_y, float degrees, float scaleX, float scaleY);
+
+/*! Records a filled triangle like GPU_TriFilled(). */
+DECLSPEC GPU_bool SDLCALL GPU_RecordTriangleFilled(GPU_Recorder* recorder, float x1, float y1, float x2, float y2, float x3, float y3, SDL_Color color);
+
+/*! Records a filled rectangle like GPU_RectangleFilled(). */
+DECLSPEC GPU_bool SDLCALL GPU_RecordRectangleFilled(GPU_Recorder* recorder, float x1, float y1, float x2, float y2, SDL_Color color);
+
+/*! Draws what the given recorders hold to the target, in array order and then in recording order, so the result doesn't depend on which thread finished first.  Consecutive draws with the same image go out as one primitive batch.  Must be called from the rendering thread, after the recording threads are done.
+ * The recorders are not reset.
+ */
+DECLSPEC void SDLCALL GPU_SubmitRecorders(GPU_Target* target, GPU_Recorder** recorders, int num_recorders);
+
+/*! Sets how the current context uploads buffered vertices.  Flushes the blit buffer first.
+ * \return GPU_TRUE on success, GPU_FALSE if the method is not supported by the current renderer.
+ */
+DECLSPEC GPU_bool SDLCALL GPU_SetBufferUploadMethod(GPU_BufferUploadEnum method);
+
+/*! \return The vertex buffer upload method of the current context. */
+DECLSPEC GPU_BufferUploadEnum SDLCALL GPU_GetBufferUploadMethod(void);
+
+/*! Times a run of full blit buffer flushes with each upload method supported by the current context and switches to the fastest one.  The flushes go to a scratch framebuffer, so nothing is drawn to your targets, but it does stall on the GPU, so call it at startup or during a loading screen.  Also done when a context is created with GPU_INIT_CALIBRATE_BUFFER_UPLOAD.  Needs SDL2's performance counter, so SDL 1.2 builds keep the current method.
+ * \return The method that was chosen.
+ */
+DECLSPEC GPU_BufferUploadEnum SDLCALL GPU_CalibrateBufferUpload(void);
+
 /*! Updates the given target's associated window.  For non-context targets (e.g. image targets), this will flush the blit buffer. */
 DECLSPEC void SDLCALL GPU_Flip(GPU_Target* target);
 
@@ -22,8 +22,7 @@
 	#define glVertexAttribI1ui glVertexAttrib1f
 	#define glVertexAttribI2ui glVertexAttrib2f
 	#define glVertexAttribI3ui glVertexAttrib3f
-    #define glMapBuffer glMapBufferOES
-    #define glUnmapBuffer glUnmapBufferOES
+    // GLES 3 has glMapBufferRange() and glUnmapBuffer() in core, so the OES_mapbuffer aliases aren't needed
     #define GL_WRITE_ONLY GL_WRITE_ONLY_OES
 #endif
 
@@ -94,6 +93,69 @@ void main(void)\n\
     fragColor = texture(tex, texCoord) * color;\n\
 }"
 
+#define GPU_DEFAULT_TEXTURED_SLOTS_VERTEX_SHADER_SOURCE \
+"#version 300 es\n\
+precision highp float;\n\
+precision mediump int;\n\
+\
+in vec2 gpu_Vertex;\n\
+in vec2 gpu_TexCoord;\n\
+in mediump vec4 gpu_Color;\n\
+in float gpu_TexSlot;\n\
+uniform mat4 gpu_ModelViewProjectionMatrix;\n\
+\
+out mediump vec4 color;\n\
+out vec2 texCoord;\n\
+out float texSlot;\n\
+\
+void main(void)\n\
+{\n\
+	color = gpu_Color;\n\
+	texCoord = vec2(gpu_TexCoord);\n\
+	texSlot = gpu_TexSlot;\n\
+	gl_Position = gpu_ModelViewProjectionMatrix * vec4(gpu_Vertex, 0.0, 1.0);\n\
+}"
+
+#define GPU_DEFAULT_TEXTURED_SLOTS_FRAGMENT_SHADER_SOURCE \
+"#version 300 es\n\
+#ifdef GL_FRAGMENT_PRECISION_HIGH\n\
+precision highp float;\n\
+#else\n\
+precision mediump float;\n\
+#endif\n\
+precision mediump int;\n\
+\
+in mediump vec4 color;\n\
+in vec2 texCoord;\n\
+in float texSlot;\n\
+\
+uniform sampler2D gpu_TexSlots[8];\n\
+\
+out vec4 fragColor;\n\
+\
+void main(void)\n\
+{\n\
+    vec4 texel = texture(gpu_TexSlots[0], texCoord);\n\
+    if(texSlot >= 0.5)\n\
+    {\n\
+        if(texSlot < 1.5)\n\
+            texel = texture(gpu_TexSlots[1], texCoord);\n\
+        else if(texSlot < 2.5)\n\
+            texel = texture(gpu_TexSlots[2], texCoord);\n\
+        else if(texSlot < 3.5)\n\
+            texel = texture(gpu_TexSlots[3], texCoord);\n\
+        else if(texSlot < 4.5)\n\
+            texel = texture(gpu_TexSlots[4], texCoord);\n\
+        else if(texSlot < 5.5)\n\
+            texel = texture(gpu_TexSlots[5], texCoord);\n\
+        else if(texSlot < 6.5)\n\
+            texel = texture(gpu_TexSlots[6], texCoord);\n\
+        else\n\
+            texel = texture(gpu_TexSlots[7], texCoord);\n\
+    }\n\
+    fragColor = texel * color;\n\
+}"
+
 #define GPU_DEFAULT_UNTEXTURED_FRAGMENT_SHADER_SOURCE \
 "#version 300 es\n\
 #ifdef GL_FRAGMENT_PRECISION_HIGH\n\
@@ -132,20 +194,58 @@ typedef struct ContextData_GLES_3
 	
 	GPU_Image* last_image;
 	float* blit_buffer;  // Holds sets of 4 vertices, each with interleaved position, tex coords, and colors (e.g. [x0, y0, z0, s0, t0, r0, g0, b0, a0, ...]).
-	unsigned short blit_buffer_num_vertices;
-	unsigned short blit_buffer_max_num_vertices;
-	unsigned short* index_buffer;  // Indexes into the blit buffer so we can use 4 vertices for every 2 triangles (1 quad)
+	unsigned int blit_buffer_num_vertices;
+	unsigned int blit_buffer_max_num_vertices;
+	unsigned int* index_buffer;  // Indexes into the blit buffer so we can use 4 vertices for every 2 triangles (1 quad)
 	unsigned int index_buffer_num_vertices;
 	unsigned int index_buffer_max_num_vertices;
+	struct SortedBatchData* sorted_batch;  // Draws recorded by GPU_BeginSortedBatch(), or NULL
+	struct GPUTimingData* gpu_timing;  // Timer queries while GPU_EnableGPUTiming() is on, or NULL
+	struct PixelUploadData* pixel_uploads;  // Unpack buffer ring for GPU_UpdateImageBytesAsync(), created on first use
     
     // Tier 3 rendering
     unsigned int blit_VAO;
+    unsigned int flush_VAO[16];  // Built once per attribute layout and buffer and reused by every flush with it (see bindFlushVAO())
+    int flush_VAO_key[16][6];  // Position, texcoord, color, and texture slot locations, then the VBO and IBO
+    int flush_VAO_next;  // Replaced next when all of the VAOs are taken
     unsigned int blit_VBO[2];  // For double-buffering
     unsigned int blit_IBO;
+    unsigned int blit_quad_IBO;  // Prebuilt 0-1-2, 0-2-3 pattern for every quad the blit buffer can hold
     GPU_bool blit_VBO_flop;
+    GPU_BufferUploadEnum buffer_upload_method;
+    
+    // Last MVP built for a flush and what it was built from (see getModelViewProjectionKey())
+    float mvp_cache[16];
+    Uint32 mvp_cache_key[5];
+    // Programs recently sent an MVP, with the key of the one they hold
+    Uint32 mvp_upload_program[8];
+    int mvp_upload_loc[8];
+    Uint32 mvp_upload_key[8][5];
+    int mvp_upload_next;
+    
+    // Texture units used by blits with the default textured shader
+    GPU_Image* slot_images[GPU_MAX_TEXTURE_SLOTS];
+    int num_texture_slots;  // 0 if the default textured shader doesn't have slots
+    int num_bound_slots;
+    int next_texture_slot;  // Replaced next when all of the units are taken
+    float current_texture_slot;  // Written into each textured vertex
+    int texture_slot_loc;  // gpu_TexSlot attribute
     
 	GPU_AttributeSource shader_attributes[16];
 	unsigned int attribute_VBO[16];
+	
+	// Instanced sprite rendering (GPU_INIT_USE_INSTANCED_SPRITES)
+	GPU_bool use_instanced_sprites;
+	float* instance_buffer;  // Holds one record per sprite (position, size, pivot, rotation, tex rect, RGBA8 color)
+	unsigned int instance_buffer_num_sprites;
+	unsigned int instance_buffer_max_num_sprites;
+	unsigned int instanced_VAO;
+	unsigned int instanced_quad_VBO;  // Static unit quad corners
+	unsigned int instanced_quad_IBO;  // Static 0-1-2 / 0-2-3 indices
+	unsigned int instance_VBO;
+	Uint32 instanced_vertex_shader_id;
+	Uint32 instanced_shader_program;
+	int instanced_modelViewProjection_loc;
 } ContextData_GLES_3;
 
 typedef struct ImageData_GLES_3
@@ -238,16 +238,29 @@ typedef struct ContextData_OpenGL_1
 	
 	GPU_Image* last_image;
 	float* blit_buffer;  // Holds sets of 4 vertices and 4 tex coords interleaved (e.g. [x0, y0, z0, s0, t0, ...]).
-	unsigned short blit_buffer_num_vertices;
-	unsigned short blit_buffer_max_num_vertices;
-	unsigned short* index_buffer;  // Indexes into the blit buffer so we can use 4 vertices for every 2 triangles (1 quad)
+	unsigned int blit_buffer_num_vertices;
+	unsigned int blit_buffer_max_num_vertices;
+	unsigned int* index_buffer;  // Indexes into the blit buffer so we can use 4 vertices for every 2 triangles (1 quad)
 	unsigned int index_buffer_num_vertices;
 	unsigned int index_buffer_max_num_vertices;
+	struct SortedBatchData* sorted_batch;  // Draws recorded by GPU_BeginSortedBatch(), or NULL
+	struct GPUTimingData* gpu_timing;  // Timer queries while GPU_EnableGPUTiming() is on, or NULL
 	
     
     unsigned int blit_VBO[2];  // For double-buffering
     unsigned int blit_IBO;
+    unsigned int blit_quad_IBO;  // Prebuilt 0-1-2, 0-2-3 pattern for every quad the blit buffer can hold
     GPU_bool blit_VBO_flop;
+    GPU_BufferUploadEnum buffer_upload_method;
+    
+    // Last MVP built for a flush and what it was built from (see getModelViewProjectionKey())
+    float mvp_cache[16];
+    Uint32 mvp_cache_key[5];
+    // Programs recently sent an MVP, with the key of the one they hold
+    Uint32 mvp_upload_program[8];
+    int mvp_upload_loc[8];
+    Uint32 mvp_upload_key[8][5];
+    int mvp_upload_next;
     
 	GPU_AttributeSource shader_attributes[16];
 	unsigned int attribute_VBO[16];
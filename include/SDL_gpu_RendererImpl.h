@@ -82,6 +82,9 @@ typedef struct GPU_RendererImpl
 	/*! \see GPU_UpdateImageBytes */
 	void (SDLCALL *UpdateImageBytes)(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row);
 	
+	/*! \see GPU_UpdateImageBytesAsync */
+	void (SDLCALL *UpdateImageBytesAsync)(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row);
+	
 	/*! \see GPU_ReplaceImage */
 	GPU_bool (SDLCALL *ReplaceImage)(GPU_Renderer* renderer, GPU_Image* image, SDL_Surface* surface, const GPU_Rect* surface_rect);
 	
@@ -97,6 +100,18 @@ typedef struct GPU_RendererImpl
 	/*! \see GPU_CopySurfaceFromImage() */
 	SDL_Surface* (SDLCALL *CopySurfaceFromImage)(GPU_Renderer* renderer, GPU_Image* image);
 	
+	/*! \see GPU_ReadPixelsAsync() */
+	GPU_Readback* (SDLCALL *ReadPixelsAsync)(GPU_Renderer* renderer, GPU_Target* target, const GPU_Rect* rect);
+	
+	/*! \see GPU_IsReadbackReady() */
+	GPU_bool (SDLCALL *IsReadbackReady)(GPU_Renderer* renderer, GPU_Readback* readback);
+	
+	/*! \see GPU_MapReadback() */
+	const unsigned char* (SDLCALL *MapReadback)(GPU_Renderer* renderer, GPU_Readback* readback, int* bytes_per_row);
+	
+	/*! \see GPU_FreeReadback() */
+	void (SDLCALL *FreeReadback)(GPU_Renderer* renderer, GPU_Readback* readback);
+	
 	/*! \see GPU_FreeImage() */
 	void (SDLCALL *FreeImage)(GPU_Renderer* renderer, GPU_Image* image);
 	
@@ -121,9 +136,33 @@ typedef struct GPU_RendererImpl
 	/*! \see GPU_BlitTransformX() */
 	void (SDLCALL *BlitTransformX)(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float pivot_x, float pivot_y, float degrees, float scaleX, float scaleY);
 	
+	/*! \see GPU_BlitBatch() */
+	void (SDLCALL *BlitBatch)(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* values, GPU_BlitFlagEnum flags);
+	
+	/*! \see GPU_BlitBatchSeparate() */
+	void (SDLCALL *BlitBatchSeparate)(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* positions, float* src_rects, float* colors, GPU_BlitFlagEnum flags);
+	
+	/*! \see GPU_BlitTransformBatch() */
+	void (SDLCALL *BlitTransformBatch)(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* x, float* y, float* degrees, float* scale_x, float* scale_y, unsigned int num_src_rects, GPU_Rect* src_rects, Uint16* src_rect_indices, SDL_Color* colors);
+	
 	/*! \see GPU_PrimitiveBatchV() */
 	void (SDLCALL *PrimitiveBatchV)(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned short num_vertices, void* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags);
 	
+	/*! \see GPU_PrimitiveBatchV32() */
+	void (SDLCALL *PrimitiveBatchV32)(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned int num_vertices, void* values, unsigned int num_indices, unsigned int* indices, GPU_BatchFlagEnum flags);
+	
+	/*! \see GPU_CreateVertexBuffer() */
+	GPU_VertexBuffer* (SDLCALL *CreateVertexBuffer)(GPU_Renderer* renderer, GPU_BatchFlagEnum flags, unsigned int num_vertices, void* values, unsigned int num_indices, unsigned int* indices);
+	
+	/*! \see GPU_UpdateVertexBuffer() */
+	void (SDLCALL *UpdateVertexBuffer)(GPU_Renderer* renderer, GPU_VertexBuffer* buffer, unsigned int first_vertex, unsigned int num_vertices, void* values);
+	
+	/*! \see GPU_DrawVertexBuffer() */
+	void (SDLCALL *DrawVertexBuffer)(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_VertexBuffer* buffer, GPU_PrimitiveEnum primitive_type, unsigned int first, unsigned int count);
+	
+	/*! \see GPU_FreeVertexBuffer() */
+	void (SDLCALL *FreeVertexBuffer)(GPU_Renderer* renderer, GPU_VertexBuffer* buffer);
+	
 	/*! \see GPU_GenerateMipmaps() */
 	void (SDLCALL *GenerateMipmaps)(GPU_Renderer* renderer, GPU_Image* image);
 
@@ -136,6 +175,9 @@ typedef struct GPU_RendererImpl
 	/*! \see GPU_GetPixel() */
 	SDL_Color (SDLCALL *GetPixel)(GPU_Renderer* renderer, GPU_Target* target, Sint16 x, Sint16 y);
 	
+	/*! \see GPU_GetPixels() */
+	void (SDLCALL *GetPixels)(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_points, const Sint16* points, SDL_Color* colors);
+	
 	/*! \see GPU_SetImageFilter() */
 	void (SDLCALL *SetImageFilter)(GPU_Renderer* renderer, GPU_Image* image, GPU_FilterEnum filter);
 	
@@ -149,8 +191,39 @@ typedef struct GPU_RendererImpl
 	void (SDLCALL *ClearRGBA)(GPU_Renderer* renderer, GPU_Target* target, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
 	/*! \see GPU_FlushBlitBuffer() */
 	void (SDLCALL *FlushBlitBuffer)(GPU_Renderer* renderer);
+	/*! \see GPU_BeginSortedBatch() */
+	void (SDLCALL *BeginSortedBatch)(GPU_Renderer* renderer, GPU_Target* target);
+	/*! \see GPU_EndSortedBatch() */
+	void (SDLCALL *EndSortedBatch)(GPU_Renderer* renderer);
+	/*! \see GPU_SetSortedBatchLayer() */
+	void (SDLCALL *SetSortedBatchLayer)(GPU_Renderer* renderer, int layer);
+	/*! \see GPU_BeginCommandList() */
+	void (SDLCALL *BeginCommandList)(GPU_Renderer* renderer, GPU_Target* target);
+	/*! \see GPU_EndCommandList() */
+	GPU_CommandList* (SDLCALL *EndCommandList)(GPU_Renderer* renderer);
+	/*! \see GPU_ExecuteCommandList() */
+	void (SDLCALL *ExecuteCommandList)(GPU_Renderer* renderer, GPU_CommandList* list, GPU_Target* target, const float* transform);
+	/*! \see GPU_FreeCommandList() */
+	void (SDLCALL *FreeCommandList)(GPU_Renderer* renderer, GPU_CommandList* list);
+	/*! \see GPU_SetBufferUploadMethod() */
+	GPU_bool (SDLCALL *SetBufferUploadMethod)(GPU_Renderer* renderer, GPU_BufferUploadEnum method);
+	/*! \see GPU_GetBufferUploadMethod() */
+	GPU_BufferUploadEnum (SDLCALL *GetBufferUploadMethod)(GPU_Renderer* renderer);
+	/*! \see GPU_CalibrateBufferUpload() */
+	GPU_BufferUploadEnum (SDLCALL *CalibrateBufferUpload)(GPU_Renderer* renderer);
 	/*! \see GPU_Flip() */
 	void (SDLCALL *Flip)(GPU_Renderer* renderer, GPU_Target* target);
+	/*! \see GPU_EnableGPUTiming() */
+	GPU_bool (SDLCALL *EnableGPUTiming)(GPU_Renderer* renderer, GPU_bool enable);
+	/*! \see GPU_BeginGPUScope() */
+	void (SDLCALL *BeginGPUScope)(GPU_Renderer* renderer, const char* name);
+	/*! \see GPU_EndGPUScope() */
+	void (SDLCALL *EndGPUScope)(GPU_Renderer* renderer);
+	/*! Returns the timed frame when both 'scope_name' and 'target' are NULL.
+	 * \see GPU_GetGPUFrameTime()
+	 * \see GPU_GetGPUScopeTime()
+	 * \see GPU_GetGPUTargetTime() */
+	float (SDLCALL *GetGPUTime)(GPU_Renderer* renderer, const char* scope_name, GPU_Target* target);
 	
 	
     /*! \see GPU_CreateShaderProgram() */
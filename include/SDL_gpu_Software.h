@@ -0,0 +1,70 @@
+#ifndef _SDL_GPU_SOFTWARE_H__
+#define _SDL_GPU_SOFTWARE_H__
+
+#include "SDL_gpu.h"
+
+
+#define GPU_CONTEXT_DATA ContextData_Software
+#define GPU_IMAGE_DATA ImageData_Software
+#define GPU_TARGET_DATA TargetData_Software
+
+// Attribute and uniform names that get a location, per context
+#define GPU_CPU_MAX_LOCATIONS 64
+#define GPU_CPU_LOCATION_NAME_LENGTH 32
+
+
+typedef struct ContextData_Software
+{
+	GPU_bool last_use_texturing;
+	unsigned int last_shape;
+	GPU_bool last_use_blending;
+	GPU_BlendMode last_blend_mode;
+	GPU_Rect last_viewport;
+	GPU_Camera last_camera;
+	float last_mvp[16];  // Built for the last flush, as a GL renderer would upload it
+
+	GPU_bool last_depth_test;
+	GPU_bool last_depth_write;
+	GPU_ComparisonEnum last_depth_function;
+
+	GPU_Image* last_image;
+	float* blit_buffer;  // Same interleaved layout as the GL renderers: [x0, y0, s0, t0, r0, g0, b0, a0, ...]
+	unsigned int blit_buffer_num_vertices;
+	unsigned int blit_buffer_max_num_vertices;
+	unsigned short* index_buffer;
+	unsigned int index_buffer_num_vertices;
+	unsigned int index_buffer_max_num_vertices;
+
+	// Texture, framebuffer, shader, and program names are handed out from here
+	Uint32 next_object_id;
+
+	GPU_Target* sorted_batch_target;
+	int sorted_batch_layer;
+
+	char location_names[GPU_CPU_MAX_LOCATIONS][GPU_CPU_LOCATION_NAME_LENGTH];
+	int num_location_names;
+
+	GPU_Attribute shader_attributes[16];
+	GPU_bool shader_attribute_enabled[16];
+
+	SDL_Surface* framebuffer;  // Stands in for the window's back buffer, in RGBA byte order
+	struct GPU_Rasterizer* rasterizer;  // Bins, worker threads, and scratch memory
+} ContextData_Software;
+
+typedef struct ImageData_Software
+{
+    int refcount;
+    GPU_bool owns_handle;
+	Uint32 handle;
+	SDL_Surface* pixels;  // Always 32-bit RGBA byte order, whatever the image's format
+} ImageData_Software;
+
+typedef struct TargetData_Software
+{
+    int refcount;
+	Uint32 handle;
+} TargetData_Software;
+
+
+
+#endif
@@ -36,9 +36,11 @@
 #define RETURN_ERROR(code, details) do{ GPU_PushErrorCode(__func__, code, "%s", details); return; } while(0)
 
 int gpu_strcasecmp(const char* s1, const char* s2);
+void gpu_flush_blit_buffer_for(GPU_FlushCauseEnum cause);
 
 void gpu_init_renderer_register(void);
 void gpu_free_renderer_register(void);
+void gpu_free_image_loader(void);
 GPU_Renderer* gpu_create_and_add_renderer(GPU_RendererID id);
 
 int gpu_default_print(GPU_LogLevelEnum log_level, const char* format, va_list args);
@@ -576,6 +578,70 @@ void GPU_SetDepthFunction(GPU_Target* target, GPU_ComparisonEnum compare_operati
         target->depth_function = compare_operation;
 }
 
+void GPU_SetCulling(GPU_Target* target, GPU_bool enable)
+{
+    if(target != NULL)
+        target->use_culling = enable;
+}
+
+GPU_bool GPU_IsCullingEnabled(GPU_Target* target)
+{
+    if(target == NULL)
+        return GPU_FALSE;
+    return target->use_culling;
+}
+
+void GPU_GetCullingStats(Uint32* num_submitted, Uint32* num_culled)
+{
+    GPU_Context* context = NULL;
+    if(_gpu_current_renderer != NULL && _gpu_current_renderer->current_context_target != NULL)
+        context = _gpu_current_renderer->current_context_target->context;
+
+    if(num_submitted != NULL)
+        *num_submitted = (context != NULL? context->num_submitted_primitives : 0);
+    if(num_culled != NULL)
+        *num_culled = (context != NULL? context->num_culled_primitives : 0);
+}
+
+void GPU_ResetCullingStats(void)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    _gpu_current_renderer->current_context_target->context->num_submitted_primitives = 0;
+    _gpu_current_renderer->current_context_target->context->num_culled_primitives = 0;
+}
+
+void GPU_EnableFrameStats(GPU_bool enable)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    _gpu_current_renderer->current_context_target->context->use_frame_stats = enable;
+}
+
+void GPU_GetFrameStats(GPU_FrameStats* stats)
+{
+    if(stats == NULL)
+        return;
+
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+    {
+        memset(stats, 0, sizeof(GPU_FrameStats));
+        return;
+    }
+
+    *stats = _gpu_current_renderer->current_context_target->context->frame_stats;
+}
+
+void GPU_ResetFrameStats(void)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    memset(&_gpu_current_renderer->current_context_target->context->frame_stats, 0, sizeof(GPU_FrameStats));
+}
+
 GPU_bool GPU_SetWindowResolution(Uint16 w, Uint16 h)
 {
     if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL || w == 0 || h == 0)
@@ -631,7 +697,7 @@ void GPU_SetImageVirtualResolution(GPU_Image* image, Uint16 w, Uint16 h)
     if(image == NULL)
         return;
 
-    GPU_FlushBlitBuffer();  // TODO: Perhaps move SetImageVirtualResolution into the renderer so we can check to see if this image is bound first.
+    gpu_flush_blit_buffer_for(GPU_FLUSH_STATE_CHANGE);  // TODO: Perhaps move SetImageVirtualResolution into the renderer so we can check to see if this image is bound first.
     image->w = w;
     image->h = h;
     image->using_virtual_resolution = 1;
@@ -645,7 +711,7 @@ void GPU_UnsetImageVirtualResolution(GPU_Image* image)
     if(image == NULL)
         return;
 
-    GPU_FlushBlitBuffer();  // TODO: Perhaps move SetImageVirtualResolution into the renderer so we can check to see if this image is bound first.
+    gpu_flush_blit_buffer_for(GPU_FLUSH_STATE_CHANGE);  // TODO: Perhaps move SetImageVirtualResolution into the renderer so we can check to see if this image is bound first.
     image->w = image->base_w;
     image->h = image->base_h;
     image->using_virtual_resolution = 0;
@@ -696,6 +762,8 @@ void GPU_Quit(void)
     if(_gpu_num_error_codes > 0 && GPU_GetDebugLevel() >= GPU_DEBUG_LEVEL_1)
         GPU_LogError("GPU_Quit: %d uncleared error%s.\n", _gpu_num_error_codes, (_gpu_num_error_codes > 1? "s" : ""));
 
+    // Unfinished images are freed with the renderer that is about to go away
+    gpu_free_image_loader();
     gpu_free_error_queue();
 
     if(_gpu_current_renderer == NULL)
@@ -1048,6 +1116,14 @@ void GPU_UpdateImageBytes(GPU_Image* image, const GPU_Rect* image_rect, const un
     _gpu_current_renderer->impl->UpdateImageBytes(_gpu_current_renderer, image, image_rect, bytes, bytes_per_row);
 }
 
+void GPU_UpdateImageBytesAsync(GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    _gpu_current_renderer->impl->UpdateImageBytesAsync(_gpu_current_renderer, image, image_rect, bytes, bytes_per_row);
+}
+
 GPU_bool GPU_ReplaceImage(GPU_Image* image, SDL_Surface* surface, const GPU_Rect* surface_rect)
 {
     if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
@@ -1348,6 +1424,72 @@ SDL_Surface* GPU_CopySurfaceFromImage(GPU_Image* image)
     return _gpu_current_renderer->impl->CopySurfaceFromImage(_gpu_current_renderer, image);
 }
 
+GPU_Readback* GPU_ReadPixelsAsync(GPU_Target* target, const GPU_Rect* rect)
+{
+    if(_gpu_current_renderer == NULL)
+        return NULL;
+    MAKE_CURRENT_IF_NONE(target);
+    if(_gpu_current_renderer->current_context_target == NULL)
+        return NULL;
+
+    return _gpu_current_renderer->impl->ReadPixelsAsync(_gpu_current_renderer, target, rect);
+}
+
+GPU_bool GPU_IsReadbackReady(GPU_Readback* readback)
+{
+    if(readback == NULL)
+        return GPU_FALSE;
+
+    return readback->renderer->impl->IsReadbackReady(readback->renderer, readback);
+}
+
+const unsigned char* GPU_MapReadback(GPU_Readback* readback, int* bytes_per_row)
+{
+    if(readback == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "readback");
+        return NULL;
+    }
+
+    return readback->renderer->impl->MapReadback(readback->renderer, readback, bytes_per_row);
+}
+
+SDL_Surface* GPU_CopySurfaceFromReadback(GPU_Readback* readback)
+{
+    const unsigned char* pixels;
+    int pitch;
+    int i;
+    SDL_Surface* result;
+
+    pixels = GPU_MapReadback(readback, &pitch);
+    if(pixels == NULL)
+        return NULL;
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    result = SDL_CreateRGBSurface(SDL_SWSURFACE, readback->w, readback->h, 32, 0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
+#else
+    result = SDL_CreateRGBSurface(SDL_SWSURFACE, readback->w, readback->h, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+#endif
+    if(result == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_DATA_ERROR, "Failed to create new %dx%d surface", readback->w, readback->h);
+        return NULL;
+    }
+
+    for(i = 0; i < readback->h; ++i)
+        memcpy((Uint8*)result->pixels + i*result->pitch, pixels + i*pitch, readback->w*4);
+
+    return result;
+}
+
+void GPU_FreeReadback(GPU_Readback* readback)
+{
+    if(readback == NULL)
+        return;
+
+    readback->renderer->impl->FreeReadback(readback->renderer, readback);
+}
+
 void GPU_FreeImage(GPU_Image* image)
 {
     if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
@@ -1555,6 +1697,63 @@ void GPU_BlitRectX(GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, GPU
     GPU_BlitTransformX(image, src_rect, target, dx + pivot_x * scale_x, dy + pivot_y * scale_y, pivot_x, pivot_y, degrees, scale_x, scale_y);
 }
 
+void GPU_BlitBatch(GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* values, GPU_BlitFlagEnum flags)
+{
+    if(!CHECK_RENDERER)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    MAKE_CURRENT_IF_NONE(target);
+    if(!CHECK_CONTEXT)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+
+    if(image == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "image");
+    if(target == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+
+    if(num_sprites == 0)
+        return;
+
+    _gpu_current_renderer->impl->BlitBatch(_gpu_current_renderer, image, target, num_sprites, values, flags);
+}
+
+void GPU_BlitBatchSeparate(GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* positions, float* src_rects, float* colors, GPU_BlitFlagEnum flags)
+{
+    if(!CHECK_RENDERER)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    MAKE_CURRENT_IF_NONE(target);
+    if(!CHECK_CONTEXT)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+
+    if(image == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "image");
+    if(target == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+
+    if(num_sprites == 0)
+        return;
+
+    _gpu_current_renderer->impl->BlitBatchSeparate(_gpu_current_renderer, image, target, num_sprites, positions, src_rects, colors, flags);
+}
+
+void GPU_BlitTransformBatch(GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* x, float* y, float* degrees, float* scale_x, float* scale_y, unsigned int num_src_rects, GPU_Rect* src_rects, Uint16* src_rect_indices, SDL_Color* colors)
+{
+    if(!CHECK_RENDERER)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    MAKE_CURRENT_IF_NONE(target);
+    if(!CHECK_CONTEXT)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+
+    if(image == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "image");
+    if(target == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+
+    if(num_sprites == 0)
+        return;
+
+    _gpu_current_renderer->impl->BlitTransformBatch(_gpu_current_renderer, image, target, num_sprites, x, y, degrees, scale_x, scale_y, num_src_rects, src_rects, src_rect_indices, colors);
+}
+
 void GPU_TriangleBatch(GPU_Image* image, GPU_Target* target, unsigned short num_vertices, float* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags)
 {
     GPU_PrimitiveBatchV(image, target, GPU_TRIANGLES, num_vertices, (void*)values, num_indices, indices, flags);
@@ -1588,6 +1787,89 @@ void GPU_PrimitiveBatchV(GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum
     _gpu_current_renderer->impl->PrimitiveBatchV(_gpu_current_renderer, image, target, primitive_type, num_vertices, values, num_indices, indices, flags);
 }
 
+void GPU_PrimitiveBatchV32(GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned int num_vertices, void* values, unsigned int num_indices, unsigned int* indices, GPU_BatchFlagEnum flags)
+{
+    if(!CHECK_RENDERER)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    MAKE_CURRENT_IF_NONE(target);
+    if(!CHECK_CONTEXT)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+
+    if(target == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+
+    if(num_vertices == 0)
+        return;
+
+
+    _gpu_current_renderer->impl->PrimitiveBatchV32(_gpu_current_renderer, image, target, primitive_type, num_vertices, values, num_indices, indices, flags);
+}
+
+GPU_VertexBuffer* GPU_CreateVertexBuffer(GPU_BatchFlagEnum flags, unsigned int num_vertices, void* values, unsigned int num_indices, unsigned int* indices)
+{
+    if(!CHECK_RENDERER)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_USER_ERROR, "NULL renderer");
+        return NULL;
+    }
+    if(!CHECK_CONTEXT)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_USER_ERROR, "NULL context");
+        return NULL;
+    }
+    if(num_vertices == 0)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_DATA_ERROR, "No vertices given");
+        return NULL;
+    }
+
+    return _gpu_current_renderer->impl->CreateVertexBuffer(_gpu_current_renderer, flags, num_vertices, values, num_indices, indices);
+}
+
+void GPU_UpdateVertexBuffer(GPU_VertexBuffer* buffer, unsigned int first_vertex, unsigned int num_vertices, void* values)
+{
+    if(buffer == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "buffer");
+    if(values == NULL || num_vertices == 0)
+        return;
+    if(first_vertex + num_vertices > buffer->num_vertices)
+        RETURN_ERROR(GPU_ERROR_DATA_ERROR, "Vertex range is past the end of the buffer");
+
+    buffer->renderer->impl->UpdateVertexBuffer(buffer->renderer, buffer, first_vertex, num_vertices, values);
+}
+
+void GPU_DrawVertexBuffer(GPU_Image* image, GPU_Target* target, GPU_VertexBuffer* buffer, GPU_PrimitiveEnum primitive_type, unsigned int first, unsigned int count)
+{
+    unsigned int size;
+
+    if(!CHECK_RENDERER)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    MAKE_CURRENT_IF_NONE(target);
+    if(!CHECK_CONTEXT)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+
+    if(target == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+    if(buffer == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "buffer");
+
+    size = (buffer->num_indices > 0? buffer->num_indices : buffer->num_vertices);
+    if(first >= size)
+        return;
+    if(count == 0 || count > size - first)
+        count = size - first;
+
+    _gpu_current_renderer->impl->DrawVertexBuffer(_gpu_current_renderer, image, target, buffer, primitive_type, first, count);
+}
+
+void GPU_FreeVertexBuffer(GPU_VertexBuffer* buffer)
+{
+    if(buffer == NULL)
+        return;
+
+    buffer->renderer->impl->FreeVertexBuffer(buffer->renderer, buffer);
+}
+
 
 
 
@@ -2067,6 +2349,25 @@ SDL_Color GPU_GetPixel(GPU_Target* target, Sint16 x, Sint16 y)
     return _gpu_current_renderer->impl->GetPixel(_gpu_current_renderer, target, x, y);
 }
 
+void GPU_GetPixels(GPU_Target* target, unsigned int num_points, const Sint16* points, SDL_Color* colors)
+{
+    if(!CHECK_RENDERER)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    if(target == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+    MAKE_CURRENT_IF_NONE(target);
+    if(!CHECK_CONTEXT)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+    if(num_points == 0)
+        return;
+    if(points == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "points");
+    if(colors == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "colors");
+
+    _gpu_current_renderer->impl->GetPixels(_gpu_current_renderer, target, num_points, points, colors);
+}
+
 
 
 
@@ -2125,6 +2426,116 @@ void GPU_FlushBlitBuffer(void)
     _gpu_current_renderer->impl->FlushBlitBuffer(_gpu_current_renderer);
 }
 
+// GPU_FlushBlitBuffer() with the reason recorded for the frame statistics
+void gpu_flush_blit_buffer_for(GPU_FlushCauseEnum cause)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    _gpu_current_renderer->current_context_target->context->flush_cause = cause;
+    _gpu_current_renderer->impl->FlushBlitBuffer(_gpu_current_renderer);
+}
+
+void GPU_BeginSortedBatch(GPU_Target* target)
+{
+    if(!CHECK_RENDERER)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    MAKE_CURRENT_IF_NONE(target);
+    if(!CHECK_CONTEXT)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+
+    if(target == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+
+    _gpu_current_renderer->impl->BeginSortedBatch(_gpu_current_renderer, target);
+}
+
+void GPU_EndSortedBatch(void)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    _gpu_current_renderer->impl->EndSortedBatch(_gpu_current_renderer);
+}
+
+void GPU_SetSortedBatchLayer(int layer)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    _gpu_current_renderer->impl->SetSortedBatchLayer(_gpu_current_renderer, layer);
+}
+
+void GPU_BeginCommandList(GPU_Target* target)
+{
+    if(!CHECK_RENDERER)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    MAKE_CURRENT_IF_NONE(target);
+    if(!CHECK_CONTEXT)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+
+    if(target == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+
+    _gpu_current_renderer->impl->BeginCommandList(_gpu_current_renderer, target);
+}
+
+GPU_CommandList* GPU_EndCommandList(void)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return NULL;
+
+    return _gpu_current_renderer->impl->EndCommandList(_gpu_current_renderer);
+}
+
+void GPU_ExecuteCommandList(GPU_CommandList* list, GPU_Target* target, const float* transform)
+{
+    if(!CHECK_RENDERER)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    MAKE_CURRENT_IF_NONE(target);
+    if(!CHECK_CONTEXT)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+
+    if(list == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "list");
+    if(target == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+
+    _gpu_current_renderer->impl->ExecuteCommandList(_gpu_current_renderer, list, target, transform);
+}
+
+void GPU_FreeCommandList(GPU_CommandList* list)
+{
+    if(list == NULL)
+        return;
+
+    list->renderer->impl->FreeCommandList(list->renderer, list);
+}
+
+GPU_bool GPU_SetBufferUploadMethod(GPU_BufferUploadEnum method)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return GPU_FALSE;
+
+    return _gpu_current_renderer->impl->SetBufferUploadMethod(_gpu_current_renderer, method);
+}
+
+GPU_BufferUploadEnum GPU_GetBufferUploadMethod(void)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return GPU_BUFFER_UPLOAD_NONE;
+
+    return _gpu_current_renderer->impl->GetBufferUploadMethod(_gpu_current_renderer);
+}
+
+GPU_BufferUploadEnum GPU_CalibrateBufferUpload(void)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return GPU_BUFFER_UPLOAD_NONE;
+
+    return _gpu_current_renderer->impl->CalibrateBufferUpload(_gpu_current_renderer);
+}
+
 void GPU_Flip(GPU_Target* target)
 {
     if(!CHECK_RENDERER)
@@ -2143,6 +2554,57 @@ void GPU_Flip(GPU_Target* target)
     _gpu_current_renderer->impl->Flip(_gpu_current_renderer, target);
 }
 
+GPU_bool GPU_EnableGPUTiming(GPU_bool enable)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return GPU_FALSE;
+
+    return _gpu_current_renderer->impl->EnableGPUTiming(_gpu_current_renderer, enable);
+}
+
+void GPU_BeginGPUScope(const char* name)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    if(name == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "name");
+
+    _gpu_current_renderer->impl->BeginGPUScope(_gpu_current_renderer, name);
+}
+
+void GPU_EndGPUScope(void)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    _gpu_current_renderer->impl->EndGPUScope(_gpu_current_renderer);
+}
+
+float GPU_GetGPUFrameTime(void)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return -1.0f;
+
+    return _gpu_current_renderer->impl->GetGPUTime(_gpu_current_renderer, NULL, NULL);
+}
+
+float GPU_GetGPUScopeTime(const char* name)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL || name == NULL)
+        return -1.0f;
+
+    return _gpu_current_renderer->impl->GetGPUTime(_gpu_current_renderer, name, NULL);
+}
+
+float GPU_GetGPUTargetTime(GPU_Target* target)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL || target == NULL)
+        return -1.0f;
+
+    return _gpu_current_renderer->impl->GetGPUTime(_gpu_current_renderer, NULL, target);
+}
+
 
 
 
@@ -0,0 +1,506 @@
+#include "SDL_gpu.h"
+#include "stb_image.h"
+#include <string.h>
+
+#ifdef _MSC_VER
+// Disable warning: selection for inlining
+#pragma warning(disable: 4514 4711)
+// Disable warning: Spectre mitigation
+#pragma warning(disable: 5045)
+#endif
+
+#ifndef MIN
+#define MIN(a,b) ((a) < (b)? (a) : (b))
+#endif
+
+#define GPU_LOADER_MAX_THREADS 8
+
+/* Files are read and decoded by a pool of worker threads.  Decoded images wait in the upload queue until
+GPU_ProcessPendingUploads() creates their textures on the rendering thread, a band of rows at a time.
+Workers never touch GL, the current renderer, or the error queue.  Failures are pushed as errors when the rendering thread reaches them.
+Without workers (SDL 1.2, or GPU_SetImageLoaderThreads(0)), GPU_ProcessPendingUploads() decodes them itself. */
+
+typedef enum {
+    GPU_LOADER_QUEUED = 0,
+    GPU_LOADER_DECODING = 1,
+    GPU_LOADER_DECODED = 2,  // In the upload queue
+    GPU_LOADER_FINISHED = 3  // Out of both queues, so only the caller has it
+} GPU_LoaderStateEnum;
+
+struct GPU_PendingImage
+{
+    char* filename;
+    GPU_PendingStatusEnum status;  // Only changed by the rendering thread
+    GPU_LoaderStateEnum state;  // Guarded by the loader lock
+    GPU_bool cancelled;  // Freed by the caller while queued.  Whoever takes it out of its queue frees it.
+    const char* error;
+
+    unsigned char* pixels;  // From stbi, tightly packed
+    int w, h, channels;
+    GPU_Image* image;  // Created when its upload starts
+    int rows_uploaded;
+
+    GPU_PendingImage* next;
+};
+
+typedef struct GPU_LoaderQueue
+{
+    GPU_PendingImage* head;
+    GPU_PendingImage* tail;
+} GPU_LoaderQueue;
+
+typedef struct GPU_ImageLoader
+{
+    SDL_mutex* lock;
+    SDL_cond* wake;  // Signaled when a file is queued or the workers have to stop
+    GPU_LoaderQueue decode_queue;
+    GPU_LoaderQueue upload_queue;
+
+    GPU_bool threads_requested;  // False until GPU_SetImageLoaderThreads() is called
+    int requested_threads;  // Negative for one per spare CPU core
+    #ifdef SDL_GPU_USE_SDL2
+    SDL_Thread* threads[GPU_LOADER_MAX_THREADS];
+    #endif
+    int num_threads;
+    GPU_bool started;
+    GPU_bool quitting;
+} GPU_ImageLoader;
+
+static GPU_ImageLoader _gpu_loader;
+
+
+static void pushPendingImage(GPU_LoaderQueue* queue, GPU_PendingImage* pending)
+{
+    pending->next = NULL;
+    if(queue->tail != NULL)
+        queue->tail->next = pending;
+    else
+        queue->head = pending;
+    queue->tail = pending;
+}
+
+static GPU_PendingImage* popPendingImage(GPU_LoaderQueue* queue)
+{
+    GPU_PendingImage* pending = queue->head;
+    if(pending == NULL)
+        return NULL;
+
+    queue->head = pending->next;
+    if(queue->head == NULL)
+        queue->tail = NULL;
+    pending->next = NULL;
+    return pending;
+}
+
+static void freePendingImageData(GPU_PendingImage* pending)
+{
+    if(pending->pixels != NULL)
+        stbi_image_free(pending->pixels);
+    if(pending->image != NULL && pending->status != GPU_PENDING_DONE)
+        GPU_FreeImage(pending->image);
+    SDL_free(pending->filename);
+    SDL_free(pending);
+}
+
+// Reads and decodes the file into pending->pixels, or sets pending->error.  Safe on any thread.
+static void decodePendingImage(GPU_PendingImage* pending)
+{
+    SDL_RWops* rwops;
+    unsigned char* c_data;
+    int data_bytes;
+
+    rwops = SDL_RWFromFile(pending->filename, "rb");
+    if(rwops == NULL)
+    {
+        pending->error = "Failed to open file";
+        return;
+    }
+
+    SDL_RWseek(rwops, 0, SEEK_SET);
+    data_bytes = (int)SDL_RWseek(rwops, 0, SEEK_END);
+    SDL_RWseek(rwops, 0, SEEK_SET);
+
+    c_data = (data_bytes > 0? (unsigned char*)SDL_malloc(data_bytes) : NULL);
+    if(c_data == NULL)
+    {
+        SDL_RWclose(rwops);
+        pending->error = "Failed to read file";
+        return;
+    }
+    SDL_RWread(rwops, c_data, 1, data_bytes);
+    SDL_RWclose(rwops);
+
+    // stbi_failure_reason() is shared by every thread, so it can't be trusted here
+    pending->pixels = stbi_load_from_memory(c_data, data_bytes, &pending->w, &pending->h, &pending->channels, 0);
+    SDL_free(c_data);
+
+    if(pending->pixels == NULL)
+        pending->error = "Failed to decode image data";
+    else if(pending->w > 65535 || pending->h > 65535)
+        pending->error = "Image is too large";
+}
+
+// Takes a decoded image into the upload queue.  The loader lock must be held.
+static void finishDecode(GPU_PendingImage* pending)
+{
+    if(pending->cancelled)
+    {
+        freePendingImageData(pending);
+        return;
+    }
+
+    pending->state = GPU_LOADER_DECODED;
+    pushPendingImage(&_gpu_loader.upload_queue, pending);
+}
+
+#ifdef SDL_GPU_USE_SDL2
+static int loaderThread(void* data)
+{
+    GPU_PendingImage* pending;
+    (void)data;
+
+    SDL_LockMutex(_gpu_loader.lock);
+    while(1)
+    {
+        while(!_gpu_loader.quitting && _gpu_loader.decode_queue.head == NULL)
+            SDL_CondWait(_gpu_loader.wake, _gpu_loader.lock);
+        if(_gpu_loader.quitting)
+            break;
+
+        pending = popPendingImage(&_gpu_loader.decode_queue);
+        if(pending->cancelled)
+        {
+            freePendingImageData(pending);
+            continue;
+        }
+
+        pending->state = GPU_LOADER_DECODING;
+        SDL_UnlockMutex(_gpu_loader.lock);
+
+        decodePendingImage(pending);
+
+        SDL_LockMutex(_gpu_loader.lock);
+        finishDecode(pending);
+    }
+    SDL_UnlockMutex(_gpu_loader.lock);
+    return 0;
+}
+#endif
+
+// The loader starts zeroed, so -1 (one per spare core) stands in until a count is set
+static int getRequestedLoaderThreads(void)
+{
+    return (_gpu_loader.threads_requested? _gpu_loader.requested_threads : -1);
+}
+
+// Threads are started with the first GPU_LoadImageAsync()
+static void startLoaderThreads(void)
+{
+    #ifdef SDL_GPU_USE_SDL2
+    int i;
+    int n = getRequestedLoaderThreads();
+    if(n < 0)
+        n = (SDL_GetCPUCount() > 1? SDL_GetCPUCount() - 1 : 1);
+
+    _gpu_loader.started = GPU_TRUE;
+    _gpu_loader.num_threads = 0;
+    for(i = 0; i < MIN(n, GPU_LOADER_MAX_THREADS); i++)
+    {
+        _gpu_loader.threads[i] = SDL_CreateThread(&loaderThread, "GPU_ImageLoader", NULL);
+        if(_gpu_loader.threads[i] == NULL)
+            break;
+        _gpu_loader.num_threads++;
+    }
+    #else
+    _gpu_loader.started = GPU_TRUE;
+    _gpu_loader.num_threads = 0;
+    #endif
+}
+
+// Waits for decodes in progress.  Queued files stay queued.
+static void stopLoaderThreads(void)
+{
+    #ifdef SDL_GPU_USE_SDL2
+    int i;
+    if(_gpu_loader.num_threads > 0)
+    {
+        SDL_LockMutex(_gpu_loader.lock);
+        _gpu_loader.quitting = GPU_TRUE;
+        SDL_CondBroadcast(_gpu_loader.wake);
+        SDL_UnlockMutex(_gpu_loader.lock);
+
+        for(i = 0; i < _gpu_loader.num_threads; i++)
+            SDL_WaitThread(_gpu_loader.threads[i], NULL);
+    }
+    #endif
+
+    _gpu_loader.num_threads = 0;
+    _gpu_loader.started = GPU_FALSE;
+    _gpu_loader.quitting = GPU_FALSE;
+}
+
+// Called by GPU_Quit().  Unfinished loads fail, since their textures would outlive the renderer.
+void gpu_free_image_loader(void)
+{
+    GPU_LoaderQueue* queues[2];
+    GPU_PendingImage* pending;
+    int i;
+
+    if(_gpu_loader.lock == NULL)
+        return;
+
+    stopLoaderThreads();
+
+    queues[0] = &_gpu_loader.decode_queue;
+    queues[1] = &_gpu_loader.upload_queue;
+    for(i = 0; i < 2; i++)
+    {
+        while((pending = popPendingImage(queues[i])) != NULL)
+        {
+            if(pending->cancelled)
+            {
+                freePendingImageData(pending);
+                continue;
+            }
+
+            if(pending->pixels != NULL)
+                stbi_image_free(pending->pixels);
+            if(pending->image != NULL)
+                GPU_FreeImage(pending->image);
+            pending->pixels = NULL;
+            pending->image = NULL;
+            pending->state = GPU_LOADER_FINISHED;
+            pending->status = GPU_PENDING_FAILED;
+        }
+    }
+
+    SDL_DestroyCond(_gpu_loader.wake);
+    SDL_DestroyMutex(_gpu_loader.lock);
+    _gpu_loader.wake = NULL;
+    _gpu_loader.lock = NULL;
+}
+
+
+void GPU_SetImageLoaderThreads(int num_threads)
+{
+    if(num_threads > GPU_LOADER_MAX_THREADS)
+        num_threads = GPU_LOADER_MAX_THREADS;
+    if(num_threads < 0)
+        num_threads = -1;
+    if(num_threads == getRequestedLoaderThreads())
+        return;
+
+    _gpu_loader.threads_requested = GPU_TRUE;
+    _gpu_loader.requested_threads = num_threads;
+    // The new pool starts with the next load
+    if(_gpu_loader.started)
+        stopLoaderThreads();
+}
+
+GPU_PendingImage* GPU_LoadImageAsync(const char* filename)
+{
+    GPU_PendingImage* pending;
+
+    if(filename == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "filename");
+        return NULL;
+    }
+
+    if(_gpu_loader.lock == NULL)
+    {
+        _gpu_loader.lock = SDL_CreateMutex();
+        _gpu_loader.wake = SDL_CreateCond();
+        if(_gpu_loader.lock == NULL || _gpu_loader.wake == NULL)
+        {
+            GPU_PushErrorCode(__func__, GPU_ERROR_BACKEND_ERROR, "Failed to create the loader lock.");
+            if(_gpu_loader.wake != NULL)
+                SDL_DestroyCond(_gpu_loader.wake);
+            if(_gpu_loader.lock != NULL)
+                SDL_DestroyMutex(_gpu_loader.lock);
+            _gpu_loader.wake = NULL;
+            _gpu_loader.lock = NULL;
+            return NULL;
+        }
+    }
+
+    pending = (GPU_PendingImage*)SDL_malloc(sizeof(GPU_PendingImage));
+    if(pending == NULL)
+        return NULL;
+    memset(pending, 0, sizeof(GPU_PendingImage));
+    pending->filename = (char*)SDL_malloc(strlen(filename) + 1);
+    if(pending->filename == NULL)
+    {
+        SDL_free(pending);
+        return NULL;
+    }
+    strcpy(pending->filename, filename);
+    pending->status = GPU_PENDING_LOADING;
+    pending->state = GPU_LOADER_QUEUED;
+
+    if(!_gpu_loader.started)
+        startLoaderThreads();
+
+    SDL_LockMutex(_gpu_loader.lock);
+    pushPendingImage(&_gpu_loader.decode_queue, pending);
+    SDL_CondSignal(_gpu_loader.wake);
+    SDL_UnlockMutex(_gpu_loader.lock);
+
+    return pending;
+}
+
+GPU_PendingStatusEnum GPU_GetPendingImageStatus(GPU_PendingImage* pending)
+{
+    if(pending == NULL)
+        return GPU_PENDING_FAILED;
+    return pending->status;
+}
+
+GPU_Image* GPU_GetPendingImage(GPU_PendingImage* pending)
+{
+    if(pending == NULL || pending->status != GPU_PENDING_DONE)
+        return NULL;
+    return pending->image;
+}
+
+void GPU_FreePendingImage(GPU_PendingImage* pending)
+{
+    if(pending == NULL)
+        return;
+
+    if(_gpu_loader.lock != NULL)
+    {
+        SDL_LockMutex(_gpu_loader.lock);
+        if(pending->state != GPU_LOADER_FINISHED)
+        {
+            // Still queued or being decoded
+            pending->cancelled = GPU_TRUE;
+            SDL_UnlockMutex(_gpu_loader.lock);
+            return;
+        }
+        SDL_UnlockMutex(_gpu_loader.lock);
+    }
+
+    freePendingImageData(pending);
+}
+
+// Takes the next image out of the upload queue, decoding one here first if there are no workers.
+// Returns the image that is being uploaded or NULL if there is nothing to do.
+static GPU_PendingImage* nextPendingUpload(void)
+{
+    GPU_PendingImage* pending;
+
+    SDL_LockMutex(_gpu_loader.lock);
+    while(_gpu_loader.upload_queue.head != NULL && _gpu_loader.upload_queue.head->cancelled)
+        freePendingImageData(popPendingImage(&_gpu_loader.upload_queue));
+
+    pending = _gpu_loader.upload_queue.head;
+    if(pending == NULL && _gpu_loader.num_threads == 0)
+    {
+        while((pending = popPendingImage(&_gpu_loader.decode_queue)) != NULL && pending->cancelled)
+            freePendingImageData(pending);
+
+        if(pending != NULL)
+        {
+            pending->state = GPU_LOADER_DECODING;
+            SDL_UnlockMutex(_gpu_loader.lock);
+
+            decodePendingImage(pending);
+
+            SDL_LockMutex(_gpu_loader.lock);
+            finishDecode(pending);
+            pending = _gpu_loader.upload_queue.head;
+        }
+    }
+    SDL_UnlockMutex(_gpu_loader.lock);
+    return pending;
+}
+
+// Takes the head of the upload queue out now that the rendering thread is done with it
+static void finishPendingUpload(GPU_PendingImage* pending, GPU_PendingStatusEnum status)
+{
+    SDL_LockMutex(_gpu_loader.lock);
+    popPendingImage(&_gpu_loader.upload_queue);
+    if(pending->cancelled)
+    {
+        SDL_UnlockMutex(_gpu_loader.lock);
+        freePendingImageData(pending);
+        return;
+    }
+
+    if(pending->pixels != NULL)
+        stbi_image_free(pending->pixels);
+    pending->pixels = NULL;
+    if(status == GPU_PENDING_FAILED && pending->image != NULL)
+    {
+        GPU_FreeImage(pending->image);
+        pending->image = NULL;
+    }
+    pending->state = GPU_LOADER_FINISHED;
+    pending->status = status;
+    SDL_UnlockMutex(_gpu_loader.lock);
+}
+
+int GPU_ProcessPendingUploads(Uint32 max_bytes, Uint32 max_ms)
+{
+    static const GPU_FormatEnum formats[5] = {GPU_FORMAT_RGBA, GPU_FORMAT_LUMINANCE, GPU_FORMAT_LUMINANCE_ALPHA, GPU_FORMAT_RGB, GPU_FORMAT_RGBA};
+    GPU_PendingImage* pending;
+    GPU_Rect rect;
+    Uint32 start_time;
+    Uint32 bytes = 0;
+    int row_size;
+    int num_rows;
+    int num_finished = 0;
+    GPU_Renderer* renderer = GPU_GetCurrentRenderer();
+
+    if(_gpu_loader.lock == NULL || renderer == NULL || renderer->current_context_target == NULL)
+        return 0;
+
+    start_time = SDL_GetTicks();
+    while(!(max_bytes > 0 && bytes >= max_bytes) && !(max_ms > 0 && SDL_GetTicks() - start_time >= max_ms))
+    {
+        pending = nextPendingUpload();
+        if(pending == NULL)
+            break;
+
+        if(pending->error != NULL)
+        {
+            GPU_PushErrorCode("GPU_LoadImageAsync", GPU_ERROR_DATA_ERROR, "%s: %s", pending->error, pending->filename);
+            finishPendingUpload(pending, GPU_PENDING_FAILED);
+            continue;
+        }
+
+        if(pending->image == NULL)
+        {
+            pending->image = GPU_CreateImage((Uint16)pending->w, (Uint16)pending->h, formats[pending->channels]);
+            if(pending->image == NULL)
+            {
+                finishPendingUpload(pending, GPU_PENDING_FAILED);
+                continue;
+            }
+        }
+
+        // Big images are spread over several calls, but every call makes progress
+        row_size = pending->w*pending->channels;
+        num_rows = pending->h - pending->rows_uploaded;
+        if(max_bytes > 0 && (Uint32)(num_rows*row_size) > max_bytes - bytes)
+        {
+            num_rows = (int)((max_bytes - bytes) / row_size);
+            if(num_rows < 1)
+                num_rows = 1;
+        }
+
+        rect = GPU_MakeRect(0, (float)pending->rows_uploaded, (float)pending->w, (float)num_rows);
+        GPU_UpdateImageBytesAsync(pending->image, &rect, pending->pixels + pending->rows_uploaded*row_size, row_size);
+        pending->rows_uploaded += num_rows;
+        bytes += (Uint32)(num_rows*row_size);
+
+        if(pending->rows_uploaded >= pending->h)
+        {
+            finishPendingUpload(pending, GPU_PENDING_DONE);
+            num_finished++;
+        }
+    }
+
+    return num_finished;
+}
@@ -59,6 +59,55 @@
 
 
 
+void gpu_flush_blit_buffer_for(GPU_FlushCauseEnum cause);
+
+
+// Source of the generation numbers stamped on matrix stacks and cameras.  Shared so that equal generations always mean equal contents.
+static Uint32 gpu_matrix_generation = 0;
+
+Uint32 gpu_next_matrix_generation(void)
+{
+    gpu_matrix_generation++;
+    // Zero means "never set"
+    if(gpu_matrix_generation == 0)
+        gpu_matrix_generation++;
+    return gpu_matrix_generation;
+}
+
+// Reads the top matrix without marking it as changed
+static_inline float* peekTopMatrix(GPU_MatrixStack* stack)
+{
+    if(stack == NULL || stack->size == 0)
+        return NULL;
+    return stack->matrix[stack->size-1];
+}
+
+// For the renderers, which read the matrices on every flush
+float* gpu_peek_top_matrix(GPU_MatrixStack* stack)
+{
+    return peekTopMatrix(stack);
+}
+
+static GPU_MatrixStack* getCurrentMatrixStack(void)
+{
+    GPU_Target* target = GPU_GetActiveTarget();
+    if(target == NULL)
+        return NULL;
+    if(target->matrix_mode == GPU_MODEL)
+        return &target->model_matrix;
+    else if(target->matrix_mode == GPU_VIEW)
+        return &target->view_matrix;
+    else// if(target->matrix_mode == GPU_PROJECTION)
+        return &target->projection_matrix;
+}
+
+static void touchMatrixStack(GPU_MatrixStack* stack)
+{
+    if(stack != NULL)
+        stack->generation = gpu_next_matrix_generation();
+}
+
+
 GPU_MatrixStack* GPU_CreateMatrixStack(void)
 {
     GPU_MatrixStack* stack = (GPU_MatrixStack*)SDL_malloc(sizeof(GPU_MatrixStack));
@@ -90,6 +139,7 @@ void GPU_InitMatrixStack(GPU_MatrixStack* stack)
     stack->matrix = (float**)SDL_malloc(sizeof(float*) * stack->storage_size);
     stack->matrix[0] = (float*)SDL_malloc(sizeof(float) * 16);
     GPU_MatrixIdentity(stack->matrix[0]);
+    touchMatrixStack(stack);
 }
 
 void GPU_CopyMatrixStack(const GPU_MatrixStack* source, GPU_MatrixStack* dest)
@@ -107,6 +157,8 @@ void GPU_CopyMatrixStack(const GPU_MatrixStack* source, GPU_MatrixStack* dest)
 		memcpy(dest->matrix[i], source->matrix[i], matrix_size);
 	}
 	dest->storage_size = source->storage_size;
+	dest->size = source->size;
+	touchMatrixStack(dest);
 }
 
 void GPU_ClearMatrixStack(GPU_MatrixStack* stack)
@@ -138,6 +190,8 @@ void GPU_ResetProjection(GPU_Target* target)
         GPU_MatrixOrtho(projection_matrix, 0, target->w, target->h, 0, target->camera.z_near, target->camera.z_far);
     else
         GPU_MatrixOrtho(projection_matrix, 0, target->w, 0, target->h, target->camera.z_near, target->camera.z_far);  // Special inverted orthographic projection because tex coords are inverted already for render-to-texture
+    
+    touchMatrixStack(&target->projection_matrix);
 }
 
 // Column-major
@@ -492,7 +546,7 @@ void GPU_MatrixMode(GPU_Target* target, int matrix_mode)
     if(target == NULL)
         return;
     
-    GPU_FlushBlitBuffer();
+    gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
     target->matrix_mode = matrix_mode;
     
     context_target = GPU_GetContextTarget();
@@ -500,6 +554,8 @@ void GPU_MatrixMode(GPU_Target* target, int matrix_mode)
         context_target->context->active_target = target;
 }
 
+// The getters hand out writable matrices, so they count as a change.
+
 float* GPU_GetModel(void)
 {
     GPU_Target* target = GPU_GetActiveTarget();
@@ -526,18 +582,7 @@ float* GPU_GetProjection(void)
 
 float* GPU_GetCurrentMatrix(void)
 {
-    GPU_MatrixStack* stack;
-    GPU_Target* target = GPU_GetActiveTarget();
-    if(target == NULL)
-        return NULL;
-    if(target->matrix_mode == GPU_MODEL)
-        stack = &target->model_matrix;
-    else if(target->matrix_mode == GPU_VIEW)
-        stack = &target->view_matrix;
-    else// if(target->matrix_mode == GPU_PROJECTION)
-        stack = &target->projection_matrix;
-    
-    return GPU_GetTopMatrix(stack);
+    return GPU_GetTopMatrix(getCurrentMatrixStack());
 }
 
 void GPU_PushMatrix(void)
@@ -584,6 +629,7 @@ void GPU_PushMatrix(void)
     }
     GPU_MatrixCopy(stack->matrix[stack->size], stack->matrix[stack->size-1]);
     stack->size++;
+    touchMatrixStack(stack);
 }
 
 void GPU_PopMatrix(void)
@@ -595,7 +641,7 @@ void GPU_PopMatrix(void)
         return;
     
 	// FIXME: Flushing here is not always necessary if this isn't the last target
-	GPU_FlushBlitBuffer();
+	gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
 	
     if(target->matrix_mode == GPU_MODEL)
         stack = &target->model_matrix;
@@ -613,7 +659,10 @@ void GPU_PopMatrix(void)
         GPU_PushErrorCode(__func__, GPU_ERROR_USER_ERROR, "Matrix stack would become empty!");
     }
     else
+    {
         stack->size--;
+        touchMatrixStack(stack);
+    }
 }
 
 void GPU_SetProjection(const float* A)
@@ -622,8 +671,9 @@ void GPU_SetProjection(const float* A)
     if(target == NULL || A == NULL)
         return;
     
-	GPU_FlushBlitBuffer();
-    GPU_MatrixCopy(GPU_GetProjection(), A);
+	gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
+    GPU_MatrixCopy(peekTopMatrix(&target->projection_matrix), A);
+    touchMatrixStack(&target->projection_matrix);
 }
 
 void GPU_SetModel(const float* A)
@@ -632,8 +682,9 @@ void GPU_SetModel(const float* A)
     if(target == NULL || A == NULL)
         return;
     
-	GPU_FlushBlitBuffer();
-    GPU_MatrixCopy(GPU_GetModel(), A);
+	gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
+    GPU_MatrixCopy(peekTopMatrix(&target->model_matrix), A);
+    touchMatrixStack(&target->model_matrix);
 }
 
 void GPU_SetView(const float* A)
@@ -642,8 +693,9 @@ void GPU_SetView(const float* A)
     if(target == NULL || A == NULL)
         return;
     
-	GPU_FlushBlitBuffer();
-    GPU_MatrixCopy(GPU_GetView(), A);
+	gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
+    GPU_MatrixCopy(peekTopMatrix(&target->view_matrix), A);
+    touchMatrixStack(&target->view_matrix);
 }
 
 void GPU_SetProjectionFromStack(GPU_MatrixStack* stack)
@@ -677,83 +729,152 @@ float* GPU_GetTopMatrix(GPU_MatrixStack* stack)
 {
     if(stack == NULL || stack->size == 0)
         return NULL;
+    touchMatrixStack(stack);
     return stack->matrix[stack->size-1];
 }
 
 void GPU_LoadIdentity(void)
 {
-    float* result = GPU_GetCurrentMatrix();
+    GPU_MatrixStack* stack = getCurrentMatrixStack();
+    float* result = peekTopMatrix(stack);
     if(result == NULL)
 		return;
     
-	GPU_FlushBlitBuffer();
+	gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
     GPU_MatrixIdentity(result);
+    touchMatrixStack(stack);
 }
 
 void GPU_LoadMatrix(const float* A)
 {
-    float* result = GPU_GetCurrentMatrix();
+    GPU_MatrixStack* stack = getCurrentMatrixStack();
+    float* result = peekTopMatrix(stack);
     if(result == NULL)
         return;
-	GPU_FlushBlitBuffer();
+	gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
     GPU_MatrixCopy(result, A);
+    touchMatrixStack(stack);
 }
 
 void GPU_Ortho(float left, float right, float bottom, float top, float z_near, float z_far)
 {
-	GPU_FlushBlitBuffer();
-    GPU_MatrixOrtho(GPU_GetCurrentMatrix(), left, right, bottom, top, z_near, z_far);
+    GPU_MatrixStack* stack = getCurrentMatrixStack();
+	gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
+    GPU_MatrixOrtho(peekTopMatrix(stack), left, right, bottom, top, z_near, z_far);
+    touchMatrixStack(stack);
 }
 
 void GPU_Frustum(float left, float right, float bottom, float top, float z_near, float z_far)
 {
-	GPU_FlushBlitBuffer();
-    GPU_MatrixFrustum(GPU_GetCurrentMatrix(), left, right, bottom, top, z_near, z_far);
+    GPU_MatrixStack* stack = getCurrentMatrixStack();
+	gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
+    GPU_MatrixFrustum(peekTopMatrix(stack), left, right, bottom, top, z_near, z_far);
+    touchMatrixStack(stack);
 }
 
 void GPU_Perspective(float fovy, float aspect, float z_near, float z_far)
 {
-	GPU_FlushBlitBuffer();
-    GPU_MatrixPerspective(GPU_GetCurrentMatrix(), fovy, aspect, z_near, z_far);
+    GPU_MatrixStack* stack = getCurrentMatrixStack();
+	gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
+    GPU_MatrixPerspective(peekTopMatrix(stack), fovy, aspect, z_near, z_far);
+    touchMatrixStack(stack);
 }
 
 void GPU_LookAt(float eye_x, float eye_y, float eye_z, float target_x, float target_y, float target_z, float up_x, float up_y, float up_z)
 {
-	GPU_FlushBlitBuffer();
-    GPU_MatrixLookAt(GPU_GetCurrentMatrix(), eye_x, eye_y, eye_z, target_x, target_y, target_z, up_x, up_y, up_z);
+    GPU_MatrixStack* stack = getCurrentMatrixStack();
+	gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
+    GPU_MatrixLookAt(peekTopMatrix(stack), eye_x, eye_y, eye_z, target_x, target_y, target_z, up_x, up_y, up_z);
+    touchMatrixStack(stack);
 }
 
 
 void GPU_Translate(float x, float y, float z)
 {
-	GPU_FlushBlitBuffer();
-    GPU_MatrixTranslate(GPU_GetCurrentMatrix(), x, y, z);
+    GPU_MatrixStack* stack = getCurrentMatrixStack();
+	gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
+    GPU_MatrixTranslate(peekTopMatrix(stack), x, y, z);
+    touchMatrixStack(stack);
 }
 
 void GPU_Scale(float sx, float sy, float sz)
 {
-	GPU_FlushBlitBuffer();
-    GPU_MatrixScale(GPU_GetCurrentMatrix(), sx, sy, sz);
+    GPU_MatrixStack* stack = getCurrentMatrixStack();
+	gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
+    GPU_MatrixScale(peekTopMatrix(stack), sx, sy, sz);
+    touchMatrixStack(stack);
 }
 
 void GPU_Rotate(float degrees, float x, float y, float z)
 {
-	GPU_FlushBlitBuffer();
-    GPU_MatrixRotate(GPU_GetCurrentMatrix(), degrees, x, y, z);
+    GPU_MatrixStack* stack = getCurrentMatrixStack();
+	gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
+    GPU_MatrixRotate(peekTopMatrix(stack), degrees, x, y, z);
+    touchMatrixStack(stack);
 }
 
 void GPU_MultMatrix(const float* A)
 {
-    float* result = GPU_GetCurrentMatrix();
+    GPU_MatrixStack* stack = getCurrentMatrixStack();
+    float* result = peekTopMatrix(stack);
     if(result == NULL)
         return;
-	GPU_FlushBlitBuffer();
+	gpu_flush_blit_buffer_for(GPU_FLUSH_MATRIX_CHANGE);
     GPU_MultiplyAndAssign(result, A);
+    touchMatrixStack(stack);
 }
 
 void GPU_GetModelViewProjection(float* result)
+{
+    GPU_Target* target = GPU_GetActiveTarget();
+    if(target == NULL || result == NULL)
+        return;
+    
+    // MVP = P * V * M
+    GPU_MatrixMultiply(result, peekTopMatrix(&target->projection_matrix), peekTopMatrix(&target->view_matrix));
+    GPU_MultiplyAndAssign(result, peekTopMatrix(&target->model_matrix));
+}
+
+// The view matrix that the target's camera stands for.  Shared by the renderers and the tilemap culling.
+void gpu_get_camera_matrix(GPU_Target* target, float* result)
+{
+	float offsetX, offsetY;
+
+    GPU_MatrixIdentity(result);
+
+    GPU_MatrixTranslate(result, -target->camera.x, -target->camera.y, -target->camera.z);
+    
+    if(target->camera.use_centered_origin)
+    {
+        offsetX = target->w/2.0f;
+        offsetY = target->h/2.0f;
+        GPU_MatrixTranslate(result, offsetX, offsetY, 0);
+    }
+    
+    GPU_MatrixRotate(result, target->camera.angle, 0, 0, 1);
+    GPU_MatrixScale(result, target->camera.zoom_x, target->camera.zoom_y, 1.0f);
+    
+    if(target->camera.use_centered_origin)
+        GPU_MatrixTranslate(result, -offsetX, -offsetY, 0);
+}
+
+// The model-view-projection that the target is drawn with, camera included
+void gpu_get_modelviewprojection(GPU_Target* target, float* result)
 {
     // MVP = P * V * M
-    GPU_MatrixMultiply(result, GPU_GetProjection(), GPU_GetView());
-    GPU_MultiplyAndAssign(result, GPU_GetModel());
+    GPU_MatrixCopy(result, peekTopMatrix(&target->projection_matrix));
+
+    if(target->use_camera)
+    {
+        float cam_matrix[16];
+        gpu_get_camera_matrix(target, cam_matrix);
+
+        GPU_MultiplyAndAssign(result, cam_matrix);
+    }
+    else
+    {
+        GPU_MultiplyAndAssign(result, peekTopMatrix(&target->view_matrix));
+    }
+
+    GPU_MultiplyAndAssign(result, peekTopMatrix(&target->model_matrix));
 }
@@ -0,0 +1,378 @@
+#include "SDL_gpu.h"
+#include <math.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+// Disable warning: selection for inlining
+#pragma warning(disable: 4514 4711)
+// Disable warning: Spectre mitigation
+#pragma warning(disable: 5045)
+#endif
+
+#ifdef SDL_GPU_USE_SDL2
+    #define GET_ALPHA(sdl_color) ((sdl_color).a)
+#else
+    #define GET_ALPHA(sdl_color) ((sdl_color).unused)
+#endif
+
+#define RAD_PER_DEG 0.017453293f
+
+// Floats per vertex: [x, y, s, t, r, g, b, a] for images, [x, y, r, g, b, a] for shapes
+#define GPU_RECORDER_IMAGE_FLOATS 8
+#define GPU_RECORDER_SHAPE_FLOATS 6
+
+// Runs are split at this many vertices, so renderers with 16-bit indices can draw each one
+#define GPU_RECORDER_MAX_RUN_VERTICES 65536
+
+/* Recorders never touch GL, the current renderer, or the error queue, so any thread can fill one.
+Submitting them is the only part that has to happen on the rendering thread. */
+
+// Consecutive draws with the same image, which go out as one primitive batch
+typedef struct GPU_RecordedRun
+{
+    GPU_Image* image;
+    unsigned int first_float;
+    unsigned int num_vertices;
+    unsigned int first_index;
+    unsigned int num_indices;
+} GPU_RecordedRun;
+
+struct GPU_Recorder
+{
+    GPU_RecordedRun* runs;
+    unsigned int num_runs;
+    unsigned int max_num_runs;
+
+    float* vertices;
+    unsigned int num_floats;
+    unsigned int max_num_floats;
+
+    unsigned int* indices;  // Relative to the first vertex of their run
+    unsigned int num_indices;
+    unsigned int max_num_indices;
+};
+
+
+static GPU_bool growRecorderStorage(void** storage, unsigned int* max_count, unsigned int count, size_t element_size)
+{
+    unsigned int new_max_count;
+    void* new_storage;
+
+    if(count <= *max_count)
+        return GPU_TRUE;
+
+    new_max_count = (*max_count == 0? 256 : *max_count);
+    while(new_max_count < count)
+        new_max_count *= 2;
+
+    new_storage = SDL_realloc(*storage, new_max_count * element_size);
+    if(new_storage == NULL)
+        return GPU_FALSE;
+
+    *storage = new_storage;
+    *max_count = new_max_count;
+    return GPU_TRUE;
+}
+
+// Makes room for a draw and returns the run it goes into, or NULL if it doesn't fit in memory
+static GPU_RecordedRun* beginRecordedDraw(GPU_Recorder* recorder, GPU_Image* image, unsigned int num_vertices, unsigned int num_indices)
+{
+    unsigned int floats_per_vertex = (image != NULL? GPU_RECORDER_IMAGE_FLOATS : GPU_RECORDER_SHAPE_FLOATS);
+    GPU_RecordedRun* run;
+
+    if(!growRecorderStorage((void**)&recorder->vertices, &recorder->max_num_floats, recorder->num_floats + num_vertices*floats_per_vertex, sizeof(float))
+       || !growRecorderStorage((void**)&recorder->indices, &recorder->max_num_indices, recorder->num_indices + num_indices, sizeof(unsigned int)))
+        return NULL;
+
+    if(recorder->num_runs > 0)
+    {
+        run = &recorder->runs[recorder->num_runs-1];
+        if(run->image == image && run->num_vertices + num_vertices <= GPU_RECORDER_MAX_RUN_VERTICES)
+            return run;
+    }
+
+    if(!growRecorderStorage((void**)&recorder->runs, &recorder->max_num_runs, recorder->num_runs + 1, sizeof(GPU_RecordedRun)))
+        return NULL;
+
+    run = &recorder->runs[recorder->num_runs++];
+    run->image = image;
+    run->first_float = recorder->num_floats;
+    run->num_vertices = 0;
+    run->first_index = recorder->num_indices;
+    run->num_indices = 0;
+    return run;
+}
+
+static void addRecordedQuadIndices(GPU_Recorder* recorder, GPU_RecordedRun* run)
+{
+    unsigned int* indices = recorder->indices + recorder->num_indices;
+    unsigned int base = run->num_vertices;
+
+    indices[0] = base;
+    indices[1] = base + 1;
+    indices[2] = base + 2;
+    indices[3] = base;
+    indices[4] = base + 2;
+    indices[5] = base + 3;
+
+    recorder->num_indices += 6;
+    run->num_indices += 6;
+}
+
+static void addRecordedShapeVertex(GPU_Recorder* recorder, float x, float y, SDL_Color color)
+{
+    float* v = recorder->vertices + recorder->num_floats;
+    v[0] = x;
+    v[1] = y;
+    v[2] = color.r/255.0f;
+    v[3] = color.g/255.0f;
+    v[4] = color.b/255.0f;
+    v[5] = GET_ALPHA(color)/255.0f;
+    recorder->num_floats += GPU_RECORDER_SHAPE_FLOATS;
+}
+
+
+GPU_Recorder* GPU_CreateRecorder(void)
+{
+    GPU_Recorder* recorder = (GPU_Recorder*)SDL_malloc(sizeof(GPU_Recorder));
+    if(recorder == NULL)
+        return NULL;
+
+    memset(recorder, 0, sizeof(GPU_Recorder));
+    return recorder;
+}
+
+void GPU_FreeRecorder(GPU_Recorder* recorder)
+{
+    if(recorder == NULL)
+        return;
+
+    SDL_free(recorder->runs);
+    SDL_free(recorder->vertices);
+    SDL_free(recorder->indices);
+    SDL_free(recorder);
+}
+
+void GPU_ResetRecorder(GPU_Recorder* recorder)
+{
+    if(recorder == NULL)
+        return;
+
+    // Keep the storage for the next frame
+    recorder->num_runs = 0;
+    recorder->num_floats = 0;
+    recorder->num_indices = 0;
+}
+
+GPU_bool GPU_RecordBlit(GPU_Recorder* recorder, GPU_Image* image, GPU_Rect* src_rect, float x, float y)
+{
+    float w, h;
+    if(image == NULL)
+        return GPU_FALSE;
+
+    w = (src_rect == NULL? image->w : src_rect->w);
+    h = (src_rect == NULL? image->h : src_rect->h);
+    return GPU_RecordBlitTransformX(recorder, image, src_rect, x, y, w*image->anchor_x, h*image->anchor_y, 0.0f, 1.0f, 1.0f);
+}
+
+GPU_bool GPU_RecordBlitTransformX(GPU_Recorder* recorder, GPU_Image* image, GPU_Rect* src_rect, float x, float y, float pivot_x, float pivot_y, float degrees, float scaleX, float scaleY)
+{
+    GPU_RecordedRun* run;
+    float* v;
+    float tex_w, tex_h;
+    float x1, y1, x2, y2;
+    float dx1, dy1, dx2, dy2, dx3, dy3, dx4, dy4;
+    float w, h;
+    float r, g, b, a;
+
+    if(recorder == NULL || image == NULL)
+        return GPU_FALSE;
+
+    // Same vertices as GPU_BlitTransformX() without a target color
+    tex_w = (float)image->texture_w;
+    tex_h = (float)image->texture_h;
+
+    if(image->snap_mode == GPU_SNAP_POSITION || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
+    {
+        x = floorf(x);
+        y = floorf(y);
+    }
+
+    if(src_rect == NULL)
+    {
+        x1 = 0.0f;
+        y1 = 0.0f;
+        x2 = image->w/tex_w;
+        y2 = image->h/tex_h;
+        w = image->w;
+        h = image->h;
+    }
+    else
+    {
+        x1 = src_rect->x/tex_w;
+        y1 = src_rect->y/tex_h;
+        x2 = (src_rect->x + src_rect->w)/tex_w;
+        y2 = (src_rect->y + src_rect->h)/tex_h;
+        w = src_rect->w;
+        h = src_rect->h;
+    }
+
+    if(image->using_virtual_resolution)
+    {
+        x1 *= image->base_w/(float)image->w;
+        y1 *= image->base_h/(float)image->h;
+        x2 *= image->base_w/(float)image->w;
+        y2 *= image->base_h/(float)image->h;
+    }
+
+    dx1 = -pivot_x;
+    dy1 = -pivot_y;
+    dx2 = w - pivot_x;
+    dy2 = h - pivot_y;
+
+    if(image->snap_mode == GPU_SNAP_DIMENSIONS || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
+    {
+        float fractional;
+        fractional = w/2.0f - floorf(w/2.0f);
+        dx1 += fractional;
+        dx2 += fractional;
+        fractional = h/2.0f - floorf(h/2.0f);
+        dy1 += fractional;
+        dy2 += fractional;
+    }
+
+    if(image->renderer != NULL && image->renderer->coordinate_mode == 1)
+    {
+        float temp = dy1;
+        dy1 = dy2;
+        dy2 = temp;
+    }
+
+    dx1 *= scaleX;
+    dy1 *= scaleY;
+    dx2 *= scaleX;
+    dy2 *= scaleY;
+
+    dx3 = dx2;
+    dy3 = dy1;
+    dx4 = dx1;
+    dy4 = dy2;
+
+    if(degrees != 0.0f)
+    {
+        float cosA = cosf(degrees*RAD_PER_DEG);
+        float sinA = sinf(degrees*RAD_PER_DEG);
+        float tempX = dx1;
+        dx1 = dx1*cosA - dy1*sinA;
+        dy1 = tempX*sinA + dy1*cosA;
+        tempX = dx2;
+        dx2 = dx2*cosA - dy2*sinA;
+        dy2 = tempX*sinA + dy2*cosA;
+        tempX = dx3;
+        dx3 = dx3*cosA - dy3*sinA;
+        dy3 = tempX*sinA + dy3*cosA;
+        tempX = dx4;
+        dx4 = dx4*cosA - dy4*sinA;
+        dy4 = tempX*sinA + dy4*cosA;
+    }
+
+    run = beginRecordedDraw(recorder, image, 4, 6);
+    if(run == NULL)
+        return GPU_FALSE;
+
+    r = image->color.r/255.0f;
+    g = image->color.g/255.0f;
+    b = image->color.b/255.0f;
+    a = GET_ALPHA(image->color)/255.0f;
+
+    /*
+        1 --- 3
+        |     |
+        4 --- 2
+    */
+    v = recorder->vertices + recorder->num_floats;
+    v[0] = x + dx1; v[1] = y + dy1; v[2] = x1; v[3] = y1;
+    v[8] = x + dx3; v[9] = y + dy3; v[10] = x2; v[11] = y1;
+    v[16] = x + dx2; v[17] = y + dy2; v[18] = x2; v[19] = y2;
+    v[24] = x + dx4; v[25] = y + dy4; v[26] = x1; v[27] = y2;
+    v[4] = v[12] = v[20] = v[28] = r;
+    v[5] = v[13] = v[21] = v[29] = g;
+    v[6] = v[14] = v[22] = v[30] = b;
+    v[7] = v[15] = v[23] = v[31] = a;
+    recorder->num_floats += 4*GPU_RECORDER_IMAGE_FLOATS;
+
+    addRecordedQuadIndices(recorder, run);
+    run->num_vertices += 4;
+    return GPU_TRUE;
+}
+
+GPU_bool GPU_RecordTriangleFilled(GPU_Recorder* recorder, float x1, float y1, float x2, float y2, float x3, float y3, SDL_Color color)
+{
+    GPU_RecordedRun* run;
+    unsigned int* indices;
+
+    if(recorder == NULL)
+        return GPU_FALSE;
+
+    run = beginRecordedDraw(recorder, NULL, 3, 3);
+    if(run == NULL)
+        return GPU_FALSE;
+
+    addRecordedShapeVertex(recorder, x1, y1, color);
+    addRecordedShapeVertex(recorder, x2, y2, color);
+    addRecordedShapeVertex(recorder, x3, y3, color);
+
+    indices = recorder->indices + recorder->num_indices;
+    indices[0] = run->num_vertices;
+    indices[1] = run->num_vertices + 1;
+    indices[2] = run->num_vertices + 2;
+    recorder->num_indices += 3;
+    run->num_indices += 3;
+    run->num_vertices += 3;
+    return GPU_TRUE;
+}
+
+GPU_bool GPU_RecordRectangleFilled(GPU_Recorder* recorder, float x1, float y1, float x2, float y2, SDL_Color color)
+{
+    GPU_RecordedRun* run;
+
+    if(recorder == NULL)
+        return GPU_FALSE;
+
+    run = beginRecordedDraw(recorder, NULL, 4, 6);
+    if(run == NULL)
+        return GPU_FALSE;
+
+    addRecordedShapeVertex(recorder, x1, y1, color);
+    addRecordedShapeVertex(recorder, x2, y1, color);
+    addRecordedShapeVertex(recorder, x2, y2, color);
+    addRecordedShapeVertex(recorder, x1, y2, color);
+
+    addRecordedQuadIndices(recorder, run);
+    run->num_vertices += 4;
+    return GPU_TRUE;
+}
+
+void GPU_SubmitRecorders(GPU_Target* target, GPU_Recorder** recorders, int num_recorders)
+{
+    int i;
+    unsigned int j;
+
+    if(target == NULL || recorders == NULL)
+        return;
+
+    // Array order, then recording order, so the result doesn't depend on which thread finished first
+    for(i = 0; i < num_recorders; i++)
+    {
+        GPU_Recorder* recorder = recorders[i];
+        if(recorder == NULL)
+            continue;
+
+        for(j = 0; j < recorder->num_runs; j++)
+        {
+            GPU_RecordedRun* run = &recorder->runs[j];
+            GPU_PrimitiveBatchV32(run->image, target, GPU_TRIANGLES, run->num_vertices, recorder->vertices + run->first_float,
+                                  run->num_indices, recorder->indices + run->first_index, (run->image != NULL? GPU_BATCH_XY_ST_RGBA : GPU_BATCH_XY_RGBA));
+        }
+    }
+}
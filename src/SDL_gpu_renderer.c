@@ -13,7 +13,7 @@
 #endif
 
 #define GPU_MAX_ACTIVE_RENDERERS 20
-#define GPU_MAX_REGISTERED_RENDERERS 10
+#define GPU_MAX_REGISTERED_RENDERERS 16
 
 void gpu_init_renderer_register(void);
 void gpu_free_renderer_register(void);
@@ -145,6 +145,10 @@ GPU_Renderer* GPU_CreateRenderer_GLES_2(GPU_RendererID request);
 void GPU_FreeRenderer_GLES_2(GPU_Renderer* renderer);
 GPU_Renderer* GPU_CreateRenderer_GLES_3(GPU_RendererID request);
 void GPU_FreeRenderer_GLES_3(GPU_Renderer* renderer);
+GPU_Renderer* GPU_CreateRenderer_Null(GPU_RendererID request);
+void GPU_FreeRenderer_Null(GPU_Renderer* renderer);
+GPU_Renderer* GPU_CreateRenderer_Software(GPU_RendererID request);
+void GPU_FreeRenderer_Software(GPU_Renderer* renderer);
 
 void GPU_RegisterRenderer(GPU_RendererID id, GPU_Renderer* (*create_renderer)(GPU_RendererID request), void (*free_renderer)(GPU_Renderer* renderer))
 {
@@ -238,6 +242,18 @@ void gpu_register_built_in_renderers(void)
                              &GPU_FreeRenderer_GLES_3);
         #endif
     #endif
+
+    #ifndef SDL_GPU_DISABLE_NULL
+    GPU_RegisterRenderer(GPU_MakeRendererID("Null", GPU_RENDERER_NULL, 1, 0),
+                         &GPU_CreateRenderer_Null,
+                         &GPU_FreeRenderer_Null);
+    #endif
+
+    #ifndef SDL_GPU_DISABLE_SOFTWARE
+    GPU_RegisterRenderer(GPU_MakeRendererID("Software", GPU_RENDERER_SOFTWARE, 1, 0),
+                         &GPU_CreateRenderer_Software,
+                         &GPU_FreeRenderer_Software);
+    #endif
 	
 }
 
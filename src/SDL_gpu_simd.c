@@ -0,0 +1,478 @@
+#include "SDL_gpu.h"
+#include <math.h>
+
+#ifdef _MSC_VER
+// Disable warning: selection for inlining
+#pragma warning(disable: 4514 4711)
+// Disable warning: Spectre mitigation
+#pragma warning(disable: 5045)
+#endif
+
+/* Vectorized vertex generation and software renderer pixel spans, picked at runtime by CPU support.
+   Define SDL_GPU_DISABLE_SIMD to only build the scalar code. */
+
+#ifndef SDL_GPU_DISABLE_SIMD
+    #if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define SDL_GPU_USE_SSE2
+        #include <emmintrin.h>
+    #endif
+
+    // AVX2 is compiled per-function, so it needs compiler support but no build flags
+    #if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)) && defined(SDL_GPU_USE_SDL2) && SDL_VERSION_ATLEAST(2,0,4) \
+        && (defined(_MSC_VER) || defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+        #define SDL_GPU_USE_AVX2
+        #include <immintrin.h>
+        #if defined(__GNUC__) || defined(__clang__)
+            #define GPU_TARGET_AVX2 __attribute__((target("avx2")))
+        #else
+            #define GPU_TARGET_AVX2
+        #endif
+    #endif
+
+    #if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define SDL_GPU_USE_NEON
+        #include <arm_neon.h>
+    #endif
+#endif
+
+#define GPU_RAD_PER_DEG 0.017453292519943f
+
+// Minimax coefficients for sin() and cos() on [-pi/4, pi/4] (from Cephes)
+#define GPU_SIN_C1 -1.6666654611e-1f
+#define GPU_SIN_C2 8.3321608736e-3f
+#define GPU_SIN_C3 -1.9515295891e-4f
+#define GPU_COS_C1 4.166664568298827e-2f
+#define GPU_COS_C2 -1.388731625493765e-3f
+#define GPU_COS_C3 2.443315711809948e-5f
+
+
+typedef void (*GPU_TransformQuadsFn)(unsigned int num_quads, const float* x, const float* y, const float* degrees, const float* scale_x, const float* scale_y,
+                                     const float* left, const float* top, const float* right, const float* bottom, float* corners_x, float* corners_y);
+
+
+// Same math as BlitTransformX(), one quad at a time.
+static void transformQuadsScalar(unsigned int num_quads, const float* x, const float* y, const float* degrees, const float* scale_x, const float* scale_y,
+                                 const float* left, const float* top, const float* right, const float* bottom, float* corners_x, float* corners_y)
+{
+    unsigned int i;
+    for(i = 0; i < num_quads; i++)
+    {
+        float c = cosf(degrees[i]*GPU_RAD_PER_DEG);
+        float s = sinf(degrees[i]*GPU_RAD_PER_DEG);
+        float l = left[i]*scale_x[i];
+        float r = right[i]*scale_x[i];
+        float t = top[i]*scale_y[i];
+        float b = bottom[i]*scale_y[i];
+
+        corners_x[i] = x[i] + l*c - t*s;
+        corners_y[i] = y[i] + l*s + t*c;
+        corners_x[num_quads + i] = x[i] + r*c - t*s;
+        corners_y[num_quads + i] = y[i] + r*s + t*c;
+        corners_x[2*num_quads + i] = x[i] + r*c - b*s;
+        corners_y[2*num_quads + i] = y[i] + r*s + b*c;
+        corners_x[3*num_quads + i] = x[i] + l*c - b*s;
+        corners_y[3*num_quads + i] = y[i] + l*s + b*c;
+    }
+}
+
+/* The vector versions reduce the angle to [-45, 45] degrees by quadrant (exact, since 90 is representable), then evaluate the polynomials.
+   For quadrant q: q&1 swaps sin and cos, q&2 negates sin, and (q+1)&2 negates cos. */
+
+#ifdef SDL_GPU_USE_SSE2
+static void transformQuadsSSE2(unsigned int num_quads, const float* x, const float* y, const float* degrees, const float* scale_x, const float* scale_y,
+                               const float* left, const float* top, const float* right, const float* bottom, float* corners_x, float* corners_y)
+{
+    unsigned int i;
+    unsigned int num_vectors = num_quads & ~3u;
+    const __m128 sign_bit = _mm_set1_ps(-0.0f);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+
+    for(i = 0; i < num_vectors; i += 4)
+    {
+        __m128 deg = _mm_loadu_ps(degrees + i);
+        __m128i q = _mm_cvtps_epi32(_mm_mul_ps(deg, _mm_set1_ps(1.0f/90.0f)));  // Rounds to nearest
+        __m128 rad = _mm_mul_ps(_mm_sub_ps(deg, _mm_mul_ps(_mm_cvtepi32_ps(q), _mm_set1_ps(90.0f))), _mm_set1_ps(GPU_RAD_PER_DEG));
+        __m128 z = _mm_mul_ps(rad, rad);
+        __m128 ps, pc, swap, s, c, px, py, l, r, t, b, lc, ls, rc, rs, tc, ts, bc, bs;
+
+        ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(GPU_SIN_C3), z), _mm_set1_ps(GPU_SIN_C2));
+        ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(GPU_SIN_C1));
+        ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), rad), rad);
+
+        pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(GPU_COS_C3), z), _mm_set1_ps(GPU_COS_C2));
+        pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(GPU_COS_C1));
+        pc = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_mul_ps(pc, z), z), _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+        swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+        s = _mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps));
+        c = _mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc));
+        s = _mm_xor_ps(s, _mm_and_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, two), two)), sign_bit));
+        c = _mm_xor_ps(c, _mm_and_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), two)), sign_bit));
+
+        px = _mm_loadu_ps(x + i);
+        py = _mm_loadu_ps(y + i);
+        l = _mm_mul_ps(_mm_loadu_ps(left + i), _mm_loadu_ps(scale_x + i));
+        r = _mm_mul_ps(_mm_loadu_ps(right + i), _mm_loadu_ps(scale_x + i));
+        t = _mm_mul_ps(_mm_loadu_ps(top + i), _mm_loadu_ps(scale_y + i));
+        b = _mm_mul_ps(_mm_loadu_ps(bottom + i), _mm_loadu_ps(scale_y + i));
+        lc = _mm_mul_ps(l, c);
+        ls = _mm_mul_ps(l, s);
+        rc = _mm_mul_ps(r, c);
+        rs = _mm_mul_ps(r, s);
+        tc = _mm_mul_ps(t, c);
+        ts = _mm_mul_ps(t, s);
+        bc = _mm_mul_ps(b, c);
+        bs = _mm_mul_ps(b, s);
+
+        _mm_storeu_ps(corners_x + i, _mm_add_ps(px, _mm_sub_ps(lc, ts)));
+        _mm_storeu_ps(corners_y + i, _mm_add_ps(py, _mm_add_ps(ls, tc)));
+        _mm_storeu_ps(corners_x + num_quads + i, _mm_add_ps(px, _mm_sub_ps(rc, ts)));
+        _mm_storeu_ps(corners_y + num_quads + i, _mm_add_ps(py, _mm_add_ps(rs, tc)));
+        _mm_storeu_ps(corners_x + 2*num_quads + i, _mm_add_ps(px, _mm_sub_ps(rc, bs)));
+        _mm_storeu_ps(corners_y + 2*num_quads + i, _mm_add_ps(py, _mm_add_ps(rs, bc)));
+        _mm_storeu_ps(corners_x + 3*num_quads + i, _mm_add_ps(px, _mm_sub_ps(lc, bs)));
+        _mm_storeu_ps(corners_y + 3*num_quads + i, _mm_add_ps(py, _mm_add_ps(ls, bc)));
+    }
+
+    // The rest, with the outputs still laid out for num_quads
+    for(; i < num_quads; i++)
+    {
+        float cx[4], cy[4];
+        int k;
+        transformQuadsScalar(1, x + i, y + i, degrees + i, scale_x + i, scale_y + i, left + i, top + i, right + i, bottom + i, cx, cy);
+        for(k = 0; k < 4; k++)
+        {
+            corners_x[k*num_quads + i] = cx[k];
+            corners_y[k*num_quads + i] = cy[k];
+        }
+    }
+}
+#endif
+
+#ifdef SDL_GPU_USE_AVX2
+GPU_TARGET_AVX2 static void transformQuadsAVX2(unsigned int num_quads, const float* x, const float* y, const float* degrees, const float* scale_x, const float* scale_y,
+                                               const float* left, const float* top, const float* right, const float* bottom, float* corners_x, float* corners_y)
+{
+    unsigned int i;
+    unsigned int num_vectors = num_quads & ~7u;
+    const __m256 sign_bit = _mm256_set1_ps(-0.0f);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i two = _mm256_set1_epi32(2);
+
+    for(i = 0; i < num_vectors; i += 8)
+    {
+        __m256 deg = _mm256_loadu_ps(degrees + i);
+        __m256i q = _mm256_cvtps_epi32(_mm256_mul_ps(deg, _mm256_set1_ps(1.0f/90.0f)));  // Rounds to nearest
+        __m256 rad = _mm256_mul_ps(_mm256_sub_ps(deg, _mm256_mul_ps(_mm256_cvtepi32_ps(q), _mm256_set1_ps(90.0f))), _mm256_set1_ps(GPU_RAD_PER_DEG));
+        __m256 z = _mm256_mul_ps(rad, rad);
+        __m256 ps, pc, swap, s, c, px, py, l, r, t, b, lc, ls, rc, rs, tc, ts, bc, bs;
+
+        ps = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(GPU_SIN_C3), z), _mm256_set1_ps(GPU_SIN_C2));
+        ps = _mm256_add_ps(_mm256_mul_ps(ps, z), _mm256_set1_ps(GPU_SIN_C1));
+        ps = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(ps, z), rad), rad);
+
+        pc = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(GPU_COS_C3), z), _mm256_set1_ps(GPU_COS_C2));
+        pc = _mm256_add_ps(_mm256_mul_ps(pc, z), _mm256_set1_ps(GPU_COS_C1));
+        pc = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(pc, z), z), _mm256_mul_ps(z, _mm256_set1_ps(0.5f))), _mm256_set1_ps(1.0f));
+
+        swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, one), one));
+        s = _mm256_blendv_ps(ps, pc, swap);
+        c = _mm256_blendv_ps(pc, ps, swap);
+        s = _mm256_xor_ps(s, _mm256_and_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, two), two)), sign_bit));
+        c = _mm256_xor_ps(c, _mm256_and_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_add_epi32(q, one), two), two)), sign_bit));
+
+        px = _mm256_loadu_ps(x + i);
+        py = _mm256_loadu_ps(y + i);
+        l = _mm256_mul_ps(_mm256_loadu_ps(left + i), _mm256_loadu_ps(scale_x + i));
+        r = _mm256_mul_ps(_mm256_loadu_ps(right + i), _mm256_loadu_ps(scale_x + i));
+        t = _mm256_mul_ps(_mm256_loadu_ps(top + i), _mm256_loadu_ps(scale_y + i));
+        b = _mm256_mul_ps(_mm256_loadu_ps(bottom + i), _mm256_loadu_ps(scale_y + i));
+        lc = _mm256_mul_ps(l, c);
+        ls = _mm256_mul_ps(l, s);
+        rc = _mm256_mul_ps(r, c);
+        rs = _mm256_mul_ps(r, s);
+        tc = _mm256_mul_ps(t, c);
+        ts = _mm256_mul_ps(t, s);
+        bc = _mm256_mul_ps(b, c);
+        bs = _mm256_mul_ps(b, s);
+
+        _mm256_storeu_ps(corners_x + i, _mm256_add_ps(px, _mm256_sub_ps(lc, ts)));
+        _mm256_storeu_ps(corners_y + i, _mm256_add_ps(py, _mm256_add_ps(ls, tc)));
+        _mm256_storeu_ps(corners_x + num_quads + i, _mm256_add_ps(px, _mm256_sub_ps(rc, ts)));
+        _mm256_storeu_ps(corners_y + num_quads + i, _mm256_add_ps(py, _mm256_add_ps(rs, tc)));
+        _mm256_storeu_ps(corners_x + 2*num_quads + i, _mm256_add_ps(px, _mm256_sub_ps(rc, bs)));
+        _mm256_storeu_ps(corners_y + 2*num_quads + i, _mm256_add_ps(py, _mm256_add_ps(rs, bc)));
+        _mm256_storeu_ps(corners_x + 3*num_quads + i, _mm256_add_ps(px, _mm256_sub_ps(lc, bs)));
+        _mm256_storeu_ps(corners_y + 3*num_quads + i, _mm256_add_ps(py, _mm256_add_ps(ls, bc)));
+    }
+
+    // Leave the upper halves of the registers clean before any SSE code runs
+    _mm256_zeroupper();
+
+    for(; i < num_quads; i++)
+    {
+        float cx[4], cy[4];
+        int k;
+        transformQuadsScalar(1, x + i, y + i, degrees + i, scale_x + i, scale_y + i, left + i, top + i, right + i, bottom + i, cx, cy);
+        for(k = 0; k < 4; k++)
+        {
+            corners_x[k*num_quads + i] = cx[k];
+            corners_y[k*num_quads + i] = cy[k];
+        }
+    }
+}
+#endif
+
+#ifdef SDL_GPU_USE_NEON
+static void transformQuadsNEON(unsigned int num_quads, const float* x, const float* y, const float* degrees, const float* scale_x, const float* scale_y,
+                               const float* left, const float* top, const float* right, const float* bottom, float* corners_x, float* corners_y)
+{
+    unsigned int i;
+    unsigned int num_vectors = num_quads & ~3u;
+    const uint32x4_t sign_bit = vdupq_n_u32(0x80000000u);
+    const int32x4_t one = vdupq_n_s32(1);
+    const int32x4_t two = vdupq_n_s32(2);
+
+    for(i = 0; i < num_vectors; i += 4)
+    {
+        float32x4_t deg = vld1q_f32(degrees + i);
+        float32x4_t quadrants = vmulq_n_f32(deg, 1.0f/90.0f);
+        // Round half away from zero (vcvtnq is ARMv8-only)
+        float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(vreinterpretq_u32_f32(quadrants), sign_bit), vreinterpretq_u32_f32(vdupq_n_f32(0.5f))));
+        int32x4_t q = vcvtq_s32_f32(vaddq_f32(quadrants, half));
+        float32x4_t rad = vmulq_n_f32(vsubq_f32(deg, vmulq_n_f32(vcvtq_f32_s32(q), 90.0f)), GPU_RAD_PER_DEG);
+        float32x4_t z = vmulq_f32(rad, rad);
+        float32x4_t ps, pc, s, c, px, py, l, r, t, b, lc, ls, rc, rs, tc, ts, bc, bs;
+        uint32x4_t swap;
+
+        ps = vaddq_f32(vmulq_n_f32(z, GPU_SIN_C3), vdupq_n_f32(GPU_SIN_C2));
+        ps = vaddq_f32(vmulq_f32(ps, z), vdupq_n_f32(GPU_SIN_C1));
+        ps = vaddq_f32(vmulq_f32(vmulq_f32(ps, z), rad), rad);
+
+        pc = vaddq_f32(vmulq_n_f32(z, GPU_COS_C3), vdupq_n_f32(GPU_COS_C2));
+        pc = vaddq_f32(vmulq_f32(pc, z), vdupq_n_f32(GPU_COS_C1));
+        pc = vaddq_f32(vsubq_f32(vmulq_f32(vmulq_f32(pc, z), z), vmulq_n_f32(z, 0.5f)), vdupq_n_f32(1.0f));
+
+        swap = vceqq_s32(vandq_s32(q, one), one);
+        s = vbslq_f32(swap, pc, ps);
+        c = vbslq_f32(swap, ps, pc);
+        s = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(s), vandq_u32(vceqq_s32(vandq_s32(q, two), two), sign_bit)));
+        c = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(c), vandq_u32(vceqq_s32(vandq_s32(vaddq_s32(q, one), two), two), sign_bit)));
+
+        px = vld1q_f32(x + i);
+        py = vld1q_f32(y + i);
+        l = vmulq_f32(vld1q_f32(left + i), vld1q_f32(scale_x + i));
+        r = vmulq_f32(vld1q_f32(right + i), vld1q_f32(scale_x + i));
+        t = vmulq_f32(vld1q_f32(top + i), vld1q_f32(scale_y + i));
+        b = vmulq_f32(vld1q_f32(bottom + i), vld1q_f32(scale_y + i));
+        lc = vmulq_f32(l, c);
+        ls = vmulq_f32(l, s);
+        rc = vmulq_f32(r, c);
+        rs = vmulq_f32(r, s);
+        tc = vmulq_f32(t, c);
+        ts = vmulq_f32(t, s);
+        bc = vmulq_f32(b, c);
+        bs = vmulq_f32(b, s);
+
+        vst1q_f32(corners_x + i, vaddq_f32(px, vsubq_f32(lc, ts)));
+        vst1q_f32(corners_y + i, vaddq_f32(py, vaddq_f32(ls, tc)));
+        vst1q_f32(corners_x + num_quads + i, vaddq_f32(px, vsubq_f32(rc, ts)));
+        vst1q_f32(corners_y + num_quads + i, vaddq_f32(py, vaddq_f32(rs, tc)));
+        vst1q_f32(corners_x + 2*num_quads + i, vaddq_f32(px, vsubq_f32(rc, bs)));
+        vst1q_f32(corners_y + 2*num_quads + i, vaddq_f32(py, vaddq_f32(rs, bc)));
+        vst1q_f32(corners_x + 3*num_quads + i, vaddq_f32(px, vsubq_f32(lc, bs)));
+        vst1q_f32(corners_y + 3*num_quads + i, vaddq_f32(py, vaddq_f32(ls, bc)));
+    }
+
+    for(; i < num_quads; i++)
+    {
+        float cx[4], cy[4];
+        int k;
+        transformQuadsScalar(1, x + i, y + i, degrees + i, scale_x + i, scale_y + i, left + i, top + i, right + i, bottom + i, cx, cy);
+        for(k = 0; k < 4; k++)
+        {
+            corners_x[k*num_quads + i] = cx[k];
+            corners_y[k*num_quads + i] = cy[k];
+        }
+    }
+}
+#endif
+
+
+static GPU_TransformQuadsFn gpu_transform_quads_impl = NULL;
+
+static GPU_TransformQuadsFn gpu_select_transform_quads(void)
+{
+    #ifdef SDL_GPU_USE_AVX2
+    if(SDL_HasAVX2())
+        return &transformQuadsAVX2;
+    #endif
+    #ifdef SDL_GPU_USE_SSE2
+    if(SDL_HasSSE2())
+        return &transformQuadsSSE2;
+    #endif
+    #ifdef SDL_GPU_USE_NEON
+    // Built for NEON means the CPU has it
+    return &transformQuadsNEON;
+    #endif
+    return &transformQuadsScalar;
+}
+
+/* Transforms the local boxes (left, top, right, bottom) of num_quads quads by scale, then rotation in degrees, then translation to (x, y).
+   All inputs have num_quads entries.  corners_x and corners_y get 4*num_quads entries each, corner-major: corner k of quad i is at [k*num_quads + i].
+   Corners go (left, top), (right, top), (right, bottom), (left, bottom). */
+void gpu_transform_quads(unsigned int num_quads, const float* x, const float* y, const float* degrees, const float* scale_x, const float* scale_y,
+                         const float* left, const float* top, const float* right, const float* bottom, float* corners_x, float* corners_y)
+{
+    // Racing threads would all pick the same function
+    if(gpu_transform_quads_impl == NULL)
+        gpu_transform_quads_impl = gpu_select_transform_quads();
+
+    gpu_transform_quads_impl(num_quads, x, y, degrees, scale_x, scale_y, left, top, right, bottom, corners_x, corners_y);
+}
+
+
+/* Pixel spans for the software renderer.  Pixels are 32-bit with R, G, B, A in memory order, so the alpha byte is
+   always the fourth byte, whatever the endianness. */
+
+typedef void (*GPU_FillSpanFn)(Uint32* dest, Uint32 color, int count);
+typedef void (*GPU_BlendSpanFn)(Uint32* dest, const Uint32* src, int count);
+
+// (x + 128)/255, rounded, for x in [0, 255*255]
+#define GPU_DIV255(x) ((((x) + 128) + (((x) + 128) >> 8)) >> 8)
+
+static void fillSpanScalar(Uint32* dest, Uint32 color, int count)
+{
+    int i;
+    for(i = 0; i < count; i++)
+        dest[i] = color;
+}
+
+// GPU_BLEND_NORMAL: every channel, alpha included, is src*src_alpha + dest*(1 - src_alpha)
+static void blendSpanNormalScalar(Uint32* dest, const Uint32* src, int count)
+{
+    int i, c;
+    for(i = 0; i < count; i++)
+    {
+        const Uint8* s = (const Uint8*)(src + i);
+        Uint8* d = (Uint8*)(dest + i);
+        unsigned int a = s[3];
+
+        if(a == 255)
+            dest[i] = src[i];
+        else if(a != 0)
+        {
+            for(c = 0; c < 4; c++)
+                d[c] = (Uint8)GPU_DIV255(s[c]*a + d[c]*(255 - a));
+        }
+    }
+}
+
+#ifdef SDL_GPU_USE_SSE2
+static void fillSpanSSE2(Uint32* dest, Uint32 color, int count)
+{
+    __m128i c = _mm_set1_epi32((int)color);
+    int i = 0;
+    for(; i + 4 <= count; i += 4)
+        _mm_storeu_si128((__m128i*)(dest + i), c);
+    for(; i < count; i++)
+        dest[i] = color;
+}
+
+// Two pixels per 16-bit lane group
+static __m128i blendNormalSSE2(__m128i s, __m128i d)
+{
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), a)));
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+static void blendSpanNormalSSE2(Uint32* dest, const Uint32* src, int count)
+{
+    __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+        __m128i lo = blendNormalSSE2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+        __m128i hi = blendNormalSSE2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_packus_epi16(lo, hi));
+    }
+    blendSpanNormalScalar(dest + i, src + i, count - i);
+}
+#endif
+
+#ifdef SDL_GPU_USE_NEON
+static void fillSpanNEON(Uint32* dest, Uint32 color, int count)
+{
+    uint32x4_t c = vdupq_n_u32(color);
+    int i = 0;
+    for(; i + 4 <= count; i += 4)
+        vst1q_u32(dest + i, c);
+    for(; i < count; i++)
+        dest[i] = color;
+}
+
+// Eight pixels at a time, split into channels
+static void blendSpanNormalNEON(Uint32* dest, const Uint32* src, int count)
+{
+    uint16x8_t half = vdupq_n_u16(128);
+    int i = 0, c;
+    for(; i + 8 <= count; i += 8)
+    {
+        uint8x8x4_t s = vld4_u8((const uint8_t*)(src + i));
+        uint8x8x4_t d = vld4_u8((const uint8_t*)(dest + i));
+        uint8x8_t a = s.val[3];
+        uint8x8_t inv_a = vmvn_u8(a);
+        for(c = 0; c < 4; c++)
+        {
+            uint16x8_t x = vaddq_u16(vaddq_u16(vmull_u8(s.val[c], a), vmull_u8(d.val[c], inv_a)), half);
+            d.val[c] = vshrn_n_u16(vsraq_n_u16(x, x, 8), 8);
+        }
+        vst4_u8((uint8_t*)(dest + i), d);
+    }
+    blendSpanNormalScalar(dest + i, src + i, count - i);
+}
+#endif
+
+static GPU_FillSpanFn gpu_fill_span_impl = NULL;
+static GPU_BlendSpanFn gpu_blend_span_normal_impl = NULL;
+
+static void gpu_select_span_functions(void)
+{
+    gpu_blend_span_normal_impl = &blendSpanNormalScalar;
+    gpu_fill_span_impl = &fillSpanScalar;
+    #ifdef SDL_GPU_USE_SSE2
+    if(SDL_HasSSE2())
+    {
+        gpu_blend_span_normal_impl = &blendSpanNormalSSE2;
+        gpu_fill_span_impl = &fillSpanSSE2;
+    }
+    #endif
+    #ifdef SDL_GPU_USE_NEON
+    gpu_blend_span_normal_impl = &blendSpanNormalNEON;
+    gpu_fill_span_impl = &fillSpanNEON;
+    #endif
+}
+
+// Sets count pixels of dest to color.
+void gpu_fill_span(Uint32* dest, Uint32 color, int count)
+{
+    // Racing threads would all pick the same functions
+    if(gpu_fill_span_impl == NULL)
+        gpu_select_span_functions();
+
+    gpu_fill_span_impl(dest, color, count);
+}
+
+// Blends count pixels of src over dest with GPU_BLEND_NORMAL.
+void gpu_blend_span_normal(Uint32* dest, const Uint32* src, int count)
+{
+    if(gpu_blend_span_normal_impl == NULL)
+        gpu_select_span_functions();
+
+    gpu_blend_span_normal_impl(dest, src, count);
+}
@@ -0,0 +1,343 @@
+#include "SDL_gpu.h"
+#include <string.h>
+
+#ifdef _MSC_VER
+// Disable warning: selection for inlining
+#pragma warning(disable: 4514 4711)
+// Disable warning: Spectre mitigation
+#pragma warning(disable: 5045)
+#endif
+
+void gpu_get_modelviewprojection(GPU_Target* target, float* result);
+
+// Tiles per chunk side.  A full chunk is 4096 vertices, so it fits renderers that narrow vertex buffer indices to 16 bits.
+#define GPU_TILEMAP_CHUNK_SIZE 32
+#define GPU_TILEMAP_FLOATS_PER_VERTEX 4  // x, y, s, t
+
+/* Each chunk keeps the quads of its non-empty tiles in a vertex buffer, packed to the front so that one draw covers them.
+Changing a tile only marks its chunk, which is rebuilt the next time it is drawn. */
+
+typedef struct GPU_TilemapChunk
+{
+    GPU_VertexBuffer* buffer;  // Created the first time the chunk is drawn
+    unsigned int num_tiles;
+    GPU_bool dirty;
+} GPU_TilemapChunk;
+
+struct GPU_Tilemap
+{
+    GPU_Image* tileset;
+    int tile_w;
+    int tile_h;
+    int columns;
+    int rows;
+    int* tiles;
+
+    int chunk_columns;
+    int chunk_rows;
+    GPU_TilemapChunk* chunks;
+
+    float* scratch;  // Vertices of the chunk being rebuilt
+};
+
+// Every chunk has the same quad pattern, however many of its tiles are used
+static unsigned int gpu_tilemap_indices[GPU_TILEMAP_CHUNK_SIZE*GPU_TILEMAP_CHUNK_SIZE*6];
+static GPU_bool gpu_tilemap_indices_ready = GPU_FALSE;
+
+
+static GPU_TilemapChunk* getTilemapChunk(GPU_Tilemap* tilemap, int column, int row)
+{
+    return &tilemap->chunks[(row / GPU_TILEMAP_CHUNK_SIZE)*tilemap->chunk_columns + column / GPU_TILEMAP_CHUNK_SIZE];
+}
+
+static void markTilemapChunks(GPU_Tilemap* tilemap)
+{
+    int i;
+    for(i = 0; i < tilemap->chunk_columns*tilemap->chunk_rows; i++)
+        tilemap->chunks[i].dirty = GPU_TRUE;
+}
+
+// Fills the chunk's vertex buffer from the tile grid
+static void rebuildTilemapChunk(GPU_Tilemap* tilemap, GPU_TilemapChunk* chunk, int chunk_column, int chunk_row)
+{
+    GPU_Image* tileset = tilemap->tileset;
+    int first_column = chunk_column*GPU_TILEMAP_CHUNK_SIZE;
+    int first_row = chunk_row*GPU_TILEMAP_CHUNK_SIZE;
+    int last_column = first_column + GPU_TILEMAP_CHUNK_SIZE;
+    int last_row = first_row + GPU_TILEMAP_CHUNK_SIZE;
+    int tileset_columns = tileset->w / tilemap->tile_w;
+    int tileset_rows = tileset->h / tilemap->tile_h;
+    float tex_w = (float)tileset->texture_w;
+    float tex_h = (float)tileset->texture_h;
+    float* v = tilemap->scratch;
+    int column, row;
+
+    if(tileset_columns < 1)
+        tileset_columns = 1;
+
+    if(tileset->using_virtual_resolution)
+    {
+        // Scale texture coords to fit the original dims
+        tex_w *= tileset->w/(float)tileset->base_w;
+        tex_h *= tileset->h/(float)tileset->base_h;
+    }
+
+    if(last_column > tilemap->columns)
+        last_column = tilemap->columns;
+    if(last_row > tilemap->rows)
+        last_row = tilemap->rows;
+
+    chunk->num_tiles = 0;
+    for(row = first_row; row < last_row; row++)
+    {
+        for(column = first_column; column < last_column; column++)
+        {
+            int tile = tilemap->tiles[row*tilemap->columns + column];
+            float x1, y1, x2, y2;
+            float s1, t1, s2, t2;
+
+            if(tile < 0 || tile >= tileset_columns*tileset_rows)
+                continue;
+
+            x1 = (float)(column*tilemap->tile_w);
+            y1 = (float)(row*tilemap->tile_h);
+            x2 = x1 + tilemap->tile_w;
+            y2 = y1 + tilemap->tile_h;
+            s1 = (tile % tileset_columns)*tilemap->tile_w/tex_w;
+            t1 = (tile / tileset_columns)*tilemap->tile_h/tex_h;
+            s2 = s1 + tilemap->tile_w/tex_w;
+            t2 = t1 + tilemap->tile_h/tex_h;
+
+            v[0] = x1; v[1] = y1; v[2] = s1; v[3] = t1;
+            v[4] = x2; v[5] = y1; v[6] = s2; v[7] = t1;
+            v[8] = x2; v[9] = y2; v[10] = s2; v[11] = t2;
+            v[12] = x1; v[13] = y2; v[14] = s1; v[15] = t2;
+            v += 4*GPU_TILEMAP_FLOATS_PER_VERTEX;
+            chunk->num_tiles++;
+        }
+    }
+
+    if(chunk->num_tiles > 0)
+        GPU_UpdateVertexBuffer(chunk->buffer, 0, chunk->num_tiles*4, tilemap->scratch);
+    chunk->dirty = GPU_FALSE;
+}
+
+static GPU_bool createTilemapChunkBuffer(GPU_TilemapChunk* chunk)
+{
+    unsigned int* indices = gpu_tilemap_indices;
+    unsigned int i;
+
+    if(!gpu_tilemap_indices_ready)
+    {
+        for(i = 0; i < GPU_TILEMAP_CHUNK_SIZE*GPU_TILEMAP_CHUNK_SIZE; i++)
+        {
+            indices[i*6] = i*4;
+            indices[i*6 + 1] = i*4 + 1;
+            indices[i*6 + 2] = i*4 + 2;
+            indices[i*6 + 3] = i*4;
+            indices[i*6 + 4] = i*4 + 2;
+            indices[i*6 + 5] = i*4 + 3;
+        }
+        gpu_tilemap_indices_ready = GPU_TRUE;
+    }
+
+    chunk->buffer = GPU_CreateVertexBuffer(GPU_BATCH_XY_ST, GPU_TILEMAP_CHUNK_SIZE*GPU_TILEMAP_CHUNK_SIZE*4, NULL, GPU_TILEMAP_CHUNK_SIZE*GPU_TILEMAP_CHUNK_SIZE*6, indices);
+    return (chunk->buffer != NULL);
+}
+
+// Conservatively tests whether the box lands outside of clip space
+static GPU_bool isTilemapChunkVisible(const float* mvp, float min_x, float min_y, float max_x, float max_y)
+{
+    float corners[8];
+    GPU_bool left = GPU_TRUE, right = GPU_TRUE, below = GPU_TRUE, above = GPU_TRUE;
+    int i;
+
+    corners[0] = min_x; corners[1] = min_y;
+    corners[2] = max_x; corners[3] = min_y;
+    corners[4] = max_x; corners[5] = max_y;
+    corners[6] = min_x; corners[7] = max_y;
+
+    for(i = 0; i < 8; i += 2)
+    {
+        // Column-major, with z = 0 and w = 1
+        float clip_x = mvp[0]*corners[i] + mvp[4]*corners[i+1] + mvp[12];
+        float clip_y = mvp[1]*corners[i] + mvp[5]*corners[i+1] + mvp[13];
+        float clip_w = mvp[3]*corners[i] + mvp[7]*corners[i+1] + mvp[15];
+
+        // Behind the eye in a perspective projection.  Don't guess.
+        if(clip_w <= 0.0f)
+            return GPU_TRUE;
+
+        left = left && (clip_x < -clip_w);
+        right = right && (clip_x > clip_w);
+        below = below && (clip_y < -clip_w);
+        above = above && (clip_y > clip_w);
+    }
+
+    return !(left || right || below || above);
+}
+
+// Draws the visible chunks, rebuilding the ones whose tiles changed
+static void drawTilemapChunks(GPU_Tilemap* tilemap, GPU_Target* target)
+{
+    float mvp[16];
+    int chunk_w = GPU_TILEMAP_CHUNK_SIZE*tilemap->tile_w;
+    int chunk_h = GPU_TILEMAP_CHUNK_SIZE*tilemap->tile_h;
+    int column, row;
+
+    gpu_get_modelviewprojection(target, mvp);
+
+    for(row = 0; row < tilemap->chunk_rows; row++)
+    {
+        for(column = 0; column < tilemap->chunk_columns; column++)
+        {
+            GPU_TilemapChunk* chunk = &tilemap->chunks[row*tilemap->chunk_columns + column];
+
+            if(!isTilemapChunkVisible(mvp, (float)(column*chunk_w), (float)(row*chunk_h), (float)((column+1)*chunk_w), (float)((row+1)*chunk_h)))
+                continue;
+
+            // If the renderer can't make this buffer, it won't make the others either
+            if(chunk->buffer == NULL && !createTilemapChunkBuffer(chunk))
+                return;
+            if(chunk->dirty)
+                rebuildTilemapChunk(tilemap, chunk, column, row);
+
+            if(chunk->num_tiles > 0)
+                GPU_DrawVertexBuffer(tilemap->tileset, target, chunk->buffer, GPU_TRIANGLES, 0, chunk->num_tiles*6);
+        }
+    }
+}
+
+
+GPU_Tilemap* GPU_CreateTilemap(GPU_Image* tileset, int tile_w, int tile_h, int columns, int rows)
+{
+    GPU_Tilemap* tilemap;
+    int i;
+
+    if(tileset == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "tileset");
+        return NULL;
+    }
+    if(tile_w <= 0 || tile_h <= 0 || columns <= 0 || rows <= 0)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_DATA_ERROR, "Given invalid dimensions (%dx%d tiles of %dx%d)", columns, rows, tile_w, tile_h);
+        return NULL;
+    }
+
+    tilemap = (GPU_Tilemap*)SDL_malloc(sizeof(GPU_Tilemap));
+    if(tilemap == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_BACKEND_ERROR, "Failed to allocate tilemap");
+        return NULL;
+    }
+    memset(tilemap, 0, sizeof(GPU_Tilemap));
+    tilemap->tileset = tileset;
+    tilemap->tile_w = tile_w;
+    tilemap->tile_h = tile_h;
+    tilemap->columns = columns;
+    tilemap->rows = rows;
+    tilemap->chunk_columns = (columns + GPU_TILEMAP_CHUNK_SIZE - 1) / GPU_TILEMAP_CHUNK_SIZE;
+    tilemap->chunk_rows = (rows + GPU_TILEMAP_CHUNK_SIZE - 1) / GPU_TILEMAP_CHUNK_SIZE;
+
+    tilemap->tiles = (int*)SDL_malloc(columns*rows*sizeof(int));
+    tilemap->chunks = (GPU_TilemapChunk*)SDL_malloc(tilemap->chunk_columns*tilemap->chunk_rows*sizeof(GPU_TilemapChunk));
+    tilemap->scratch = (float*)SDL_malloc(GPU_TILEMAP_CHUNK_SIZE*GPU_TILEMAP_CHUNK_SIZE*4*GPU_TILEMAP_FLOATS_PER_VERTEX*sizeof(float));
+    if(tilemap->tiles == NULL || tilemap->chunks == NULL || tilemap->scratch == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_BACKEND_ERROR, "Failed to allocate tilemap");
+        GPU_FreeTilemap(tilemap);
+        return NULL;
+    }
+
+    for(i = 0; i < columns*rows; i++)
+        tilemap->tiles[i] = -1;
+    memset(tilemap->chunks, 0, tilemap->chunk_columns*tilemap->chunk_rows*sizeof(GPU_TilemapChunk));
+    markTilemapChunks(tilemap);
+    return tilemap;
+}
+
+void GPU_FreeTilemap(GPU_Tilemap* tilemap)
+{
+    int i;
+    if(tilemap == NULL)
+        return;
+
+    if(tilemap->chunks != NULL)
+    {
+        for(i = 0; i < tilemap->chunk_columns*tilemap->chunk_rows; i++)
+            GPU_FreeVertexBuffer(tilemap->chunks[i].buffer);
+    }
+
+    SDL_free(tilemap->tiles);
+    SDL_free(tilemap->chunks);
+    SDL_free(tilemap->scratch);
+    SDL_free(tilemap);
+}
+
+void GPU_SetTile(GPU_Tilemap* tilemap, int column, int row, int tile)
+{
+    int* t;
+    if(tilemap == NULL || column < 0 || row < 0 || column >= tilemap->columns || row >= tilemap->rows)
+        return;
+
+    t = &tilemap->tiles[row*tilemap->columns + column];
+    if(*t == tile)
+        return;
+
+    *t = tile;
+    getTilemapChunk(tilemap, column, row)->dirty = GPU_TRUE;
+}
+
+int GPU_GetTile(GPU_Tilemap* tilemap, int column, int row)
+{
+    if(tilemap == NULL || column < 0 || row < 0 || column >= tilemap->columns || row >= tilemap->rows)
+        return -1;
+
+    return tilemap->tiles[row*tilemap->columns + column];
+}
+
+void GPU_SetTiles(GPU_Tilemap* tilemap, const int* tiles)
+{
+    if(tilemap == NULL || tiles == NULL)
+        return;
+
+    memcpy(tilemap->tiles, tiles, tilemap->columns*tilemap->rows*sizeof(int));
+    markTilemapChunks(tilemap);
+}
+
+void GPU_DrawTilemap(GPU_Tilemap* tilemap, GPU_Target* target, float x, float y)
+{
+    float saved_model[16];
+    float* model;
+    GPU_bool moved;
+
+    if(tilemap == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "tilemap");
+        return;
+    }
+    if(target == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+
+    // The chunks are built at the origin, so a position goes in the target's model matrix.
+    // That is changed directly rather than through the matrix mode, which would also switch the active target.
+    moved = (x != 0.0f || y != 0.0f);
+    if(moved)
+    {
+        // Blits already waiting were positioned with the old matrix
+        GPU_FlushBlitBuffer();
+
+        model = GPU_GetTopMatrix(&target->model_matrix);
+        GPU_MatrixCopy(saved_model, model);
+        GPU_MatrixTranslate(model, x, y, 0.0f);
+    }
+
+    drawTilemapChunks(tilemap, target);
+
+    if(moved)
+        GPU_MatrixCopy(GPU_GetTopMatrix(&target->model_matrix), saved_model);
+}
@@ -0,0 +1,3415 @@
+/* This is an implementation file to be included after certain #defines have been set.
+See a particular renderer's *.c file for specifics.
+
+The CPU renderers do all of the CPU-side work of the GL renderers without a GPU or a GL context.
+They track render state, build the blit buffer, tessellate shapes, and build the model-view-projection matrix for
+every flush.  Shapes, culling, and the state that doesn't touch GL use the same code as the GL renderers
+(renderer_shapes_GL_common.inl and renderer_common.inl).  Flushes, draw calls, and state changes are counted in the
+context's GPU_FrameStats like they are with GL.
+
+Without SDL_GPU_CPU_RASTERIZE, nothing is ever drawn and images and targets have no pixels (reads give transparent
+black).  With it, images and targets are backed by SDL_Surfaces and each flush goes to rasterizeVertices(). */
+
+#define SDL_GPU_SKIP_LINE_WIDTH
+
+#include "SDL_platform.h"
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+// Disable warning: selection for inlining
+#pragma warning(disable: 4514 4711 4710)
+// Disable warning: Spectre mitigation
+#pragma warning(disable: 5045)
+#endif
+
+#ifndef PI
+#define PI 3.1415926f
+#endif
+
+#define RAD_PER_DEG 0.017453293f
+#define DEG_PER_RAD 57.2957795f
+
+// Visual C does not support static inline
+#ifndef static_inline
+    #ifdef _MSC_VER
+		#define static_inline static
+    #else
+        #define static_inline static inline
+    #endif
+#endif
+
+#if defined ( WIN32 ) && defined(_MSC_VER)
+#define __func__ __FUNCTION__
+#endif
+
+#ifdef SDL_GPU_USE_SDL2
+#define GET_ALPHA(sdl_color) ((sdl_color).a)
+#else
+#define GET_ALPHA(sdl_color) ((sdl_color).unused)
+#endif
+
+#define MAX(a, b) ((a) > (b)? (a) : (b))
+#define MIN(a, b) ((a) < (b)? (a) : (b))
+
+Uint32 gpu_next_matrix_generation(void);
+void gpu_get_modelviewprojection(GPU_Target* target, float* result);
+float* gpu_peek_top_matrix(GPU_MatrixStack* stack);
+void gpu_transform_quads(unsigned int num_quads, const float* x, const float* y, const float* degrees, const float* scale_x, const float* scale_y,
+                         const float* left, const float* top, const float* right, const float* bottom, float* corners_x, float* corners_y);
+
+
+// Primitive types, as the shared shape code names them (same values as GPU_PrimitiveEnum)
+#define GL_POINTS 0x0000
+#define GL_LINES 0x0001
+#define GL_LINE_LOOP 0x0002
+#define GL_LINE_STRIP 0x0003
+#define GL_TRIANGLES 0x0004
+#define GL_TRIANGLE_STRIP 0x0005
+#define GL_TRIANGLE_FAN 0x0006
+
+// The GL renderers' blit buffer layout: x, y, s, t, r, g, b, a
+#define GPU_BLIT_BUFFER_VERTICES_PER_SPRITE 4
+#define GPU_BLIT_BUFFER_INIT_MAX_NUM_VERTICES (GPU_BLIT_BUFFER_VERTICES_PER_SPRITE*1000)
+#define GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES 60000
+#define GPU_INDEX_BUFFER_ABSOLUTE_MAX_VERTICES 4000000000u
+#define GPU_BLIT_INDEX_TYPE unsigned short
+#define GPU_BLIT_BUFFER_FLOATS_PER_VERTEX 8
+#define GPU_BLIT_BUFFER_STRIDE (sizeof(float)*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX)
+#define GPU_BLIT_BUFFER_VERTEX_OFFSET 0
+#define GPU_BLIT_BUFFER_TEX_COORD_OFFSET 2
+#define GPU_BLIT_BUFFER_COLOR_OFFSET 4
+
+// Sprites transformed per call to gpu_transform_quads()
+#define GPU_TRANSFORM_BATCH_CHUNK 64
+
+
+static char shader_message[256];
+
+
+static_inline Uint32 nextObjectID(GPU_CONTEXT_DATA* cdata)
+{
+    return cdata->next_object_id++;
+}
+
+// Looks up the size of a real window, if the context is attached to one
+static GPU_bool get_window_dimensions(Uint32 windowID, int* w, int* h)
+{
+    #ifdef SDL_GPU_USE_SDL2
+    SDL_Window* window = (windowID == 0? NULL : SDL_GetWindowFromID(windowID));
+    if(window == NULL)
+        return GPU_FALSE;
+    SDL_GetWindowSize(window, w, h);
+    return GPU_TRUE;
+    #else
+    SDL_Surface* screen = (windowID == 1? SDL_GetVideoSurface() : NULL);
+    if(screen == NULL)
+        return GPU_FALSE;
+    *w = screen->w;
+    *h = screen->h;
+    return GPU_TRUE;
+    #endif
+}
+
+// Pixels are stored as 32-bit surfaces with the bytes in R, G, B, A order
+static SDL_Surface* createBlankSurface(int w, int h)
+{
+    Uint32 rmask, gmask, bmask, amask;
+    #if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    rmask = 0xff000000;
+    gmask = 0x00ff0000;
+    bmask = 0x0000ff00;
+    amask = 0x000000ff;
+    #else
+    rmask = 0x000000ff;
+    gmask = 0x0000ff00;
+    bmask = 0x00ff0000;
+    amask = 0xff000000;
+    #endif
+
+    // Zeroed, so transparent black
+    return SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, 32, rmask, gmask, bmask, amask);
+}
+
+#ifdef SDL_GPU_CPU_RASTERIZE
+
+// Provided by the rasterizing renderer
+static void createRasterizer(GPU_CONTEXT_DATA* cdata);
+static void freeRasterizer(GPU_CONTEXT_DATA* cdata);
+static void rasterizeVertices(GPU_Renderer* renderer, GPU_Target* dest, GPU_Image* image, unsigned int shape,
+                              const float* vertices, unsigned int num_vertices, const void* indices, int index_size, unsigned int num_indices);
+
+void gpu_fill_span(Uint32* dest, Uint32 color, int count);
+
+static_inline Uint32 packPixel(Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    Uint32 result;
+    Uint8* bytes = (Uint8*)&result;
+    bytes[0] = r;
+    bytes[1] = g;
+    bytes[2] = b;
+    bytes[3] = a;
+    return result;
+}
+
+static_inline Uint32* getPixelRow(SDL_Surface* surface, int y)
+{
+    return (Uint32*)((Uint8*)surface->pixels + y*surface->pitch);
+}
+
+// The surface that the target draws into
+static SDL_Surface* getTargetSurface(GPU_Target* target)
+{
+    if(target->image != NULL)
+        return ((GPU_IMAGE_DATA*)target->image->data)->pixels;
+    if(target->context != NULL)
+        return ((GPU_CONTEXT_DATA*)target->context->data)->framebuffer;
+    return NULL;
+}
+
+/* Converts a row of pixels in the given format to R, G, B, A bytes, as the GL renderers would sample them.
+   Only the luminance plane of YCbCr data is kept. */
+static void convertRowToRGBA(GPU_FormatEnum format, const Uint8* src, Uint8* dst, int count)
+{
+    int i;
+    switch(format)
+    {
+        case GPU_FORMAT_RGBA:
+            memcpy(dst, src, 4*count);
+            break;
+        case GPU_FORMAT_RGB:
+            for(i = 0; i < count; i++, src += 3, dst += 4)
+            {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+                dst[3] = 255;
+            }
+            break;
+        case GPU_FORMAT_BGR:
+            for(i = 0; i < count; i++, src += 3, dst += 4)
+            {
+                dst[0] = src[2];
+                dst[1] = src[1];
+                dst[2] = src[0];
+                dst[3] = 255;
+            }
+            break;
+        case GPU_FORMAT_BGRA:
+            for(i = 0; i < count; i++, src += 4, dst += 4)
+            {
+                dst[0] = src[2];
+                dst[1] = src[1];
+                dst[2] = src[0];
+                dst[3] = src[3];
+            }
+            break;
+        case GPU_FORMAT_ABGR:
+            for(i = 0; i < count; i++, src += 4, dst += 4)
+            {
+                dst[0] = src[3];
+                dst[1] = src[2];
+                dst[2] = src[1];
+                dst[3] = src[0];
+            }
+            break;
+        case GPU_FORMAT_ALPHA:
+            for(i = 0; i < count; i++, src++, dst += 4)
+            {
+                dst[0] = dst[1] = dst[2] = 0;
+                dst[3] = src[0];
+            }
+            break;
+        case GPU_FORMAT_LUMINANCE_ALPHA:
+            for(i = 0; i < count; i++, src += 2, dst += 4)
+            {
+                dst[0] = dst[1] = dst[2] = src[0];
+                dst[3] = src[1];
+            }
+            break;
+        case GPU_FORMAT_RG:
+            for(i = 0; i < count; i++, src += 2, dst += 4)
+            {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = 0;
+                dst[3] = 255;
+            }
+            break;
+        default:  // Luminance and YCbCr
+            for(i = 0; i < count; i++, src++, dst += 4)
+            {
+                dst[0] = dst[1] = dst[2] = src[0];
+                dst[3] = 255;
+            }
+            break;
+    }
+}
+
+// Copies a w x h block of pixels between surfaces that are both in the stored layout.  The block is clipped to both surfaces.
+static void copyPixels(SDL_Surface* dst, int dst_x, int dst_y, SDL_Surface* src, int src_x, int src_y, int w, int h)
+{
+    int y;
+
+    if(dst_x < 0)
+    {
+        w += dst_x;
+        src_x -= dst_x;
+        dst_x = 0;
+    }
+    if(dst_y < 0)
+    {
+        h += dst_y;
+        src_y -= dst_y;
+        dst_y = 0;
+    }
+    if(src_x < 0)
+    {
+        w += src_x;
+        dst_x -= src_x;
+        src_x = 0;
+    }
+    if(src_y < 0)
+    {
+        h += src_y;
+        dst_y -= src_y;
+        src_y = 0;
+    }
+    w = MIN(w, MIN(dst->w - dst_x, src->w - src_x));
+    h = MIN(h, MIN(dst->h - dst_y, src->h - src_y));
+
+    for(y = 0; y < h; y++)
+        memcpy(getPixelRow(dst, dst_y + y) + dst_x, getPixelRow(src, src_y + y) + src_x, w*sizeof(Uint32));
+}
+
+// Converts any surface to the stored layout
+static SDL_Surface* convertToPixelSurface(SDL_Surface* surface)
+{
+    SDL_Surface* result;
+    SDL_Surface* format_template = createBlankSurface(1, 1);
+    if(format_template == NULL)
+        return NULL;
+
+    result = SDL_ConvertSurface(surface, format_template->format, SDL_SWSURFACE);
+    SDL_FreeSurface(format_template);
+    return result;
+}
+
+static SDL_Surface* duplicatePixels(SDL_Surface* surface)
+{
+    SDL_Surface* result;
+    if(surface == NULL)
+        return NULL;
+
+    result = createBlankSurface(surface->w, surface->h);
+    if(result != NULL)
+        copyPixels(result, 0, 0, surface, 0, 0, surface->w, surface->h);
+    return result;
+}
+
+static void fillPixels(SDL_Surface* surface, int x1, int y1, int x2, int y2, Uint32 color)
+{
+    int y;
+
+    x1 = MAX(x1, 0);
+    y1 = MAX(y1, 0);
+    x2 = MIN(x2, surface->w);
+    y2 = MIN(y2, surface->h);
+    if(x1 >= x2)
+        return;
+
+    for(y = y1; y < y2; y++)
+        gpu_fill_span(getPixelRow(surface, y) + x1, color, x2 - x1);
+}
+
+// The context's surface stands in for the window's framebuffer
+static void resizeFramebuffer(GPU_CONTEXT_DATA* cdata, int w, int h)
+{
+    if(cdata->framebuffer != NULL && cdata->framebuffer->w == w && cdata->framebuffer->h == h)
+        return;
+
+    if(cdata->framebuffer != NULL)
+        SDL_FreeSurface(cdata->framebuffer);
+    cdata->framebuffer = ((w > 0 && h > 0)? createBlankSurface(w, h) : NULL);
+}
+
+// The part of the surface that glScissor() would leave, with rows going top-down.  The whole surface if the target doesn't clip.
+static void getClipPixels(GPU_Renderer* renderer, GPU_Target* target, SDL_Surface* surface, int* x1, int* y1, int* x2, int* y2)
+{
+    int x, y, w, h;
+
+    if(!target->use_clip_rect)
+    {
+        *x1 = *y1 = 0;
+        *x2 = surface->w;
+        *y2 = surface->h;
+        return;
+    }
+
+    if(target->context != NULL)
+    {
+        GPU_Target* context_target = renderer->current_context_target;
+        float xFactor = ((float)context_target->context->drawable_w)/context_target->w;
+        float yFactor = ((float)context_target->context->drawable_h)/context_target->h;
+        x = (int)(target->clip_rect.x * xFactor);
+        w = (int)(target->clip_rect.w * xFactor);
+        h = (int)(target->clip_rect.h * yFactor);
+        // The window's rows go bottom-up in GL
+        if(renderer->coordinate_mode == 0)
+            y = (int)(target->clip_rect.y * yFactor);
+        else
+            y = surface->h - (int)(target->clip_rect.y * yFactor) - h;
+    }
+    else
+    {
+        // Texture rows match the surface rows
+        x = (int)target->clip_rect.x;
+        y = (int)target->clip_rect.y;
+        w = (int)target->clip_rect.w;
+        h = (int)target->clip_rect.h;
+    }
+
+    *x1 = MAX(x, 0);
+    *y1 = MAX(y, 0);
+    *x2 = MIN(x + w, surface->w);
+    *y2 = MIN(y + h, surface->h);
+}
+
+#endif
+
+// Frame statistics, culling, and other state tracking shared with the GL renderers
+#include "renderer_common.inl"
+
+// Sorted batches are drawn in submission order, so draws are never recorded for later
+static_inline GPU_bool isRecordingSortedBatch(GPU_Context* context, GPU_Target* target)
+{
+    (void)context;
+    (void)target;
+    return GPU_FALSE;
+}
+
+static_inline void recordSortedDraw(GPU_Renderer* renderer, GPU_Target* target, GPU_Image* image, unsigned int shape)
+{
+    (void)renderer;
+    (void)target;
+    (void)image;
+    (void)shape;
+}
+
+static void makeContextCurrent(GPU_Renderer* renderer, GPU_Target* target)
+{
+    if(target == NULL || target->context == NULL || renderer->current_context_target == target)
+        return;
+
+    flushBlitBufferFor(renderer, GPU_FLUSH_TARGET_SWITCH);
+    renderer->current_context_target = target;
+    GPU_COUNT_FRAME_STAT(target->context, target_switches, 1);
+}
+
+static GPU_bool SetActiveTarget(GPU_Renderer* renderer, GPU_Target* target)
+{
+    makeContextCurrent(renderer, target);
+
+    if(target == NULL || renderer->current_context_target == NULL)
+        return GPU_FALSE;
+
+    if(target != renderer->current_context_target->context->active_target)
+    {
+        flushBlitBufferFor(renderer, GPU_FLUSH_TARGET_SWITCH);
+        renderer->current_context_target->context->active_target = target;
+        GPU_COUNT_FRAME_STAT(renderer->current_context_target->context, target_switches, 1);
+    }
+    return GPU_TRUE;
+}
+
+static void bindTexture(GPU_Renderer* renderer, GPU_Image* image)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    if(image != ((GPU_CONTEXT_DATA*)context->data)->last_image)
+    {
+        flushBlitBufferFor(renderer, GPU_FLUSH_TEXTURE_CHANGE);
+        GPU_COUNT_FRAME_STAT(context, texture_binds, 1);
+        ((GPU_CONTEXT_DATA*)context->data)->last_image = image;
+    }
+}
+
+// The image is about to change, so pending blits that use it have to go first
+static_inline void flushBlitBufferIfCurrentTexture(GPU_Renderer* renderer, GPU_Image* image)
+{
+    if(renderer->current_context_target != NULL && image == ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image)
+        flushBlitBufferFor(renderer, GPU_FLUSH_TEXTURE_CHANGE);
+}
+
+static GPU_bool growBlitBuffer(GPU_CONTEXT_DATA* cdata, unsigned int minimum_vertices_needed)
+{
+	unsigned int new_max_num_vertices;
+	float* new_buffer;
+
+    if(minimum_vertices_needed <= cdata->blit_buffer_max_num_vertices)
+        return GPU_TRUE;
+    if(cdata->blit_buffer_max_num_vertices == GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES)
+        return GPU_FALSE;
+
+    // Calculate new size (in vertices)
+    new_max_num_vertices = cdata->blit_buffer_max_num_vertices * 2;
+    while(new_max_num_vertices <= minimum_vertices_needed)
+        new_max_num_vertices *= 2;
+
+    if(new_max_num_vertices > GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES)
+        new_max_num_vertices = GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES;
+
+    new_buffer = (float*)SDL_malloc(new_max_num_vertices * GPU_BLIT_BUFFER_STRIDE);
+    memcpy(new_buffer, cdata->blit_buffer, cdata->blit_buffer_num_vertices * GPU_BLIT_BUFFER_STRIDE);
+    SDL_free(cdata->blit_buffer);
+    cdata->blit_buffer = new_buffer;
+    cdata->blit_buffer_max_num_vertices = new_max_num_vertices;
+    return GPU_TRUE;
+}
+
+static GPU_bool growIndexBuffer(GPU_CONTEXT_DATA* cdata, unsigned int minimum_vertices_needed)
+{
+	unsigned int new_max_num_vertices;
+	GPU_BLIT_INDEX_TYPE* new_indices;
+
+    if(minimum_vertices_needed <= cdata->index_buffer_max_num_vertices)
+        return GPU_TRUE;
+    if(cdata->index_buffer_max_num_vertices == GPU_INDEX_BUFFER_ABSOLUTE_MAX_VERTICES)
+        return GPU_FALSE;
+
+    // Calculate new size (in vertices)
+    new_max_num_vertices = cdata->index_buffer_max_num_vertices * 2;
+    while(new_max_num_vertices <= minimum_vertices_needed)
+        new_max_num_vertices *= 2;
+
+    if(new_max_num_vertices > GPU_INDEX_BUFFER_ABSOLUTE_MAX_VERTICES)
+        new_max_num_vertices = GPU_INDEX_BUFFER_ABSOLUTE_MAX_VERTICES;
+
+    new_indices = (GPU_BLIT_INDEX_TYPE*)SDL_malloc(new_max_num_vertices * sizeof(GPU_BLIT_INDEX_TYPE));
+    memcpy(new_indices, cdata->index_buffer, cdata->index_buffer_num_vertices * sizeof(GPU_BLIT_INDEX_TYPE));
+    SDL_free(cdata->index_buffer);
+    cdata->index_buffer = new_indices;
+    cdata->index_buffer_max_num_vertices = new_max_num_vertices;
+    return GPU_TRUE;
+}
+
+
+// For isCulled()
+static float* getTargetModelViewProjection(GPU_Renderer* renderer, GPU_Target* target, float* storage)
+{
+    (void)renderer;
+    gpu_get_modelviewprojection(target, storage);
+    return storage;
+}
+
+
+static void changeDepthTest(GPU_Renderer* renderer, GPU_bool enable)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->last_depth_test == enable)
+        return;
+
+    flushBlitBufferFor(renderer, GPU_FLUSH_STATE_CHANGE);
+    cdata->last_depth_test = enable;
+}
+
+static void changeDepthWrite(GPU_Renderer* renderer, GPU_bool enable)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->last_depth_write == enable)
+        return;
+
+    flushBlitBufferFor(renderer, GPU_FLUSH_STATE_CHANGE);
+    cdata->last_depth_write = enable;
+}
+
+static void changeDepthFunction(GPU_Renderer* renderer, GPU_ComparisonEnum compare_operation)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->last_depth_function == compare_operation)
+        return;
+
+    flushBlitBufferFor(renderer, GPU_FLUSH_STATE_CHANGE);
+    cdata->last_depth_function = compare_operation;
+}
+
+static void prepareToRenderToTarget(GPU_Renderer* renderer, GPU_Target* target)
+{
+    // Set up the camera
+    renderer->impl->SetCamera(renderer, target, &target->camera);
+    changeDepthTest(renderer, target->use_depth_test);
+    changeDepthWrite(renderer, target->use_depth_write);
+    changeDepthFunction(renderer, target->depth_function);
+}
+
+static void changeBlending(GPU_Renderer* renderer, GPU_bool enable)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->last_use_blending == enable)
+        return;
+
+    flushBlitBufferFor(renderer, GPU_FLUSH_BLEND_CHANGE);
+    cdata->last_use_blending = enable;
+}
+
+static void changeBlendMode(GPU_Renderer* renderer, GPU_BlendMode mode)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->last_blend_mode.source_color == mode.source_color
+       && cdata->last_blend_mode.dest_color == mode.dest_color
+       && cdata->last_blend_mode.source_alpha == mode.source_alpha
+       && cdata->last_blend_mode.dest_alpha == mode.dest_alpha
+       && cdata->last_blend_mode.color_equation == mode.color_equation
+       && cdata->last_blend_mode.alpha_equation == mode.alpha_equation)
+        return;
+
+    flushBlitBufferFor(renderer, GPU_FLUSH_BLEND_CHANGE);
+    cdata->last_blend_mode = mode;
+}
+
+static void enableTexturing(GPU_Renderer* renderer)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    if(!((GPU_CONTEXT_DATA*)context->data)->last_use_texturing)
+    {
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
+        ((GPU_CONTEXT_DATA*)context->data)->last_use_texturing = GPU_TRUE;
+    }
+    context->use_texturing = GPU_TRUE;
+}
+
+static void disableTexturing(GPU_Renderer* renderer)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    if(((GPU_CONTEXT_DATA*)context->data)->last_use_texturing)
+    {
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
+        ((GPU_CONTEXT_DATA*)context->data)->last_use_texturing = GPU_FALSE;
+    }
+    context->use_texturing = GPU_FALSE;
+}
+
+static void prepareToRenderImage(GPU_Renderer* renderer, GPU_Image* image)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+
+    enableTexturing(renderer);
+    if(GL_TRIANGLES != ((GPU_CONTEXT_DATA*)context->data)->last_shape)
+    {
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
+        ((GPU_CONTEXT_DATA*)context->data)->last_shape = GL_TRIANGLES;
+    }
+
+    changeBlending(renderer, image->use_blending);
+    changeBlendMode(renderer, image->blend_mode);
+
+    // If we're using the untextured shader, switch it.
+    if(context->current_shader_program == context->default_untextured_shader_program)
+        renderer->impl->ActivateShaderProgram(renderer, context->default_textured_shader_program, NULL);
+}
+
+static void prepareToRenderShapes(GPU_Renderer* renderer, unsigned int shape)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+
+    disableTexturing(renderer);
+    if(shape != ((GPU_CONTEXT_DATA*)context->data)->last_shape)
+    {
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
+        ((GPU_CONTEXT_DATA*)context->data)->last_shape = shape;
+    }
+
+    changeBlending(renderer, context->shapes_use_blending);
+    changeBlendMode(renderer, context->shapes_blend_mode);
+
+    // If we're using the textured shader, switch it.
+    if(context->current_shader_program == context->default_textured_shader_program)
+        renderer->impl->ActivateShaderProgram(renderer, context->default_untextured_shader_program, NULL);
+}
+
+// Attribute and uniform locations are handed out by name, shared by every program in the context
+static int getLocation(GPU_Renderer* renderer, const char* name)
+{
+    GPU_CONTEXT_DATA* cdata;
+    int i;
+
+    if(name == NULL || renderer->current_context_target == NULL)
+        return -1;
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    for(i = 0; i < cdata->num_location_names; i++)
+    {
+        if(strncmp(cdata->location_names[i], name, GPU_CPU_LOCATION_NAME_LENGTH - 1) == 0)
+            return i;
+    }
+
+    if(cdata->num_location_names == GPU_CPU_MAX_LOCATIONS)
+        return -1;
+
+    strncpy(cdata->location_names[i], name, GPU_CPU_LOCATION_NAME_LENGTH - 1);
+    cdata->location_names[i][GPU_CPU_LOCATION_NAME_LENGTH - 1] = '\0';
+    cdata->num_location_names++;
+    return i;
+}
+
+
+
+static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowID, GPU_Target* target);
+
+static GPU_Target* Init(GPU_Renderer* renderer, GPU_RendererID renderer_request, Uint16 w, Uint16 h, GPU_WindowFlagEnum SDL_flags)
+{
+    GPU_Target* target;
+    Uint32 windowID;
+    int window_w, window_h;
+
+    renderer->requested_id = renderer_request;
+    renderer->SDL_init_flags = SDL_flags;
+    renderer->GPU_init_flags = GPU_GetPreInitFlags();
+
+    // No GPU means no GPU features to check for.  Timer queries are left out because there is nothing to time.
+    renderer->enabled_features = GPU_FEATURE_ALL_BASE | GPU_FEATURE_NON_POWER_OF_TWO | GPU_FEATURE_ALL_BLEND_PRESETS | GPU_FEATURE_BLEND_EQUATIONS_SEPARATE
+                                 | GPU_FEATURE_ALL_GL_FORMATS | GPU_FEATURE_WRAP_REPEAT_MIRRORED | GPU_FEATURE_CORE_FRAMEBUFFER_OBJECTS;
+    #ifndef SDL_GPU_DISABLE_SHADERS
+    renderer->enabled_features |= GPU_FEATURE_BASIC_SHADERS;
+    #endif
+
+    // An init window is used for its size, but no window is ever created
+    windowID = GPU_GetInitWindow();
+    if(!get_window_dimensions(windowID, &window_w, &window_h))
+        windowID = 0;
+
+    target = CreateTargetFromWindow(renderer, windowID, renderer->current_context_target);
+    if(target == NULL)
+        return NULL;
+
+    if(windowID == 0)
+    {
+        // Headless, so the context is whatever size was asked for
+        renderer->impl->SetWindowResolution(renderer, w, h);
+    }
+    else if(!(renderer->GPU_init_flags & GPU_INIT_DISABLE_AUTO_VIRTUAL_RESOLUTION) && w != 0 && h != 0 && (w != target->w || h != target->h))
+        renderer->impl->SetVirtualResolution(renderer, target, w, h);
+
+    return target;
+}
+
+static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowID, GPU_Target* target)
+{
+    GPU_CONTEXT_DATA* cdata;
+    GPU_Context* context;
+    int window_w, window_h;
+
+    if(target == NULL)
+    {
+        target = (GPU_Target*)SDL_malloc(sizeof(GPU_Target));
+        memset(target, 0, sizeof(GPU_Target));
+        target->refcount = 1;
+        target->is_alias = GPU_FALSE;
+        target->data = (GPU_TARGET_DATA*)SDL_malloc(sizeof(GPU_TARGET_DATA));
+        memset(target->data, 0, sizeof(GPU_TARGET_DATA));
+        ((GPU_TARGET_DATA*)target->data)->refcount = 1;
+        target->image = NULL;
+
+        target->context = (GPU_Context*)SDL_malloc(sizeof(GPU_Context));
+        memset(target->context, 0, sizeof(GPU_Context));
+        target->context->refcount = 1;
+
+        cdata = (GPU_CONTEXT_DATA*)SDL_malloc(sizeof(GPU_CONTEXT_DATA));
+        memset(cdata, 0, sizeof(GPU_CONTEXT_DATA));
+        target->context->data = cdata;
+
+        cdata->next_object_id = 1;
+        cdata->blit_buffer_max_num_vertices = GPU_BLIT_BUFFER_INIT_MAX_NUM_VERTICES;
+        cdata->blit_buffer = (float*)SDL_malloc(GPU_BLIT_BUFFER_STRIDE * cdata->blit_buffer_max_num_vertices);
+        cdata->index_buffer_max_num_vertices = GPU_BLIT_BUFFER_INIT_MAX_NUM_VERTICES;
+        cdata->index_buffer = (GPU_BLIT_INDEX_TYPE*)SDL_malloc(sizeof(GPU_BLIT_INDEX_TYPE) * cdata->index_buffer_max_num_vertices);
+
+        #ifdef SDL_GPU_CPU_RASTERIZE
+        createRasterizer(cdata);
+        #endif
+    }
+    else
+    {
+        GPU_RemoveWindowMapping(target->context->windowID);
+        cdata = (GPU_CONTEXT_DATA*)target->context->data;
+    }
+
+    context = target->context;
+    context->windowID = windowID;
+    context->context = NULL;  // No GL context
+
+    // Headless contexts start empty and are sized by GPU_SetWindowResolution()
+    window_w = window_h = 0;
+    get_window_dimensions(windowID, &window_w, &window_h);
+    context->window_w = context->drawable_w = context->stored_window_w = window_w;
+    context->window_h = context->drawable_h = context->stored_window_h = window_h;
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    resizeFramebuffer(cdata, window_w, window_h);
+    #endif
+
+    GPU_AddWindowMapping(target);
+
+    ((GPU_TARGET_DATA*)target->data)->handle = 0;
+
+    target->renderer = renderer;
+    target->context_target = target;
+    target->w = target->base_w = (Uint16)window_w;
+    target->h = target->base_h = (Uint16)window_h;
+
+    target->use_clip_rect = GPU_FALSE;
+    target->clip_rect = GPU_MakeRect(0, 0, target->w, target->h);
+    target->use_color = GPU_FALSE;
+
+    target->viewport = GPU_MakeRect(0, 0, (float)window_w, (float)window_h);
+
+    target->matrix_mode = GPU_MODEL;
+    GPU_InitMatrixStack(&target->projection_matrix);
+    GPU_InitMatrixStack(&target->view_matrix);
+    GPU_InitMatrixStack(&target->model_matrix);
+
+    target->camera = GPU_GetDefaultCamera();
+    target->use_camera = GPU_TRUE;
+
+    target->use_depth_test = GPU_FALSE;
+    target->use_depth_write = GPU_TRUE;
+    target->use_culling = GPU_FALSE;
+
+    context->line_thickness = 1.0f;
+    context->use_texturing = GPU_TRUE;
+    context->shapes_use_blending = GPU_TRUE;
+    context->shapes_blend_mode = GPU_GetBlendModeFromPreset(GPU_BLEND_NORMAL);
+
+    cdata->last_use_texturing = GPU_TRUE;
+    cdata->last_shape = GL_TRIANGLES;
+    cdata->last_use_blending = GPU_FALSE;
+    cdata->last_blend_mode = GPU_GetBlendModeFromPreset(GPU_BLEND_NORMAL);
+    cdata->last_viewport = target->viewport;
+    cdata->last_camera = target->camera;
+    cdata->last_depth_test = GPU_FALSE;
+    cdata->last_depth_write = GPU_TRUE;
+
+    renderer->impl->MakeCurrent(renderer, target, windowID);
+
+    GPU_ResetProjection(target);
+
+    // Stand-ins for the default shaders, so program switches are counted like they are with GL
+    context->default_textured_vertex_shader_id = nextObjectID(cdata);
+    context->default_textured_fragment_shader_id = nextObjectID(cdata);
+    context->default_untextured_vertex_shader_id = nextObjectID(cdata);
+    context->default_untextured_fragment_shader_id = nextObjectID(cdata);
+    context->default_textured_shader_program = nextObjectID(cdata);
+    context->default_untextured_shader_program = nextObjectID(cdata);
+
+    context->default_textured_shader_block = renderer->impl->LoadShaderBlock(renderer, context->default_textured_shader_program, "gpu_Vertex", "gpu_TexCoord", "gpu_Color", "gpu_ModelViewProjectionMatrix");
+    context->default_untextured_shader_block = renderer->impl->LoadShaderBlock(renderer, context->default_untextured_shader_program, "gpu_Vertex", NULL, "gpu_Color", "gpu_ModelViewProjectionMatrix");
+    context->current_shader_program = context->default_textured_shader_program;
+    context->current_shader_block = context->default_textured_shader_block;
+
+    renderer->impl->SetLineThickness(renderer, 1.0f);
+
+    return target;
+}
+
+static void MakeCurrent(GPU_Renderer* renderer, GPU_Target* target, Uint32 windowID)
+{
+    if(target == NULL || target->context == NULL || target->image != NULL)
+        return;
+
+    if(renderer->current_context_target != target)
+        makeContextCurrent(renderer, target);
+
+    // Reset window mapping and base size if the target's window was changed
+    if(target->context->windowID != windowID)
+    {
+        int window_w, window_h;
+
+        flushBlitBufferFor(renderer, GPU_FLUSH_TARGET_SWITCH);
+
+        GPU_RemoveWindowMapping(windowID);
+        // Don't remove the target's current mapping.  That lets other windows refer to it.
+        target->context->windowID = windowID;
+        GPU_AddWindowMapping(target);
+
+        if(get_window_dimensions(windowID, &window_w, &window_h))
+        {
+            target->context->window_w = target->context->drawable_w = window_w;
+            target->context->window_h = target->context->drawable_h = window_h;
+            target->base_w = (Uint16)window_w;
+            target->base_h = (Uint16)window_h;
+            #ifdef SDL_GPU_CPU_RASTERIZE
+            resizeFramebuffer((GPU_CONTEXT_DATA*)target->context->data, window_w, window_h);
+            #endif
+        }
+    }
+}
+
+static void ResetRendererState(GPU_Renderer* renderer)
+{
+    GPU_Target* target;
+    GPU_CONTEXT_DATA* cdata;
+
+    if(renderer->current_context_target == NULL)
+        return;
+
+    target = renderer->current_context_target;
+    cdata = (GPU_CONTEXT_DATA*)target->context->data;
+
+    // Forget the tracked state so the next draw sets it all again
+    cdata->last_image = NULL;
+    cdata->last_use_blending = GPU_FALSE;
+    cdata->last_blend_mode = GPU_GetBlendModeFromPreset(GPU_BLEND_NORMAL);
+    cdata->last_viewport = target->viewport;
+    cdata->last_camera = target->camera;
+    target->context->active_target = NULL;
+}
+
+static GPU_bool AddDepthBuffer(GPU_Renderer* renderer, GPU_Target* target)
+{
+    (void)renderer;
+    if(target == NULL)
+        return GPU_FALSE;
+
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    GPU_PushErrorCode("GPU_AddDepthBuffer", GPU_ERROR_UNSUPPORTED_FUNCTION, "This renderer does not depth test");
+    return GPU_FALSE;
+    #else
+    GPU_SetDepthTest(target, 1);
+    return GPU_TRUE;
+    #endif
+}
+
+static GPU_bool SetWindowResolution(GPU_Renderer* renderer, Uint16 w, Uint16 h)
+{
+    GPU_Target* target = renderer->current_context_target;
+
+    if(target == NULL)
+        return GPU_FALSE;
+
+    flushBlitBufferFor(renderer, GPU_FLUSH_STATE_CHANGE);
+
+    #ifdef SDL_GPU_USE_SDL2
+    if(target->context->windowID != 0 && SDL_GetWindowFromID(target->context->windowID) != NULL)
+        SDL_SetWindowSize(SDL_GetWindowFromID(target->context->windowID), w, h);
+    #endif
+
+    target->context->window_w = target->context->drawable_w = w;
+    target->context->window_h = target->context->drawable_h = h;
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    resizeFramebuffer((GPU_CONTEXT_DATA*)target->context->data, w, h);
+    #endif
+
+    // Store the resolution for fullscreen_desktop changes
+    target->context->stored_window_w = w;
+    target->context->stored_window_h = h;
+
+    // Update base dimensions
+    target->base_w = w;
+    target->base_h = h;
+
+    // Resets virtual resolution
+    target->w = target->base_w;
+    target->h = target->base_h;
+    target->using_virtual_resolution = GPU_FALSE;
+
+    // Resets viewport
+    target->viewport = GPU_MakeRect(0, 0, target->w, target->h);
+
+    GPU_UnsetClip(target);
+	GPU_ResetProjection(target);
+
+    return GPU_TRUE;
+}
+
+static void SetVirtualResolution(GPU_Renderer* renderer, GPU_Target* target, Uint16 w, Uint16 h)
+{
+    if(target == NULL)
+        return;
+
+    if(isCurrentTarget(renderer, target))
+        flushBlitBufferFor(renderer, GPU_FLUSH_STATE_CHANGE);
+
+    target->w = w;
+    target->h = h;
+    target->using_virtual_resolution = GPU_TRUE;
+
+	GPU_ResetProjection(target);
+}
+
+static void UnsetVirtualResolution(GPU_Renderer* renderer, GPU_Target* target)
+{
+    if(target == NULL)
+        return;
+
+    if(isCurrentTarget(renderer, target))
+        flushBlitBufferFor(renderer, GPU_FLUSH_STATE_CHANGE);
+
+    target->w = target->base_w;
+    target->h = target->base_h;
+    target->using_virtual_resolution = GPU_FALSE;
+
+	GPU_ResetProjection(target);
+}
+
+static GPU_bool SetFullscreen(GPU_Renderer* renderer, GPU_bool enable_fullscreen, GPU_bool use_desktop_resolution)
+{
+    (void)renderer;
+    (void)use_desktop_resolution;
+
+    // There is no display to fill
+    if(enable_fullscreen)
+        GPU_PushErrorCode("GPU_SetFullscreen", GPU_ERROR_UNSUPPORTED_FUNCTION, "The null renderer has no display");
+    return GPU_FALSE;
+}
+
+
+static GPU_Image* CreateUninitializedImage(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_FormatEnum format)
+{
+	GPU_Image* result;
+	GPU_IMAGE_DATA* data;
+	int num_layers, bytes_per_pixel;
+	SDL_Color white = { 255, 255, 255, 255 };
+
+    switch(format)
+    {
+        case GPU_FORMAT_LUMINANCE:
+        case GPU_FORMAT_ALPHA:
+            num_layers = 1;
+            bytes_per_pixel = 1;
+            break;
+        case GPU_FORMAT_LUMINANCE_ALPHA:
+        case GPU_FORMAT_RG:
+            num_layers = 1;
+            bytes_per_pixel = 2;
+            break;
+        case GPU_FORMAT_RGB:
+        case GPU_FORMAT_BGR:
+            num_layers = 1;
+            bytes_per_pixel = 3;
+            break;
+        case GPU_FORMAT_RGBA:
+        case GPU_FORMAT_BGRA:
+        case GPU_FORMAT_ABGR:
+            num_layers = 1;
+            bytes_per_pixel = 4;
+            break;
+        case GPU_FORMAT_YCbCr420P:
+        case GPU_FORMAT_YCbCr422:
+            num_layers = 3;
+            bytes_per_pixel = 1;
+            break;
+        default:
+            GPU_PushErrorCode("GPU_CreateUninitializedImage", GPU_ERROR_DATA_ERROR, "Unsupported image format (0x%x)", format);
+            return NULL;
+    }
+
+    result = (GPU_Image*)SDL_malloc(sizeof(GPU_Image));
+    memset(result, 0, sizeof(GPU_Image));
+    result->refcount = 1;
+    data = (GPU_IMAGE_DATA*)SDL_malloc(sizeof(GPU_IMAGE_DATA));
+    data->refcount = 1;
+    data->owns_handle = GPU_TRUE;
+    data->handle = nextObjectID((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data);
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    // Every format is stored as RGBA
+    data->pixels = createBlankSurface(w, h);
+    if(data->pixels == NULL)
+    {
+        GPU_PushErrorCode("GPU_CreateUninitializedImage", GPU_ERROR_BACKEND_ERROR, "Failed to allocate pixels (%dx%d)", w, h);
+        SDL_free(data);
+        SDL_free(result);
+        return NULL;
+    }
+    #endif
+    result->target = NULL;
+    result->renderer = renderer;
+    result->context_target = renderer->current_context_target;
+    result->format = format;
+    result->num_layers = num_layers;
+    result->bytes_per_pixel = bytes_per_pixel;
+    result->has_mipmaps = GPU_FALSE;
+
+    result->anchor_x = renderer->default_image_anchor_x;
+    result->anchor_y = renderer->default_image_anchor_y;
+
+    result->color = white;
+    result->use_blending = GPU_TRUE;
+    result->blend_mode = GPU_GetBlendModeFromPreset(GPU_BLEND_NORMAL);
+    result->filter_mode = GPU_FILTER_LINEAR;
+    result->snap_mode = GPU_SNAP_POSITION_AND_DIMENSIONS;
+    result->wrap_mode_x = GPU_WRAP_NONE;
+    result->wrap_mode_y = GPU_WRAP_NONE;
+
+    result->data = data;
+    result->is_alias = GPU_FALSE;
+
+    result->using_virtual_resolution = GPU_FALSE;
+    result->w = w;
+    result->h = h;
+    result->base_w = w;
+    result->base_h = h;
+    result->texture_w = w;
+    result->texture_h = h;
+
+    return result;
+}
+
+static GPU_Image* CreateImage(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_FormatEnum format)
+{
+    if(format < 1)
+    {
+        GPU_PushErrorCode("GPU_CreateImage", GPU_ERROR_DATA_ERROR, "Unsupported image format (0x%x)", format);
+        return NULL;
+    }
+
+    return CreateUninitializedImage(renderer, w, h, format);
+}
+
+static GPU_Image* CreateImageUsingTexture(GPU_Renderer* renderer, GPU_TextureHandle handle, GPU_bool take_ownership)
+{
+    (void)renderer;
+    (void)handle;
+    (void)take_ownership;
+
+    // Nothing can be asked about a texture that doesn't exist
+    GPU_PushErrorCode("GPU_CreateImageUsingTexture", GPU_ERROR_UNSUPPORTED_FUNCTION, "This renderer has no GL textures");
+    return NULL;
+}
+
+static GPU_bool SaveImage(GPU_Renderer* renderer, GPU_Image* image, const char* filename, GPU_FileFormatEnum format)
+{
+    GPU_bool result;
+    SDL_Surface* surface;
+
+    if(image == NULL || filename == NULL)
+        return GPU_FALSE;
+
+    surface = renderer->impl->CopySurfaceFromImage(renderer, image);
+    if(surface == NULL)
+        return GPU_FALSE;
+
+    result = GPU_SaveSurface(surface, filename, format);
+
+    SDL_FreeSurface(surface);
+    return result;
+}
+
+static GPU_Image* CopyImage(GPU_Renderer* renderer, GPU_Image* image)
+{
+    GPU_Image* result;
+
+    if(image == NULL)
+        return NULL;
+
+    result = CreateUninitializedImage(renderer, image->texture_w, image->texture_h, image->format);
+    if(result == NULL)
+        return NULL;
+
+    // Copy the image settings
+    result->w = image->w;
+    result->h = image->h;
+    result->base_w = image->base_w;
+    result->base_h = image->base_h;
+    result->using_virtual_resolution = image->using_virtual_resolution;
+    result->anchor_x = image->anchor_x;
+    result->anchor_y = image->anchor_y;
+    result->color = image->color;
+    result->use_blending = image->use_blending;
+    result->blend_mode = image->blend_mode;
+    result->filter_mode = image->filter_mode;
+    result->snap_mode = image->snap_mode;
+    result->wrap_mode_x = image->wrap_mode_x;
+    result->wrap_mode_y = image->wrap_mode_y;
+
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    if(image->target != NULL && isCurrentTarget(renderer, image->target))
+        flushBlitBufferFor(renderer, GPU_FLUSH_READBACK);
+    copyPixels(((GPU_IMAGE_DATA*)result->data)->pixels, 0, 0, ((GPU_IMAGE_DATA*)image->data)->pixels, 0, 0, image->texture_w, image->texture_h);
+    #endif
+    return result;
+}
+
+static void UpdateImage(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, SDL_Surface* surface, const GPU_Rect* surface_rect)
+{
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    SDL_Surface* converted;
+    GPU_Rect updateRect, sourceRect;
+    #else
+    (void)image_rect;
+    (void)surface_rect;
+    #endif
+    if(image == NULL || surface == NULL)
+        return;
+
+    flushBlitBufferIfCurrentTexture(renderer, image);
+
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    converted = convertToPixelSurface(surface);
+    if(converted == NULL)
+    {
+        GPU_PushErrorCode("GPU_UpdateImage", GPU_ERROR_BACKEND_ERROR, "Failed to convert surface to proper pixel format.");
+        return;
+    }
+
+    updateRect = (image_rect != NULL? *image_rect : GPU_MakeRect(0, 0, image->base_w, image->base_h));
+    sourceRect = (surface_rect != NULL? *surface_rect : GPU_MakeRect(0, 0, (float)surface->w, (float)surface->h));
+
+    // Clipped to both rects and both surfaces
+    copyPixels(((GPU_IMAGE_DATA*)image->data)->pixels, (int)updateRect.x, (int)updateRect.y, converted, (int)sourceRect.x, (int)sourceRect.y,
+               (int)MIN(updateRect.w, sourceRect.w), (int)MIN(updateRect.h, sourceRect.h));
+    SDL_FreeSurface(converted);
+    #endif
+}
+
+static void UpdateImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row)
+{
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    SDL_Surface* pixels;
+    int x, y, w, h, row;
+    #else
+    (void)image_rect;
+    (void)bytes_per_row;
+    #endif
+    if(image == NULL || bytes == NULL)
+        return;
+
+    flushBlitBufferIfCurrentTexture(renderer, image);
+
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    pixels = ((GPU_IMAGE_DATA*)image->data)->pixels;
+    if(image_rect != NULL)
+    {
+        x = (int)image_rect->x;
+        y = (int)image_rect->y;
+        w = (int)image_rect->w;
+        h = (int)image_rect->h;
+    }
+    else
+    {
+        x = y = 0;
+        w = image->base_w;
+        h = image->base_h;
+    }
+    if(x < 0 || y < 0 || x + w > pixels->w || y + h > pixels->h)
+    {
+        GPU_PushErrorCode("GPU_UpdateImageBytes", GPU_ERROR_USER_ERROR, "Given rect is outside of the image.");
+        return;
+    }
+
+    for(row = 0; row < h; row++)
+        convertRowToRGBA(image->format, bytes + row*bytes_per_row, (Uint8*)(getPixelRow(pixels, y + row) + x), w);
+    #endif
+}
+
+// Pixels are copied straight into the image, so there is no transfer to wait for
+static void UpdateImageBytesAsync(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row)
+{
+    UpdateImageBytes(renderer, image, image_rect, bytes, bytes_per_row);
+}
+
+static GPU_bool ReplaceImage(GPU_Renderer* renderer, GPU_Image* image, SDL_Surface* surface, const GPU_Rect* surface_rect)
+{
+    Uint16 w, h;
+
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_ReplaceImage", GPU_ERROR_NULL_ARGUMENT, "image");
+        return GPU_FALSE;
+    }
+    if(surface == NULL)
+    {
+        GPU_PushErrorCode("GPU_ReplaceImage", GPU_ERROR_NULL_ARGUMENT, "surface");
+        return GPU_FALSE;
+    }
+
+    flushBlitBufferIfCurrentTexture(renderer, image);
+
+    w = (Uint16)(surface_rect == NULL? surface->w : surface_rect->w);
+    h = (Uint16)(surface_rect == NULL? surface->h : surface_rect->h);
+
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    {
+        GPU_IMAGE_DATA* data = (GPU_IMAGE_DATA*)image->data;
+        SDL_Surface* converted = convertToPixelSurface(surface);
+        SDL_Surface* pixels = createBlankSurface(w, h);
+        if(converted == NULL || pixels == NULL)
+        {
+            if(converted != NULL)
+                SDL_FreeSurface(converted);
+            if(pixels != NULL)
+                SDL_FreeSurface(pixels);
+            GPU_PushErrorCode("GPU_ReplaceImage", GPU_ERROR_BACKEND_ERROR, "Failed to convert surface to proper pixel format.");
+            return GPU_FALSE;
+        }
+
+        copyPixels(pixels, 0, 0, converted, (surface_rect == NULL? 0 : (int)surface_rect->x), (surface_rect == NULL? 0 : (int)surface_rect->y), w, h);
+        SDL_FreeSurface(converted);
+        SDL_FreeSurface(data->pixels);
+        data->pixels = pixels;
+    }
+    #endif
+
+    image->w = image->base_w = image->texture_w = w;
+    image->h = image->base_h = image->texture_h = h;
+    image->using_virtual_resolution = GPU_FALSE;
+    image->has_mipmaps = GPU_FALSE;
+
+    // Keep the image's target in step
+    if(image->target != NULL)
+    {
+        image->target->w = image->target->base_w = w;
+        image->target->h = image->target->base_h = h;
+        image->target->viewport = GPU_MakeRect(0, 0, w, h);
+        GPU_ResetProjection(image->target);
+    }
+    return GPU_TRUE;
+}
+
+static GPU_Image* CopyImageFromSurface(GPU_Renderer* renderer, SDL_Surface* surface, GPU_Rect* surface_rect)
+{
+    GPU_FormatEnum format;
+    Uint16 w, h;
+
+    if(surface == NULL)
+    {
+        GPU_PushErrorCode("GPU_CopyImageFromSurface", GPU_ERROR_NULL_ARGUMENT, "surface");
+        return NULL;
+    }
+
+    w = (Uint16)(surface_rect == NULL? surface->w : surface_rect->w);
+    h = (Uint16)(surface_rect == NULL? surface->h : surface_rect->h);
+    format = (surface->format->Amask != 0? GPU_FORMAT_RGBA : GPU_FORMAT_RGB);
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    {
+        GPU_Image* image = CreateUninitializedImage(renderer, w, h, format);
+        if(image != NULL)
+            UpdateImage(renderer, image, NULL, surface, surface_rect);
+        return image;
+    }
+    #else
+    return CreateUninitializedImage(renderer, w, h, format);
+    #endif
+}
+
+static GPU_Image* CopyImageFromTarget(GPU_Renderer* renderer, GPU_Target* target)
+{
+    if(target == NULL)
+        return NULL;
+
+    if(isCurrentTarget(renderer, target))
+        flushBlitBufferFor(renderer, GPU_FLUSH_READBACK);
+
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    {
+        GPU_Image* image = CreateUninitializedImage(renderer, target->base_w, target->base_h, GPU_FORMAT_RGBA);
+        SDL_Surface* pixels = getTargetSurface(target);
+        if(image != NULL && pixels != NULL)
+            copyPixels(((GPU_IMAGE_DATA*)image->data)->pixels, 0, 0, pixels, 0, 0, pixels->w, pixels->h);
+        return image;
+    }
+    #else
+    return CreateUninitializedImage(renderer, target->base_w, target->base_h, GPU_FORMAT_RGBA);
+    #endif
+}
+
+static SDL_Surface* CopySurfaceFromTarget(GPU_Renderer* renderer, GPU_Target* target)
+{
+    if(target == NULL)
+    {
+        GPU_PushErrorCode("GPU_CopySurfaceFromTarget", GPU_ERROR_NULL_ARGUMENT, "target");
+        return NULL;
+    }
+    if(target->base_w < 1 || target->base_h < 1)
+    {
+        GPU_PushErrorCode("GPU_CopySurfaceFromTarget", GPU_ERROR_DATA_ERROR, "Invalid target dimensions (%dx%d)", target->base_w, target->base_h);
+        return NULL;
+    }
+
+    if(isCurrentTarget(renderer, target))
+        flushBlitBufferFor(renderer, GPU_FLUSH_READBACK);
+
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    return duplicatePixels(getTargetSurface(target));
+    #else
+    return createBlankSurface(target->base_w, target->base_h);
+    #endif
+}
+
+static SDL_Surface* CopySurfaceFromImage(GPU_Renderer* renderer, GPU_Image* image)
+{
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_CopySurfaceFromImage", GPU_ERROR_NULL_ARGUMENT, "image");
+        return NULL;
+    }
+    if(image->w < 1 || image->h < 1)
+    {
+        GPU_PushErrorCode("GPU_CopySurfaceFromImage", GPU_ERROR_DATA_ERROR, "Invalid image dimensions (%dx%d)", image->base_w, image->base_h);
+        return NULL;
+    }
+
+    if(image->target != NULL && isCurrentTarget(renderer, image->target))
+        flushBlitBufferFor(renderer, GPU_FLUSH_READBACK);
+
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    return duplicatePixels(((GPU_IMAGE_DATA*)image->data)->pixels);
+    #else
+    return createBlankSurface(image->w, image->h);
+    #endif
+}
+
+// Targets live in CPU memory, so the pixels are copied right away
+static GPU_Readback* ReadPixelsAsync(GPU_Renderer* renderer, GPU_Target* target, const GPU_Rect* rect)
+{
+    GPU_Readback* result;
+    unsigned char* pixels;
+    int x, y, w, h;
+
+    if(target == NULL)
+    {
+        GPU_PushErrorCode("GPU_ReadPixelsAsync", GPU_ERROR_NULL_ARGUMENT, "target");
+        return NULL;
+    }
+
+    x = 0;
+    y = 0;
+    w = target->base_w;
+    h = target->base_h;
+    if(rect != NULL)
+    {
+        x = MAX((int)rect->x, 0);
+        y = MAX((int)rect->y, 0);
+        w = MIN((int)(rect->x + rect->w), target->base_w) - x;
+        h = MIN((int)(rect->y + rect->h), target->base_h) - y;
+    }
+    if(w < 1 || h < 1)
+    {
+        GPU_PushErrorCode("GPU_ReadPixelsAsync", GPU_ERROR_USER_ERROR, "Given rect is outside of the target.");
+        return NULL;
+    }
+
+    if(isCurrentTarget(renderer, target))
+        flushBlitBufferFor(renderer, GPU_FLUSH_READBACK);
+
+    pixels = (unsigned char*)SDL_malloc(w*h*4);
+    memset(pixels, 0, w*h*4);
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    {
+        SDL_Surface* surface = getTargetSurface(target);
+        int row;
+        if(surface != NULL && x < surface->w)
+        {
+            for(row = 0; row < h && y + row < surface->h; row++)
+                memcpy(pixels + row*w*4, getPixelRow(surface, y + row) + x, MIN(w, surface->w - x)*4);
+        }
+    }
+    #endif
+
+    result = (GPU_Readback*)SDL_malloc(sizeof(GPU_Readback));
+    result->renderer = renderer;
+    result->w = w;
+    result->h = h;
+    result->data = pixels;
+    return result;
+}
+
+static GPU_bool IsReadbackReady(GPU_Renderer* renderer, GPU_Readback* readback)
+{
+    (void)renderer;
+    (void)readback;
+    return GPU_TRUE;
+}
+
+static const unsigned char* MapReadback(GPU_Renderer* renderer, GPU_Readback* readback, int* bytes_per_row)
+{
+    (void)renderer;
+    if(bytes_per_row != NULL)
+        *bytes_per_row = readback->w*4;
+    return (const unsigned char*)readback->data;
+}
+
+static void FreeReadback(GPU_Renderer* renderer, GPU_Readback* readback)
+{
+    (void)renderer;
+    SDL_free(readback->data);
+    SDL_free(readback);
+}
+
+static void FreeImage(GPU_Renderer* renderer, GPU_Image* image)
+{
+	GPU_IMAGE_DATA* data;
+
+    if(image == NULL)
+        return;
+
+    if(image->refcount > 1)
+    {
+        image->refcount--;
+        return;
+    }
+
+    // Delete the attached target first
+    if(image->target != NULL)
+    {
+        GPU_Target* target = image->target;
+        image->target = NULL;
+
+        // Freeing it will decrement the refcount.  If this is the only increment, it will be freed.  This means GPU_LoadTarget() needs to be paired with GPU_FreeTarget().
+        target->refcount++;
+        renderer->impl->FreeTarget(renderer, target);
+    }
+
+    if(renderer->current_context_target != NULL && image == ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image)
+    {
+        flushBlitBufferFor(renderer, GPU_FLUSH_TEXTURE_CHANGE);
+        ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image = NULL;
+    }
+
+    // Does the renderer data need to be freed too?
+    data = (GPU_IMAGE_DATA*)image->data;
+    if(data->refcount > 1)
+        data->refcount--;
+    else
+    {
+        #ifdef SDL_GPU_CPU_RASTERIZE
+        SDL_FreeSurface(data->pixels);
+        #endif
+        SDL_free(data);
+    }
+
+    SDL_free(image);
+}
+
+static GPU_Target* GetTarget(GPU_Renderer* renderer, GPU_Image* image)
+{
+	GPU_Target* result;
+	GPU_TARGET_DATA* data;
+
+    if(image == NULL)
+        return NULL;
+
+    if(image->target != NULL)
+        return image->target;
+
+    result = (GPU_Target*)SDL_malloc(sizeof(GPU_Target));
+    memset(result, 0, sizeof(GPU_Target));
+    result->refcount = 0;
+    data = (GPU_TARGET_DATA*)SDL_malloc(sizeof(GPU_TARGET_DATA));
+    data->refcount = 1;
+    data->handle = nextObjectID((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data);
+    result->data = data;
+
+    result->renderer = renderer;
+    result->context_target = renderer->current_context_target;
+    result->context = NULL;
+    result->image = image;
+    result->w = image->w;
+    result->h = image->h;
+    result->base_w = image->texture_w;
+    result->base_h = image->texture_h;
+    result->using_virtual_resolution = image->using_virtual_resolution;
+
+    result->viewport = GPU_MakeRect(0, 0, result->w, result->h);
+
+	result->matrix_mode = GPU_MODEL;
+	GPU_InitMatrixStack(&result->projection_matrix);
+	GPU_InitMatrixStack(&result->view_matrix);
+	GPU_InitMatrixStack(&result->model_matrix);
+
+    result->camera = GPU_GetDefaultCamera();
+    result->use_camera = GPU_TRUE;
+
+    // Set up default projection matrix
+    GPU_ResetProjection(result);
+
+    result->use_depth_test = GPU_FALSE;
+    result->use_depth_write = GPU_TRUE;
+    result->use_culling = GPU_FALSE;
+
+    result->use_clip_rect = GPU_FALSE;
+    result->clip_rect = GPU_MakeRect(0, 0, result->w, result->h);
+    result->use_color = GPU_FALSE;
+
+    image->target = result;
+    return result;
+}
+
+static void FreeTargetData(GPU_TARGET_DATA* data)
+{
+    if(data == NULL)
+        return;
+
+    if(data->refcount > 1)
+    {
+        data->refcount--;
+        return;
+    }
+
+    SDL_free(data);
+}
+
+static void FreeContext(GPU_Context* context)
+{
+    GPU_CONTEXT_DATA* cdata;
+
+    if(context == NULL)
+        return;
+
+    if(context->refcount > 1)
+    {
+        context->refcount--;
+        return;
+    }
+
+    cdata = (GPU_CONTEXT_DATA*)context->data;
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    freeRasterizer(cdata);
+    if(cdata->framebuffer != NULL)
+        SDL_FreeSurface(cdata->framebuffer);
+    #endif
+    SDL_free(cdata->blit_buffer);
+    SDL_free(cdata->index_buffer);
+    SDL_free(cdata);
+    SDL_free(context);
+}
+
+static void FreeTarget(GPU_Renderer* renderer, GPU_Target* target)
+{
+    if(target == NULL)
+        return;
+
+    if(target->refcount > 1)
+    {
+        target->refcount--;
+        return;
+    }
+
+    // Time to actually free this target
+
+    // Prepare to work in this target's context, if it has one
+    if(target == renderer->current_context_target)
+        flushBlitBufferFor(renderer, GPU_FLUSH_TARGET_SWITCH);
+    else if(target->context_target != NULL && target->context_target != target)
+        GPU_MakeCurrent(target->context_target, target->context_target->context->windowID);
+
+    FreeTargetData((GPU_TARGET_DATA*)target->data);
+
+    // Release context reference
+    if(target->context != NULL)
+    {
+        // Remove all of the window mappings that refer to this target
+        GPU_RemoveWindowMappingByTarget(target);
+
+        FreeContext(target->context);
+    }
+
+    // Clear references to this target
+    if(target == renderer->current_context_target)
+        renderer->current_context_target = NULL;
+
+    // Make sure this target is not referenced by the context
+    if(renderer->current_context_target != NULL)
+    {
+        GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+        if(cdata->last_image == target->image)
+            cdata->last_image = NULL;
+        if(cdata->sorted_batch_target == target)
+            cdata->sorted_batch_target = NULL;
+
+        if(target == renderer->current_context_target->context->active_target)
+            renderer->current_context_target->context->active_target = NULL;
+    }
+
+    if(target->image != NULL)
+    {
+        // Make sure this is not targeted by an image that will persist
+        if(target->image->target == target)
+            target->image->target = NULL;
+    }
+
+	// Delete matrices
+	GPU_ClearMatrixStack(&target->projection_matrix);
+	GPU_ClearMatrixStack(&target->view_matrix);
+	GPU_ClearMatrixStack(&target->model_matrix);
+
+    SDL_free(target);
+}
+
+
+
+#define SET_VERTEX_COLOR(r, g, b, a) \
+    blit_buffer[color_index] = r; \
+    blit_buffer[color_index+1] = g; \
+    blit_buffer[color_index+2] = b; \
+    blit_buffer[color_index+3] = a;
+
+#define SET_UNTEXTURED_VERTEX(x, y, r, g, b, a) \
+    blit_buffer[vert_index] = x; \
+    blit_buffer[vert_index+1] = y; \
+    SET_VERTEX_COLOR(r, g, b, a); \
+    index_buffer[cdata->index_buffer_num_vertices++] = cdata->blit_buffer_num_vertices++; \
+    vert_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
+    color_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+
+#define SET_INDEXED_VERTEX(offset) \
+    index_buffer[cdata->index_buffer_num_vertices++] = blit_buffer_starting_index + (GPU_BLIT_INDEX_TYPE)(offset);
+
+#define SET_RELATIVE_INDEXED_VERTEX(offset) \
+    index_buffer[cdata->index_buffer_num_vertices++] = cdata->blit_buffer_num_vertices + (GPU_BLIT_INDEX_TYPE)(offset);
+
+#define BEGIN_UNTEXTURED_SEGMENTS(x1, y1, x2, y2, r, g, b, a) \
+    SET_UNTEXTURED_VERTEX(x1, y1, r, g, b, a); \
+    SET_UNTEXTURED_VERTEX(x2, y2, r, g, b, a);
+
+// Finish previous triangles and start the next one
+#define SET_UNTEXTURED_SEGMENTS(x1, y1, x2, y2, r, g, b, a) \
+    SET_UNTEXTURED_VERTEX(x1, y1, r, g, b, a); \
+    SET_RELATIVE_INDEXED_VERTEX(-2); \
+    SET_UNTEXTURED_VERTEX(x2, y2, r, g, b, a); \
+    SET_RELATIVE_INDEXED_VERTEX(-2); \
+    SET_RELATIVE_INDEXED_VERTEX(-2); \
+    SET_RELATIVE_INDEXED_VERTEX(-1);
+
+// Finish previous triangles
+#define LOOP_UNTEXTURED_SEGMENTS() \
+    SET_INDEXED_VERTEX(0); \
+    SET_RELATIVE_INDEXED_VERTEX(-1); \
+    SET_INDEXED_VERTEX(1); \
+    SET_INDEXED_VERTEX(0);
+
+#define END_UNTEXTURED_SEGMENTS(x1, y1, x2, y2, r, g, b, a) \
+    SET_UNTEXTURED_VERTEX(x1, y1, r, g, b, a); \
+    SET_RELATIVE_INDEXED_VERTEX(-2); \
+    SET_UNTEXTURED_VERTEX(x2, y2, r, g, b, a); \
+    SET_RELATIVE_INDEXED_VERTEX(-2);
+
+
+// Checks shared by the blit functions.  Makes the target's context current.
+static GPU_bool checkBlitArguments(GPU_Renderer* renderer, const char* function_name, GPU_Image* image, GPU_Target* target)
+{
+    if(image == NULL)
+    {
+        GPU_PushErrorCode(function_name, GPU_ERROR_NULL_ARGUMENT, "image");
+        return GPU_FALSE;
+    }
+    if(target == NULL)
+    {
+        GPU_PushErrorCode(function_name, GPU_ERROR_NULL_ARGUMENT, "target");
+        return GPU_FALSE;
+    }
+    if(renderer != image->renderer || renderer != target->renderer)
+    {
+        GPU_PushErrorCode(function_name, GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return GPU_FALSE;
+    }
+
+    makeContextCurrent(renderer, target);
+    if(renderer->current_context_target == NULL)
+    {
+        GPU_PushErrorCode(function_name, GPU_ERROR_USER_ERROR, "NULL context");
+        return GPU_FALSE;
+    }
+    return GPU_TRUE;
+}
+
+// Sets up the state for blitting the image, like the GL renderers do before they write to the blit buffer
+static GPU_bool prepareToBlit(GPU_Renderer* renderer, const char* function_name, GPU_Image* image, GPU_Target* target)
+{
+    prepareToRenderToTarget(renderer, target);
+    prepareToRenderImage(renderer, image);
+    bindTexture(renderer, image);
+
+    if(!SetActiveTarget(renderer, target))
+    {
+        GPU_PushErrorCode(function_name, GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+        return GPU_FALSE;
+    }
+    return GPU_TRUE;
+}
+
+// Makes room in the blit buffer for one more sprite
+static void reserveSprite(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata)
+{
+    if(cdata->blit_buffer_num_vertices + GPU_BLIT_BUFFER_VERTICES_PER_SPRITE >= cdata->blit_buffer_max_num_vertices)
+    {
+        if(!growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + GPU_BLIT_BUFFER_VERTICES_PER_SPRITE))
+            flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL);
+    }
+    if(cdata->index_buffer_num_vertices + 6 >= cdata->index_buffer_max_num_vertices)
+    {
+        if(!growIndexBuffer(cdata, cdata->index_buffer_num_vertices + 6))
+            flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL);
+    }
+}
+
+/* Writes one sprite into the blit buffer.  'corners' holds x, y, s, t for each corner, going around the quad.
+   'colors' is one r, g, b, a for the whole sprite, or one per corner if 'color_per_corner' is set. */
+static void addSprite(GPU_CONTEXT_DATA* cdata, const float* corners, const float* colors, GPU_bool color_per_corner)
+{
+    float* blit_buffer = cdata->blit_buffer + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+    GPU_BLIT_INDEX_TYPE* index_buffer = cdata->index_buffer + cdata->index_buffer_num_vertices;
+    GPU_BLIT_INDEX_TYPE first = (GPU_BLIT_INDEX_TYPE)cdata->blit_buffer_num_vertices;
+    int i;
+
+    for(i = 0; i < 4; i++)
+    {
+        const float* color = (color_per_corner? colors + 4*i : colors);
+        blit_buffer[GPU_BLIT_BUFFER_VERTEX_OFFSET] = corners[4*i];
+        blit_buffer[GPU_BLIT_BUFFER_VERTEX_OFFSET+1] = corners[4*i + 1];
+        blit_buffer[GPU_BLIT_BUFFER_TEX_COORD_OFFSET] = corners[4*i + 2];
+        blit_buffer[GPU_BLIT_BUFFER_TEX_COORD_OFFSET+1] = corners[4*i + 3];
+        blit_buffer[GPU_BLIT_BUFFER_COLOR_OFFSET] = color[0];
+        blit_buffer[GPU_BLIT_BUFFER_COLOR_OFFSET+1] = color[1];
+        blit_buffer[GPU_BLIT_BUFFER_COLOR_OFFSET+2] = color[2];
+        blit_buffer[GPU_BLIT_BUFFER_COLOR_OFFSET+3] = color[3];
+        blit_buffer += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+    }
+
+    // 6 Triangle indices
+    index_buffer[0] = first;
+    index_buffer[1] = first + 1;
+    index_buffer[2] = first + 2;
+    index_buffer[3] = first;
+    index_buffer[4] = first + 2;
+    index_buffer[5] = first + 3;
+
+    cdata->blit_buffer_num_vertices += GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+    cdata->index_buffer_num_vertices += 6;
+}
+
+static_inline void getNormalizedColor(SDL_Color color, float* result)
+{
+    result[0] = color.r/255.0f;
+    result[1] = color.g/255.0f;
+    result[2] = color.b/255.0f;
+    result[3] = GET_ALPHA(color)/255.0f;
+}
+
+// Texture coords (s1, t1, s2, t2) and size in pixels of the part of the image that gets drawn
+static void getSourceRect(GPU_Image* image, GPU_Rect* src_rect, float* tex_coords, float* w, float* h)
+{
+    Uint32 tex_w = image->texture_w;
+    Uint32 tex_h = image->texture_h;
+
+    if(src_rect == NULL)
+    {
+        tex_coords[0] = 0.0f;
+        tex_coords[1] = 0.0f;
+        tex_coords[2] = ((float)image->w)/tex_w;
+        tex_coords[3] = ((float)image->h)/tex_h;
+        *w = image->w;
+        *h = image->h;
+    }
+    else
+    {
+        tex_coords[0] = src_rect->x/(float)tex_w;
+        tex_coords[1] = src_rect->y/(float)tex_h;
+        tex_coords[2] = (src_rect->x + src_rect->w)/(float)tex_w;
+        tex_coords[3] = (src_rect->y + src_rect->h)/(float)tex_h;
+        *w = src_rect->w;
+        *h = src_rect->h;
+    }
+
+    if(image->using_virtual_resolution)
+    {
+        // Scale texture coords to fit the original dims
+        tex_coords[0] *= image->base_w/(float)image->w;
+        tex_coords[1] *= image->base_h/(float)image->h;
+        tex_coords[2] *= image->base_w/(float)image->w;
+        tex_coords[3] *= image->base_h/(float)image->h;
+    }
+}
+
+static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y)
+{
+	float tex_coords[4];
+	float w, h;
+	float dx1, dy1, dx2, dy2;
+	float corners[16];
+	float color[4];
+	GPU_CONTEXT_DATA* cdata;
+
+    if(!checkBlitArguments(renderer, "GPU_Blit", image, target))
+        return;
+
+    if(image->snap_mode == GPU_SNAP_POSITION || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
+    {
+        // Avoid rounding errors in texture sampling by insisting on integral pixel positions
+        x = floorf(x);
+        y = floorf(y);
+    }
+
+    getSourceRect(image, src_rect, tex_coords, &w, &h);
+
+    // Center the image on the given coords
+    dx1 = x - w * image->anchor_x;
+    dy1 = y - h * image->anchor_y;
+    dx2 = x + w * (1.0f - image->anchor_x);
+    dy2 = y + h * (1.0f - image->anchor_y);
+
+    if(image->snap_mode == GPU_SNAP_DIMENSIONS || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
+    {
+        float fractional;
+        fractional = w/2.0f - floorf(w/2.0f);
+        dx1 += fractional;
+        dx2 += fractional;
+        fractional = h/2.0f - floorf(h/2.0f);
+        dy1 += fractional;
+        dy2 += fractional;
+    }
+
+    // Drop it before touching any state if it can't be seen
+    if(isCulled(renderer, target, GL_TRIANGLES, dx1, dy1, dx2, dy2))
+        return;
+
+    if(!prepareToBlit(renderer, "GPU_Blit", image, target))
+        return;
+
+    if(renderer->coordinate_mode)
+    {
+        float temp = dy1;
+        dy1 = dy2;
+        dy2 = temp;
+    }
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    reserveSprite(renderer, cdata);
+
+    corners[0] = dx1;
+    corners[1] = dy1;
+    corners[2] = tex_coords[0];
+    corners[3] = tex_coords[1];
+    corners[4] = dx2;
+    corners[5] = dy1;
+    corners[6] = tex_coords[2];
+    corners[7] = tex_coords[1];
+    corners[8] = dx2;
+    corners[9] = dy2;
+    corners[10] = tex_coords[2];
+    corners[11] = tex_coords[3];
+    corners[12] = dx1;
+    corners[13] = dy2;
+    corners[14] = tex_coords[0];
+    corners[15] = tex_coords[3];
+
+    getNormalizedColor(get_complete_mod_color(renderer, target, image), color);
+    addSprite(cdata, corners, color, GPU_FALSE);
+}
+
+static void BlitTransformX(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float pivot_x, float pivot_y, float degrees, float scaleX, float scaleY)
+{
+	float tex_coords[4];
+	float w, h;
+	float dx1, dy1, dx2, dy2, dx3, dy3, dx4, dy4;
+	float corners[16];
+	float color[4];
+	GPU_CONTEXT_DATA* cdata;
+
+    if(!checkBlitArguments(renderer, "GPU_BlitTransformX", image, target))
+        return;
+
+    if(image->snap_mode == GPU_SNAP_POSITION || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
+    {
+        // Avoid rounding errors in texture sampling by insisting on integral pixel positions
+        x = floorf(x);
+        y = floorf(y);
+    }
+
+    getSourceRect(image, src_rect, tex_coords, &w, &h);
+
+    // Create vertices about the anchor
+    dx1 = -pivot_x;
+    dy1 = -pivot_y;
+    dx2 = w - pivot_x;
+    dy2 = h - pivot_y;
+
+    if(image->snap_mode == GPU_SNAP_DIMENSIONS || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
+    {
+        // This is a little weird for rotating sprites, but oh well.
+        float fractional;
+        fractional = w/2.0f - floorf(w/2.0f);
+        dx1 += fractional;
+        dx2 += fractional;
+        fractional = h/2.0f - floorf(h/2.0f);
+        dy1 += fractional;
+        dy2 += fractional;
+    }
+
+    // Drop it before touching any state if it can't be seen.  Any rotation of the scaled quad stays within this radius of the anchor.
+    {
+        float far_x = (fabsf(dx1) > fabsf(dx2)? fabsf(dx1) : fabsf(dx2));
+        float far_y = (fabsf(dy1) > fabsf(dy2)? fabsf(dy1) : fabsf(dy2));
+        float scale = (fabsf(scaleX) > fabsf(scaleY)? fabsf(scaleX) : fabsf(scaleY));
+        float radius = sqrtf(far_x*far_x + far_y*far_y) * scale;
+        if(isCulled(renderer, target, GL_TRIANGLES, x - radius, y - radius, x + radius, y + radius))
+            return;
+    }
+
+    if(!prepareToBlit(renderer, "GPU_BlitTransformX", image, target))
+        return;
+
+    if(renderer->coordinate_mode == 1)
+    {
+        float temp = dy1;
+        dy1 = dy2;
+        dy2 = temp;
+    }
+
+    // Scale about the anchor
+    if(scaleX != 1.0f || scaleY != 1.0f)
+    {
+        dx1 *= scaleX;
+        dy1 *= scaleY;
+        dx2 *= scaleX;
+        dy2 *= scaleY;
+    }
+
+    // Get extra vertices for rotation
+    dx3 = dx2;
+    dy3 = dy1;
+    dx4 = dx1;
+    dy4 = dy2;
+
+    // Rotate about the anchor
+    if(degrees != 0.0f)
+    {
+        float cosA = cosf(degrees*RAD_PER_DEG);
+        float sinA = sinf(degrees*RAD_PER_DEG);
+        float tempX = dx1;
+        dx1 = dx1*cosA - dy1*sinA;
+        dy1 = tempX*sinA + dy1*cosA;
+        tempX = dx2;
+        dx2 = dx2*cosA - dy2*sinA;
+        dy2 = tempX*sinA + dy2*cosA;
+        tempX = dx3;
+        dx3 = dx3*cosA - dy3*sinA;
+        dy3 = tempX*sinA + dy3*cosA;
+        tempX = dx4;
+        dx4 = dx4*cosA - dy4*sinA;
+        dy4 = tempX*sinA + dy4*cosA;
+    }
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    reserveSprite(renderer, cdata);
+
+    corners[0] = dx1 + x;
+    corners[1] = dy1 + y;
+    corners[2] = tex_coords[0];
+    corners[3] = tex_coords[1];
+    corners[4] = dx3 + x;
+    corners[5] = dy3 + y;
+    corners[6] = tex_coords[2];
+    corners[7] = tex_coords[1];
+    corners[8] = dx2 + x;
+    corners[9] = dy2 + y;
+    corners[10] = tex_coords[2];
+    corners[11] = tex_coords[3];
+    corners[12] = dx4 + x;
+    corners[13] = dy4 + y;
+    corners[14] = tex_coords[0];
+    corners[15] = tex_coords[3];
+
+    getNormalizedColor(get_complete_mod_color(renderer, target, image), color);
+    addSprite(cdata, corners, color, GPU_FALSE);
+}
+
+static void BlitRotate(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float degrees)
+{
+	float w, h;
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitRotate", GPU_ERROR_NULL_ARGUMENT, "image");
+        return;
+    }
+
+    w = (src_rect == NULL? image->w : src_rect->w);
+    h = (src_rect == NULL? image->h : src_rect->h);
+    renderer->impl->BlitTransformX(renderer, image, src_rect, target, x, y, w*image->anchor_x, h*image->anchor_y, degrees, 1.0f, 1.0f);
+}
+
+static void BlitScale(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float scaleX, float scaleY)
+{
+	float w, h;
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitScale", GPU_ERROR_NULL_ARGUMENT, "image");
+        return;
+    }
+
+    w = (src_rect == NULL? image->w : src_rect->w);
+    h = (src_rect == NULL? image->h : src_rect->h);
+    renderer->impl->BlitTransformX(renderer, image, src_rect, target, x, y, w*image->anchor_x, h*image->anchor_y, 0.0f, scaleX, scaleY);
+}
+
+static void BlitTransform(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float degrees, float scaleX, float scaleY)
+{
+	float w, h;
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitTransform", GPU_ERROR_NULL_ARGUMENT, "image");
+        return;
+    }
+
+    w = (src_rect == NULL? image->w : src_rect->w);
+    h = (src_rect == NULL? image->h : src_rect->h);
+    renderer->impl->BlitTransformX(renderer, image, src_rect, target, x, y, w*image->anchor_x, h*image->anchor_y, degrees, scaleX, scaleY);
+}
+
+static void blitSpriteBatch(GPU_Renderer* renderer, const char* function_name, GPU_Image* image, GPU_Target* target, unsigned int num_sprites,
+                            float* positions, int position_stride, float* src_rects, int rect_stride, float* colors, int color_stride, GPU_BlitFlagEnum flags)
+{
+	Uint32 tex_w, tex_h;
+	float corners[16];
+	float corner_colors[16];
+	float mod_color[4];
+	GPU_CONTEXT_DATA* cdata;
+	unsigned int n;
+	int i;
+	GPU_bool pass_vertices = (positions != NULL && (flags & GPU_PASSTHROUGH_VERTICES));
+	GPU_bool pass_texcoords = (src_rects != NULL && (flags & GPU_PASSTHROUGH_TEXCOORDS));
+	GPU_bool pass_colors = (colors != NULL && (flags & GPU_PASSTHROUGH_COLORS));
+
+    if(!checkBlitArguments(renderer, function_name, image, target))
+        return;
+    if(num_sprites == 0)
+        return;
+
+    // State setup happens once for the whole batch
+    if(!prepareToBlit(renderer, function_name, image, target))
+        return;
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+
+    // Make room for the whole batch up front if we can
+    growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + num_sprites*GPU_BLIT_BUFFER_VERTICES_PER_SPRITE);
+    growIndexBuffer(cdata, cdata->index_buffer_num_vertices + num_sprites*6);
+
+    tex_w = image->texture_w;
+    tex_h = image->texture_h;
+
+    getNormalizedColor(get_complete_mod_color(renderer, target, image), mod_color);
+
+    for(n = 0; n < num_sprites; n++)
+    {
+        float x1, y1, x2, y2;
+        float w, h;
+
+        // Texture coords
+        if(src_rects == NULL)
+        {
+            x1 = 0.0f;
+            y1 = 0.0f;
+            x2 = ((float)image->w)/tex_w;
+            y2 = ((float)image->h)/tex_h;
+        }
+        else if(pass_texcoords)
+        {
+            // Corners 0 and 2 give the extent, which we need for positioning
+            x1 = src_rects[0];
+            y1 = src_rects[1];
+            x2 = src_rects[4];
+            y2 = src_rects[5];
+        }
+        else
+        {
+            x1 = src_rects[0]/(float)tex_w;
+            y1 = src_rects[1]/(float)tex_h;
+            x2 = (src_rects[0] + src_rects[2])/(float)tex_w;
+            y2 = (src_rects[1] + src_rects[3])/(float)tex_h;
+        }
+
+        w = (src_rects == NULL? image->w : (x2 - x1)*tex_w);
+        h = (src_rects == NULL? image->h : (y2 - y1)*tex_h);
+
+        if(image->using_virtual_resolution && !pass_texcoords)
+        {
+            // Scale texture coords to fit the original dims
+            x1 *= image->base_w/(float)image->w;
+            y1 *= image->base_h/(float)image->h;
+            x2 *= image->base_w/(float)image->w;
+            y2 *= image->base_h/(float)image->h;
+        }
+
+        // Position
+        if(pass_vertices)
+        {
+            for(i = 0; i < 4; i++)
+            {
+                corners[4*i] = positions[2*i];
+                corners[4*i + 1] = positions[2*i + 1];
+            }
+        }
+        else
+        {
+            float x = 0.0f;
+            float y = 0.0f;
+            float dx1, dy1, dx2, dy2;
+            if(positions != NULL)
+            {
+                x = positions[0];
+                y = positions[1];
+            }
+
+            if(image->snap_mode == GPU_SNAP_POSITION || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
+            {
+                x = floorf(x);
+                y = floorf(y);
+            }
+
+            dx1 = x - w * image->anchor_x;
+            dy1 = y - h * image->anchor_y;
+            dx2 = x + w * (1.0f - image->anchor_x);
+            dy2 = y + h * (1.0f - image->anchor_y);
+
+            if(image->snap_mode == GPU_SNAP_DIMENSIONS || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
+            {
+                float fractional;
+                fractional = w/2.0f - floorf(w/2.0f);
+                dx1 += fractional;
+                dx2 += fractional;
+                fractional = h/2.0f - floorf(h/2.0f);
+                dy1 += fractional;
+                dy2 += fractional;
+            }
+
+            if(renderer->coordinate_mode)
+            {
+                float temp = dy1;
+                dy1 = dy2;
+                dy2 = temp;
+            }
+
+            corners[0] = corners[12] = dx1;
+            corners[1] = corners[5] = dy1;
+            corners[4] = corners[8] = dx2;
+            corners[9] = corners[13] = dy2;
+        }
+
+        if(pass_texcoords)
+        {
+            for(i = 0; i < 4; i++)
+            {
+                corners[4*i + 2] = src_rects[2*i];
+                corners[4*i + 3] = src_rects[2*i + 1];
+            }
+        }
+        else
+        {
+            corners[2] = corners[14] = x1;
+            corners[3] = corners[7] = y1;
+            corners[6] = corners[10] = x2;
+            corners[11] = corners[15] = y2;
+        }
+
+        // Color
+        if(pass_colors)
+            memcpy(corner_colors, colors, sizeof(corner_colors));
+        else if(colors != NULL)
+        {
+            for(i = 0; i < 4; i++)
+                corner_colors[i] = colors[i]/255.0f;
+        }
+
+        reserveSprite(renderer, cdata);
+        if(pass_colors)
+            addSprite(cdata, corners, corner_colors, GPU_TRUE);
+        else
+            addSprite(cdata, corners, (colors == NULL? mod_color : corner_colors), GPU_FALSE);
+
+        if(positions != NULL)
+            positions += position_stride;
+        if(src_rects != NULL)
+            src_rects += rect_stride;
+        if(colors != NULL)
+            colors += color_stride;
+    }
+}
+
+static void BlitBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* values, GPU_BlitFlagEnum flags)
+{
+    int position_floats = ((flags & GPU_PASSTHROUGH_VERTICES)? 8 : 2);
+    int rect_floats = ((flags & GPU_PASSTHROUGH_TEXCOORDS)? 8 : 4);
+    int color_floats = ((flags & GPU_PASSTHROUGH_COLORS)? 16 : 4);
+    int stride;
+
+    // Defaults take no space in the interleaved data
+    if(values == NULL || (flags & GPU_USE_DEFAULT_POSITIONS))
+        position_floats = 0;
+    if(values == NULL || (flags & GPU_USE_DEFAULT_SRC_RECTS))
+        rect_floats = 0;
+    if(values == NULL || (flags & GPU_USE_DEFAULT_COLORS))
+        color_floats = 0;
+
+    stride = position_floats + rect_floats + color_floats;
+
+    blitSpriteBatch(renderer, "GPU_BlitBatch", image, target, num_sprites,
+                    (position_floats == 0? NULL : values), stride,
+                    (rect_floats == 0? NULL : values + position_floats), stride,
+                    (color_floats == 0? NULL : values + position_floats + rect_floats), stride, flags);
+}
+
+static void BlitTransformBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* x, float* y, float* degrees, float* scale_x, float* scale_y,
+                               unsigned int num_src_rects, GPU_Rect* src_rects, Uint16* src_rect_indices, SDL_Color* colors)
+{
+	float chunk_x[GPU_TRANSFORM_BATCH_CHUNK], chunk_y[GPU_TRANSFORM_BATCH_CHUNK];
+	float chunk_degrees[GPU_TRANSFORM_BATCH_CHUNK], chunk_scale_x[GPU_TRANSFORM_BATCH_CHUNK], chunk_scale_y[GPU_TRANSFORM_BATCH_CHUNK];
+	float chunk_left[GPU_TRANSFORM_BATCH_CHUNK], chunk_top[GPU_TRANSFORM_BATCH_CHUNK], chunk_right[GPU_TRANSFORM_BATCH_CHUNK], chunk_bottom[GPU_TRANSFORM_BATCH_CHUNK];
+	float chunk_tex_coords[4*GPU_TRANSFORM_BATCH_CHUNK];
+	unsigned int chunk_sprite[GPU_TRANSFORM_BATCH_CHUNK];
+	float corners_x[4*GPU_TRANSFORM_BATCH_CHUNK], corners_y[4*GPU_TRANSFORM_BATCH_CHUNK];
+	float corners[16];
+	float mod_color[4];
+	float sprite_color[4];
+	GPU_CONTEXT_DATA* cdata;
+	unsigned int num_rects;
+	unsigned int start, i;
+	GPU_bool snap_position, snap_dimensions;
+	GPU_bool bad_index = GPU_FALSE;
+
+    if(!checkBlitArguments(renderer, "GPU_BlitTransformBatch", image, target))
+        return;
+    if(x == NULL || y == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitTransformBatch", GPU_ERROR_NULL_ARGUMENT, (x == NULL? "x" : "y"));
+        return;
+    }
+    if(num_sprites == 0)
+        return;
+
+    // State setup happens once for the whole batch
+    if(!prepareToBlit(renderer, "GPU_BlitTransformBatch", image, target))
+        return;
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+
+    // Make room for the whole batch up front if we can
+    growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + num_sprites*GPU_BLIT_BUFFER_VERTICES_PER_SPRITE);
+    growIndexBuffer(cdata, cdata->index_buffer_num_vertices + num_sprites*6);
+
+    snap_position = (image->snap_mode == GPU_SNAP_POSITION || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS);
+    snap_dimensions = (image->snap_mode == GPU_SNAP_DIMENSIONS || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS);
+    num_rects = ((src_rects == NULL || num_src_rects == 0)? 1 : num_src_rects);
+
+    getNormalizedColor(get_complete_mod_color(renderer, target, image), mod_color);
+
+    for(start = 0; start < num_sprites; start += GPU_TRANSFORM_BATCH_CHUNK)
+    {
+        unsigned int count = num_sprites - start;
+        unsigned int n = 0;
+        if(count > GPU_TRANSFORM_BATCH_CHUNK)
+            count = GPU_TRANSFORM_BATCH_CHUNK;
+
+        // Gather this chunk into flat arrays
+        for(i = start; i < start + count; i++)
+        {
+            unsigned int rect_index = ((src_rects == NULL || src_rect_indices == NULL)? 0 : src_rect_indices[i]);
+            float w, h;
+
+            if(rect_index >= num_rects)
+            {
+                if(!bad_index)
+                    GPU_PushErrorCode("GPU_BlitTransformBatch", GPU_ERROR_USER_ERROR, "Source rect index %u is out of range (%u rects).  Skipping those sprites.", rect_index, num_rects);
+                bad_index = GPU_TRUE;
+                continue;
+            }
+
+            getSourceRect(image, (src_rects == NULL || num_src_rects == 0? NULL : &src_rects[rect_index]), &chunk_tex_coords[4*n], &w, &h);
+
+            // Quad about the image's anchor, like GPU_BlitTransform()
+            chunk_left[n] = -w*image->anchor_x;
+            chunk_top[n] = -h*image->anchor_y;
+            chunk_right[n] = w - w*image->anchor_x;
+            chunk_bottom[n] = h - h*image->anchor_y;
+            if(snap_dimensions)
+            {
+                float fractional;
+                fractional = w/2.0f - floorf(w/2.0f);
+                chunk_left[n] += fractional;
+                chunk_right[n] += fractional;
+                fractional = h/2.0f - floorf(h/2.0f);
+                chunk_top[n] += fractional;
+                chunk_bottom[n] += fractional;
+            }
+            if(renderer->coordinate_mode == 1)
+            {
+                float temp = chunk_top[n];
+                chunk_top[n] = chunk_bottom[n];
+                chunk_bottom[n] = temp;
+            }
+
+            chunk_x[n] = (snap_position? floorf(x[i]) : x[i]);
+            chunk_y[n] = (snap_position? floorf(y[i]) : y[i]);
+            chunk_degrees[n] = (degrees == NULL? 0.0f : degrees[i]);
+            chunk_scale_x[n] = (scale_x == NULL? 1.0f : scale_x[i]);
+            chunk_scale_y[n] = (scale_y == NULL? 1.0f : scale_y[i]);
+            chunk_sprite[n] = i;
+            n++;
+        }
+
+        gpu_transform_quads(n, chunk_x, chunk_y, chunk_degrees, chunk_scale_x, chunk_scale_y, chunk_left, chunk_top, chunk_right, chunk_bottom, corners_x, corners_y);
+
+        for(i = 0; i < n; i++)
+        {
+            float* tex_coords = &chunk_tex_coords[4*i];
+            int k;
+            for(k = 0; k < 4; k++)
+            {
+                corners[4*k] = corners_x[k*n + i];
+                corners[4*k + 1] = corners_y[k*n + i];
+            }
+            corners[2] = corners[14] = tex_coords[0];
+            corners[3] = corners[7] = tex_coords[1];
+            corners[6] = corners[10] = tex_coords[2];
+            corners[11] = corners[15] = tex_coords[3];
+
+            if(colors != NULL)
+                getNormalizedColor(colors[chunk_sprite[i]], sprite_color);
+
+            reserveSprite(renderer, cdata);
+            addSprite(cdata, corners, (colors == NULL? mod_color : sprite_color), GPU_FALSE);
+        }
+    }
+}
+
+// Bytes that a GL renderer would upload for each vertex of a primitive batch
+static int getPrimitiveBatchStride(GPU_BatchFlagEnum flags)
+{
+    int stride = 0;
+    if(flags & GPU_BATCH_XYZ)
+        stride += 3*sizeof(float);
+    else if(flags & GPU_BATCH_XY)
+        stride += 2*sizeof(float);
+    if(flags & GPU_BATCH_ST)
+        stride += 2*sizeof(float);
+    if(flags & GPU_BATCH_RGBA)
+        stride += 4*sizeof(float);
+    else if(flags & GPU_BATCH_RGB)
+        stride += 3*sizeof(float);
+    else if(flags & GPU_BATCH_RGBA8)
+        stride += 4;
+    else if(flags & GPU_BATCH_RGB8)
+        stride += 3;
+    return stride;
+}
+
+static void doPrimitiveBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned int num_vertices, void* values, unsigned int num_indices, void* indices, int index_size, GPU_BatchFlagEnum flags, GPU_bool retained)
+{
+    GPU_Context* context;
+
+    #ifndef SDL_GPU_CPU_RASTERIZE
+    (void)values;
+    #endif
+
+    if(num_vertices == 0)
+        return;
+
+    if(target == NULL)
+    {
+        GPU_PushErrorCode("GPU_PrimitiveBatchX", GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+    if((image != NULL && renderer != image->renderer) || renderer != target->renderer)
+    {
+        GPU_PushErrorCode("GPU_PrimitiveBatchX", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+
+    makeContextCurrent(renderer, target);
+
+    if(image != NULL)
+        bindTexture(renderer, image);
+
+    if(!SetActiveTarget(renderer, target))
+    {
+        GPU_PushErrorCode("GPU_PrimitiveBatchX", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+        return;
+    }
+
+    prepareToRenderToTarget(renderer, target);
+    if(image != NULL)
+        prepareToRenderImage(renderer, image);
+    else
+        prepareToRenderShapes(renderer, primitive_type);
+
+    // Primitive batches are drawn right away instead of going through the blit buffer
+    flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
+
+    context = renderer->current_context_target->context;
+    gpu_get_modelviewprojection(target, ((GPU_CONTEXT_DATA*)context->data)->last_mvp);
+
+    if(indices == NULL)
+        num_indices = num_vertices;
+
+    GPU_COUNT_FRAME_STAT(context, draw_calls, 1);
+    GPU_COUNT_FRAME_STAT(context, vertices, num_indices);
+    // Vertex buffers would already be on the GPU
+    if(!retained)
+        GPU_COUNT_FRAME_STAT(context, bytes_uploaded, getPrimitiveBatchStride(flags) * num_vertices + (indices != NULL? index_size*num_indices : 0));
+
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    if(values != NULL)
+    {
+        // Unpack the values into the blit buffer layout
+        SDL_Color color = get_complete_mod_color(renderer, target, image);
+        int stride = getPrimitiveBatchStride(flags);
+        const Uint8* src = (const Uint8*)values;
+        float* vertices = (float*)SDL_malloc(num_vertices * GPU_BLIT_BUFFER_STRIDE);
+        float* v;
+        unsigned int i;
+
+        if(vertices == NULL)
+            return;
+
+        for(i = 0, v = vertices; i < num_vertices; i++, src += stride, v += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX)
+        {
+            // Depth is dropped
+            const Uint8* p = src;
+            memcpy(v, p, 2*sizeof(float));
+            p += ((flags & GPU_BATCH_XYZ)? 3 : 2)*sizeof(float);
+
+            if(flags & GPU_BATCH_ST)
+            {
+                memcpy(v + 2, p, 2*sizeof(float));
+                p += 2*sizeof(float);
+            }
+            else
+                v[2] = v[3] = 0.0f;
+
+            if(flags & (GPU_BATCH_RGB | GPU_BATCH_RGBA))
+            {
+                memcpy(v + 4, p, 3*sizeof(float));
+                if(flags & GPU_BATCH_RGBA)
+                    memcpy(v + 7, p + 3*sizeof(float), sizeof(float));
+                else
+                    v[7] = 1.0f;
+            }
+            else if(flags & (GPU_BATCH_RGB8 | GPU_BATCH_RGBA8))
+            {
+                v[4] = p[0]/255.0f;
+                v[5] = p[1]/255.0f;
+                v[6] = p[2]/255.0f;
+                v[7] = ((flags & GPU_BATCH_RGBA8)? p[3]/255.0f : 1.0f);
+            }
+            else
+            {
+                v[4] = color.r/255.0f;
+                v[5] = color.g/255.0f;
+                v[6] = color.b/255.0f;
+                v[7] = GET_ALPHA(color)/255.0f;
+            }
+        }
+
+        rasterizeVertices(renderer, target, image, primitive_type, vertices, num_vertices, indices, index_size, num_indices);
+        SDL_free(vertices);
+    }
+    #endif
+}
+
+static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned short num_vertices, void* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags)
+{
+    doPrimitiveBatch(renderer, image, target, primitive_type, num_vertices, values, num_indices, indices, sizeof(unsigned short), flags, GPU_FALSE);
+}
+
+static void PrimitiveBatchV32(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned int num_vertices, void* values, unsigned int num_indices, unsigned int* indices, GPU_BatchFlagEnum flags)
+{
+    doPrimitiveBatch(renderer, image, target, primitive_type, num_vertices, values, num_indices, indices, sizeof(unsigned int), flags, GPU_FALSE);
+}
+
+// Vertex buffers are kept in CPU memory and drawn like primitive batches
+typedef struct VertexBufferData
+{
+    void* values;
+    unsigned int* indices;
+    int stride;
+} VertexBufferData;
+
+static GPU_VertexBuffer* CreateVertexBuffer(GPU_Renderer* renderer, GPU_BatchFlagEnum flags, unsigned int num_vertices, void* values, unsigned int num_indices, unsigned int* indices)
+{
+    GPU_VertexBuffer* result;
+    VertexBufferData* data;
+    int stride = getPrimitiveBatchStride(flags);
+
+    if(stride == 0)
+    {
+        GPU_PushErrorCode("GPU_CreateVertexBuffer", GPU_ERROR_DATA_ERROR, "Flags give no vertex data");
+        return NULL;
+    }
+    if(indices == NULL)
+        num_indices = 0;
+
+    data = (VertexBufferData*)SDL_malloc(sizeof(VertexBufferData));
+    data->stride = stride;
+    data->values = SDL_malloc(num_vertices * stride);
+    if(values != NULL)
+        memcpy(data->values, values, num_vertices * stride);
+    else
+        memset(data->values, 0, num_vertices * stride);
+    data->indices = NULL;
+    if(num_indices > 0)
+    {
+        data->indices = (unsigned int*)SDL_malloc(num_indices * sizeof(unsigned int));
+        memcpy(data->indices, indices, num_indices * sizeof(unsigned int));
+    }
+
+    if(renderer->current_context_target != NULL)
+        GPU_COUNT_FRAME_STAT(renderer->current_context_target->context, bytes_uploaded, (values != NULL? num_vertices * stride : 0) + num_indices * sizeof(unsigned int));
+
+    result = (GPU_VertexBuffer*)SDL_malloc(sizeof(GPU_VertexBuffer));
+    result->renderer = renderer;
+    result->flags = flags;
+    result->num_vertices = num_vertices;
+    result->num_indices = num_indices;
+    result->data = data;
+    return result;
+}
+
+static void UpdateVertexBuffer(GPU_Renderer* renderer, GPU_VertexBuffer* buffer, unsigned int first_vertex, unsigned int num_vertices, void* values)
+{
+    VertexBufferData* data = (VertexBufferData*)buffer->data;
+
+    memcpy((Uint8*)data->values + first_vertex * data->stride, values, num_vertices * data->stride);
+    if(renderer->current_context_target != NULL)
+        GPU_COUNT_FRAME_STAT(renderer->current_context_target->context, bytes_uploaded, num_vertices * data->stride);
+}
+
+static void DrawVertexBuffer(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_VertexBuffer* buffer, GPU_PrimitiveEnum primitive_type, unsigned int first, unsigned int count)
+{
+    VertexBufferData* data = (VertexBufferData*)buffer->data;
+
+    if(renderer != buffer->renderer)
+    {
+        GPU_PushErrorCode("GPU_DrawVertexBuffer", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+
+    if(buffer->num_indices > 0)
+        doPrimitiveBatch(renderer, image, target, primitive_type, buffer->num_vertices, data->values, count, data->indices + first, sizeof(unsigned int), buffer->flags, GPU_TRUE);
+    else
+        doPrimitiveBatch(renderer, image, target, primitive_type, count, (Uint8*)data->values + first*data->stride, 0, NULL, sizeof(unsigned int), buffer->flags, GPU_TRUE);
+}
+
+static void FreeVertexBuffer(GPU_Renderer* renderer, GPU_VertexBuffer* buffer)
+{
+    VertexBufferData* data = (VertexBufferData*)buffer->data;
+    (void)renderer;
+
+    SDL_free(data->values);
+    SDL_free(data->indices);
+    SDL_free(data);
+    SDL_free(buffer);
+}
+
+static void GenerateMipmaps(GPU_Renderer* renderer, GPU_Image* image)
+{
+    if(image == NULL)
+        return;
+
+    flushBlitBufferIfCurrentTexture(renderer, image);
+    image->has_mipmaps = GPU_TRUE;
+}
+
+static SDL_Color GetPixel(GPU_Renderer* renderer, GPU_Target* target, Sint16 x, Sint16 y)
+{
+    SDL_Color result = {0,0,0,0};
+    if(target == NULL)
+        return result;
+    if(renderer != target->renderer)
+        return result;
+    if(x < 0 || y < 0 || x >= target->w || y >= target->h)
+        return result;
+
+    if(isCurrentTarget(renderer, target))
+        flushBlitBufferFor(renderer, GPU_FLUSH_READBACK);
+    SetActiveTarget(renderer, target);
+
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    {
+        // Read the pixel that a draw at (x, y) would cover
+        SDL_Surface* surface = getTargetSurface(target);
+        int px, py;
+        Uint8* pixel;
+        if(surface == NULL)
+            return result;
+
+        px = (int)(x * (float)surface->w / target->w);
+        py = (int)(y * (float)surface->h / target->h);
+        if(target->context != NULL && renderer->coordinate_mode != 0)
+            py = surface->h - 1 - py;
+        if(px < 0 || py < 0 || px >= surface->w || py >= surface->h)
+            return result;
+
+        pixel = (Uint8*)(getPixelRow(surface, py) + px);
+        result.r = pixel[0];
+        result.g = pixel[1];
+        result.b = pixel[2];
+        GET_ALPHA(result) = pixel[3];
+    }
+    #endif
+
+    return result;
+}
+
+// There is no sync point to save, so this only saves the flush checks
+static void GetPixels(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_points, const Sint16* points, SDL_Color* colors)
+{
+    unsigned int i;
+    for(i = 0; i < num_points; i++)
+        colors[i] = GetPixel(renderer, target, points[2*i], points[2*i+1]);
+}
+
+static void SetImageFilter(GPU_Renderer* renderer, GPU_Image* image, GPU_FilterEnum filter)
+{
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_SetImageFilter", GPU_ERROR_NULL_ARGUMENT, "image");
+        return;
+    }
+    if(renderer != image->renderer)
+    {
+        GPU_PushErrorCode("GPU_SetImageFilter", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+    if(filter != GPU_FILTER_NEAREST && filter != GPU_FILTER_LINEAR && filter != GPU_FILTER_LINEAR_MIPMAP)
+    {
+        GPU_PushErrorCode("GPU_SetImageFilter", GPU_ERROR_USER_ERROR, "Unsupported value for filter (0x%x)", filter);
+        return;
+    }
+
+    flushBlitBufferIfCurrentTexture(renderer, image);
+    image->filter_mode = filter;
+}
+
+static void SetWrapMode(GPU_Renderer* renderer, GPU_Image* image, GPU_WrapEnum wrap_mode_x, GPU_WrapEnum wrap_mode_y)
+{
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_SetWrapMode", GPU_ERROR_NULL_ARGUMENT, "image");
+        return;
+    }
+    if(renderer != image->renderer)
+    {
+        GPU_PushErrorCode("GPU_SetWrapMode", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+
+    flushBlitBufferIfCurrentTexture(renderer, image);
+    image->wrap_mode_x = wrap_mode_x;
+    image->wrap_mode_y = wrap_mode_y;
+}
+
+static void ClearRGBA(GPU_Renderer* renderer, GPU_Target* target, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    #ifndef SDL_GPU_CPU_RASTERIZE
+    (void)r;
+    (void)g;
+    (void)b;
+    (void)a;
+    #endif
+
+    if(target == NULL)
+        return;
+    if(renderer != target->renderer)
+        return;
+
+    makeContextCurrent(renderer, target);
+
+    if(isCurrentTarget(renderer, target))
+        renderer->impl->FlushBlitBuffer(renderer);
+    SetActiveTarget(renderer, target);
+
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    {
+        // Like glClear(), this respects the clip rect
+        SDL_Surface* surface = getTargetSurface(target);
+        int x1, y1, x2, y2;
+        if(surface == NULL)
+            return;
+
+        getClipPixels(renderer, target, surface, &x1, &y1, &x2, &y2);
+        fillPixels(surface, x1, y1, x2, y2, packPixel(r, g, b, a));
+    }
+    #endif
+}
+
+static void FlushBlitBuffer(GPU_Renderer* renderer)
+{
+    GPU_Context* context;
+    GPU_CONTEXT_DATA* cdata;
+    GPU_FlushCauseEnum cause;
+    if(renderer->current_context_target == NULL)
+        return;
+
+    context = renderer->current_context_target->context;
+    cdata = (GPU_CONTEXT_DATA*)context->data;
+
+    // Anything that doesn't say otherwise is an explicit flush
+    cause = context->flush_cause;
+    context->flush_cause = GPU_FLUSH_EXPLICIT;
+
+    if(cdata->blit_buffer_num_vertices > 0 && context->active_target != NULL)
+    {
+        GPU_Target* dest = context->active_target;
+
+        GPU_COUNT_FRAME_STAT(context, flushes[cause], 1);
+
+        // The state a GL renderer would apply before drawing
+        cdata->last_viewport = dest->viewport;
+        cdata->last_camera = dest->camera;
+        gpu_get_modelviewprojection(dest, cdata->last_mvp);
+
+        GPU_COUNT_FRAME_STAT(context, draw_calls, 1);
+        GPU_COUNT_FRAME_STAT(context, vertices, cdata->blit_buffer_num_vertices);
+        GPU_COUNT_FRAME_STAT(context, bytes_uploaded, GPU_BLIT_BUFFER_STRIDE * cdata->blit_buffer_num_vertices + sizeof(GPU_BLIT_INDEX_TYPE)*cdata->index_buffer_num_vertices);
+
+        #ifdef SDL_GPU_CPU_RASTERIZE
+        rasterizeVertices(renderer, dest, (cdata->last_use_texturing? cdata->last_image : NULL), cdata->last_shape,
+                          cdata->blit_buffer, cdata->blit_buffer_num_vertices, cdata->index_buffer, sizeof(GPU_BLIT_INDEX_TYPE), cdata->index_buffer_num_vertices);
+        #endif
+    }
+
+    cdata->blit_buffer_num_vertices = 0;
+    cdata->index_buffer_num_vertices = 0;
+}
+
+static void BeginSortedBatch(GPU_Renderer* renderer, GPU_Target* target)
+{
+    if(target == NULL)
+    {
+        GPU_PushErrorCode("GPU_BeginSortedBatch", GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+    if(renderer != target->renderer)
+    {
+        GPU_PushErrorCode("GPU_BeginSortedBatch", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+
+    makeContextCurrent(renderer, target);
+    if(renderer->current_context_target == NULL)
+    {
+        GPU_PushErrorCode("GPU_BeginSortedBatch", GPU_ERROR_USER_ERROR, "NULL context");
+        return;
+    }
+
+    renderer->impl->FlushBlitBuffer(renderer);
+
+    // Only the batch state is kept.  The draws go out as they come.
+    ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->sorted_batch_target = target;
+    ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->sorted_batch_layer = 0;
+}
+
+static void EndSortedBatch(GPU_Renderer* renderer)
+{
+    GPU_CONTEXT_DATA* cdata;
+    if(renderer->current_context_target == NULL)
+        return;
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->sorted_batch_target == NULL)
+        return;
+
+    renderer->impl->FlushBlitBuffer(renderer);
+    cdata->sorted_batch_target = NULL;
+}
+
+static void SetSortedBatchLayer(GPU_Renderer* renderer, int layer)
+{
+    GPU_CONTEXT_DATA* cdata;
+    if(renderer->current_context_target == NULL)
+        return;
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->sorted_batch_target == NULL)
+        return;
+
+    if(layer < -32768)
+        layer = -32768;
+    else if(layer > 32767)
+        layer = 32767;
+    cdata->sorted_batch_layer = layer;
+}
+
+static void BeginCommandList(GPU_Renderer* renderer, GPU_Target* target)
+{
+    (void)renderer;
+    (void)target;
+    GPU_PushErrorCode("GPU_BeginCommandList", GPU_ERROR_UNSUPPORTED_FUNCTION, "This renderer does not record command lists");
+}
+
+static GPU_CommandList* EndCommandList(GPU_Renderer* renderer)
+{
+    (void)renderer;
+    return NULL;
+}
+
+static void ExecuteCommandList(GPU_Renderer* renderer, GPU_CommandList* list, GPU_Target* target, const float* transform)
+{
+    (void)renderer;
+    (void)list;
+    (void)target;
+    (void)transform;
+}
+
+static void FreeCommandList(GPU_Renderer* renderer, GPU_CommandList* list)
+{
+    (void)renderer;
+    SDL_free(list);
+}
+
+static GPU_bool SetBufferUploadMethod(GPU_Renderer* renderer, GPU_BufferUploadEnum method)
+{
+    (void)renderer;
+    if(method != GPU_BUFFER_UPLOAD_NONE)
+        GPU_PushErrorCode("GPU_SetBufferUploadMethod", GPU_ERROR_UNSUPPORTED_FUNCTION, "This renderer does not upload vertices through buffer objects");
+    return (method == GPU_BUFFER_UPLOAD_NONE);
+}
+
+static GPU_BufferUploadEnum GetBufferUploadMethod(GPU_Renderer* renderer)
+{
+    (void)renderer;
+    return GPU_BUFFER_UPLOAD_NONE;
+}
+
+static GPU_BufferUploadEnum CalibrateBufferUpload(GPU_Renderer* renderer)
+{
+    (void)renderer;
+    return GPU_BUFFER_UPLOAD_NONE;
+}
+
+static void Flip(GPU_Renderer* renderer, GPU_Target* target)
+{
+    renderer->impl->FlushBlitBuffer(renderer);
+
+    if(target != NULL && target->context != NULL)
+        makeContextCurrent(renderer, target);
+
+    #ifdef SDL_GPU_CPU_RASTERIZE
+    // Present the framebuffer on the window
+    if(target != NULL && target->context != NULL)
+    {
+        SDL_Surface* framebuffer = ((GPU_CONTEXT_DATA*)target->context->data)->framebuffer;
+        SDL_Surface* screen;
+        if(framebuffer == NULL)
+            return;
+
+        #ifdef SDL_GPU_USE_SDL2
+        {
+            SDL_Window* window = SDL_GetWindowFromID(target->context->windowID);
+            screen = (window != NULL? SDL_GetWindowSurface(window) : NULL);
+            if(screen == NULL)
+                return;
+
+            SDL_SetSurfaceBlendMode(framebuffer, SDL_BLENDMODE_NONE);
+            if(screen->w == framebuffer->w && screen->h == framebuffer->h)
+                SDL_BlitSurface(framebuffer, NULL, screen, NULL);
+            else
+                SDL_BlitScaled(framebuffer, NULL, screen, NULL);
+            SDL_UpdateWindowSurface(window);
+        }
+        #else
+        screen = SDL_GetVideoSurface();
+        if(screen == NULL)
+            return;
+
+        SDL_SetAlpha(framebuffer, 0, 255);
+        SDL_BlitSurface(framebuffer, NULL, screen, NULL);
+        SDL_Flip(screen);
+        #endif
+    }
+    #endif
+}
+
+static GPU_bool EnableGPUTiming(GPU_Renderer* renderer, GPU_bool enable)
+{
+    (void)renderer;
+    if(enable)
+        GPU_PushErrorCode("GPU_EnableGPUTiming", GPU_ERROR_UNSUPPORTED_FUNCTION, "Timer queries are not supported by this renderer");
+    return GPU_FALSE;
+}
+
+static void BeginGPUScope(GPU_Renderer* renderer, const char* name)
+{
+    (void)renderer;
+    (void)name;
+}
+
+static void EndGPUScope(GPU_Renderer* renderer)
+{
+    (void)renderer;
+}
+
+static float GetGPUTime(GPU_Renderer* renderer, const char* scope_name, GPU_Target* target)
+{
+    (void)renderer;
+    (void)scope_name;
+    (void)target;
+    return -1.0f;
+}
+
+
+
+static Uint32 CreateShaderProgram(GPU_Renderer* renderer)
+{
+    #ifdef SDL_GPU_DISABLE_SHADERS
+    (void)renderer;
+    return 0;
+    #else
+    return nextObjectID((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data);
+    #endif
+}
+
+static void FreeShaderProgram(GPU_Renderer* renderer, Uint32 program_object)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    if(program_object == context->current_shader_program)
+        renderer->impl->DeactivateShaderProgram(renderer);
+}
+
+static Uint32 CompileShader(GPU_Renderer* renderer, GPU_ShaderEnum shader_type, const char* shader_source)
+{
+    (void)shader_type;
+    if(shader_source == NULL)
+    {
+        GPU_PushErrorCode("GPU_CompileShader", GPU_ERROR_NULL_ARGUMENT, "shader_source");
+        return 0;
+    }
+
+    #ifdef SDL_GPU_DISABLE_SHADERS
+    (void)renderer;
+    snprintf(shader_message, 256, "Shaders not supported by this renderer.\n");
+    return 0;
+    #else
+    // Any source "compiles"
+    shader_message[0] = '\0';
+    return nextObjectID((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data);
+    #endif
+}
+
+static Uint32 CompileShader_RW(GPU_Renderer* renderer, GPU_ShaderEnum shader_type, SDL_RWops* shader_source, GPU_bool free_rwops)
+{
+    Uint32 result;
+    char* source_string;
+    long size;
+
+    if(shader_source == NULL)
+    {
+        GPU_PushErrorCode("GPU_CompileShader_RW", GPU_ERROR_NULL_ARGUMENT, "shader_source");
+        return 0;
+    }
+
+    // Read the whole source, as a GL renderer has to
+    size = (long)SDL_RWseek(shader_source, 0, SEEK_END);
+    SDL_RWseek(shader_source, 0, SEEK_SET);
+    if(size < 0)
+        size = 0;
+    source_string = (char*)SDL_malloc(size + 1);
+    size = (long)SDL_RWread(shader_source, source_string, 1, size);
+    source_string[size] = '\0';
+
+    if(free_rwops)
+        SDL_RWclose(shader_source);
+
+    result = CompileShader(renderer, shader_type, source_string);
+    SDL_free(source_string);
+    return result;
+}
+
+static void FreeShader(GPU_Renderer* renderer, Uint32 shader_object)
+{
+    (void)renderer;
+    (void)shader_object;
+}
+
+static void AttachShader(GPU_Renderer* renderer, Uint32 program_object, Uint32 shader_object)
+{
+    (void)renderer;
+    (void)program_object;
+    (void)shader_object;
+}
+
+static void DetachShader(GPU_Renderer* renderer, Uint32 program_object, Uint32 shader_object)
+{
+    (void)renderer;
+    (void)program_object;
+    (void)shader_object;
+}
+
+static GPU_bool LinkShaderProgram(GPU_Renderer* renderer, Uint32 program_object)
+{
+    (void)renderer;
+    #ifdef SDL_GPU_DISABLE_SHADERS
+    (void)program_object;
+    return GPU_FALSE;
+    #else
+    return (program_object != 0);
+    #endif
+}
+
+static void ActivateShaderProgram(GPU_Renderer* renderer, Uint32 program_object, GPU_ShaderBlock* block)
+{
+	GPU_Target* target = renderer->current_context_target;
+
+    if(program_object == 0) // Implies default shader
+    {
+        // Already using a default shader?
+        if(target->context->current_shader_program == target->context->default_textured_shader_program
+            || target->context->current_shader_program == target->context->default_untextured_shader_program)
+            return;
+
+        program_object = target->context->default_untextured_shader_program;
+    }
+
+    flushBlitBufferFor(renderer, GPU_FLUSH_SHADER_CHANGE);
+    if(program_object != target->context->current_shader_program)
+        GPU_COUNT_FRAME_STAT(target->context, program_switches, 1);
+
+    // Set up our shader attribute and uniform locations
+    if(block == NULL)
+    {
+        if(program_object == target->context->default_textured_shader_program)
+            target->context->current_shader_block = target->context->default_textured_shader_block;
+        else if(program_object == target->context->default_untextured_shader_program)
+            target->context->current_shader_block = target->context->default_untextured_shader_block;
+        else
+        {
+            GPU_ShaderBlock b;
+            b.position_loc = -1;
+            b.texcoord_loc = -1;
+            b.color_loc = -1;
+            b.modelViewProjection_loc = -1;
+            target->context->current_shader_block = b;
+        }
+    }
+    else
+        target->context->current_shader_block = *block;
+
+    target->context->current_shader_program = program_object;
+}
+
+static int GetAttributeLocation(GPU_Renderer* renderer, Uint32 program_object, const char* attrib_name)
+{
+    if(program_object == 0)
+        return -1;
+    return getLocation(renderer, attrib_name);
+}
+
+static int GetUniformLocation(GPU_Renderer* renderer, Uint32 program_object, const char* uniform_name)
+{
+    if(program_object == 0)
+        return -1;
+    return getLocation(renderer, uniform_name);
+}
+
+static GPU_ShaderBlock LoadShaderBlock(GPU_Renderer* renderer, Uint32 program_object, const char* position_name, const char* texcoord_name, const char* color_name, const char* modelViewMatrix_name)
+{
+    GPU_ShaderBlock b;
+
+    b.position_loc = (position_name == NULL? -1 : renderer->impl->GetAttributeLocation(renderer, program_object, position_name));
+    b.texcoord_loc = (texcoord_name == NULL? -1 : renderer->impl->GetAttributeLocation(renderer, program_object, texcoord_name));
+    b.color_loc = (color_name == NULL? -1 : renderer->impl->GetAttributeLocation(renderer, program_object, color_name));
+    b.modelViewProjection_loc = (modelViewMatrix_name == NULL? -1 : renderer->impl->GetUniformLocation(renderer, program_object, modelViewMatrix_name));
+
+    return b;
+}
+
+static void SetShaderBlock(GPU_Renderer* renderer, GPU_ShaderBlock block)
+{
+    renderer->current_context_target->context->current_shader_block = block;
+}
+
+static void SetShaderImage(GPU_Renderer* renderer, GPU_Image* image, int location, int image_unit)
+{
+    (void)image;
+    (void)location;
+    (void)image_unit;
+
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+}
+
+// Uniform values aren't kept.  Setting one still splits the batch, like it does with GL.
+static void GetUniformiv(GPU_Renderer* renderer, Uint32 program_object, int location, int* values)
+{
+    (void)renderer;
+    (void)program_object;
+    (void)location;
+    if(values != NULL)
+        values[0] = 0;
+}
+
+static void SetUniformi(GPU_Renderer* renderer, int location, int value)
+{
+    (void)location;
+    (void)value;
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+}
+
+static void SetUniformiv(GPU_Renderer* renderer, int location, int num_elements_per_value, int num_values, int* values)
+{
+    (void)location;
+    (void)num_elements_per_value;
+    (void)num_values;
+    (void)values;
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+}
+
+static void GetUniformuiv(GPU_Renderer* renderer, Uint32 program_object, int location, unsigned int* values)
+{
+    (void)renderer;
+    (void)program_object;
+    (void)location;
+    if(values != NULL)
+        values[0] = 0;
+}
+
+static void SetUniformui(GPU_Renderer* renderer, int location, unsigned int value)
+{
+    (void)location;
+    (void)value;
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+}
+
+static void SetUniformuiv(GPU_Renderer* renderer, int location, int num_elements_per_value, int num_values, unsigned int* values)
+{
+    (void)location;
+    (void)num_elements_per_value;
+    (void)num_values;
+    (void)values;
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+}
+
+static void GetUniformfv(GPU_Renderer* renderer, Uint32 program_object, int location, float* values)
+{
+    (void)renderer;
+    (void)program_object;
+    (void)location;
+    if(values != NULL)
+        values[0] = 0.0f;
+}
+
+static void SetUniformf(GPU_Renderer* renderer, int location, float value)
+{
+    (void)location;
+    (void)value;
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+}
+
+static void SetUniformfv(GPU_Renderer* renderer, int location, int num_elements_per_value, int num_values, float* values)
+{
+    (void)location;
+    (void)num_elements_per_value;
+    (void)num_values;
+    (void)values;
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+}
+
+static void SetUniformMatrixfv(GPU_Renderer* renderer, int location, int num_matrices, int num_rows, int num_columns, GPU_bool transpose, float* values)
+{
+    (void)location;
+    (void)num_matrices;
+    (void)transpose;
+    (void)values;
+
+    if(num_rows < 2 || num_rows > 4 || num_columns < 2 || num_columns > 4)
+    {
+        GPU_PushErrorCode("GPU_SetUniformMatrixfv", GPU_ERROR_DATA_ERROR, "Given invalid dimensions (%dx%d)", num_rows, num_columns);
+        return;
+    }
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+}
+
+// Generic attribute values only need to split the batch
+static void setAttributeValue(GPU_Renderer* renderer, int location)
+{
+    GPU_CONTEXT_DATA* cdata;
+    if(location < 0 || location >= 16)
+        return;
+
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    cdata->shader_attribute_enabled[location] = GPU_FALSE;
+}
+
+static void SetAttributef(GPU_Renderer* renderer, int location, float value)
+{
+    (void)value;
+    setAttributeValue(renderer, location);
+}
+
+static void SetAttributei(GPU_Renderer* renderer, int location, int value)
+{
+    (void)value;
+    setAttributeValue(renderer, location);
+}
+
+static void SetAttributeui(GPU_Renderer* renderer, int location, unsigned int value)
+{
+    (void)value;
+    setAttributeValue(renderer, location);
+}
+
+static void SetAttributefv(GPU_Renderer* renderer, int location, int num_elements, float* value)
+{
+    (void)num_elements;
+    (void)value;
+    setAttributeValue(renderer, location);
+}
+
+static void SetAttributeiv(GPU_Renderer* renderer, int location, int num_elements, int* value)
+{
+    (void)num_elements;
+    (void)value;
+    setAttributeValue(renderer, location);
+}
+
+static void SetAttributeuiv(GPU_Renderer* renderer, int location, int num_elements, unsigned int* value)
+{
+    (void)num_elements;
+    (void)value;
+    setAttributeValue(renderer, location);
+}
+
+static void SetAttributeSource(GPU_Renderer* renderer, int num_values, GPU_Attribute source)
+{
+    GPU_CONTEXT_DATA* cdata;
+    (void)num_values;
+
+    if(source.location < 0 || source.location >= 16)
+        return;
+
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    cdata->shader_attributes[source.location] = source;
+    cdata->shader_attribute_enabled[source.location] = (source.values != NULL);
+}
+
+
+
+#define SET_COMMON_FUNCTIONS(impl) \
+    impl->Init = &Init; \
+    impl->CreateTargetFromWindow = &CreateTargetFromWindow; \
+    impl->SetActiveTarget = &SetActiveTarget; \
+    impl->CreateAliasTarget = &CreateAliasTarget; \
+    impl->MakeCurrent = &MakeCurrent; \
+    impl->SetAsCurrent = &SetAsCurrent; \
+    impl->ResetRendererState = &ResetRendererState; \
+    impl->AddDepthBuffer = &AddDepthBuffer; \
+    impl->SetWindowResolution = &SetWindowResolution; \
+    impl->SetVirtualResolution = &SetVirtualResolution; \
+    impl->UnsetVirtualResolution = &UnsetVirtualResolution; \
+    impl->Quit = &Quit; \
+    impl->SetFullscreen = &SetFullscreen; \
+    impl->SetCamera = &SetCamera; \
+    impl->CreateImage = &CreateImage; \
+    impl->CreateImageUsingTexture = &CreateImageUsingTexture; \
+    impl->CreateAliasImage = &CreateAliasImage; \
+    impl->SaveImage = &SaveImage; \
+    impl->CopyImage = &CopyImage; \
+    impl->UpdateImage = &UpdateImage; \
+    impl->UpdateImageBytes = &UpdateImageBytes; \
+    impl->UpdateImageBytesAsync = &UpdateImageBytesAsync; \
+    impl->ReplaceImage = &ReplaceImage; \
+    impl->CopyImageFromSurface = &CopyImageFromSurface; \
+    impl->CopyImageFromTarget = &CopyImageFromTarget; \
+    impl->CopySurfaceFromTarget = &CopySurfaceFromTarget; \
+    impl->CopySurfaceFromImage = &CopySurfaceFromImage; \
+    impl->ReadPixelsAsync = &ReadPixelsAsync; \
+    impl->IsReadbackReady = &IsReadbackReady; \
+    impl->MapReadback = &MapReadback; \
+    impl->FreeReadback = &FreeReadback; \
+    impl->FreeImage = &FreeImage; \
+    impl->GetTarget = &GetTarget; \
+    impl->FreeTarget = &FreeTarget; \
+    impl->Blit = &Blit; \
+    impl->BlitRotate = &BlitRotate; \
+    impl->BlitScale = &BlitScale; \
+    impl->BlitTransform = &BlitTransform; \
+    impl->BlitTransformX = &BlitTransformX; \
+    impl->BlitBatch = &BlitBatch; \
+    impl->BlitBatchSeparate = &BlitBatchSeparate; \
+    impl->BlitTransformBatch = &BlitTransformBatch; \
+    impl->PrimitiveBatchV = &PrimitiveBatchV; \
+    impl->PrimitiveBatchV32 = &PrimitiveBatchV32; \
+    impl->CreateVertexBuffer = &CreateVertexBuffer; \
+    impl->UpdateVertexBuffer = &UpdateVertexBuffer; \
+    impl->DrawVertexBuffer = &DrawVertexBuffer; \
+    impl->FreeVertexBuffer = &FreeVertexBuffer; \
+    impl->GenerateMipmaps = &GenerateMipmaps; \
+    impl->SetClip = &SetClip; \
+    impl->UnsetClip = &UnsetClip; \
+    impl->GetPixel = &GetPixel; \
+    impl->GetPixels = &GetPixels; \
+    impl->SetImageFilter = &SetImageFilter; \
+    impl->SetWrapMode = &SetWrapMode; \
+    impl->GetTextureHandle = &GetTextureHandle; \
+    impl->ClearRGBA = &ClearRGBA; \
+    impl->FlushBlitBuffer = &FlushBlitBuffer; \
+    impl->BeginSortedBatch = &BeginSortedBatch; \
+    impl->EndSortedBatch = &EndSortedBatch; \
+    impl->SetSortedBatchLayer = &SetSortedBatchLayer; \
+    impl->BeginCommandList = &BeginCommandList; \
+    impl->EndCommandList = &EndCommandList; \
+    impl->ExecuteCommandList = &ExecuteCommandList; \
+    impl->FreeCommandList = &FreeCommandList; \
+    impl->SetBufferUploadMethod = &SetBufferUploadMethod; \
+    impl->GetBufferUploadMethod = &GetBufferUploadMethod; \
+    impl->CalibrateBufferUpload = &CalibrateBufferUpload; \
+    impl->Flip = &Flip; \
+    impl->EnableGPUTiming = &EnableGPUTiming; \
+    impl->BeginGPUScope = &BeginGPUScope; \
+    impl->EndGPUScope = &EndGPUScope; \
+    impl->GetGPUTime = &GetGPUTime; \
+    impl->CreateShaderProgram = &CreateShaderProgram; \
+    impl->FreeShaderProgram = &FreeShaderProgram; \
+    impl->CompileShader_RW = &CompileShader_RW; \
+    impl->CompileShader = &CompileShader; \
+    impl->FreeShader = &FreeShader; \
+    impl->AttachShader = &AttachShader; \
+    impl->DetachShader = &DetachShader; \
+    impl->LinkShaderProgram = &LinkShaderProgram; \
+    impl->ActivateShaderProgram = &ActivateShaderProgram; \
+    impl->DeactivateShaderProgram = &DeactivateShaderProgram; \
+    impl->GetShaderMessage = &GetShaderMessage; \
+    impl->GetAttributeLocation = &GetAttributeLocation; \
+    impl->GetUniformLocation = &GetUniformLocation; \
+    impl->LoadShaderBlock = &LoadShaderBlock; \
+    impl->SetShaderBlock = &SetShaderBlock; \
+    impl->SetShaderImage = &SetShaderImage; \
+    impl->GetUniformiv = &GetUniformiv; \
+    impl->SetUniformi = &SetUniformi; \
+    impl->SetUniformiv = &SetUniformiv; \
+    impl->GetUniformuiv = &GetUniformuiv; \
+    impl->SetUniformui = &SetUniformui; \
+    impl->SetUniformuiv = &SetUniformuiv; \
+    impl->GetUniformfv = &GetUniformfv; \
+    impl->SetUniformf = &SetUniformf; \
+    impl->SetUniformfv = &SetUniformfv; \
+    impl->SetUniformMatrixfv = &SetUniformMatrixfv; \
+    impl->SetAttributef = &SetAttributef; \
+    impl->SetAttributei = &SetAttributei; \
+    impl->SetAttributeui = &SetAttributeui; \
+    impl->SetAttributefv = &SetAttributefv; \
+    impl->SetAttributeiv = &SetAttributeiv; \
+    impl->SetAttributeuiv = &SetAttributeuiv; \
+    impl->SetAttributeSource = &SetAttributeSource; \
+    \
+    /* Shapes */ \
+    impl->SetLineThickness = &SetLineThickness; \
+    impl->GetLineThickness = &GetLineThickness; \
+    impl->Pixel = &Pixel; \
+    impl->Line = &Line; \
+    impl->Arc = &Arc; \
+    impl->ArcFilled = &ArcFilled; \
+    impl->Circle = &Circle; \
+    impl->CircleFilled = &CircleFilled; \
+    impl->Ellipse = &Ellipse; \
+    impl->EllipseFilled = &EllipseFilled; \
+    impl->Sector = &Sector; \
+    impl->SectorFilled = &SectorFilled; \
+    impl->Tri = &Tri; \
+    impl->TriFilled = &TriFilled; \
+    impl->Rectangle = &Rectangle; \
+    impl->RectangleFilled = &RectangleFilled; \
+    impl->RectangleRound = &RectangleRound; \
+    impl->RectangleRoundFilled = &RectangleRoundFilled; \
+    impl->Polygon = &Polygon; \
+    impl->Polyline = &Polyline; \
+    impl->PolygonFilled = &PolygonFilled;
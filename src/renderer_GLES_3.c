@@ -20,6 +20,8 @@ void GPU_FreeRenderer_GLES_3(GPU_Renderer* renderer) {}
 #define SDL_GPU_GLSL_VERSION 300
 
 #define SDL_GPU_USE_BUFFER_PIPELINE
+#define SDL_GPU_USE_INSTANCED_SPRITES
+#define SDL_GPU_USE_32BIT_INDICES
 #define SDL_GPU_SKIP_ENABLE_TEXTURE_2D
 #define SDL_GPU_ASSUME_SHADERS
 #define SDL_GPU_ASSUME_CORE_FBO
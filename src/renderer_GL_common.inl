@@ -86,11 +86,49 @@ See a particular renderer's *.c file for specifics. */
 #endif
 
 int gpu_strcasecmp(const char* s1, const char* s2);
+Uint32 gpu_next_matrix_generation(void);
+void gpu_get_camera_matrix(GPU_Target* target, float* result);
+void gpu_get_modelviewprojection(GPU_Target* target, float* result);
+float* gpu_peek_top_matrix(GPU_MatrixStack* stack);
+void gpu_transform_quads(unsigned int num_quads, const float* x, const float* y, const float* degrees, const float* scale_x, const float* scale_y,
+                         const float* left, const float* top, const float* right, const float* bottom, float* corners_x, float* corners_y);
 
 
-// Default to buffer reset VBO upload method
-#if defined(SDL_GPU_USE_BUFFER_PIPELINE) && !defined(SDL_GPU_USE_BUFFER_RESET) && !defined(SDL_GPU_USE_BUFFER_MAPPING) && !defined(SDL_GPU_USE_BUFFER_UPDATE)
-    #define SDL_GPU_USE_BUFFER_RESET
+// Every VBO upload method is compiled in and can be switched per context (GPU_SetBufferUploadMethod()).
+// The SDL_GPU_USE_BUFFER_* macros only pick the default.
+#ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    // GLES 2 has no buffer mapping and GLES 3 only has glMapBufferRange()
+    #if defined(SDL_GPU_USE_OPENGL) || (defined(SDL_GPU_USE_GLES) && SDL_GPU_GLES_MAJOR_VERSION >= 3)
+        #define SDL_GPU_HAS_BUFFER_MAPPING
+    #endif
+
+    #if defined(SDL_GPU_USE_BUFFER_MAPPING) && defined(SDL_GPU_HAS_BUFFER_MAPPING)
+        #define GPU_DEFAULT_BUFFER_UPLOAD GPU_BUFFER_UPLOAD_MAPPING
+    #elif defined(SDL_GPU_USE_BUFFER_UPDATE)
+        #define GPU_DEFAULT_BUFFER_UPLOAD GPU_BUFFER_UPLOAD_UPDATE
+    #elif defined(SDL_GPU_USE_BUFFER_PERSISTENT)
+        #define GPU_DEFAULT_BUFFER_UPLOAD GPU_BUFFER_UPLOAD_PERSISTENT
+    #else
+        #define GPU_DEFAULT_BUFFER_UPLOAD GPU_BUFFER_UPLOAD_RESET
+    #endif
+
+    // Flushes of a full blit buffer timed per method by GPU_CalibrateBufferUpload()
+    #define GPU_BUFFER_CALIBRATION_NUM_FLUSHES 64
+
+    // Flushes bind a prebuilt VAO instead of setting up the attributes every time
+    #if !defined(SDL_GPU_NO_VAO)
+        #define SDL_GPU_USE_FLUSH_VAOS
+    #endif
+
+    // GPU_UpdateImageBytesAsync() stages pixels in mapped GL_PIXEL_UNPACK_BUFFERs and GPU_ReadPixelsAsync() reads into
+    // GL_PIXEL_PACK_BUFFERs (GL 3.0 / GLES 3.0)
+    #if defined(SDL_GPU_HAS_BUFFER_MAPPING) && (SDL_GPU_GL_MAJOR_VERSION >= 3 || SDL_GPU_GLES_MAJOR_VERSION >= 3)
+        #define SDL_GPU_USE_PIXEL_UNPACK_BUFFERS
+        #define SDL_GPU_USE_PIXEL_PACK_BUFFERS
+
+        // Uploads that can be in flight before a buffer is reused
+        #define GPU_PIXEL_UPLOAD_RING_SIZE 3
+    #endif
 #endif
 
 
@@ -99,20 +137,107 @@ int gpu_strcasecmp(const char* s1, const char* s2);
 #define GPU_BLIT_BUFFER_INIT_MAX_NUM_VERTICES (GPU_BLIT_BUFFER_VERTICES_PER_SPRITE*1000)
 
 
+#ifdef SDL_GPU_USE_32BIT_INDICES
+// Whole batches fit in one GL_UNSIGNED_INT draw, so this only bounds memory use (512 MB of vertex data)
+#define GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES 16777216u
+#define GPU_BLIT_INDEX_TYPE unsigned int
+#define GPU_BLIT_INDEX_GL_TYPE GL_UNSIGNED_INT
+#else
 // Near the unsigned short limit (65535)
 #define GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES 60000
+#define GPU_BLIT_INDEX_TYPE unsigned short
+#define GPU_BLIT_INDEX_GL_TYPE GL_UNSIGNED_SHORT
+#endif
 // Near the unsigned int limit (4294967295)
 #define GPU_INDEX_BUFFER_ABSOLUTE_MAX_VERTICES 4000000000u
 
 
-// x, y, s, t, r, g, b, a
-#define GPU_BLIT_BUFFER_FLOATS_PER_VERTEX 8
+// Textured blits are always quads, so the buffer pipeline draws them with a prebuilt index buffer.
+// The fixed-function fallback still reads the CPU-side indices.
+#if defined(SDL_GPU_USE_BUFFER_PIPELINE) && !defined(SDL_GPU_USE_BUFFER_PIPELINE_FALLBACK)
+#define SDL_GPU_SKIP_BLIT_INDICES
+#endif
+
+// Packed colors are normalized by the vertex attribute setup, so only shader-based renderers can use them
+#if defined(SDL_GPU_USE_PACKED_VERTICES) && defined(SDL_GPU_ASSUME_SHADERS)
+#define SDL_GPU_PACK_BLIT_COLORS
+#endif
+
+// The default textured shader can sample from several texture units, so blits of different images don't have to flush
+#ifdef SDL_GPU_ASSUME_SHADERS
+#define SDL_GPU_USE_TEXTURE_SLOTS
+#endif
+
+#ifdef SDL_GPU_USE_TEXTURE_SLOTS
+// One more float per vertex for the texture unit.  The stride is fixed, so untextured and custom shader blits upload it too.
+#define GPU_BLIT_BUFFER_TEX_SLOT_FLOATS 1
+#else
+#define GPU_BLIT_BUFFER_TEX_SLOT_FLOATS 0
+#endif
+
+#ifdef SDL_GPU_PACK_BLIT_COLORS
+// x, y, s, t, RGBA8 color packed into one float, [slot]
+#define GPU_BLIT_BUFFER_FLOATS_PER_VERTEX (5 + GPU_BLIT_BUFFER_TEX_SLOT_FLOATS)
+#define GPU_BLIT_BUFFER_COLOR_GL_TYPE GL_UNSIGNED_BYTE
+#define GPU_BLIT_BUFFER_COLOR_NORMALIZED GL_TRUE
+#else
+// x, y, s, t, r, g, b, a, [slot]
+#define GPU_BLIT_BUFFER_FLOATS_PER_VERTEX (8 + GPU_BLIT_BUFFER_TEX_SLOT_FLOATS)
+#define GPU_BLIT_BUFFER_COLOR_GL_TYPE GL_FLOAT
+#define GPU_BLIT_BUFFER_COLOR_NORMALIZED GL_FALSE
+#endif
 
 // bytes per vertex
 #define GPU_BLIT_BUFFER_STRIDE (sizeof(float)*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX)
 #define GPU_BLIT_BUFFER_VERTEX_OFFSET 0
 #define GPU_BLIT_BUFFER_TEX_COORD_OFFSET 2
 #define GPU_BLIT_BUFFER_COLOR_OFFSET 4
+#define GPU_BLIT_BUFFER_TEX_SLOT_OFFSET (GPU_BLIT_BUFFER_FLOATS_PER_VERTEX - 1)
+
+#ifdef SDL_GPU_USE_INSTANCED_SPRITES
+// x, y, w, h, pivot_x, pivot_y, rotation (radians), s1, t1, s2, t2, RGBA8 color packed into the last float
+#define GPU_INSTANCE_BUFFER_FLOATS_PER_SPRITE 12
+#define GPU_INSTANCE_BUFFER_STRIDE (sizeof(float)*GPU_INSTANCE_BUFFER_FLOATS_PER_SPRITE)
+#define GPU_INSTANCE_BUFFER_RECT_OFFSET 0
+#define GPU_INSTANCE_BUFFER_PIVOT_OFFSET 4
+#define GPU_INSTANCE_BUFFER_TEX_RECT_OFFSET 7
+#define GPU_INSTANCE_BUFFER_COLOR_OFFSET 11
+#define GPU_INSTANCE_BUFFER_INIT_MAX_NUM_SPRITES 1000
+#define GPU_INSTANCE_BUFFER_ABSOLUTE_MAX_SPRITES 262144
+
+// Instanced sprites use a unit quad for gpu_Vertex and one record per sprite for the rest.
+// Every backend shares this body and only the version line differs.
+#define GPU_INSTANCED_VERTEX_SHADER_BODY \
+"in vec2 gpu_Vertex;\n\
+in vec4 gpu_InstanceRect;\n\
+in vec3 gpu_InstancePivot;\n\
+in vec4 gpu_InstanceTexRect;\n\
+in vec4 gpu_InstanceColor;\n\
+uniform mat4 gpu_ModelViewProjectionMatrix;\n\
+\
+out vec4 color;\n\
+out vec2 texCoord;\n\
+\
+void main(void)\n\
+{\n\
+	vec2 corner = gpu_Vertex * gpu_InstanceRect.zw - gpu_InstancePivot.xy;\n\
+	float c = cos(gpu_InstancePivot.z);\n\
+	float s = sin(gpu_InstancePivot.z);\n\
+	vec2 pos = gpu_InstanceRect.xy + vec2(corner.x*c - corner.y*s, corner.x*s + corner.y*c);\n\
+	color = gpu_InstanceColor;\n\
+	texCoord = mix(gpu_InstanceTexRect.xy, gpu_InstanceTexRect.zw, gpu_Vertex);\n\
+	gl_Position = gpu_ModelViewProjectionMatrix * vec4(pos, 0.0, 1.0);\n\
+}"
+
+#ifdef SDL_GPU_USE_GLES
+    #define GPU_DEFAULT_INSTANCED_VERTEX_SHADER_SOURCE "#version 300 es\nprecision highp float;\nprecision mediump int;\n" GPU_INSTANCED_VERTEX_SHADER_BODY
+#elif SDL_GPU_GL_MAJOR_VERSION >= 4
+    #define GPU_DEFAULT_INSTANCED_VERTEX_SHADER_SOURCE "#version 400\n" GPU_INSTANCED_VERTEX_SHADER_BODY
+#else
+    #define GPU_DEFAULT_INSTANCED_VERTEX_SHADER_SOURCE "#version 130\n" GPU_INSTANCED_VERTEX_SHADER_BODY
+    #define GPU_DEFAULT_INSTANCED_VERTEX_SHADER_SOURCE_CORE "#version 150\n" GPU_INSTANCED_VERTEX_SHADER_BODY
+#endif
+#endif
 
 
 
@@ -447,6 +572,31 @@ static_inline void upload_new_texture(void* pixels, GPU_Rect update_rect, Uint32
     static void (GLAPIENTRY *glGenerateMipmapPROC)(GLenum target) = glGenerateMipmapNOOP;
 #endif
 
+// Timestamp queries for GPU_EnableGPUTiming(): ARB_timer_query on desktop GL, EXT_disjoint_timer_query on GLES 2+.
+// These are loaded in init_features() and stay NULL if unsupported.
+#if defined(SDL_GPU_USE_OPENGL) || SDL_GPU_GLES_MAJOR_VERSION >= 2
+    #define SDL_GPU_USE_TIMER_QUERIES
+
+    #ifndef GL_TIMESTAMP
+        #define GL_TIMESTAMP 0x8E28
+    #endif
+    #ifndef GL_QUERY_RESULT
+        #define GL_QUERY_RESULT 0x8866
+    #endif
+    #ifndef GL_QUERY_RESULT_AVAILABLE
+        #define GL_QUERY_RESULT_AVAILABLE 0x8867
+    #endif
+    #ifndef GL_GPU_DISJOINT_EXT
+        #define GL_GPU_DISJOINT_EXT 0x8FBB
+    #endif
+
+    static void (GLAPIENTRY *glGenQueriesPROC)(GLsizei n, GLuint* ids) = NULL;
+    static void (GLAPIENTRY *glDeleteQueriesPROC)(GLsizei n, const GLuint* ids) = NULL;
+    static void (GLAPIENTRY *glQueryCounterPROC)(GLuint id, GLenum target) = NULL;
+    static void (GLAPIENTRY *glGetQueryObjectuivPROC)(GLuint id, GLenum pname, GLuint* params) = NULL;
+    static void (GLAPIENTRY *glGetQueryObjectui64vPROC)(GLuint id, GLenum pname, GLuint64* params) = NULL;
+#endif
+
 static void init_features(GPU_Renderer* renderer)
 {
     // Reset supported features
@@ -613,7 +763,264 @@ static void init_features(GPU_Renderer* renderer)
     #ifdef SDL_GPU_ASSUME_SHADERS
     renderer->enabled_features |= GPU_FEATURE_BASIC_SHADERS;
     #endif
+
+    // Timer queries
+#ifdef SDL_GPU_USE_TIMER_QUERIES
+    glGenQueriesPROC = NULL;
+    glDeleteQueriesPROC = NULL;
+    glQueryCounterPROC = NULL;
+    glGetQueryObjectuivPROC = NULL;
+    glGetQueryObjectui64vPROC = NULL;
+    #ifdef SDL_GPU_USE_OPENGL
+    if(isExtensionSupported("GL_ARB_timer_query"))
+    {
+        glGenQueriesPROC = glGenQueries;
+        glDeleteQueriesPROC = glDeleteQueries;
+        glQueryCounterPROC = glQueryCounter;
+        glGetQueryObjectuivPROC = glGetQueryObjectuiv;
+        glGetQueryObjectui64vPROC = glGetQueryObjectui64v;
+    }
+    #else
+    // Extension functions aren't exported by every GLES library, so look them up
+    if(isExtensionSupported("GL_EXT_disjoint_timer_query"))
+    {
+        *(void**)&glGenQueriesPROC = SDL_GL_GetProcAddress("glGenQueriesEXT");
+        *(void**)&glDeleteQueriesPROC = SDL_GL_GetProcAddress("glDeleteQueriesEXT");
+        *(void**)&glQueryCounterPROC = SDL_GL_GetProcAddress("glQueryCounterEXT");
+        *(void**)&glGetQueryObjectuivPROC = SDL_GL_GetProcAddress("glGetQueryObjectuivEXT");
+        *(void**)&glGetQueryObjectui64vPROC = SDL_GL_GetProcAddress("glGetQueryObjectui64vEXT");
+    }
+    #endif
+    if(glGenQueriesPROC != NULL && glDeleteQueriesPROC != NULL && glQueryCounterPROC != NULL
+       && glGetQueryObjectuivPROC != NULL && glGetQueryObjectui64vPROC != NULL)
+        renderer->enabled_features |= GPU_FEATURE_TIMER_QUERIES;
+#endif
+}
+
+// Frame statistics, culling, and other state tracking shared with the CPU renderers
+#include "renderer_common.inl"
+
+
+#ifdef SDL_GPU_USE_TIMER_QUERIES
+// Frames that may wait for their timer results.  A frame that still isn't done when its slot comes around again goes unmeasured, so reading results never stalls.
+#define GPU_TIMER_FRAMES 4
+#define GPU_TIMER_MAX_QUERIES 64
+#define GPU_TIMER_MAX_SPANS 32
+#define GPU_TIMER_MAX_DEPTH 8
+#define GPU_TIMER_NAME_LENGTH 32
+
+// A timed range of a frame: a named scope, or a stretch of rendering to one target
+typedef struct GPUTimerSpan
+{
+    char name[GPU_TIMER_NAME_LENGTH];  // Empty for targets
+    GPU_Target* target;  // NULL for scopes
+    int begin_query;
+    int end_query;  // -1 until the span ends
+    float ms;  // Only for results
+} GPUTimerSpan;
+
+typedef struct GPUTimerFrame
+{
+    GLuint queries[GPU_TIMER_MAX_QUERIES];
+    int num_queries;
+    GPUTimerSpan spans[GPU_TIMER_MAX_SPANS];
+    int num_spans;
+    GPU_bool pending;  // Ended, but the results haven't been read
+} GPUTimerFrame;
+
+typedef struct GPUTimingData
+{
+    GPUTimerFrame frames[GPU_TIMER_FRAMES];
+    int current_frame;
+    GPU_bool frame_open;
+    int scope_stack[GPU_TIMER_MAX_DEPTH];  // Spans of the open scopes, -1 for ones that didn't fit
+    int scope_depth;
+    int target_span;  // Span of the active target, or -1
+
+    // The newest frame that the GPU has finished
+    float frame_ms;  // Negative until there is one
+    GPUTimerSpan results[GPU_TIMER_MAX_SPANS];  // Spans with the same name or target are added together
+    int num_results;
+} GPUTimingData;
+
+// Queues a GPU timestamp in the open frame.  Returns its query index, or -1 if the frame is out of queries.
+// The last query is kept for the end of the frame.
+static int recordTimestamp(GPUTimingData* timing, GPU_bool end_of_frame)
+{
+    GPUTimerFrame* frame = &timing->frames[timing->current_frame];
+    if(frame->num_queries >= GPU_TIMER_MAX_QUERIES - (end_of_frame? 0 : 1))
+        return -1;
+
+    glQueryCounterPROC(frame->queries[frame->num_queries], GL_TIMESTAMP);
+    return frame->num_queries++;
+}
+
+// Returns the new span, or -1 if it can't be timed
+static int beginTimerSpan(GPUTimingData* timing, const char* name, GPU_Target* target, int query)
+{
+    GPUTimerFrame* frame = &timing->frames[timing->current_frame];
+    GPUTimerSpan* span;
+    if(query < 0 || frame->num_spans >= GPU_TIMER_MAX_SPANS)
+        return -1;
+
+    span = &frame->spans[frame->num_spans];
+    span->name[0] = '\0';
+    if(name != NULL)
+    {
+        strncpy(span->name, name, GPU_TIMER_NAME_LENGTH - 1);
+        span->name[GPU_TIMER_NAME_LENGTH - 1] = '\0';
+    }
+    span->target = target;
+    span->begin_query = query;
+    span->end_query = -1;
+    return frame->num_spans++;
+}
+
+static_inline void endTimerSpan(GPUTimingData* timing, int span, int query)
+{
+    if(span >= 0)
+        timing->frames[timing->current_frame].spans[span].end_query = query;
+}
+
+static void openTimerFrame(GPU_Context* context, GPUTimingData* timing)
+{
+    GPUTimerFrame* frame = &timing->frames[timing->current_frame];
+
+    // Reusing the slot drops its results if they never came back
+    frame->pending = GPU_FALSE;
+    frame->num_queries = 0;
+    frame->num_spans = 0;
+    timing->frame_open = GPU_TRUE;
+    timing->scope_depth = 0;
+    timing->target_span = beginTimerSpan(timing, NULL, context->active_target, recordTimestamp(timing, GPU_FALSE));
+}
+
+// Starts a span for the new target.  Anything drawn to the old one must already be flushed.
+static void switchTimerTarget(GPU_Context* context, GPU_Target* target)
+{
+    GPUTimingData* timing = ((GPU_CONTEXT_DATA*)context->data)->gpu_timing;
+    int query;
+    if(timing == NULL)
+        return;
+
+    if(!timing->frame_open)
+    {
+        openTimerFrame(context, timing);
+        return;
+    }
+
+    query = recordTimestamp(timing, GPU_FALSE);
+    endTimerSpan(timing, timing->target_span, query);
+    timing->target_span = beginTimerSpan(timing, NULL, target, query);
+}
+
+static void readTimerFrame(GPUTimingData* timing, GPUTimerFrame* frame)
+{
+    GLuint64 times[GPU_TIMER_MAX_QUERIES];
+    int i, j;
+
+    for(i = 0; i < frame->num_queries; i++)
+        glGetQueryObjectui64vPROC(frame->queries[i], GL_QUERY_RESULT, &times[i]);
+
+    // The first and last timestamps bracket the frame
+    timing->frame_ms = (float)(times[frame->num_queries - 1] - times[0]) / 1000000.0f;
+
+    timing->num_results = 0;
+    for(i = 0; i < frame->num_spans; i++)
+    {
+        GPUTimerSpan* span = &frame->spans[i];
+        GPUTimerSpan* result = NULL;
+        if(span->end_query < 0 || (span->name[0] == '\0' && span->target == NULL))
+            continue;
+
+        for(j = 0; j < timing->num_results; j++)
+        {
+            if(timing->results[j].target == span->target && strcmp(timing->results[j].name, span->name) == 0)
+            {
+                result = &timing->results[j];
+                break;
+            }
+        }
+        if(result == NULL)
+        {
+            result = &timing->results[timing->num_results++];
+            *result = *span;
+            result->ms = 0.0f;
+        }
+        result->ms += (float)(times[span->end_query] - times[span->begin_query]) / 1000000.0f;
+    }
+}
+
+// Reads the frames that the GPU has finished, oldest first, without waiting for the others
+static void collectTimerResults(GPUTimingData* timing)
+{
+    int i;
+    #ifdef SDL_GPU_USE_GLES
+    // A disjoint operation (e.g. a GPU clock change) makes the pending timestamps meaningless
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    #endif
+
+    for(i = 0; i < GPU_TIMER_FRAMES; i++)
+    {
+        GPUTimerFrame* frame = &timing->frames[(timing->current_frame + i) % GPU_TIMER_FRAMES];
+        GLuint available = 0;
+        if(!frame->pending)
+            continue;
+
+        #ifdef SDL_GPU_USE_GLES
+        if(disjoint)
+        {
+            frame->pending = GPU_FALSE;
+            continue;
+        }
+        #endif
+
+        glGetQueryObjectuivPROC(frame->queries[frame->num_queries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available)
+            break;
+
+        frame->pending = GPU_FALSE;
+        readTimerFrame(timing, frame);
+    }
+}
+
+static void closeTimerFrame(GPUTimingData* timing)
+{
+    int query = recordTimestamp(timing, GPU_TRUE);
+
+    endTimerSpan(timing, timing->target_span, query);
+    timing->target_span = -1;
+    // Scopes don't carry over into the next frame
+    while(timing->scope_depth > 0)
+    {
+        timing->scope_depth--;
+        if(timing->scope_depth < GPU_TIMER_MAX_DEPTH)
+            endTimerSpan(timing, timing->scope_stack[timing->scope_depth], query);
+    }
+
+    timing->frames[timing->current_frame].pending = GPU_TRUE;
+    timing->frame_open = GPU_FALSE;
+    timing->current_frame = (timing->current_frame + 1) % GPU_TIMER_FRAMES;
+
+    collectTimerResults(timing);
+}
+
+static void freeGPUTiming(GPU_CONTEXT_DATA* cdata, GPU_bool delete_queries)
+{
+    int i;
+    if(cdata->gpu_timing == NULL)
+        return;
+
+    if(delete_queries)
+    {
+        for(i = 0; i < GPU_TIMER_FRAMES; i++)
+            glDeleteQueriesPROC(GPU_TIMER_MAX_QUERIES, cdata->gpu_timing->frames[i].queries);
+    }
+    SDL_free(cdata->gpu_timing);
+    cdata->gpu_timing = NULL;
 }
+#endif
 
 static void extBindFramebuffer(GPU_Renderer* renderer, GLuint handle)
 {
@@ -637,26 +1044,225 @@ static_inline unsigned int getNearestPowerOf2(unsigned int n)
     return x;
 }
 
+// One run of recorded blit buffer geometry that shares render state (see GPU_BeginSortedBatch())
+typedef struct SortedDraw
+{
+    Uint64 key;
+    int layer;
+    GPU_Image* image;  // NULL for shapes
+    unsigned int shape;
+    Uint32 shader_program;
+    GPU_ShaderBlock shader_block;
+    GPU_bool use_blending;
+    GPU_BlendMode blend_mode;
+    GPU_bool depth_test;
+    GPU_bool depth_write;
+    GPU_ComparisonEnum depth_function;
+    unsigned int first_vertex;
+    unsigned int num_vertices;
+    unsigned int first_index;
+    unsigned int num_indices;
+} SortedDraw;
+
+typedef struct SortedDrawKey
+{
+    Uint64 key;
+    unsigned int draw;
+} SortedDrawKey;
+
+// What a command list entry does (see GPU_BeginCommandList())
+typedef enum {
+    COMMAND_DRAW,  // A run of vertices, with its render state
+    COMMAND_MODEL,  // The model matrix of the draws that follow
+    COMMAND_UNIFORM,
+    COMMAND_BATCH  // A primitive batch, which doesn't go through the blit buffer
+} CommandType;
+
+typedef enum {
+    COMMAND_UNIFORM_INT,
+    COMMAND_UNIFORM_UINT,
+    COMMAND_UNIFORM_FLOAT,
+    COMMAND_UNIFORM_MATRIX
+} CommandUniformType;
+
+typedef struct RecordedCommand
+{
+    CommandType type;
+    // Draws index the list's vertices and indices.  Indices are relative to the draw's first vertex.
+    SortedDraw draw;
+    // Shader state for uniforms and batches
+    Uint32 shader_program;
+    GPU_ShaderBlock shader_block;
+    // Bytes in the list's data: a model matrix, uniform values, or batch values followed by batch indices
+    unsigned int data_offset;
+
+    CommandUniformType uniform_type;
+    int location;
+    int num_elements_per_value;  // Rows for matrices
+    int num_columns;
+    int num_values;
+    GPU_bool transpose;
+
+    GPU_Image* image;
+    GPU_PrimitiveEnum primitive_type;
+    GPU_BatchFlagEnum flags;
+    unsigned int num_vertices;
+    unsigned int num_indices;
+    GPU_bool use_32bit_indices;
+    GPU_bool has_values;
+    GPU_bool has_indices;
+} RecordedCommand;
+
+typedef struct CommandListData
+{
+    RecordedCommand* commands;
+    unsigned int num_commands;
+    unsigned int max_num_commands;
+
+    float* vertices;
+    unsigned int num_vertices;
+    unsigned int max_num_vertices;
+    GPU_BLIT_INDEX_TYPE* indices;
+    unsigned int num_indices;
+    unsigned int max_num_indices;
+
+    Uint8* data;
+    unsigned int data_size;
+    unsigned int max_data_size;
+
+    int last_model;  // Command of the last recorded model matrix, or -1
+} CommandListData;
+
+typedef struct SortedBatchData
+{
+    GPU_Target* target;  // NULL when no batch is open
+    int layer;
+    GPU_bool replaying;
+    CommandListData* command_list;  // Recording into this instead of sorting (see GPU_BeginCommandList())
+
+    SortedDraw* draws;
+    unsigned int num_draws;
+    unsigned int max_num_draws;
+    SortedDrawKey* keys;
+    SortedDrawKey* keys_scratch;
+
+    // The recorded geometry is moved here while the blit buffer is refilled in sorted order
+    float* vertices;
+    unsigned int max_num_vertices;
+    GPU_BLIT_INDEX_TYPE* indices;
+    unsigned int max_num_indices;
+} SortedBatchData;
+
+// True if draws to this target are being recorded for the sorted batch instead of changing state now
+static_inline GPU_bool isRecordingSortedBatch(GPU_Context* context, GPU_Target* target)
+{
+    SortedBatchData* batch = ((GPU_CONTEXT_DATA*)context->data)->sorted_batch;
+    return (batch != NULL && batch->target != NULL && batch->target == target && !batch->replaying);
+}
+
+static_inline GPU_bool hasSortedDraws(GPU_CONTEXT_DATA* cdata)
+{
+    return (cdata->sorted_batch != NULL && cdata->sorted_batch->num_draws > 0 && !cdata->sorted_batch->replaying);
+}
+
 static void bindTexture(GPU_Renderer* renderer, GPU_Image* image)
 {
     // Bind the texture to which subsequent calls refer
     if(image != ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image)
     {
         GLuint handle = ((GPU_IMAGE_DATA*)image->data)->handle;
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_TEXTURE_CHANGE);
 
         glBindTexture( GL_TEXTURE_2D, handle );
+        GPU_COUNT_FRAME_STAT(renderer->current_context_target->context, texture_binds, 1);
         ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image = image;
+        #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+        if(((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->num_bound_slots > 0)
+            ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->slot_images[0] = image;
+        #endif
     }
 }
 
 static_inline void flushAndBindTexture(GPU_Renderer* renderer, GLuint handle)
 {
     // Bind the texture to which subsequent calls refer
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_TEXTURE_CHANGE);
 
     glBindTexture( GL_TEXTURE_2D, handle );
+    GPU_COUNT_FRAME_STAT(renderer->current_context_target->context, texture_binds, 1);
     ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image = NULL;
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->num_bound_slots = 0;
+    #endif
+}
+
+#ifdef SDL_GPU_USE_TEXTURE_SLOTS
+// Returns the texture unit that the image is bound to for blits, or -1.
+static_inline int getTextureSlot(GPU_CONTEXT_DATA* cdata, GPU_Image* image)
+{
+    int i;
+    for(i = 0; i < cdata->num_bound_slots; i++)
+    {
+        if(cdata->slot_images[i] == image)
+            return i;
+    }
+    return -1;
+}
+#endif
+
+// Binds the image for a blit.  With the default textured shader, each image gets its own texture unit
+// and the unit is written into the vertices, so switching between a few images doesn't flush.
+static void bindTextureSlot(GPU_Renderer* renderer, GPU_Image* image)
+{
+#ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    GPU_Context* context = renderer->current_context_target->context;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
+    GPU_bool use_slots = (cdata->num_texture_slots > 1 && context->current_shader_program == context->default_textured_shader_program);
+    int slot;
+
+    // The shader samples unit 0 outside of its branches, so mipmapped images go there to keep their derivatives defined
+    if(!use_slots || image->has_mipmaps)
+    {
+        bindTexture(renderer, image);
+        cdata->current_texture_slot = 0.0f;
+        return;
+    }
+
+    // Unit 0 is shared with bindTexture(), so start from whatever it left there
+    if(cdata->num_bound_slots == 0 && cdata->last_image != NULL)
+    {
+        cdata->slot_images[0] = cdata->last_image;
+        cdata->num_bound_slots = 1;
+    }
+
+    slot = getTextureSlot(cdata, image);
+    if(slot < 0)
+    {
+        if(cdata->num_bound_slots < cdata->num_texture_slots)
+            slot = cdata->num_bound_slots++;
+        else
+        {
+            // Every unit is in use, so the pending blits have to go before one is replaced
+            flushBlitBufferFor(renderer, GPU_FLUSH_TEXTURE_CHANGE);
+            slot = cdata->next_texture_slot;
+            cdata->next_texture_slot = (slot + 1) % cdata->num_texture_slots;
+        }
+
+        if(slot > 0)
+            glActiveTexture(GL_TEXTURE0 + slot);
+        glBindTexture(GL_TEXTURE_2D, ((GPU_IMAGE_DATA*)image->data)->handle);
+        GPU_COUNT_FRAME_STAT(context, texture_binds, 1);
+        if(slot > 0)
+            glActiveTexture(GL_TEXTURE0);
+        else
+            cdata->last_image = image;
+        cdata->slot_images[slot] = image;
+    }
+
+    cdata->current_texture_slot = (float)slot;
+#else
+    bindTexture(renderer, image);
+#endif
 }
 
 
@@ -667,12 +1273,13 @@ static void makeContextCurrent(GPU_Renderer* renderer, GPU_Target* target)
     if (target == NULL || target->context == NULL || renderer->current_context_target == target)
         return;
 
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_TARGET_SWITCH);
 
 #ifdef SDL_GPU_USE_SDL2
     SDL_GL_MakeCurrent(SDL_GetWindowFromID(target->context->windowID), target->context->context);
 #endif
     renderer->current_context_target = target;
+    GPU_COUNT_FRAME_STAT(target->context, target_switches, 1);
 }
 
 // Binds the target's framebuffer.  Returns false if it can't be bound, true if it is bound or already bound.
@@ -689,10 +1296,14 @@ static GPU_bool SetActiveTarget(GPU_Renderer* renderer, GPU_Target* target)
         if(target != renderer->current_context_target->context->active_target)
         {
             GLuint handle = ((GPU_TARGET_DATA*)target->data)->handle;
-            renderer->impl->FlushBlitBuffer(renderer);
+            flushBlitBufferFor(renderer, GPU_FLUSH_TARGET_SWITCH);
 
             extBindFramebuffer(renderer, handle);
             renderer->current_context_target->context->active_target = target;
+            GPU_COUNT_FRAME_STAT(renderer->current_context_target->context, target_switches, 1);
+            #ifdef SDL_GPU_USE_TIMER_QUERIES
+            switchTimerTarget(renderer->current_context_target->context, target);
+            #endif
         }
     }
     else
@@ -707,94 +1318,422 @@ static GPU_bool SetActiveTarget(GPU_Renderer* renderer, GPU_Target* target)
 static_inline void flushAndBindFramebuffer(GPU_Renderer* renderer, GLuint handle)
 {
     // Bind the FBO
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_TARGET_SWITCH);
 
     extBindFramebuffer(renderer, handle);
     renderer->current_context_target->context->active_target = NULL;
+    GPU_COUNT_FRAME_STAT(renderer->current_context_target->context, target_switches, 1);
+    #ifdef SDL_GPU_USE_TIMER_QUERIES
+    switchTimerTarget(renderer->current_context_target->context, NULL);
+    #endif
+}
+
+// True if the pending blits may sample from the image
+static_inline GPU_bool isTextureInUse(GPU_CONTEXT_DATA* cdata, GPU_Image* image)
+{
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    if(getTextureSlot(cdata, image) >= 0)
+        return GPU_TRUE;
+    #endif
+    // Recorded sorted batch draws may refer to any image
+    return (image == cdata->last_image || hasSortedDraws(cdata));
 }
 
 static_inline void flushBlitBufferIfCurrentTexture(GPU_Renderer* renderer, GPU_Image* image)
 {
-    if(image == ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image)
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(isTextureInUse(cdata, image))
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_TEXTURE_CHANGE);
     }
 }
 
 static_inline void flushAndClearBlitBufferIfCurrentTexture(GPU_Renderer* renderer, GPU_Image* image)
 {
-    if(image == ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image)
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(isTextureInUse(cdata, image))
     {
-        renderer->impl->FlushBlitBuffer(renderer);
-        ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image = NULL;
+        flushBlitBufferFor(renderer, GPU_FLUSH_TEXTURE_CHANGE);
+        if(image == cdata->last_image)
+            cdata->last_image = NULL;
+        #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+        if(getTextureSlot(cdata, image) >= 0)
+            cdata->num_bound_slots = 0;
+        #endif
     }
 }
 
-static_inline GPU_bool isCurrentTarget(GPU_Renderer* renderer, GPU_Target* target)
-{
-    return (target == renderer->current_context_target->context->active_target
-            || renderer->current_context_target->context->active_target == NULL);
-}
-
 static_inline void flushAndClearBlitBufferIfCurrentFramebuffer(GPU_Renderer* renderer, GPU_Target* target)
 {
     if(target == renderer->current_context_target->context->active_target
             || renderer->current_context_target->context->active_target == NULL)
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_TARGET_SWITCH);
         renderer->current_context_target->context->active_target = NULL;
     }
 }
 
-static GPU_bool growBlitBuffer(GPU_CONTEXT_DATA* cdata, unsigned int minimum_vertices_needed)
+#ifdef SDL_GPU_USE_BUFFER_PIPELINE
+// Writes the quad index pattern for the whole blit buffer into blit_quad_IBO (which must be bound).
+static void fillQuadIndexBuffer(GPU_CONTEXT_DATA* cdata)
 {
-	unsigned int new_max_num_vertices;
-	float* new_buffer;
+    unsigned int num_quads = cdata->blit_buffer_max_num_vertices / GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+    GPU_BLIT_INDEX_TYPE* indices = (GPU_BLIT_INDEX_TYPE*)SDL_malloc(num_quads * 6 * sizeof(GPU_BLIT_INDEX_TYPE));
+    GPU_BLIT_INDEX_TYPE* index = indices;
+    unsigned int i;
 
-    if(minimum_vertices_needed <= cdata->blit_buffer_max_num_vertices)
-        return GPU_TRUE;
-    if(cdata->blit_buffer_max_num_vertices == GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES)
-        return GPU_FALSE;
+    for(i = 0; i < num_quads; i++)
+    {
+        GPU_BLIT_INDEX_TYPE first = (GPU_BLIT_INDEX_TYPE)(i*GPU_BLIT_BUFFER_VERTICES_PER_SPRITE);
+        *index++ = first;
+        *index++ = first + 1;
+        *index++ = first + 2;
+        *index++ = first;
+        *index++ = first + 2;
+        *index++ = first + 3;
+    }
 
-    // Calculate new size (in vertices)
-    new_max_num_vertices = ((unsigned int)cdata->blit_buffer_max_num_vertices) * 2;
-    while(new_max_num_vertices <= minimum_vertices_needed)
-        new_max_num_vertices *= 2;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->blit_quad_IBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, num_quads * 6 * sizeof(GPU_BLIT_INDEX_TYPE), indices, GL_STATIC_DRAW);
+    SDL_free(indices);
+}
+#endif
 
-    if(new_max_num_vertices > GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES)
-        new_max_num_vertices = GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES;
+#ifdef SDL_GPU_USE_FLUSH_VAOS
+#define GPU_FLUSH_VAO_KEY_SIZE 6
 
-    //GPU_LogError("Growing to %d vertices\n", new_max_num_vertices);
-    // Resize the blit buffer
-    new_buffer = (float*)SDL_malloc(new_max_num_vertices * GPU_BLIT_BUFFER_STRIDE);
-    memcpy(new_buffer, cdata->blit_buffer, cdata->blit_buffer_num_vertices * GPU_BLIT_BUFFER_STRIDE);
-    SDL_free(cdata->blit_buffer);
-    cdata->blit_buffer = new_buffer;
-    cdata->blit_buffer_max_num_vertices = (unsigned short)new_max_num_vertices;
+// Binds the VAO that draws the blit buffer from the given VBO with these attribute locations (-1 for unused), building it the first time.
+// Attribute pointers start at offset 0, so persistent ring draws pick their vertices with a base vertex.
+static void bindFlushVAO(GPU_CONTEXT_DATA* cdata, int position_loc, int texcoord_loc, int color_loc, int texture_slot_loc, unsigned int vbo, unsigned int ibo)
+{
+    int num_entries = (int)(sizeof(cdata->flush_VAO)/sizeof(cdata->flush_VAO[0]));
+    int key[GPU_FLUSH_VAO_KEY_SIZE];
+    int i;
 
-    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
-        // Resize the VBOs
-        #if !defined(SDL_GPU_NO_VAO)
-        glBindVertexArray(cdata->blit_VAO);
-        #endif
+    key[0] = position_loc;
+    key[1] = texcoord_loc;
+    key[2] = color_loc;
+    key[3] = texture_slot_loc;
+    key[4] = (int)vbo;
+    key[5] = (int)ibo;
 
-        glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[0]);
-        glBufferData(GL_ARRAY_BUFFER, GPU_BLIT_BUFFER_STRIDE * cdata->blit_buffer_max_num_vertices, NULL, GL_STREAM_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[1]);
-        glBufferData(GL_ARRAY_BUFFER, GPU_BLIT_BUFFER_STRIDE * cdata->blit_buffer_max_num_vertices, NULL, GL_STREAM_DRAW);
+    for(i = 0; i < num_entries; i++)
+    {
+        if(cdata->flush_VAO[i] != 0 && memcmp(cdata->flush_VAO_key[i], key, sizeof(key)) == 0)
+        {
+            glBindVertexArray(cdata->flush_VAO[i]);
+            return;
+        }
+    }
 
-        #if !defined(SDL_GPU_NO_VAO)
-        glBindVertexArray(0);
-        #endif
-    #endif
+    // Start the oldest one over
+    i = cdata->flush_VAO_next;
+    cdata->flush_VAO_next = (i + 1) % num_entries;
+    if(cdata->flush_VAO[i] != 0)
+        glDeleteVertexArrays(1, &cdata->flush_VAO[i]);
+    glGenVertexArrays(1, &cdata->flush_VAO[i]);
+    memcpy(cdata->flush_VAO_key[i], key, sizeof(key));
 
-    return GPU_TRUE;
+    glBindVertexArray(cdata->flush_VAO[i]);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+
+    if(position_loc >= 0)
+    {
+        glEnableVertexAttribArray(position_loc);
+        glVertexAttribPointer(position_loc, 2, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)0);
+    }
+    if(texcoord_loc >= 0)
+    {
+        glEnableVertexAttribArray(texcoord_loc);
+        glVertexAttribPointer(texcoord_loc, 2, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)(GPU_BLIT_BUFFER_TEX_COORD_OFFSET * sizeof(float)));
+    }
+    if(color_loc >= 0)
+    {
+        glEnableVertexAttribArray(color_loc);
+        glVertexAttribPointer(color_loc, 4, GPU_BLIT_BUFFER_COLOR_GL_TYPE, GPU_BLIT_BUFFER_COLOR_NORMALIZED, GPU_BLIT_BUFFER_STRIDE, (void*)(GPU_BLIT_BUFFER_COLOR_OFFSET * sizeof(float)));
+    }
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    if(texture_slot_loc >= 0)
+    {
+        glEnableVertexAttribArray(texture_slot_loc);
+        glVertexAttribPointer(texture_slot_loc, 1, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)(GPU_BLIT_BUFFER_TEX_SLOT_OFFSET * sizeof(float)));
+    }
+    #endif
+}
+
+// Drops the VAOs that read from the given buffer.  A VAO keeps a deleted buffer alive, even if its name gets reused.
+static void freeFlushVAOs(GPU_CONTEXT_DATA* cdata, unsigned int vbo)
+{
+    int num_entries = (int)(sizeof(cdata->flush_VAO)/sizeof(cdata->flush_VAO[0]));
+    int i;
+    for(i = 0; i < num_entries; i++)
+    {
+        if(cdata->flush_VAO[i] != 0 && (vbo == 0 || cdata->flush_VAO_key[i][4] == (int)vbo))
+        {
+            glDeleteVertexArrays(1, &cdata->flush_VAO[i]);
+            cdata->flush_VAO[i] = 0;
+        }
+    }
+}
+#endif
+
+#ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+// Nanoseconds per glClientWaitSync() attempt
+#define GPU_PERSISTENT_FENCE_TIMEOUT 1000000000
+
+static GPU_bool isPersistentBufferSupported(GPU_Renderer* renderer)
+{
+    return (renderer->id.major_version > 4 || (renderer->id.major_version == 4 && renderer->id.minor_version >= 4)
+            || isExtensionSupported("GL_ARB_buffer_storage"));
+}
+
+static void releasePersistentBlitBuffer(GPU_CONTEXT_DATA* cdata)
+{
+    int i;
+    if(!cdata->use_persistent_buffer)
+        return;
+
+    #ifdef SDL_GPU_USE_FLUSH_VAOS
+    freeFlushVAOs(cdata, cdata->persistent_VBO);
+    #endif
+
+    // GL keeps the storage alive for draws that still use it
+    glBindBuffer(GL_ARRAY_BUFFER, cdata->persistent_VBO);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glDeleteBuffers(1, &cdata->persistent_VBO);
+    for(i = 0; i < GPU_PERSISTENT_RING_SEGMENTS; i++)
+    {
+        if(cdata->persistent_fences[i] != NULL)
+            glDeleteSync(cdata->persistent_fences[i]);
+        cdata->persistent_fences[i] = NULL;
+    }
+
+    cdata->persistent_VBO = 0;
+    cdata->persistent_buffer = NULL;
+    cdata->use_persistent_buffer = GPU_FALSE;
+}
+
+// Replaces the heap blit buffer with a persistently mapped ring of GPU_PERSISTENT_RING_SEGMENTS blit buffers.
+// Vertices are then written straight into GPU-visible memory.  Keeps the heap buffer if the mapping fails.
+static GPU_bool createPersistentBlitBuffer(GPU_CONTEXT_DATA* cdata)
+{
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr size = (GLsizeiptr)(GPU_BLIT_BUFFER_STRIDE * cdata->blit_buffer_max_num_vertices) * GPU_PERSISTENT_RING_SEGMENTS;
+    GLuint vbo;
+    float* mapped;
+    int i;
+
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+    mapped = (float*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+    if(mapped == NULL)
+    {
+        glDeleteBuffers(1, &vbo);
+        return GPU_FALSE;
+    }
+
+    memcpy(mapped, cdata->blit_buffer, cdata->blit_buffer_num_vertices * GPU_BLIT_BUFFER_STRIDE);
+    if(cdata->use_persistent_buffer)
+        releasePersistentBlitBuffer(cdata);
+    else
+        SDL_free(cdata->blit_buffer);
+
+    cdata->use_persistent_buffer = GPU_TRUE;
+    cdata->persistent_VBO = vbo;
+    cdata->persistent_buffer = mapped;
+    cdata->persistent_cursor = 0;
+    for(i = 0; i < GPU_PERSISTENT_RING_SEGMENTS; i++)
+        cdata->persistent_fences[i] = NULL;
+    cdata->blit_buffer = mapped;
+    return GPU_TRUE;
+}
+
+static void fencePersistentSegment(GPU_CONTEXT_DATA* cdata, unsigned int segment)
+{
+    if(cdata->persistent_fences[segment] != NULL)
+        glDeleteSync(cdata->persistent_fences[segment]);
+    cdata->persistent_fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+static void waitForPersistentSegment(GPU_CONTEXT_DATA* cdata, unsigned int segment)
+{
+    GLenum result;
+    if(cdata->persistent_fences[segment] == NULL)
+        return;
+
+    do
+    {
+        result = glClientWaitSync(cdata->persistent_fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, GPU_PERSISTENT_FENCE_TIMEOUT);
+    }
+    while(result == GL_TIMEOUT_EXPIRED);
+
+    glDeleteSync(cdata->persistent_fences[segment]);
+    cdata->persistent_fences[segment] = NULL;
+}
+
+// Moves the blit buffer past the vertices that were just drawn.  A segment gets a fence when the ring leaves it
+// and the fence is waited on before the blit buffer reaches that segment again.
+static void advancePersistentBlitBuffer(GPU_CONTEXT_DATA* cdata, unsigned int num_vertices)
+{
+    unsigned int segment_size = cdata->blit_buffer_max_num_vertices;
+    unsigned int old_segment = cdata->persistent_cursor / segment_size;
+    unsigned int cursor = cdata->persistent_cursor + num_vertices;
+    unsigned int i;
+
+    if(cursor + segment_size > segment_size * GPU_PERSISTENT_RING_SEGMENTS)
+    {
+        // Not enough room for a whole blit buffer, so wrap around
+        for(i = old_segment; i < GPU_PERSISTENT_RING_SEGMENTS; i++)
+            fencePersistentSegment(cdata, i);
+        cursor = 0;
+    }
+    else
+    {
+        for(i = old_segment; i < cursor / segment_size; i++)
+            fencePersistentSegment(cdata, i);
+    }
+
+    // The new blit buffer can reach into the next segment too
+    for(i = cursor / segment_size; i <= (cursor + segment_size - 1) / segment_size; i++)
+        waitForPersistentSegment(cdata, i);
+
+    cdata->persistent_cursor = cursor;
+    cdata->blit_buffer = cdata->persistent_buffer + cursor*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+}
+#endif
+
+#ifdef SDL_GPU_USE_BUFFER_PIPELINE
+// Gives the blit VBOs and IBO room for a full blit buffer.  GPU_BUFFER_UPLOAD_UPDATE and GPU_BUFFER_UPLOAD_MAPPING write into that storage.
+static void resizeBlitBufferObjects(GPU_CONTEXT_DATA* cdata)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[0]);
+    glBufferData(GL_ARRAY_BUFFER, GPU_BLIT_BUFFER_STRIDE * cdata->blit_buffer_max_num_vertices, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[1]);
+    glBufferData(GL_ARRAY_BUFFER, GPU_BLIT_BUFFER_STRIDE * cdata->blit_buffer_max_num_vertices, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GPU_BLIT_INDEX_TYPE) * cdata->index_buffer_max_num_vertices, NULL, GL_DYNAMIC_DRAW);
+}
+
+static GPU_bool isBufferUploadMethodSupported(GPU_Renderer* renderer, GPU_BufferUploadEnum method)
+{
+    (void)renderer;
+    if(method == GPU_BUFFER_UPLOAD_RESET || method == GPU_BUFFER_UPLOAD_UPDATE)
+        return GPU_TRUE;
+    #ifdef SDL_GPU_HAS_BUFFER_MAPPING
+    if(method == GPU_BUFFER_UPLOAD_MAPPING)
+        return GPU_TRUE;
+    #endif
+    #ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+    if(method == GPU_BUFFER_UPLOAD_PERSISTENT)
+        return isPersistentBufferSupported(renderer);
+    #endif
+    return GPU_FALSE;
+}
+
+// Switches the context's upload method.  The blit buffer must be empty.
+static GPU_bool applyBufferUploadMethod(GPU_CONTEXT_DATA* cdata, GPU_BufferUploadEnum method)
+{
+    #ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+    if(method == GPU_BUFFER_UPLOAD_PERSISTENT)
+    {
+        if(!cdata->use_persistent_buffer && !createPersistentBlitBuffer(cdata))
+            return GPU_FALSE;
+    }
+    else if(cdata->use_persistent_buffer)
+    {
+        // Back to a heap blit buffer
+        float* new_buffer = (float*)SDL_malloc(cdata->blit_buffer_max_num_vertices * GPU_BLIT_BUFFER_STRIDE);
+        if(new_buffer == NULL)
+            return GPU_FALSE;
+        releasePersistentBlitBuffer(cdata);
+        cdata->blit_buffer = new_buffer;
+    }
+    #endif
+
+    #if !defined(SDL_GPU_NO_VAO)
+    glBindVertexArray(cdata->blit_VAO);
+    #endif
+    // GPU_BUFFER_UPLOAD_RESET may have shrunk the buffers
+    if(method == GPU_BUFFER_UPLOAD_UPDATE || method == GPU_BUFFER_UPLOAD_MAPPING)
+        resizeBlitBufferObjects(cdata);
+    #if !defined(SDL_GPU_NO_VAO)
+    glBindVertexArray(0);
+    #endif
+
+    cdata->buffer_upload_method = method;
+    return GPU_TRUE;
+}
+#endif
+
+static GPU_bool growBlitBuffer(GPU_CONTEXT_DATA* cdata, unsigned int minimum_vertices_needed)
+{
+	unsigned int new_max_num_vertices;
+	float* new_buffer;
+	#ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+	GPU_bool was_persistent = cdata->use_persistent_buffer;
+	#endif
+
+    if(minimum_vertices_needed <= cdata->blit_buffer_max_num_vertices)
+        return GPU_TRUE;
+    if(cdata->blit_buffer_max_num_vertices == GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES)
+        return GPU_FALSE;
+
+    // Calculate new size (in vertices)
+    new_max_num_vertices = ((unsigned int)cdata->blit_buffer_max_num_vertices) * 2;
+    while(new_max_num_vertices <= minimum_vertices_needed)
+        new_max_num_vertices *= 2;
+
+    if(new_max_num_vertices > GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES)
+        new_max_num_vertices = GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES;
+
+    //GPU_LogError("Growing to %d vertices\n", new_max_num_vertices);
+    // Resize the blit buffer
+    new_buffer = (float*)SDL_malloc(new_max_num_vertices * GPU_BLIT_BUFFER_STRIDE);
+    if(new_buffer == NULL)
+        return GPU_FALSE;
+    memcpy(new_buffer, cdata->blit_buffer, cdata->blit_buffer_num_vertices * GPU_BLIT_BUFFER_STRIDE);
+    #ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+    if(was_persistent)
+        releasePersistentBlitBuffer(cdata);
+    else
+    #endif
+    SDL_free(cdata->blit_buffer);
+    cdata->blit_buffer = new_buffer;
+    cdata->blit_buffer_max_num_vertices = new_max_num_vertices;
+
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+        // Resize the VBOs
+        #if !defined(SDL_GPU_NO_VAO)
+        glBindVertexArray(cdata->blit_VAO);
+        #endif
+
+        resizeBlitBufferObjects(cdata);
+
+        fillQuadIndexBuffer(cdata);
+
+        #ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+        // Move the pending vertices into a bigger ring
+        if(was_persistent && !createPersistentBlitBuffer(cdata))
+        {
+            GPU_PushErrorCode(__func__, GPU_ERROR_BACKEND_ERROR, "Failed to map a bigger persistent blit buffer.  Switching to GPU_BUFFER_UPLOAD_UPDATE.");
+            applyBufferUploadMethod(cdata, GPU_BUFFER_UPLOAD_UPDATE);
+        }
+        #endif
+
+        #if !defined(SDL_GPU_NO_VAO)
+        glBindVertexArray(0);
+        #endif
+    #endif
+
+    return GPU_TRUE;
 }
 
 static GPU_bool growIndexBuffer(GPU_CONTEXT_DATA* cdata, unsigned int minimum_vertices_needed)
 {
 	unsigned int new_max_num_vertices;
-	unsigned short* new_indices;
+	GPU_BLIT_INDEX_TYPE* new_indices;
 
     if(minimum_vertices_needed <= cdata->index_buffer_max_num_vertices)
         return GPU_TRUE;
@@ -811,8 +1750,8 @@ static GPU_bool growIndexBuffer(GPU_CONTEXT_DATA* cdata, unsigned int minimum_ve
 
     //GPU_LogError("Growing to %d indices\n", new_max_num_vertices);
     // Resize the index buffer
-    new_indices = (unsigned short*)SDL_malloc(new_max_num_vertices * sizeof(unsigned short));
-    memcpy(new_indices, cdata->index_buffer, cdata->index_buffer_num_vertices * sizeof(unsigned short));
+    new_indices = (GPU_BLIT_INDEX_TYPE*)SDL_malloc(new_max_num_vertices * sizeof(GPU_BLIT_INDEX_TYPE));
+    memcpy(new_indices, cdata->index_buffer, cdata->index_buffer_num_vertices * sizeof(GPU_BLIT_INDEX_TYPE));
     SDL_free(cdata->index_buffer);
     cdata->index_buffer = new_indices;
     cdata->index_buffer_max_num_vertices = new_max_num_vertices;
@@ -824,7 +1763,7 @@ static GPU_bool growIndexBuffer(GPU_CONTEXT_DATA* cdata, unsigned int minimum_ve
         #endif
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * cdata->index_buffer_max_num_vertices, NULL, GL_DYNAMIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GPU_BLIT_INDEX_TYPE) * cdata->index_buffer_max_num_vertices, NULL, GL_DYNAMIC_DRAW);
 
         #if !defined(SDL_GPU_NO_VAO)
         glBindVertexArray(0);
@@ -834,6 +1773,195 @@ static GPU_bool growIndexBuffer(GPU_CONTEXT_DATA* cdata, unsigned int minimum_ve
     return GPU_TRUE;
 }
 
+#ifdef SDL_GPU_USE_INSTANCED_SPRITES
+
+static void setInstanceAttribute(Uint32 program_object, const char* name, int num_elems, GLenum type, GLboolean normalize, int offset)
+{
+    int loc = glGetAttribLocation(program_object, name);
+    if(loc < 0)
+        return;
+
+    glEnableVertexAttribArray(loc);
+    glVertexAttribPointer(loc, num_elems, type, normalize, GPU_INSTANCE_BUFFER_STRIDE, (void*)(offset * sizeof(float)));
+    glVertexAttribDivisor(loc, 1);
+}
+
+// Builds the instanced sprite program and its static quad.  Leaves use_instanced_sprites off if anything is missing.
+static void initInstancedSprites(GPU_Renderer* renderer, GPU_Target* target)
+{
+    static const float quad_corners[8] = {0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f};
+    static const unsigned short quad_indices[6] = {0, 1, 2, 0, 2, 3};
+    GPU_Context* context = target->context;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
+    const char* vertex_shader_source = GPU_DEFAULT_INSTANCED_VERTEX_SHADER_SOURCE;
+    Uint32 v, p;
+
+    cdata->use_instanced_sprites = GPU_FALSE;
+    if(!(renderer->GPU_init_flags & GPU_INIT_USE_INSTANCED_SPRITES) || context->default_textured_fragment_shader_id == 0)
+        return;
+
+    #ifdef SDL_GPU_USE_OPENGL
+    // Attribute divisors are core since OpenGL 3.3
+    if(renderer->id.major_version == 3 && renderer->id.minor_version < 3)
+    {
+        GPU_PushErrorCode("GPU_CreateTargetFromWindow", GPU_ERROR_BACKEND_ERROR, "Instanced sprites need OpenGL 3.3 or later.  Using the vertex batch instead.");
+        return;
+    }
+    #endif
+
+    #ifdef SDL_GPU_ENABLE_CORE_SHADERS
+    if(renderer->id.major_version > 3 || (renderer->id.major_version == 3 && renderer->id.minor_version >= 2))
+        vertex_shader_source = GPU_DEFAULT_INSTANCED_VERTEX_SHADER_SOURCE_CORE;
+    #endif
+
+    v = renderer->impl->CompileShader(renderer, GPU_VERTEX_SHADER, vertex_shader_source);
+    if(!v)
+    {
+        GPU_PushErrorCode("GPU_CreateTargetFromWindow", GPU_ERROR_BACKEND_ERROR, "Failed to load instanced sprite vertex shader: %s.", GPU_GetShaderMessage());
+        return;
+    }
+
+    p = renderer->impl->CreateShaderProgram(renderer);
+    renderer->impl->AttachShader(renderer, p, v);
+    renderer->impl->AttachShader(renderer, p, context->default_textured_fragment_shader_id);
+    if(!renderer->impl->LinkShaderProgram(renderer, p))
+    {
+        GPU_PushErrorCode("GPU_CreateTargetFromWindow", GPU_ERROR_BACKEND_ERROR, "Failed to link instanced sprite shader program: %s.", GPU_GetShaderMessage());
+        renderer->impl->FreeShader(renderer, v);
+        return;
+    }
+
+    cdata->instanced_vertex_shader_id = v;
+    cdata->instanced_shader_program = p;
+    cdata->instanced_modelViewProjection_loc = glGetUniformLocation(p, "gpu_ModelViewProjectionMatrix");
+
+    cdata->instance_buffer_max_num_sprites = GPU_INSTANCE_BUFFER_INIT_MAX_NUM_SPRITES;
+    cdata->instance_buffer_num_sprites = 0;
+    cdata->instance_buffer = (float*)SDL_malloc(cdata->instance_buffer_max_num_sprites * GPU_INSTANCE_BUFFER_STRIDE);
+
+    // The VAO holds the whole layout, so a flush only uploads the instance records.
+    glGenVertexArrays(1, &cdata->instanced_VAO);
+    glBindVertexArray(cdata->instanced_VAO);
+
+    glGenBuffers(1, &cdata->instanced_quad_VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, cdata->instanced_quad_VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad_corners), quad_corners, GL_STATIC_DRAW);
+    // gpu_Vertex is always bound to location 0 by LinkShaderProgram()
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    glGenBuffers(1, &cdata->instanced_quad_IBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->instanced_quad_IBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quad_indices), quad_indices, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &cdata->instance_VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, cdata->instance_VBO);
+    glBufferData(GL_ARRAY_BUFFER, GPU_INSTANCE_BUFFER_STRIDE * cdata->instance_buffer_max_num_sprites, NULL, GL_STREAM_DRAW);
+    setInstanceAttribute(p, "gpu_InstanceRect", 4, GL_FLOAT, GL_FALSE, GPU_INSTANCE_BUFFER_RECT_OFFSET);
+    setInstanceAttribute(p, "gpu_InstancePivot", 3, GL_FLOAT, GL_FALSE, GPU_INSTANCE_BUFFER_PIVOT_OFFSET);
+    setInstanceAttribute(p, "gpu_InstanceTexRect", 4, GL_FLOAT, GL_FALSE, GPU_INSTANCE_BUFFER_TEX_RECT_OFFSET);
+    setInstanceAttribute(p, "gpu_InstanceColor", 4, GL_UNSIGNED_BYTE, GL_TRUE, GPU_INSTANCE_BUFFER_COLOR_OFFSET);
+
+    glBindVertexArray(0);
+
+    cdata->use_instanced_sprites = GPU_TRUE;
+}
+
+static void freeInstancedSprites(GPU_CONTEXT_DATA* cdata)
+{
+    if(!cdata->use_instanced_sprites)
+        return;
+
+    glDeleteBuffers(1, &cdata->instance_VBO);
+    glDeleteBuffers(1, &cdata->instanced_quad_IBO);
+    glDeleteBuffers(1, &cdata->instanced_quad_VBO);
+    glDeleteVertexArrays(1, &cdata->instanced_VAO);
+    glDeleteProgram(cdata->instanced_shader_program);
+    glDeleteShader(cdata->instanced_vertex_shader_id);
+    cdata->use_instanced_sprites = GPU_FALSE;
+}
+
+static GPU_bool growInstanceBuffer(GPU_CONTEXT_DATA* cdata, unsigned int minimum_sprites_needed)
+{
+	unsigned int new_max_num_sprites;
+	float* new_buffer;
+
+    if(minimum_sprites_needed <= cdata->instance_buffer_max_num_sprites)
+        return GPU_TRUE;
+    if(cdata->instance_buffer_max_num_sprites == GPU_INSTANCE_BUFFER_ABSOLUTE_MAX_SPRITES)
+        return GPU_FALSE;
+
+    new_max_num_sprites = cdata->instance_buffer_max_num_sprites * 2;
+    while(new_max_num_sprites <= minimum_sprites_needed)
+        new_max_num_sprites *= 2;
+
+    if(new_max_num_sprites > GPU_INSTANCE_BUFFER_ABSOLUTE_MAX_SPRITES)
+        new_max_num_sprites = GPU_INSTANCE_BUFFER_ABSOLUTE_MAX_SPRITES;
+
+    new_buffer = (float*)SDL_malloc(new_max_num_sprites * GPU_INSTANCE_BUFFER_STRIDE);
+    memcpy(new_buffer, cdata->instance_buffer, cdata->instance_buffer_num_sprites * GPU_INSTANCE_BUFFER_STRIDE);
+    SDL_free(cdata->instance_buffer);
+    cdata->instance_buffer = new_buffer;
+    cdata->instance_buffer_max_num_sprites = new_max_num_sprites;
+
+    return GPU_TRUE;
+}
+
+// Custom shaders expect the regular per-vertex layout, so only the default textured shader gets instanced.
+static_inline GPU_bool canUseInstancedSprites(GPU_Context* context)
+{
+    return (((GPU_CONTEXT_DATA*)context->data)->use_instanced_sprites
+            && context->current_shader_program == context->default_textured_shader_program
+            && !isRecordingSortedBatch(context, context->active_target));
+}
+
+// Appends one sprite record.  The pivot is relative to the top-left of the unscaled w x h quad.
+static void addInstancedSprite(GPU_Renderer* renderer, float x, float y, float w, float h, float pivot_x, float pivot_y, float degrees, float scaleX, float scaleY, float s1, float t1, float s2, float t2, SDL_Color color)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    float* record;
+    Uint8* color_bytes;
+
+    // Keep submission order if regular vertices are waiting
+    if(cdata->blit_buffer_num_vertices > 0)
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
+
+    if(cdata->instance_buffer_num_sprites + 1 > cdata->instance_buffer_max_num_sprites)
+    {
+        if(!growInstanceBuffer(cdata, cdata->instance_buffer_num_sprites + 1))
+            flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL);
+    }
+
+    if(renderer->coordinate_mode == 1)
+    {
+        // Walk the quad bottom-up instead
+        pivot_y -= h;
+        h = -h;
+    }
+
+    record = cdata->instance_buffer + cdata->instance_buffer_num_sprites*GPU_INSTANCE_BUFFER_FLOATS_PER_SPRITE;
+    record[GPU_INSTANCE_BUFFER_RECT_OFFSET] = x;
+    record[GPU_INSTANCE_BUFFER_RECT_OFFSET+1] = y;
+    record[GPU_INSTANCE_BUFFER_RECT_OFFSET+2] = w*scaleX;
+    record[GPU_INSTANCE_BUFFER_RECT_OFFSET+3] = h*scaleY;
+    record[GPU_INSTANCE_BUFFER_PIVOT_OFFSET] = pivot_x*scaleX;
+    record[GPU_INSTANCE_BUFFER_PIVOT_OFFSET+1] = pivot_y*scaleY;
+    record[GPU_INSTANCE_BUFFER_PIVOT_OFFSET+2] = degrees*RAD_PER_DEG;
+    record[GPU_INSTANCE_BUFFER_TEX_RECT_OFFSET] = s1;
+    record[GPU_INSTANCE_BUFFER_TEX_RECT_OFFSET+1] = t1;
+    record[GPU_INSTANCE_BUFFER_TEX_RECT_OFFSET+2] = s2;
+    record[GPU_INSTANCE_BUFFER_TEX_RECT_OFFSET+3] = t2;
+    color_bytes = (Uint8*)(record + GPU_INSTANCE_BUFFER_COLOR_OFFSET);
+    color_bytes[0] = color.r;
+    color_bytes[1] = color.g;
+    color_bytes[2] = color.b;
+    color_bytes[3] = GET_ALPHA(color);
+
+    cdata->instance_buffer_num_sprites++;
+}
+
+#endif
+
 
 static void setClipRect(GPU_Renderer* renderer, GPU_Target* target)
 {
@@ -902,6 +2030,10 @@ static void changeDepthFunction(GPU_Renderer* renderer, GPU_ComparisonEnum compa
 
 static void prepareToRenderToTarget(GPU_Renderer* renderer, GPU_Target* target)
 {
+    // Draws to other targets go after the sorted batch recorded so far, so replaying it can't change their state later
+    if(hasSortedDraws((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data))
+        flushBlitBufferFor(renderer, GPU_FLUSH_TARGET_SWITCH);
+
     // Set up the camera
     renderer->impl->SetCamera(renderer, target, &target->camera);
     changeDepthTest(renderer, target->use_depth_test);
@@ -924,7 +2056,7 @@ static void changeColor(GPU_Renderer* renderer, SDL_Color color)
         || cdata->last_color.b != color.b
         || GET_ALPHA(cdata->last_color) != GET_ALPHA(color))
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_STATE_CHANGE);
         cdata->last_color = color;
         glColor4f(color.r/255.01f, color.g/255.01f, color.b/255.01f, GET_ALPHA(color)/255.01f);
     }
@@ -937,7 +2069,7 @@ static void changeBlending(GPU_Renderer* renderer, GPU_bool enable)
     if(cdata->last_use_blending == enable)
         return;
 
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_BLEND_CHANGE);
 
     if(enable)
         glEnable(GL_BLEND);
@@ -951,7 +2083,7 @@ static void forceChangeBlendMode(GPU_Renderer* renderer, GPU_BlendMode mode)
 {
     GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
 
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_BLEND_CHANGE);
 
     cdata->last_blend_mode = mode;
 
@@ -1035,7 +2167,7 @@ static void changeTexturing(GPU_Renderer* renderer, GPU_bool enable)
     GPU_Context* context = renderer->current_context_target->context;
     if(enable != ((GPU_CONTEXT_DATA*)context->data)->last_use_texturing)
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
 
         ((GPU_CONTEXT_DATA*)context->data)->last_use_texturing = enable;
         #ifndef SDL_GPU_SKIP_ENABLE_TEXTURE_2D
@@ -1051,7 +2183,7 @@ static void enableTexturing(GPU_Renderer* renderer)
 {
     if(!renderer->current_context_target->context->use_texturing)
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
         renderer->current_context_target->context->use_texturing = 1;
     }
 }
@@ -1060,38 +2192,11 @@ static void disableTexturing(GPU_Renderer* renderer)
 {
     if(renderer->current_context_target->context->use_texturing)
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
         renderer->current_context_target->context->use_texturing = 0;
     }
 }
 
-#define MIX_COLOR_COMPONENT_NORMALIZED_RESULT(a, b) ((a)/255.0f * (b)/255.0f)
-#define MIX_COLOR_COMPONENT(a, b) ((Uint8)(((a)/255.0f * (b)/255.0f)*255))
-
-static SDL_Color get_complete_mod_color(GPU_Renderer* renderer, GPU_Target* target, GPU_Image* image)
-{
-	(void)renderer;
-	SDL_Color color = { 255, 255, 255, 255 };
-	if(target->use_color)
-	{
-		if ( image != NULL )
-		{
-			color.r = MIX_COLOR_COMPONENT(target->color.r, image->color.r);
-			color.g = MIX_COLOR_COMPONENT(target->color.g, image->color.g);
-			color.b = MIX_COLOR_COMPONENT(target->color.b, image->color.b);
-			GET_ALPHA(color) = MIX_COLOR_COMPONENT(GET_ALPHA(target->color), GET_ALPHA(image->color));
-		} else {
-			color = target->color;
-		}
-		
-		return color;
-	}
-	else if ( image != NULL )
-		return image->color;
-	else
-		return color;
-}
-
 static void prepareToRenderImage(GPU_Renderer* renderer, GPU_Target* target, GPU_Image* image)
 {
     GPU_Context* context = renderer->current_context_target->context;
@@ -1099,7 +2204,7 @@ static void prepareToRenderImage(GPU_Renderer* renderer, GPU_Target* target, GPU
     enableTexturing(renderer);
     if(GL_TRIANGLES != ((GPU_CONTEXT_DATA*)context->data)->last_shape)
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
         ((GPU_CONTEXT_DATA*)context->data)->last_shape = GL_TRIANGLES;
     }
 
@@ -1120,7 +2225,7 @@ static void prepareToRenderShapes(GPU_Renderer* renderer, unsigned int shape)
     disableTexturing(renderer);
     if(shape != ((GPU_CONTEXT_DATA*)context->data)->last_shape)
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
         ((GPU_CONTEXT_DATA*)context->data)->last_shape = shape;
     }
 
@@ -1135,259 +2240,866 @@ static void prepareToRenderShapes(GPU_Renderer* renderer, unsigned int shape)
 }
 
 
-
-static void forceChangeViewport(GPU_Target* target, GPU_Rect viewport)
+static Uint64 getSortedDrawKey(SortedDraw* draw)
 {
-	float y;
-    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)(GPU_GetContextTarget()->context->data);
+    Uint64 texture = (draw->image != NULL? ((GPU_IMAGE_DATA*)draw->image->data)->handle : 0);
+    Uint32 blend = (draw->blend_mode.source_color ^ (draw->blend_mode.dest_color*3) ^ (draw->blend_mode.source_alpha*5)
+                    ^ (draw->blend_mode.dest_alpha*7) ^ (draw->blend_mode.color_equation*11) ^ (draw->blend_mode.alpha_equation*13));
+    Uint32 depth = (draw->depth_test? 0x10 : 0) | (draw->depth_write? 0x8 : 0) | (draw->depth_function & 0x7);
 
-    cdata->last_viewport = viewport;
-
-    y = viewport.y;
-    if(GPU_GetCoordinateMode() == 0)
-    {
-        // Need the real height to flip the y-coord (from OpenGL coord system)
-        if(target->image != NULL)
-            y = target->image->texture_h - viewport.h - viewport.y;
-        else if(target->context != NULL)
-            y = target->context->drawable_h - viewport.h - viewport.y;
-    }
-
-    glViewport((GLint)viewport.x, (GLint)y, (GLsizei)viewport.w, (GLsizei)viewport.h);
+    // Layer, shader, texture, shape, blend, depth.  Only the layer has to be exact; collisions in the rest just cost a flush.
+    return ((Uint64)(Uint16)(draw->layer + 32768) << 48)
+            | ((Uint64)(draw->shader_program & 0xFFF) << 36)
+            | ((texture & 0xFFFFF) << 16)
+            | ((Uint64)(draw->shape & 0x7) << 13)
+            | ((Uint64)(((blend << 1) | (draw->use_blending? 1 : 0)) & 0xFF) << 5)
+            | (Uint64)depth;
 }
 
-static void changeViewport(GPU_Target* target)
+static GPU_bool sameSortedDrawState(SortedDraw* a, SortedDraw* b)
 {
-    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)(GPU_GetContextTarget()->context->data);
+    return (a->key == b->key && a->layer == b->layer && a->image == b->image && a->shape == b->shape
+            && a->shader_program == b->shader_program
+            && a->shader_block.position_loc == b->shader_block.position_loc
+            && a->shader_block.texcoord_loc == b->shader_block.texcoord_loc
+            && a->shader_block.color_loc == b->shader_block.color_loc
+            && a->shader_block.modelViewProjection_loc == b->shader_block.modelViewProjection_loc
+            && a->use_blending == b->use_blending
+            && a->blend_mode.source_color == b->blend_mode.source_color
+            && a->blend_mode.dest_color == b->blend_mode.dest_color
+            && a->blend_mode.source_alpha == b->blend_mode.source_alpha
+            && a->blend_mode.dest_alpha == b->blend_mode.dest_alpha
+            && a->blend_mode.color_equation == b->blend_mode.color_equation
+            && a->blend_mode.alpha_equation == b->blend_mode.alpha_equation
+            && a->depth_test == b->depth_test && a->depth_write == b->depth_write && a->depth_function == b->depth_function);
+}
 
-    if(cdata->last_viewport.x == target->viewport.x && cdata->last_viewport.y == target->viewport.y && cdata->last_viewport.w == target->viewport.w && cdata->last_viewport.h == target->viewport.h)
+// The open (last) run extends to whatever is in the blit buffer now
+static void closeSortedDraw(GPU_CONTEXT_DATA* cdata)
+{
+    SortedBatchData* batch = cdata->sorted_batch;
+    SortedDraw* draw;
+    if(batch->num_draws == 0)
         return;
 
-    forceChangeViewport(target, target->viewport);
+    draw = &batch->draws[batch->num_draws-1];
+    draw->num_vertices = cdata->blit_buffer_num_vertices - draw->first_vertex;
+    draw->num_indices = cdata->index_buffer_num_vertices - draw->first_index;
 }
 
-static void applyTargetCamera(GPU_Target* target)
+// Grows a recording array to hold at least 'count' elements.  Leaves it alone if that fails.
+static GPU_bool growCommandListStorage(void** storage, unsigned int* max_count, unsigned int count, size_t element_size)
 {
-    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)GPU_GetContextTarget()->context->data;
+    unsigned int new_max_count;
+    void* new_storage;
 
-    cdata->last_camera = target->camera;
-    cdata->last_camera_inverted = (target->image != NULL);
-}
+    if(count <= *max_count)
+        return GPU_TRUE;
 
-static GPU_bool equal_cameras(GPU_Camera a, GPU_Camera b)
-{
-    return (a.x == b.x && a.y == b.y && a.z == b.z && a.angle == b.angle && a.zoom_x == b.zoom_x && a.zoom_y == b.zoom_y && a.use_centered_origin == b.use_centered_origin);
+    new_max_count = (*max_count == 0? 64 : *max_count);
+    while(new_max_count < count)
+        new_max_count *= 2;
+
+    new_storage = SDL_realloc(*storage, new_max_count * element_size);
+    if(new_storage == NULL)
+        return GPU_FALSE;
+
+    *storage = new_storage;
+    *max_count = new_max_count;
+    return GPU_TRUE;
 }
 
-static void changeCamera(GPU_Target* target)
+// Called by a draw to the sorted batch target, after the blit buffer has room and before the vertices are written.
+// Starts a new run unless the state matches the open one.
+static void recordSortedDraw(GPU_Renderer* renderer, GPU_Target* target, GPU_Image* image, unsigned int shape)
 {
-    //GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)GPU_GetContextTarget()->context->data;
+    GPU_Context* context = renderer->current_context_target->context;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
+    SortedBatchData* batch;
+    SortedDraw draw;
 
-    //if(cdata->last_camera_target != target || !equal_cameras(cdata->last_camera, target->camera))
+    if(!isRecordingSortedBatch(context, target))
+        return;
+
+    batch = cdata->sorted_batch;
+
+    draw.layer = batch->layer;
+    draw.image = image;
+    draw.shader_program = context->current_shader_program;
+    draw.shader_block = context->current_shader_block;
+    if(image != NULL)
     {
-        applyTargetCamera(target);
+        draw.shape = GL_TRIANGLES;
+        draw.use_blending = image->use_blending;
+        draw.blend_mode = image->blend_mode;
+
+        // Same default shader switch as prepareToRenderImage()
+        if(draw.shader_program == context->default_untextured_shader_program)
+        {
+            draw.shader_program = context->default_textured_shader_program;
+            draw.shader_block = context->default_textured_shader_block;
+        }
     }
-}
+    else
+    {
+        draw.shape = shape;
+        draw.use_blending = context->shapes_use_blending;
+        draw.blend_mode = context->shapes_blend_mode;
 
-static void get_camera_matrix(GPU_Target* target, float* result)
-{
-	float offsetX, offsetY;
+        // Same default shader switch as prepareToRenderShapes()
+        if(draw.shader_program == context->default_textured_shader_program)
+        {
+            draw.shader_program = context->default_untextured_shader_program;
+            draw.shader_block = context->default_untextured_shader_block;
+        }
+    }
+    draw.depth_test = target->use_depth_test;
+    draw.depth_write = target->use_depth_write;
+    draw.depth_function = target->depth_function;
+    draw.key = getSortedDrawKey(&draw);
 
-    GPU_MatrixIdentity(result);
+    closeSortedDraw(cdata);
+    if(batch->num_draws > 0 && sameSortedDrawState(&batch->draws[batch->num_draws-1], &draw))
+        return;
 
-    GPU_MatrixTranslate(result, -target->camera.x, -target->camera.y, -target->camera.z);
-    
-    if(target->camera.use_centered_origin)
+    if(batch->num_draws == batch->max_num_draws)
     {
-        offsetX = target->w/2.0f;
-        offsetY = target->h/2.0f;
-        GPU_MatrixTranslate(result, offsetX, offsetY, 0);
+        // The key arrays are only filled when sorting, but need the same capacity as the draws
+        unsigned int max_num_draws = batch->max_num_draws;
+        unsigned int max_num_keys = batch->max_num_draws;
+        unsigned int max_num_keys_scratch = batch->max_num_draws;
+
+        if(!growCommandListStorage((void**)&batch->keys, &max_num_keys, batch->num_draws + 1, sizeof(SortedDrawKey))
+           || !growCommandListStorage((void**)&batch->keys_scratch, &max_num_keys_scratch, batch->num_draws + 1, sizeof(SortedDrawKey))
+           || !growCommandListStorage((void**)&batch->draws, &max_num_draws, batch->num_draws + 1, sizeof(SortedDraw)))
+        {
+            GPU_PushErrorCode("GPU_BeginSortedBatch", GPU_ERROR_BACKEND_ERROR, "Failed to allocate sorted batch storage");
+            return;
+        }
+        batch->max_num_draws = max_num_draws;
     }
-    
-    GPU_MatrixRotate(result, target->camera.angle, 0, 0, 1);
-    GPU_MatrixScale(result, target->camera.zoom_x, target->camera.zoom_y, 1.0f);
-    
-    if(target->camera.use_centered_origin)
-        GPU_MatrixTranslate(result, -offsetX, -offsetY, 0);
+
+    draw.first_vertex = cdata->blit_buffer_num_vertices;
+    draw.num_vertices = 0;
+    draw.first_index = cdata->index_buffer_num_vertices;
+    draw.num_indices = 0;
+    batch->draws[batch->num_draws++] = draw;
 }
 
+// Stable LSD radix sort, one byte of the key per pass.  Returns whichever array holds the result.
+static SortedDrawKey* radixSortDrawKeys(SortedDrawKey* keys, SortedDrawKey* scratch, unsigned int n)
+{
+    unsigned int counts[256];
+    unsigned int i;
+    int shift;
 
+    for(shift = 0; shift < 64; shift += 8)
+    {
+        unsigned int sum = 0;
+        SortedDrawKey* temp;
 
-#ifdef SDL_GPU_APPLY_TRANSFORMS_TO_GL_STACK
-static void applyTransforms(GPU_Target* target)
+        memset(counts, 0, sizeof(counts));
+        for(i = 0; i < n; i++)
+            counts[(keys[i].key >> shift) & 0xFF]++;
+
+        // Skip the pass if every key has the same byte here (e.g. all in one layer)
+        if(counts[(keys[0].key >> shift) & 0xFF] == n)
+            continue;
+
+        for(i = 0; i < 256; i++)
+        {
+            unsigned int count = counts[i];
+            counts[i] = sum;
+            sum += count;
+        }
+        for(i = 0; i < n; i++)
+            scratch[counts[(keys[i].key >> shift) & 0xFF]++] = keys[i];
+
+        temp = keys;
+        keys = scratch;
+        scratch = temp;
+    }
+
+    return keys;
+}
+
+static void applySortedDrawState(GPU_Renderer* renderer, SortedDraw* draw)
 {
-    float* p = GPU_GetTopMatrix(&target->projection_matrix);
-    float* m = GPU_GetTopMatrix(&target->model_matrix);
-    float mv[16];
-    GPU_MatrixIdentity(mv);
-    
-    if(target->use_camera)
+    GPU_Context* context = renderer->current_context_target->context;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
+
+    if(context->current_shader_program != draw->shader_program)
+        renderer->impl->ActivateShaderProgram(renderer, draw->shader_program, &draw->shader_block);
+
+    // The depth setters don't flush on their own
+    if(cdata->last_depth_test != draw->depth_test || cdata->last_depth_write != draw->depth_write || cdata->last_depth_function != draw->depth_function)
     {
-        float cam_matrix[16];
-        get_camera_matrix(target, cam_matrix);
-        
-        GPU_MultiplyAndAssign(mv, cam_matrix);
+        flushBlitBufferFor(renderer, GPU_FLUSH_STATE_CHANGE);
+        changeDepthTest(renderer, draw->depth_test);
+        changeDepthWrite(renderer, draw->depth_write);
+        changeDepthFunction(renderer, draw->depth_function);
     }
+
+    if(draw->image != NULL)
+        enableTexturing(renderer);
     else
+        disableTexturing(renderer);
+
+    if(draw->shape != cdata->last_shape)
     {
-        GPU_MultiplyAndAssign(mv, GPU_GetTopMatrix(&target->view_matrix));
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
+        cdata->last_shape = draw->shape;
     }
-    
-    GPU_MultiplyAndAssign(mv, m);
-    
-    glMatrixMode(GL_PROJECTION);
-    glLoadMatrixf(p);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadMatrixf(mv);
-}
-#endif
 
+    changeBlending(renderer, draw->use_blending);
+    changeBlendMode(renderer, draw->blend_mode);
 
-static GPU_Target* Init(GPU_Renderer* renderer, GPU_RendererID renderer_request, Uint16 w, Uint16 h, GPU_WindowFlagEnum SDL_flags)
+    if(draw->image != NULL)
+        bindTextureSlot(renderer, draw->image);
+}
+
+static RecordedCommand* addCommand(CommandListData* list, CommandType type)
 {
-	GPU_InitFlagEnum GPU_flags;
-	SDL_Window* window;
+    RecordedCommand* command;
+    if(!growCommandListStorage((void**)&list->commands, &list->max_num_commands, list->num_commands + 1, sizeof(RecordedCommand)))
+    {
+        GPU_PushErrorCode("GPU_BeginCommandList", GPU_ERROR_BACKEND_ERROR, "Failed to allocate command list storage");
+        return NULL;
+    }
 
-#ifdef SDL_GPU_USE_OPENGL
-	const char* vendor_string;
-#endif
+    command = &list->commands[list->num_commands++];
+    memset(command, 0, sizeof(RecordedCommand));
+    command->type = type;
+    return command;
+}
 
-    if(renderer_request.major_version < 1)
+// Copies bytes into the list's data, 8-byte aligned.  Returns the offset.
+static GPU_bool addCommandData(CommandListData* list, const void* bytes, unsigned int size, unsigned int* offset)
+{
+    unsigned int start = (list->data_size + 7) & ~7u;
+    if(!growCommandListStorage((void**)&list->data, &list->max_data_size, start + size, 1))
     {
-        renderer_request.major_version = 1;
-        renderer_request.minor_version = 1;
+        GPU_PushErrorCode("GPU_BeginCommandList", GPU_ERROR_BACKEND_ERROR, "Failed to allocate command list storage");
+        return GPU_FALSE;
     }
 
-    // Tell SDL what we require for the GL context.
-    GPU_flags = GPU_GetPreInitFlags();
+    if(bytes != NULL)
+        memcpy(list->data + start, bytes, size);
+    list->data_size = start + size;
+    *offset = start;
+    return GPU_TRUE;
+}
 
-    renderer->GPU_init_flags = GPU_flags;
-    if(GPU_flags & GPU_INIT_DISABLE_DOUBLE_BUFFER)
-        SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 0);
-    else
-        SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-#ifdef SDL_GPU_USE_SDL2
+static void recordCommandModel(CommandListData* list, const float* model)
+{
+    RecordedCommand* command;
+    unsigned int offset;
 
-    // GL profile
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, 0);  // Disable in case this is a fallback renderer
-    #ifdef SDL_GPU_USE_GLES
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
-    #endif
-    // GL 3.2 and 3.3 have two profile modes
-    // ARB_compatibility brings support for this to GL 3.1, but glGetStringi() via GLEW has chicken and egg problems.
-    #if SDL_GPU_GL_MAJOR_VERSION == 3
-    if(renderer_request.minor_version >= 2)
+    if(list->last_model >= 0 && memcmp(list->data + list->commands[list->last_model].data_offset, model, 16*sizeof(float)) == 0)
+        return;
+
+    if(!addCommandData(list, model, 16*sizeof(float), &offset))
+        return;
+    command = addCommand(list, COMMAND_MODEL);
+    if(command == NULL)
+        return;
+    command->data_offset = offset;
+    list->last_model = (int)(list->num_commands - 1);
+}
+
+// Takes the recorded runs out of the blit buffer and appends them to the command list being recorded, in submission order
+static void captureCommandListDraws(GPU_Renderer* renderer)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    SortedBatchData* batch = cdata->sorted_batch;
+    CommandListData* list = batch->command_list;
+    unsigned int i, j;
+
+    closeSortedDraw(cdata);
+
+    // Vertices are in the target's model space, so each flush keeps the model matrix it would have drawn with
+    recordCommandModel(list, gpu_peek_top_matrix(&batch->target->model_matrix));
+
+    for(i = 0; i < batch->num_draws; i++)
     {
-        if(GPU_flags & GPU_INIT_REQUEST_COMPATIBILITY_PROFILE)
-            SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_COMPATIBILITY);
-        else
+        SortedDraw* draw = &batch->draws[i];
+        RecordedCommand* command;
+        if(draw->num_vertices == 0)
+            continue;
+
+        if(!growCommandListStorage((void**)&list->vertices, &list->max_num_vertices, list->num_vertices + draw->num_vertices, GPU_BLIT_BUFFER_STRIDE)
+           || !growCommandListStorage((void**)&list->indices, &list->max_num_indices, list->num_indices + draw->num_indices, sizeof(GPU_BLIT_INDEX_TYPE)))
         {
-            SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-            // Force newer default shader version for core contexts because they don't support lower versions
-            renderer->min_shader_version = SDL_GPU_GLSL_VERSION_CORE;
-            if(renderer->min_shader_version > renderer->max_shader_version)
-                renderer->max_shader_version = SDL_GPU_GLSL_VERSION_CORE;
+            GPU_PushErrorCode("GPU_BeginCommandList", GPU_ERROR_BACKEND_ERROR, "Failed to allocate command list storage");
+            break;
         }
+        command = addCommand(list, COMMAND_DRAW);
+        if(command == NULL)
+            break;
 
+        command->draw = *draw;
+        command->draw.first_vertex = list->num_vertices;
+        command->draw.first_index = list->num_indices;
+        memcpy(list->vertices + list->num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX,
+               cdata->blit_buffer + draw->first_vertex*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX, draw->num_vertices * GPU_BLIT_BUFFER_STRIDE);
+        for(j = 0; j < draw->num_indices; j++)
+            list->indices[list->num_indices + j] = (GPU_BLIT_INDEX_TYPE)(cdata->index_buffer[draw->first_index + j] - draw->first_vertex);
+        list->num_vertices += draw->num_vertices;
+        list->num_indices += draw->num_indices;
+
+        // Keep the image alive for as long as the list
+        if(draw->image != NULL)
+            draw->image->refcount++;
     }
-    #endif
 
-    // GL version
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, renderer_request.major_version);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, renderer_request.minor_version);
-#else
-    // vsync for SDL 1.2
-    if(!(GPU_flags & GPU_INIT_DISABLE_VSYNC))
-        SDL_GL_SetAttribute(SDL_GL_SWAP_CONTROL, 1);
-#endif
+    cdata->blit_buffer_num_vertices = 0;
+    cdata->index_buffer_num_vertices = 0;
+    batch->num_draws = 0;
+}
 
-    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 16);
+// Bytes per vertex of a primitive batch's values
+static unsigned int getBatchVertexSize(GPU_BatchFlagEnum flags)
+{
+    unsigned int num_floats = 0;
+    unsigned int num_bytes = 0;
 
-    SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
-    SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 8);
+    if(flags & GPU_BATCH_XYZ)
+        num_floats += 3;
+    else if(flags & GPU_BATCH_XY)
+        num_floats += 2;
+    if(flags & GPU_BATCH_ST)
+        num_floats += 2;
+    if(flags & GPU_BATCH_RGBA)
+        num_floats += 4;
+    else if(flags & GPU_BATCH_RGB)
+        num_floats += 3;
+    if(flags & GPU_BATCH_RGBA8)
+        num_bytes = 4;
+    else if(flags & GPU_BATCH_RGB8)
+        num_bytes = 3;
 
-	renderer->requested_id = renderer_request;
+    return num_floats*sizeof(float) + num_bytes;
+}
 
-#ifdef SDL_GPU_USE_SDL2
+static void freeCommandListData(CommandListData* list)
+{
+    SDL_free(list->commands);
+    SDL_free(list->vertices);
+    SDL_free(list->indices);
+    SDL_free(list->data);
+    SDL_free(list);
+}
 
-	window = NULL;
-    // Is there a window already set up that we are supposed to use?
-    if(renderer->current_context_target != NULL)
-        window = SDL_GetWindowFromID(renderer->current_context_target->context->windowID);
-    else
-        window = SDL_GetWindowFromID(GPU_GetInitWindow());
+// Sorts the recorded runs and refills the blit buffer in key order, flushing only where the state changes.
+// The last flush is charged to 'cause', the barrier that ended the batch.
+static void emitSortedBatch(GPU_Renderer* renderer, GPU_FlushCauseEnum cause)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
+    SortedBatchData* batch = cdata->sorted_batch;
+    SortedDrawKey* order;
+    unsigned int num_vertices;
+    unsigned int num_indices;
+    unsigned int i, j;
+    Uint32 saved_program = context->current_shader_program;
+    GPU_ShaderBlock saved_block = context->current_shader_block;
+    GPU_bool saved_depth_test = cdata->last_depth_test;
+    GPU_bool saved_depth_write = cdata->last_depth_write;
+    GPU_ComparisonEnum saved_depth_function = cdata->last_depth_function;
+
+    // Command lists keep their draws instead
+    if(batch->command_list != NULL)
+    {
+        captureCommandListDraws(renderer);
+        return;
+    }
 
-    if(window == NULL)
+    closeSortedDraw(cdata);
+
+    num_vertices = cdata->blit_buffer_num_vertices;
+    num_indices = cdata->index_buffer_num_vertices;
+    if(batch->max_num_vertices < num_vertices)
     {
-        int win_w, win_h;
-        #ifdef __ANDROID__
-        win_w = win_h = 0;  // Force Android to create full screen window
-        #else
-        win_w = w;
-        win_h = h;
-        #endif
+        SDL_free(batch->vertices);
+        batch->vertices = (float*)SDL_malloc(num_vertices * GPU_BLIT_BUFFER_STRIDE);
+        batch->max_num_vertices = num_vertices;
+    }
+    if(batch->max_num_indices < num_indices)
+    {
+        SDL_free(batch->indices);
+        batch->indices = (GPU_BLIT_INDEX_TYPE*)SDL_malloc(num_indices * sizeof(GPU_BLIT_INDEX_TYPE));
+        batch->max_num_indices = num_indices;
+    }
+    memcpy(batch->vertices, cdata->blit_buffer, num_vertices * GPU_BLIT_BUFFER_STRIDE);
+    memcpy(batch->indices, cdata->index_buffer, num_indices * sizeof(GPU_BLIT_INDEX_TYPE));
+    cdata->blit_buffer_num_vertices = 0;
+    cdata->index_buffer_num_vertices = 0;
 
-        // Set up window flags
-        SDL_flags |= SDL_WINDOW_OPENGL;
-        if(!(SDL_flags & SDL_WINDOW_HIDDEN))
-            SDL_flags |= SDL_WINDOW_SHOWN;
+    for(i = 0; i < batch->num_draws; i++)
+    {
+        batch->keys[i].key = batch->draws[i].key;
+        batch->keys[i].draw = i;
+    }
+    order = radixSortDrawKeys(batch->keys, batch->keys_scratch, batch->num_draws);
 
-        renderer->SDL_init_flags = SDL_flags;
-        window = SDL_CreateWindow("",
-                                  SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-                                  win_w, win_h,
-                                  SDL_flags);
+    batch->replaying = GPU_TRUE;
 
-        if(window == NULL)
+    for(i = 0; i < batch->num_draws; i++)
+    {
+        SortedDraw* draw = &batch->draws[order[i].draw];
+        GPU_BLIT_INDEX_TYPE base;
+        if(draw->num_vertices == 0)
+            continue;
+
+        applySortedDrawState(renderer, draw);
+
+        // Everything fit in the blit buffer before, so it still does
+        base = (GPU_BLIT_INDEX_TYPE)cdata->blit_buffer_num_vertices;
+        memcpy(cdata->blit_buffer + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX,
+               batch->vertices + draw->first_vertex*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX, draw->num_vertices * GPU_BLIT_BUFFER_STRIDE);
+        for(j = 0; j < draw->num_indices; j++)
+            cdata->index_buffer[cdata->index_buffer_num_vertices++] = base + (GPU_BLIT_INDEX_TYPE)(batch->indices[draw->first_index + j] - draw->first_vertex);
+        #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+        // The texture units are only known now
+        if(draw->image != NULL)
         {
-            GPU_PushErrorCode("GPU_Init", GPU_ERROR_BACKEND_ERROR, "Window creation failed.");
-            return NULL;
+            float* slot = cdata->blit_buffer + base*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX + GPU_BLIT_BUFFER_TEX_SLOT_OFFSET;
+            for(j = 0; j < draw->num_vertices; j++)
+                slot[j*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX] = cdata->current_texture_slot;
         }
-
-        GPU_SetInitWindow(get_window_id(window));
+        #endif
+        cdata->blit_buffer_num_vertices += draw->num_vertices;
     }
-    else
-        renderer->SDL_init_flags = SDL_flags;
 
-#else
-    SDL_flags |= SDL_OPENGL;
-    renderer->SDL_init_flags = SDL_flags;
-    window = SDL_SetVideoMode(w, h, 0, SDL_flags);
+    flushBlitBufferFor(renderer, cause);
 
-    if(window == NULL)
-    {
-        GPU_PushErrorCode("GPU_Init", GPU_ERROR_BACKEND_ERROR, "Screen surface creation failed.");
-        return NULL;
-    }
-#endif
+    // Put back the state that draws outside of the batch expect
+    if(context->current_shader_program != saved_program)
+        renderer->impl->ActivateShaderProgram(renderer, saved_program, &saved_block);
+    changeDepthTest(renderer, saved_depth_test);
+    changeDepthWrite(renderer, saved_depth_write);
+    changeDepthFunction(renderer, saved_depth_function);
 
-    renderer->enabled_features = 0xFFFFFFFF;  // Pretend to support them all if using incompatible headers
+    batch->num_draws = 0;
+    batch->replaying = GPU_FALSE;
+}
 
+static void freeSortedBatch(GPU_CONTEXT_DATA* cdata)
+{
+    SortedBatchData* batch = cdata->sorted_batch;
+    if(batch == NULL)
+        return;
 
-    // Create or re-init the current target.  This also creates the GL context and initializes enabled_features.
-    if(renderer->impl->CreateTargetFromWindow(renderer, get_window_id(window), renderer->current_context_target) == NULL)
-        return NULL;
+    if(batch->command_list != NULL)
+        freeCommandListData(batch->command_list);
+    SDL_free(batch->draws);
+    SDL_free(batch->keys);
+    SDL_free(batch->keys_scratch);
+    SDL_free(batch->vertices);
+    SDL_free(batch->indices);
+    SDL_free(batch);
+    cdata->sorted_batch = NULL;
+}
 
-    // If the dimensions of the window don't match what we asked for, then set up a virtual resolution to pretend like they are.
-	if (!(GPU_flags & GPU_INIT_DISABLE_AUTO_VIRTUAL_RESOLUTION) && w != 0 && h != 0 && (w != renderer->current_context_target->w || h != renderer->current_context_target->h))
-	{
-		renderer->impl->SetVirtualResolution(renderer, renderer->current_context_target, w, h);
-	}
+static void BeginSortedBatch(GPU_Renderer* renderer, GPU_Target* target)
+{
+    GPU_CONTEXT_DATA* cdata;
 
-    // Init glVertexAttrib workaround
-    #ifdef SDL_GPU_USE_OPENGL
-    vendor_string = (const char*)glGetString(GL_VENDOR);
-    if(strstr(vendor_string, "Intel") != NULL)
+    if(target == NULL)
     {
-        vendor_is_Intel = 1;
-        apply_Intel_attrib_workaround = 1;
+        GPU_PushErrorCode("GPU_BeginSortedBatch", GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+    if(renderer != target->renderer)
+    {
+        GPU_PushErrorCode("GPU_BeginSortedBatch", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
     }
-    #endif
 
-    return renderer->current_context_target;
-}
+    makeContextCurrent(renderer, target);
+    if(renderer->current_context_target == NULL)
+    {
+        GPU_PushErrorCode("GPU_BeginSortedBatch", GPU_ERROR_USER_ERROR, "NULL context");
+        return;
+    }
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->sorted_batch != NULL && cdata->sorted_batch->command_list != NULL)
+    {
+        GPU_PushErrorCode("GPU_BeginSortedBatch", GPU_ERROR_USER_ERROR, "Can't start a sorted batch while recording a command list");
+        return;
+    }
+
+    // Whatever is already buffered (or an open batch) keeps its place in front
+    renderer->impl->FlushBlitBuffer(renderer);
+
+    if(cdata->sorted_batch == NULL)
+    {
+        cdata->sorted_batch = (SortedBatchData*)SDL_malloc(sizeof(SortedBatchData));
+        memset(cdata->sorted_batch, 0, sizeof(SortedBatchData));
+    }
+
+    cdata->sorted_batch->target = target;
+    cdata->sorted_batch->layer = 0;
+}
+
+static void EndSortedBatch(GPU_Renderer* renderer)
+{
+    GPU_CONTEXT_DATA* cdata;
+    if(renderer->current_context_target == NULL)
+        return;
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->sorted_batch == NULL || cdata->sorted_batch->target == NULL || cdata->sorted_batch->command_list != NULL)
+        return;
+
+    renderer->impl->FlushBlitBuffer(renderer);
+    cdata->sorted_batch->target = NULL;
+}
+
+static void SetSortedBatchLayer(GPU_Renderer* renderer, int layer)
+{
+    GPU_CONTEXT_DATA* cdata;
+    if(renderer->current_context_target == NULL)
+        return;
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->sorted_batch == NULL || cdata->sorted_batch->target == NULL)
+        return;
+
+    if(layer < -32768)
+        layer = -32768;
+    else if(layer > 32767)
+        layer = 32767;
+    cdata->sorted_batch->layer = layer;
+}
+
+
+
+static void forceChangeViewport(GPU_Target* target, GPU_Rect viewport)
+{
+	float y;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)(GPU_GetContextTarget()->context->data);
+
+    cdata->last_viewport = viewport;
+
+    y = viewport.y;
+    if(GPU_GetCoordinateMode() == 0)
+    {
+        // Need the real height to flip the y-coord (from OpenGL coord system)
+        if(target->image != NULL)
+            y = target->image->texture_h - viewport.h - viewport.y;
+        else if(target->context != NULL)
+            y = target->context->drawable_h - viewport.h - viewport.y;
+    }
+
+    glViewport((GLint)viewport.x, (GLint)y, (GLsizei)viewport.w, (GLsizei)viewport.h);
+}
+
+static void changeViewport(GPU_Target* target)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)(GPU_GetContextTarget()->context->data);
+
+    if(cdata->last_viewport.x == target->viewport.x && cdata->last_viewport.y == target->viewport.y && cdata->last_viewport.w == target->viewport.w && cdata->last_viewport.h == target->viewport.h)
+        return;
+
+    forceChangeViewport(target, target->viewport);
+}
+
+static void applyTargetCamera(GPU_Target* target)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)GPU_GetContextTarget()->context->data;
+
+    cdata->last_camera = target->camera;
+    cdata->last_camera_inverted = (target->image != NULL);
+}
+
+static void changeCamera(GPU_Target* target)
+{
+    //GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)GPU_GetContextTarget()->context->data;
+
+    //if(cdata->last_camera_target != target || !equal_cameras(cdata->last_camera, target->camera))
+    {
+        applyTargetCamera(target);
+    }
+}
+
+
+
+#ifdef SDL_GPU_USE_BUFFER_PIPELINE
+
+// Number of Uint32s in an MVP key (see ContextData::mvp_cache_key)
+#define GPU_MVP_KEY_SIZE 5
+
+// Identifies everything a target's MVP is built from.  Matrix and camera generations are unique across targets, so equal keys mean equal matrices.
+static void getModelViewProjectionKey(GPU_Target* target, Uint32* key)
+{
+    key[0] = target->projection_matrix.generation;
+    key[1] = (target->use_camera? target->camera.generation : target->view_matrix.generation);
+    key[2] = target->model_matrix.generation;
+    key[3] = (target->use_camera? 1 : 0);
+    // A centered camera origin depends on the target size
+    key[4] = ((Uint32)target->w << 16) | target->h;
+}
+
+// Returns the MVP for the given key, only rebuilding it when the key changed since the last call.
+static float* getCachedModelViewProjection(GPU_CONTEXT_DATA* cdata, GPU_Target* target, const Uint32* key)
+{
+    if(memcmp(key, cdata->mvp_cache_key, sizeof(cdata->mvp_cache_key)) != 0)
+    {
+        gpu_get_modelviewprojection(target, cdata->mvp_cache);
+        memcpy(cdata->mvp_cache_key, key, sizeof(cdata->mvp_cache_key));
+    }
+    return cdata->mvp_cache;
+}
+
+// Sets the MVP uniform of the bound program, unless it already holds this target's MVP.
+static void uploadModelViewProjection(GPU_CONTEXT_DATA* cdata, GPU_Target* target, Uint32 program_object, int location)
+{
+    int num_entries = (int)(sizeof(cdata->mvp_upload_program)/sizeof(cdata->mvp_upload_program[0]));
+    Uint32 key[GPU_MVP_KEY_SIZE];
+    int i;
+
+    if(location < 0)
+        return;
+
+    getModelViewProjectionKey(target, key);
+
+    for(i = 0; i < num_entries; i++)
+    {
+        if(cdata->mvp_upload_program[i] == program_object && cdata->mvp_upload_loc[i] == location)
+            break;
+    }
+
+    if(i < num_entries && memcmp(key, cdata->mvp_upload_key[i], sizeof(cdata->mvp_upload_key[i])) == 0)
+        return;
+
+    glUniformMatrix4fv(location, 1, 0, getCachedModelViewProjection(cdata, target, key));
+
+    if(i == num_entries)
+    {
+        // Replace the oldest entry
+        i = cdata->mvp_upload_next;
+        cdata->mvp_upload_next = (i + 1) % num_entries;
+        cdata->mvp_upload_program[i] = program_object;
+        cdata->mvp_upload_loc[i] = location;
+    }
+    memcpy(cdata->mvp_upload_key[i], key, sizeof(cdata->mvp_upload_key[i]));
+}
+
+// The program's uniforms were reset or it was deleted (and the name may be reused)
+static void forgetModelViewProjectionUploads(GPU_Renderer* renderer, Uint32 program_object)
+{
+    GPU_CONTEXT_DATA* cdata;
+    int num_entries;
+    int i;
+
+    if(renderer->current_context_target == NULL)
+        return;
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    num_entries = (int)(sizeof(cdata->mvp_upload_program)/sizeof(cdata->mvp_upload_program[0]));
+    for(i = 0; i < num_entries; i++)
+    {
+        if(cdata->mvp_upload_program[i] == program_object)
+            cdata->mvp_upload_program[i] = 0;
+    }
+}
+
+#endif
+
+// For isCulled().  The buffer pipeline reuses the MVP that is cached for uploading.
+static float* getTargetModelViewProjection(GPU_Renderer* renderer, GPU_Target* target, float* storage)
+{
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    Uint32 key[GPU_MVP_KEY_SIZE];
+    (void)storage;
+    getModelViewProjectionKey(target, key);
+    return getCachedModelViewProjection((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, target, key);
+    #else
+    (void)renderer;
+    gpu_get_modelviewprojection(target, storage);
+    return storage;
+    #endif
+}
+
+
+
+#ifdef SDL_GPU_APPLY_TRANSFORMS_TO_GL_STACK
+static void applyTransforms(GPU_Target* target)
+{
+    float* p = gpu_peek_top_matrix(&target->projection_matrix);
+    float* m = gpu_peek_top_matrix(&target->model_matrix);
+    float mv[16];
+    GPU_MatrixIdentity(mv);
+    
+    if(target->use_camera)
+    {
+        float cam_matrix[16];
+        gpu_get_camera_matrix(target, cam_matrix);
+        
+        GPU_MultiplyAndAssign(mv, cam_matrix);
+    }
+    else
+    {
+        GPU_MultiplyAndAssign(mv, gpu_peek_top_matrix(&target->view_matrix));
+    }
+    
+    GPU_MultiplyAndAssign(mv, m);
+    
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(p);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixf(mv);
+}
+#endif
+
+
+static GPU_Target* Init(GPU_Renderer* renderer, GPU_RendererID renderer_request, Uint16 w, Uint16 h, GPU_WindowFlagEnum SDL_flags)
+{
+	GPU_InitFlagEnum GPU_flags;
+	SDL_Window* window;
+
+#ifdef SDL_GPU_USE_OPENGL
+	const char* vendor_string;
+#endif
+
+    if(renderer_request.major_version < 1)
+    {
+        renderer_request.major_version = 1;
+        renderer_request.minor_version = 1;
+    }
+
+    // Tell SDL what we require for the GL context.
+    GPU_flags = GPU_GetPreInitFlags();
+
+    renderer->GPU_init_flags = GPU_flags;
+    if(GPU_flags & GPU_INIT_DISABLE_DOUBLE_BUFFER)
+        SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 0);
+    else
+        SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+#ifdef SDL_GPU_USE_SDL2
+
+    // GL profile
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, 0);  // Disable in case this is a fallback renderer
+    #ifdef SDL_GPU_USE_GLES
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
+    #endif
+    // GL 3.2 and 3.3 have two profile modes
+    // ARB_compatibility brings support for this to GL 3.1, but glGetStringi() via GLEW has chicken and egg problems.
+    #if SDL_GPU_GL_MAJOR_VERSION == 3
+    if(renderer_request.minor_version >= 2)
+    {
+        if(GPU_flags & GPU_INIT_REQUEST_COMPATIBILITY_PROFILE)
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_COMPATIBILITY);
+        else
+        {
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+            // Force newer default shader version for core contexts because they don't support lower versions
+            renderer->min_shader_version = SDL_GPU_GLSL_VERSION_CORE;
+            if(renderer->min_shader_version > renderer->max_shader_version)
+                renderer->max_shader_version = SDL_GPU_GLSL_VERSION_CORE;
+        }
+
+    }
+    #endif
+
+    // GL version
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, renderer_request.major_version);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, renderer_request.minor_version);
+#else
+    // vsync for SDL 1.2
+    if(!(GPU_flags & GPU_INIT_DISABLE_VSYNC))
+        SDL_GL_SetAttribute(SDL_GL_SWAP_CONTROL, 1);
+#endif
+
+    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 16);
+
+    SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
+    SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 8);
+
+	renderer->requested_id = renderer_request;
+
+#ifdef SDL_GPU_USE_SDL2
+
+	window = NULL;
+    // Is there a window already set up that we are supposed to use?
+    if(renderer->current_context_target != NULL)
+        window = SDL_GetWindowFromID(renderer->current_context_target->context->windowID);
+    else
+        window = SDL_GetWindowFromID(GPU_GetInitWindow());
+
+    if(window == NULL)
+    {
+        int win_w, win_h;
+        #ifdef __ANDROID__
+        win_w = win_h = 0;  // Force Android to create full screen window
+        #else
+        win_w = w;
+        win_h = h;
+        #endif
+
+        // Set up window flags
+        SDL_flags |= SDL_WINDOW_OPENGL;
+        if(!(SDL_flags & SDL_WINDOW_HIDDEN))
+            SDL_flags |= SDL_WINDOW_SHOWN;
+
+        renderer->SDL_init_flags = SDL_flags;
+        window = SDL_CreateWindow("",
+                                  SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                                  win_w, win_h,
+                                  SDL_flags);
+
+        if(window == NULL)
+        {
+            GPU_PushErrorCode("GPU_Init", GPU_ERROR_BACKEND_ERROR, "Window creation failed.");
+            return NULL;
+        }
+
+        GPU_SetInitWindow(get_window_id(window));
+    }
+    else
+        renderer->SDL_init_flags = SDL_flags;
+
+#else
+    SDL_flags |= SDL_OPENGL;
+    renderer->SDL_init_flags = SDL_flags;
+    window = SDL_SetVideoMode(w, h, 0, SDL_flags);
+
+    if(window == NULL)
+    {
+        GPU_PushErrorCode("GPU_Init", GPU_ERROR_BACKEND_ERROR, "Screen surface creation failed.");
+        return NULL;
+    }
+#endif
+
+    renderer->enabled_features = 0xFFFFFFFF;  // Pretend to support them all if using incompatible headers
+
+
+    // Create or re-init the current target.  This also creates the GL context and initializes enabled_features.
+    if(renderer->impl->CreateTargetFromWindow(renderer, get_window_id(window), renderer->current_context_target) == NULL)
+        return NULL;
+
+    // If the dimensions of the window don't match what we asked for, then set up a virtual resolution to pretend like they are.
+	if (!(GPU_flags & GPU_INIT_DISABLE_AUTO_VIRTUAL_RESOLUTION) && w != 0 && h != 0 && (w != renderer->current_context_target->w || h != renderer->current_context_target->h))
+	{
+		renderer->impl->SetVirtualResolution(renderer, renderer->current_context_target, w, h);
+	}
+
+    // Init glVertexAttrib workaround
+    #ifdef SDL_GPU_USE_OPENGL
+    vendor_string = (const char*)glGetString(GL_VENDOR);
+    if(strstr(vendor_string, "Intel") != NULL)
+    {
+        vendor_is_Intel = 1;
+        apply_Intel_attrib_workaround = 1;
+    }
+    #endif
+
+    return renderer->current_context_target;
+}
 
 
 static GPU_bool IsFeatureEnabled(GPU_Renderer* renderer, GPU_FeatureEnum feature)
@@ -1502,6 +3214,10 @@ static void update_stored_dimensions(GPU_Target* target)
     }
 }
 
+#ifdef SDL_GPU_USE_BUFFER_PIPELINE
+static GPU_BufferUploadEnum calibrateBufferUpload(GPU_Renderer* renderer, GPU_Target* target);
+#endif
+
 static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowID, GPU_Target* target)
 {
     GPU_bool created = GPU_FALSE;  // Make a new one or repurpose an existing target?
@@ -1546,8 +3262,8 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
         cdata->blit_buffer = (float*)SDL_malloc(blit_buffer_storage_size);
         cdata->index_buffer_max_num_vertices = GPU_BLIT_BUFFER_INIT_MAX_NUM_VERTICES;
         cdata->index_buffer_num_vertices = 0;
-        index_buffer_storage_size = GPU_BLIT_BUFFER_INIT_MAX_NUM_VERTICES*sizeof(unsigned short);
-        cdata->index_buffer = (unsigned short*)SDL_malloc(index_buffer_storage_size);
+        index_buffer_storage_size = GPU_BLIT_BUFFER_INIT_MAX_NUM_VERTICES*sizeof(GPU_BLIT_INDEX_TYPE);
+        cdata->index_buffer = (GPU_BLIT_INDEX_TYPE*)SDL_malloc(index_buffer_storage_size);
     }
     else
     {
@@ -1638,6 +3354,7 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
     
     target->use_depth_test = GPU_FALSE;
     target->use_depth_write = GPU_TRUE;
+    target->use_culling = GPU_FALSE;
 
     target->context->line_thickness = 1.0f;
     target->context->use_texturing = GPU_TRUE;
@@ -1773,6 +3490,9 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
         const char* textured_fragment_shader_source = GPU_DEFAULT_TEXTURED_FRAGMENT_SHADER_SOURCE;
         const char* untextured_vertex_shader_source = GPU_DEFAULT_UNTEXTURED_VERTEX_SHADER_SOURCE;
         const char* untextured_fragment_shader_source = GPU_DEFAULT_UNTEXTURED_FRAGMENT_SHADER_SOURCE;
+        #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+        GLint max_texture_units = 0;
+        #endif
 
         #ifdef SDL_GPU_ENABLE_CORE_SHADERS
         // Use core shaders only when supported by the actual context we got
@@ -1785,6 +3505,30 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
         }
         #endif
 
+        #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+        // Let blits sample from several texture units.  The instanced sprite program shares the textured fragment shader and only feeds it unit 0.
+        cdata->num_texture_slots = 0;
+        cdata->texture_slot_loc = -1;
+        glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &max_texture_units);
+        if(max_texture_units >= GPU_MAX_TEXTURE_SLOTS
+        #ifdef SDL_GPU_USE_INSTANCED_SPRITES
+           && !(renderer->GPU_init_flags & GPU_INIT_USE_INSTANCED_SPRITES)
+        #endif
+           )
+        {
+            textured_vertex_shader_source = GPU_DEFAULT_TEXTURED_SLOTS_VERTEX_SHADER_SOURCE;
+            textured_fragment_shader_source = GPU_DEFAULT_TEXTURED_SLOTS_FRAGMENT_SHADER_SOURCE;
+            #ifdef SDL_GPU_ENABLE_CORE_SHADERS
+            if(renderer->id.major_version > 3 || (renderer->id.major_version == 3 && renderer->id.minor_version >= 2))
+            {
+                textured_vertex_shader_source = GPU_DEFAULT_TEXTURED_SLOTS_VERTEX_SHADER_SOURCE_CORE;
+                textured_fragment_shader_source = GPU_DEFAULT_TEXTURED_SLOTS_FRAGMENT_SHADER_SOURCE_CORE;
+            }
+            #endif
+            cdata->num_texture_slots = GPU_MAX_TEXTURE_SLOTS;
+        }
+        #endif
+
         // Textured shader
         v = renderer->impl->CompileShader(renderer, GPU_VERTEX_SHADER, textured_vertex_shader_source);
 
@@ -1823,6 +3567,23 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
         // Get locations of the attributes in the shader
         target->context->default_textured_shader_block = GPU_LoadShaderBlock(p, "gpu_Vertex", "gpu_TexCoord", "gpu_Color", "gpu_ModelViewProjectionMatrix");
 
+        #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+        if(cdata->num_texture_slots > 0)
+        {
+            GLint units[GPU_MAX_TEXTURE_SLOTS];
+            int i;
+            for(i = 0; i < GPU_MAX_TEXTURE_SLOTS; i++)
+                units[i] = i;
+
+            // Each sampler reads its own unit
+            glUseProgram(p);
+            glUniform1iv(glGetUniformLocation(p, "gpu_TexSlots"), GPU_MAX_TEXTURE_SLOTS, units);
+            cdata->texture_slot_loc = glGetAttribLocation(p, "gpu_TexSlot");
+            if(cdata->texture_slot_loc < 0)
+                cdata->num_texture_slots = 0;
+        }
+        #endif
+
 
         // Untextured shader
         v = renderer->impl->CompileShader(renderer, GPU_VERTEX_SHADER, untextured_vertex_shader_source);
@@ -1885,12 +3646,26 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
 
         glGenBuffers(1, &cdata->blit_IBO);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * cdata->blit_buffer_max_num_vertices, NULL, GL_DYNAMIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GPU_BLIT_INDEX_TYPE) * cdata->index_buffer_max_num_vertices, NULL, GL_DYNAMIC_DRAW);
+
+        glGenBuffers(1, &cdata->blit_quad_IBO);
+        fillQuadIndexBuffer(cdata);
+
+        cdata->buffer_upload_method = GPU_BUFFER_UPLOAD_RESET;
+        if(isBufferUploadMethodSupported(renderer, GPU_DEFAULT_BUFFER_UPLOAD))
+            applyBufferUploadMethod(cdata, GPU_DEFAULT_BUFFER_UPLOAD);
 
         glGenBuffers(16, cdata->attribute_VBO);
 
         // Init 16 attributes to 0 / NULL.
         memset(cdata->shader_attributes, 0, 16*sizeof(GPU_AttributeSource));
+
+        #ifdef SDL_GPU_USE_INSTANCED_SPRITES
+        initInstancedSprites(renderer, target);
+        #endif
+
+        if(renderer->GPU_init_flags & GPU_INIT_CALIBRATE_BUFFER_UPLOAD)
+            calibrateBufferUpload(renderer, target);
     #endif
     #endif
 
@@ -1898,42 +3673,6 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
 }
 
 
-static GPU_Target* CreateAliasTarget(GPU_Renderer* renderer, GPU_Target* target)
-{
-	GPU_Target* result;
-	(void)renderer;
-
-    if(target == NULL)
-        return NULL;
-
-    result = (GPU_Target*)SDL_malloc(sizeof(GPU_Target));
-
-    // Copy the members
-    *result = *target;
-
-	// Deep copies
-	result->projection_matrix.matrix = NULL;
-	result->view_matrix.matrix = NULL;
-	result->model_matrix.matrix = NULL;
-	result->projection_matrix.size = result->projection_matrix.storage_size = 0;
-	result->view_matrix.size = result->view_matrix.storage_size = 0;
-	result->model_matrix.size = result->model_matrix.storage_size = 0;
-	GPU_CopyMatrixStack(&target->projection_matrix, &result->projection_matrix);
-	GPU_CopyMatrixStack(&target->view_matrix, &result->view_matrix);
-	GPU_CopyMatrixStack(&target->model_matrix, &result->model_matrix);
-
-    // Alias info
-    if(target->image != NULL)
-        target->image->refcount++;
-    if(target->context != NULL)
-        target->context->refcount++;
-    ((GPU_TARGET_DATA*)target->data)->refcount++;
-    result->refcount = 1;
-    result->is_alias = GPU_TRUE;
-
-    return result;
-}
-
 static void MakeCurrent(GPU_Renderer* renderer, GPU_Target* target, Uint32 windowID)
 {
 	SDL_Window* window;
@@ -1957,7 +3696,7 @@ static void MakeCurrent(GPU_Renderer* renderer, GPU_Target* target, Uint32 windo
         // Reset window mapping, base size, and camera if the target's window was changed
         if(target->context->windowID != windowID)
         {
-            renderer->impl->FlushBlitBuffer(renderer);
+            flushBlitBufferFor(renderer, GPU_FLUSH_TARGET_SWITCH);
 
             // Update the window mappings
             GPU_RemoveWindowMapping(windowID);
@@ -1982,14 +3721,6 @@ static void MakeCurrent(GPU_Renderer* renderer, GPU_Target* target, Uint32 windo
 }
 
 
-static void SetAsCurrent(GPU_Renderer* renderer)
-{
-    if(renderer->current_context_target == NULL)
-        return;
-
-    renderer->impl->MakeCurrent(renderer, renderer->current_context_target, renderer->current_context_target->context->windowID);
-}
-
 static void ResetRendererState(GPU_Renderer* renderer)
 {
     GPU_Target* target;
@@ -2040,6 +3771,10 @@ static void ResetRendererState(GPU_Renderer* renderer)
 
     if(cdata->last_image != NULL)
         glBindTexture(GL_TEXTURE_2D, ((GPU_IMAGE_DATA*)(cdata->last_image)->data)->handle);
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    // The other texture units may have been changed outside of SDL_gpu
+    cdata->num_bound_slots = 0;
+    #endif
 
     if(target->context->active_target != NULL)
         extBindFramebuffer(renderer, ((GPU_TARGET_DATA*)target->context->active_target->data)->handle);
@@ -2065,7 +3800,7 @@ static GPU_bool AddDepthBuffer(GPU_Renderer* renderer, GPU_Target* target)
     }
 
     if(isCurrentTarget(renderer, target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_STATE_CHANGE);
 
     if(!SetActiveTarget(renderer, target))
     {
@@ -2102,7 +3837,7 @@ static GPU_bool SetWindowResolution(GPU_Renderer* renderer, Uint16 w, Uint16 h)
 
     GPU_bool isCurrent = isCurrentTarget(renderer, target);
     if(isCurrent)
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_STATE_CHANGE);
 
     // Don't need to resize (only update internals) when resolution isn't changing.
     get_target_window_dimensions(target, &target->context->window_w, &target->context->window_h);
@@ -2166,7 +3901,7 @@ static void SetVirtualResolution(GPU_Renderer* renderer, GPU_Target* target, Uin
 
     isCurrent = isCurrentTarget(renderer, target);
     if(isCurrent)
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_STATE_CHANGE);
 
     target->w = w;
     target->h = h;
@@ -2187,7 +3922,7 @@ static void UnsetVirtualResolution(GPU_Renderer* renderer, GPU_Target* target)
 
     isCurrent = isCurrentTarget(renderer, target);
     if(isCurrent)
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_STATE_CHANGE);
 
     target->w = target->base_w;
     target->h = target->base_h;
@@ -2200,12 +3935,6 @@ static void UnsetVirtualResolution(GPU_Renderer* renderer, GPU_Target* target)
 	GPU_ResetProjection(target);
 }
 
-static void Quit(GPU_Renderer* renderer)
-{
-    renderer->impl->FreeTarget(renderer, renderer->current_context_target);
-    renderer->current_context_target = NULL;
-}
-
 
 
 static GPU_bool SetFullscreen(GPU_Renderer* renderer, GPU_bool enable_fullscreen, GPU_bool use_desktop_resolution)
@@ -2292,35 +4021,6 @@ static GPU_bool SetFullscreen(GPU_Renderer* renderer, GPU_bool enable_fullscreen
     return is_fullscreen;
 }
 
-static GPU_Camera SetCamera(GPU_Renderer* renderer, GPU_Target* target, GPU_Camera* cam)
-{
-    GPU_Camera new_camera;
-	GPU_Camera old_camera;
-
-    if(target == NULL)
-    {
-        GPU_PushErrorCode("GPU_SetCamera", GPU_ERROR_NULL_ARGUMENT, "target");
-        return GPU_GetDefaultCamera();
-    }
-
-    if(cam == NULL)
-        new_camera = GPU_GetDefaultCamera();
-    else
-        new_camera = *cam;
-
-    old_camera = target->camera;
-
-    if(!equal_cameras(new_camera, old_camera))
-    {
-        if(isCurrentTarget(renderer, target))
-            renderer->impl->FlushBlitBuffer(renderer);
-
-        target->camera = new_camera;
-    }
-
-    return old_camera;
-}
-
 static GLuint CreateUninitializedTexture(GPU_Renderer* renderer)
 {
     GLuint handle;
@@ -2742,26 +4442,6 @@ static GPU_Image* CreateImageUsingTexture(GPU_Renderer* renderer, GPU_TextureHan
 }
 
 
-static GPU_Image* CreateAliasImage(GPU_Renderer* renderer, GPU_Image* image)
-{
-	GPU_Image* result;
-	(void)renderer;
-
-    if(image == NULL)
-        return NULL;
-
-    result = (GPU_Image*)SDL_malloc(sizeof(GPU_Image));
-    // Copy the members
-    *result = *image;
-
-    // Alias info
-    ((GPU_IMAGE_DATA*)image->data)->refcount++;
-    result->refcount = 1;
-    result->is_alias = GPU_TRUE;
-
-    return result;
-}
-
 
 static GPU_bool readTargetPixels(GPU_Renderer* renderer, GPU_Target* source, GLint format, GLubyte* pixels)
 {
@@ -2769,7 +4449,7 @@ static GPU_bool readTargetPixels(GPU_Renderer* renderer, GPU_Target* source, GLi
         return GPU_FALSE;
 
     if(isCurrentTarget(renderer, source))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_READBACK);
 
     if(SetActiveTarget(renderer, source))
     {
@@ -2827,7 +4507,7 @@ static unsigned char* getRawTargetData(GPU_Renderer* renderer, GPU_Target* targe
 	int y;
 
     if(isCurrentTarget(renderer, target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_READBACK);
 
     bytes_per_pixel = 4;
     if(target->image != NULL)
@@ -2863,7 +4543,7 @@ static unsigned char* getRawImageData(GPU_Renderer* renderer, GPU_Image* image)
 	unsigned char* data;
 
     if(image->target != NULL && isCurrentTarget(renderer, image->target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_READBACK);
 
     data = (unsigned char*)SDL_malloc(image->texture_w * image->texture_h * image->bytes_per_pixel);
 
@@ -3562,7 +5242,7 @@ static void UpdateImage(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect
 
     changeTexturing(renderer, 1);
     if(image->target != NULL && isCurrentTarget(renderer, image->target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_TEXTURE_CHANGE);
     bindTexture(renderer, image);
     alignment = 8;
     while(newSurface->pitch % alignment)
@@ -3587,19 +5267,10 @@ static void UpdateImage(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect
 }
 
 
-static void UpdateImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row)
+// Clips the rect given to GPU_UpdateImageBytes() to the image.  NULL means the whole image.
+static GPU_bool getImageUpdateRect(GPU_Image* image, const GPU_Rect* image_rect, GPU_Rect* result)
 {
-	GPU_IMAGE_DATA* data;
-	GLenum original_format;
-
 	GPU_Rect updateRect;
-	int alignment;
-
-    if(image == NULL || bytes == NULL)
-        return;
-
-    data = (GPU_IMAGE_DATA*)image->data;
-    original_format = data->format;
 
     if(image_rect != NULL)
     {
@@ -3633,14 +5304,34 @@ static void UpdateImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU
         if(updateRect.w < 0.0f || updateRect.h < 0.0f)
         {
             GPU_PushErrorCode("GPU_UpdateImage", GPU_ERROR_USER_ERROR, "Given negative image rectangle.");
-            return;
+            return GPU_FALSE;
         }
     }
 
+    *result = updateRect;
+    return GPU_TRUE;
+}
+
+static void UpdateImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row)
+{
+	GPU_IMAGE_DATA* data;
+	GLenum original_format;
+
+	GPU_Rect updateRect;
+	int alignment;
+
+    if(image == NULL || bytes == NULL)
+        return;
+
+    data = (GPU_IMAGE_DATA*)image->data;
+    original_format = data->format;
+
+    if(!getImageUpdateRect(image, image_rect, &updateRect))
+        return;
 
     changeTexturing(renderer, 1);
     if(image->target != NULL && isCurrentTarget(renderer, image->target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_TEXTURE_CHANGE);
     bindTexture(renderer, image);
     alignment = 8;
     while(bytes_per_row % alignment)
@@ -3649,6 +5340,300 @@ static void UpdateImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU
     upload_texture(bytes, updateRect, original_format, alignment, bytes_per_row / image->bytes_per_pixel, bytes_per_row, image->bytes_per_pixel);
 }
 
+#ifdef SDL_GPU_USE_PIXEL_UNPACK_BUFFERS
+typedef struct PixelUploadData
+{
+    GLuint buffers[GPU_PIXEL_UPLOAD_RING_SIZE];
+    unsigned int sizes[GPU_PIXEL_UPLOAD_RING_SIZE];  // Allocated bytes
+    GLsync fences[GPU_PIXEL_UPLOAD_RING_SIZE];  // Set by the last upload from each buffer
+    int next;
+    GPU_bool use_fences;  // Without sync objects, every buffer is treated as busy
+} PixelUploadData;
+
+static GPU_bool isFenceSyncSupported(GPU_Renderer* renderer)
+{
+    #ifdef SDL_GPU_USE_GLES
+    (void)renderer;
+    return GPU_TRUE;
+    #else
+    return (renderer->id.major_version > 3 || (renderer->id.major_version == 3 && renderer->id.minor_version >= 2)
+            || isExtensionSupported("GL_ARB_sync"));
+    #endif
+}
+
+static PixelUploadData* getPixelUploads(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata)
+{
+    if(cdata->pixel_uploads == NULL)
+    {
+        cdata->pixel_uploads = (PixelUploadData*)SDL_malloc(sizeof(PixelUploadData));
+        memset(cdata->pixel_uploads, 0, sizeof(PixelUploadData));
+        glGenBuffers(GPU_PIXEL_UPLOAD_RING_SIZE, cdata->pixel_uploads->buffers);
+        cdata->pixel_uploads->use_fences = isFenceSyncSupported(renderer);
+    }
+    return cdata->pixel_uploads;
+}
+
+static void freePixelUploads(GPU_CONTEXT_DATA* cdata, GPU_bool delete_buffers)
+{
+    int i;
+    if(cdata->pixel_uploads == NULL)
+        return;
+
+    if(delete_buffers)
+    {
+        for(i = 0; i < GPU_PIXEL_UPLOAD_RING_SIZE; i++)
+        {
+            if(cdata->pixel_uploads->fences[i] != NULL)
+                glDeleteSync(cdata->pixel_uploads->fences[i]);
+        }
+        glDeleteBuffers(GPU_PIXEL_UPLOAD_RING_SIZE, cdata->pixel_uploads->buffers);
+    }
+    SDL_free(cdata->pixel_uploads);
+    cdata->pixel_uploads = NULL;
+}
+
+// Binds the given buffer of the ring to GL_PIXEL_UNPACK_BUFFER and maps size bytes of it.
+// A buffer that the GPU may still be reading from is orphaned instead of waited on: the driver hands out fresh storage
+// and the earlier upload keeps the old one.
+static unsigned char* mapPixelUploadBuffer(PixelUploadData* uploads, int slot, unsigned int size)
+{
+    GPU_bool busy = uploads->use_fences? GPU_FALSE : GPU_TRUE;
+    GLenum result;
+
+    if(uploads->fences[slot] != NULL)
+    {
+        result = glClientWaitSync(uploads->fences[slot], 0, 0);
+        busy = (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED);
+        glDeleteSync(uploads->fences[slot]);
+        uploads->fences[slot] = NULL;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploads->buffers[slot]);
+    if(busy || uploads->sizes[slot] < size)
+    {
+        if(uploads->sizes[slot] < size)
+            uploads->sizes[slot] = size;
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, uploads->sizes[slot], NULL, GL_STREAM_DRAW);
+    }
+
+    // Nothing is reading from the storage now, so the driver doesn't need to synchronize
+    return (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+#endif
+
+static void UpdateImageBytesAsync(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row)
+{
+    #ifdef SDL_GPU_USE_PIXEL_UNPACK_BUFFERS
+	GPU_CONTEXT_DATA* cdata;
+	PixelUploadData* uploads;
+	GPU_Rect updateRect;
+	unsigned char* mapped;
+	unsigned int row_size, h, i;
+	int slot;
+	int alignment;
+
+    if(image == NULL || bytes == NULL)
+        return;
+
+    if(!getImageUpdateRect(image, image_rect, &updateRect))
+        return;
+
+    row_size = (unsigned int)updateRect.w * image->bytes_per_pixel;
+    h = (unsigned int)updateRect.h;
+    if(row_size == 0 || h == 0)
+        return;
+
+    changeTexturing(renderer, 1);
+    if(image->target != NULL && isCurrentTarget(renderer, image->target))
+        flushBlitBufferFor(renderer, GPU_FLUSH_TEXTURE_CHANGE);
+    bindTexture(renderer, image);
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    uploads = getPixelUploads(renderer, cdata);
+    slot = uploads->next;
+    uploads->next = (slot + 1) % GPU_PIXEL_UPLOAD_RING_SIZE;
+
+    mapped = mapPixelUploadBuffer(uploads, slot, row_size * h);
+    if(mapped == NULL)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        UpdateImageBytes(renderer, image, image_rect, bytes, bytes_per_row);
+        return;
+    }
+
+    // Rows are packed tightly in the buffer
+    for(i = 0; i < h; i++)
+        memcpy(mapped + i*row_size, bytes + i*bytes_per_row, row_size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    alignment = 8;
+    while(row_size % alignment)
+        alignment >>= 1;
+
+    // With an unpack buffer bound, the pixel pointer is an offset into it
+    fast_upload_texture(NULL, updateRect, ((GPU_IMAGE_DATA*)image->data)->format, alignment, (int)updateRect.w);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if(uploads->use_fences)
+        uploads->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    #else
+    UpdateImageBytes(renderer, image, image_rect, bytes, bytes_per_row);
+    #endif
+}
+
+
+typedef struct ReadbackData
+{
+    #ifdef SDL_GPU_USE_PIXEL_PACK_BUFFERS
+    GLuint buffer;
+    GLsync fence;  // NULL once the GPU is done, or without sync objects
+    #endif
+    unsigned char* pixels;  // The mapped buffer, or a copy read right away.  Rows are bottom-up, as GL reads them.
+} ReadbackData;
+
+static GPU_Readback* ReadPixelsAsync(GPU_Renderer* renderer, GPU_Target* target, const GPU_Rect* rect)
+{
+    GPU_Readback* result;
+    ReadbackData* data;
+    int x, y, w, h;
+
+    if(target == NULL)
+    {
+        GPU_PushErrorCode("GPU_ReadPixelsAsync", GPU_ERROR_NULL_ARGUMENT, "target");
+        return NULL;
+    }
+
+    x = 0;
+    y = 0;
+    w = target->base_w;
+    h = target->base_h;
+    if(rect != NULL)
+    {
+        x = (rect->x > 0? (int)rect->x : 0);
+        y = (rect->y > 0? (int)rect->y : 0);
+        w = (int)(rect->x + rect->w);
+        h = (int)(rect->y + rect->h);
+        w = (w < target->base_w? w : target->base_w) - x;
+        h = (h < target->base_h? h : target->base_h) - y;
+    }
+    if(w < 1 || h < 1)
+    {
+        GPU_PushErrorCode("GPU_ReadPixelsAsync", GPU_ERROR_USER_ERROR, "Given rect is outside of the target.");
+        return NULL;
+    }
+
+    if(isCurrentTarget(renderer, target))
+        flushBlitBufferFor(renderer, GPU_FLUSH_READBACK);
+    if(!SetActiveTarget(renderer, target))
+    {
+        GPU_PushErrorCode("GPU_ReadPixelsAsync", GPU_ERROR_BACKEND_ERROR, "Could not bind the target.");
+        return NULL;
+    }
+
+    result = (GPU_Readback*)SDL_malloc(sizeof(GPU_Readback));
+    data = (ReadbackData*)SDL_malloc(sizeof(ReadbackData));
+    memset(data, 0, sizeof(ReadbackData));
+    result->renderer = renderer;
+    result->w = w;
+    result->h = h;
+    result->data = data;
+
+    // GL counts rows from the bottom, like getRawTargetData() expects
+    y = target->base_h - y - h;
+
+    #ifdef SDL_GPU_USE_PIXEL_PACK_BUFFERS
+    glGenBuffers(1, &data->buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, data->buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, w*h*4, NULL, GL_STREAM_READ);
+    // With a pack buffer bound, the pixel pointer is an offset into it
+    glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if(isFenceSyncSupported(renderer))
+        data->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    #else
+    data->pixels = (unsigned char*)SDL_malloc(w*h*4);
+    glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, data->pixels);
+    #endif
+
+    return result;
+}
+
+static GPU_bool IsReadbackReady(GPU_Renderer* renderer, GPU_Readback* readback)
+{
+    #ifdef SDL_GPU_USE_PIXEL_PACK_BUFFERS
+    ReadbackData* data = (ReadbackData*)readback->data;
+    GLenum result;
+    (void)renderer;
+
+    if(data->fence == NULL)
+        return GPU_TRUE;
+
+    // The flush makes sure that the fence gets to the GPU at all
+    result = glClientWaitSync(data->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if(result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+        return GPU_FALSE;
+
+    glDeleteSync(data->fence);
+    data->fence = NULL;
+    #else
+    (void)renderer;
+    (void)readback;
+    #endif
+    return GPU_TRUE;
+}
+
+static const unsigned char* MapReadback(GPU_Renderer* renderer, GPU_Readback* readback, int* bytes_per_row)
+{
+    ReadbackData* data = (ReadbackData*)readback->data;
+    (void)renderer;
+
+    #ifdef SDL_GPU_USE_PIXEL_PACK_BUFFERS
+    if(data->pixels == NULL)
+    {
+        // Mapping waits for the GPU if the read isn't done yet
+        if(data->fence != NULL)
+            glDeleteSync(data->fence);
+        data->fence = NULL;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, data->buffer);
+        data->pixels = (unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback->w*readback->h*4, GL_MAP_READ_BIT);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if(data->pixels == NULL)
+        {
+            GPU_PushErrorCode("GPU_MapReadback", GPU_ERROR_BACKEND_ERROR, "Failed to map the pixel pack buffer.");
+            return NULL;
+        }
+    }
+    #endif
+
+    if(bytes_per_row != NULL)
+        *bytes_per_row = -readback->w*4;
+    return data->pixels + (readback->h - 1)*readback->w*4;
+}
+
+static void FreeReadback(GPU_Renderer* renderer, GPU_Readback* readback)
+{
+    ReadbackData* data = (ReadbackData*)readback->data;
+    (void)renderer;
+
+    #ifdef SDL_GPU_USE_PIXEL_PACK_BUFFERS
+    if(data->pixels != NULL)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, data->buffer);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    if(data->fence != NULL)
+        glDeleteSync(data->fence);
+    glDeleteBuffers(1, &data->buffer);
+    #else
+    SDL_free(data->pixels);
+    #endif
+
+    SDL_free(data);
+    SDL_free(readback);
+}
+
 
 
 static GPU_bool ReplaceImage(GPU_Renderer* renderer, GPU_Image* image, SDL_Surface* surface, const GPU_Rect* surface_rect)
@@ -4047,6 +6032,7 @@ static GPU_Target* GetTarget(GPU_Renderer* renderer, GPU_Image* image)
     
     result->use_depth_test = GPU_FALSE;
     result->use_depth_write = GPU_TRUE;
+    result->use_culling = GPU_FALSE;
 
     result->use_clip_rect = GPU_FALSE;
     result->clip_rect.x = 0;
@@ -4098,18 +6084,42 @@ static void FreeContext(GPU_Context* context)
     // Time to actually free this context and its data
     cdata = (GPU_CONTEXT_DATA*)context->data;
 
+    #ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+    // The mapping goes with the VBO below
+    if(!cdata->use_persistent_buffer)
+    #endif
     SDL_free(cdata->blit_buffer);
     SDL_free(cdata->index_buffer);
+    freeSortedBatch(cdata);
+    #ifdef SDL_GPU_USE_TIMER_QUERIES
+    freeGPUTiming(cdata, !context->failed);
+    #endif
+    #ifdef SDL_GPU_USE_PIXEL_UNPACK_BUFFERS
+    freePixelUploads(cdata, !context->failed);
+    #endif
+    #ifdef SDL_GPU_USE_INSTANCED_SPRITES
+    SDL_free(cdata->instance_buffer);
+    #endif
 
     if(!context->failed)
     {
         #ifdef SDL_GPU_USE_BUFFER_PIPELINE
         glDeleteBuffers(2, cdata->blit_VBO);
         glDeleteBuffers(1, &cdata->blit_IBO);
+        glDeleteBuffers(1, &cdata->blit_quad_IBO);
         glDeleteBuffers(16, cdata->attribute_VBO);
+        #ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+        releasePersistentBlitBuffer(cdata);
+        #endif
         #if !defined(SDL_GPU_NO_VAO)
         glDeleteVertexArrays(1, &cdata->blit_VAO);
         #endif
+        #ifdef SDL_GPU_USE_FLUSH_VAOS
+        freeFlushVAOs(cdata, 0);
+        #endif
+        #endif
+        #ifdef SDL_GPU_USE_INSTANCED_SPRITES
+        freeInstancedSprites(cdata);
         #endif
     }
 
@@ -4135,10 +6145,14 @@ static void FreeTarget(GPU_Renderer* renderer, GPU_Target* target)
     }
     
     // Time to actually free this target
+
+    // Draw and close a sorted batch that is recording to this target
+    if(renderer->current_context_target != NULL && isRecordingSortedBatch(renderer->current_context_target->context, target))
+        EndSortedBatch(renderer);
     
     // Prepare to work in this target's context, if it has one
     if(target == renderer->current_context_target)
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_TARGET_SWITCH);
     else if (target->context_target != NULL)
     {
         GPU_MakeCurrent(target->context_target, target->context_target->context->windowID);
@@ -4192,15 +6206,37 @@ static void FreeTarget(GPU_Renderer* renderer, GPU_Target* target)
 
 
 
+#ifdef SDL_GPU_PACK_BLIT_COLORS
+#define SET_VERTEX_COLOR(r, g, b, a) \
+    { \
+        Uint8* color_bytes = (Uint8*)(blit_buffer + color_index); \
+        color_bytes[0] = (Uint8)((r)*255.0f + 0.5f); \
+        color_bytes[1] = (Uint8)((g)*255.0f + 0.5f); \
+        color_bytes[2] = (Uint8)((b)*255.0f + 0.5f); \
+        color_bytes[3] = (Uint8)((a)*255.0f + 0.5f); \
+    }
+#else
+#define SET_VERTEX_COLOR(r, g, b, a) \
+    blit_buffer[color_index] = r; \
+    blit_buffer[color_index+1] = g; \
+    blit_buffer[color_index+2] = b; \
+    blit_buffer[color_index+3] = a
+#endif
+
+#ifdef SDL_GPU_USE_TEXTURE_SLOTS
+#define SET_VERTEX_TEX_SLOT() \
+    blit_buffer[tex_index + (GPU_BLIT_BUFFER_TEX_SLOT_OFFSET - GPU_BLIT_BUFFER_TEX_COORD_OFFSET)] = cdata->current_texture_slot
+#else
+#define SET_VERTEX_TEX_SLOT()
+#endif
+
 #define SET_TEXTURED_VERTEX(x, y, s, t, r, g, b, a) \
     blit_buffer[vert_index] = x; \
     blit_buffer[vert_index+1] = y; \
     blit_buffer[tex_index] = s; \
     blit_buffer[tex_index+1] = t; \
-    blit_buffer[color_index] = r; \
-    blit_buffer[color_index+1] = g; \
-    blit_buffer[color_index+2] = b; \
-    blit_buffer[color_index+3] = a; \
+    SET_VERTEX_COLOR(r, g, b, a); \
+    SET_VERTEX_TEX_SLOT(); \
     index_buffer[cdata->index_buffer_num_vertices++] = cdata->blit_buffer_num_vertices++; \
     vert_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
     tex_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
@@ -4211,10 +6247,8 @@ static void FreeTarget(GPU_Renderer* renderer, GPU_Target* target)
     blit_buffer[vert_index+1] = y; \
     blit_buffer[tex_index] = s; \
     blit_buffer[tex_index+1] = t; \
-    blit_buffer[color_index] = r; \
-    blit_buffer[color_index+1] = g; \
-    blit_buffer[color_index+2] = b; \
-    blit_buffer[color_index+3] = a; \
+    SET_VERTEX_COLOR(r, g, b, a); \
+    SET_VERTEX_TEX_SLOT(); \
     vert_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
     tex_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
     color_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
@@ -4222,10 +6256,7 @@ static void FreeTarget(GPU_Renderer* renderer, GPU_Target* target)
 #define SET_UNTEXTURED_VERTEX(x, y, r, g, b, a) \
     blit_buffer[vert_index] = x; \
     blit_buffer[vert_index+1] = y; \
-    blit_buffer[color_index] = r; \
-    blit_buffer[color_index+1] = g; \
-    blit_buffer[color_index+2] = b; \
-    blit_buffer[color_index+3] = a; \
+    SET_VERTEX_COLOR(r, g, b, a); \
     index_buffer[cdata->index_buffer_num_vertices++] = cdata->blit_buffer_num_vertices++; \
     vert_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
     color_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
@@ -4233,18 +6264,15 @@ static void FreeTarget(GPU_Renderer* renderer, GPU_Target* target)
 #define SET_UNTEXTURED_VERTEX_UNINDEXED(x, y, r, g, b, a) \
     blit_buffer[vert_index] = x; \
     blit_buffer[vert_index+1] = y; \
-    blit_buffer[color_index] = r; \
-    blit_buffer[color_index+1] = g; \
-    blit_buffer[color_index+2] = b; \
-    blit_buffer[color_index+3] = a; \
+    SET_VERTEX_COLOR(r, g, b, a); \
     vert_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
     color_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
 
 #define SET_INDEXED_VERTEX(offset) \
-    index_buffer[cdata->index_buffer_num_vertices++] = blit_buffer_starting_index + (unsigned short)(offset);
+    index_buffer[cdata->index_buffer_num_vertices++] = blit_buffer_starting_index + (GPU_BLIT_INDEX_TYPE)(offset);
 
 #define SET_RELATIVE_INDEXED_VERTEX(offset) \
-    index_buffer[cdata->index_buffer_num_vertices++] = cdata->blit_buffer_num_vertices + (unsigned short)(offset);
+    index_buffer[cdata->index_buffer_num_vertices++] = cdata->blit_buffer_num_vertices + (GPU_BLIT_INDEX_TYPE)(offset);
 
 
 
@@ -4276,17 +6304,275 @@ static void FreeTarget(GPU_Renderer* renderer, GPU_Target* target)
 
 
 
-static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y)
+static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y)
+{
+	Uint32 tex_w, tex_h;
+	float w;
+	float h;
+	float x1, y1, x2, y2;
+	float dx1, dy1, dx2, dy2;
+	GPU_CONTEXT_DATA* cdata;
+	float* blit_buffer;
+	GPU_BLIT_INDEX_TYPE* index_buffer;
+	GPU_BLIT_INDEX_TYPE blit_buffer_starting_index;
+	int vert_index;
+	int tex_index;
+	int color_index;
+	float r, g, b, a;
+
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_NULL_ARGUMENT, "image");
+        return;
+    }
+    if(target == NULL)
+    {
+        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+    if(renderer != image->renderer || renderer != target->renderer)
+    {
+        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+
+    makeContextCurrent(renderer, target);
+    if(renderer->current_context_target == NULL)
+    {
+        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_USER_ERROR, "NULL context");
+        return;
+    }
+
+    tex_w = image->texture_w;
+    tex_h = image->texture_h;
+
+    if(image->snap_mode == GPU_SNAP_POSITION || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
+    {
+        // Avoid rounding errors in texture sampling by insisting on integral pixel positions
+        x = floorf(x);
+        y = floorf(y);
+    }
+
+    if(src_rect == NULL)
+    {
+        // Scale tex coords according to actual texture dims
+        x1 = 0.0f;
+        y1 = 0.0f;
+        x2 = ((float)image->w)/tex_w;
+        y2 = ((float)image->h)/tex_h;
+        w = image->w;
+        h = image->h;
+    }
+    else
+    {
+        // Scale src_rect tex coords according to actual texture dims
+        x1 = src_rect->x/(float)tex_w;
+        y1 = src_rect->y/(float)tex_h;
+        x2 = (src_rect->x + src_rect->w)/(float)tex_w;
+        y2 = (src_rect->y + src_rect->h)/(float)tex_h;
+        w = src_rect->w;
+        h = src_rect->h;
+    }
+
+    if(image->using_virtual_resolution)
+    {
+        // Scale texture coords to fit the original dims
+        x1 *= image->base_w/(float)image->w;
+        y1 *= image->base_h/(float)image->h;
+        x2 *= image->base_w/(float)image->w;
+        y2 *= image->base_h/(float)image->h;
+    }
+
+    // Center the image on the given coords
+    dx1 = x - w * image->anchor_x;
+    dy1 = y - h * image->anchor_y;
+    dx2 = x + w * (1.0f - image->anchor_x);
+    dy2 = y + h * (1.0f - image->anchor_y);
+
+    if(image->snap_mode == GPU_SNAP_DIMENSIONS || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
+    {
+        float fractional;
+        fractional = w/2.0f - floorf(w/2.0f);
+        dx1 += fractional;
+        dx2 += fractional;
+        fractional = h/2.0f - floorf(h/2.0f);
+        dy1 += fractional;
+        dy2 += fractional;
+    }
+
+    // Drop it before touching any state if it can't be seen
+    if(isCulled(renderer, target, GL_TRIANGLES, dx1, dy1, dx2, dy2))
+        return;
+
+    if(isRecordingSortedBatch(renderer->current_context_target->context, target))
+        renderer->impl->SetCamera(renderer, target, &target->camera);
+    else
+    {
+        prepareToRenderToTarget(renderer, target);
+        prepareToRenderImage(renderer, target, image);
+
+        // Bind the texture to which subsequent calls refer
+        bindTextureSlot(renderer, image);
+    }
+
+    // Bind the FBO
+    if(!SetActiveTarget(renderer, target))
+    {
+        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+        return;
+    }
+
+    #ifdef SDL_GPU_USE_INSTANCED_SPRITES
+    if(canUseInstancedSprites(renderer->current_context_target->context))
+    {
+        addInstancedSprite(renderer, x, y, w, h, x - dx1, y - dy1, 0.0f, 1.0f, 1.0f, x1, y1, x2, y2, get_complete_mod_color(renderer, target, image));
+        return;
+    }
+    #endif
+
+    if(renderer->coordinate_mode)
+    {
+        float temp = dy1;
+        dy1 = dy2;
+        dy2 = temp;
+    }
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+
+    #ifdef SDL_GPU_USE_INSTANCED_SPRITES
+    if(cdata->instance_buffer_num_sprites > 0)
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
+    #endif
+
+    if(cdata->blit_buffer_num_vertices + 4 >= cdata->blit_buffer_max_num_vertices)
+    {
+        if(!growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + 4))
+            flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL);
+    }
+    #ifndef SDL_GPU_SKIP_BLIT_INDICES
+    if(cdata->index_buffer_num_vertices + 6 >= cdata->index_buffer_max_num_vertices)
+    {
+        if(!growIndexBuffer(cdata, cdata->index_buffer_num_vertices + 6))
+            flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL);
+    }
+    #endif
+
+    recordSortedDraw(renderer, target, image, GL_TRIANGLES);
+
+    blit_buffer = cdata->blit_buffer;
+    index_buffer = cdata->index_buffer;
+
+    blit_buffer_starting_index = cdata->blit_buffer_num_vertices;
+
+    vert_index = GPU_BLIT_BUFFER_VERTEX_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+    tex_index = GPU_BLIT_BUFFER_TEX_COORD_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+    color_index = GPU_BLIT_BUFFER_COLOR_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+    if(target->use_color)
+    {
+        r = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.r, image->color.r);
+        g = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.g, image->color.g);
+        b = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.b, image->color.b);
+        a = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(GET_ALPHA(target->color), GET_ALPHA(image->color));
+    }
+    else
+    {
+        r = image->color.r/255.0f;
+        g = image->color.g/255.0f;
+        b = image->color.b/255.0f;
+        a = GET_ALPHA(image->color)/255.0f;
+    }
+
+    // 4 Quad vertices
+    SET_TEXTURED_VERTEX_UNINDEXED(dx1, dy1, x1, y1, r, g, b, a);
+    SET_TEXTURED_VERTEX_UNINDEXED(dx2, dy1, x2, y1, r, g, b, a);
+    SET_TEXTURED_VERTEX_UNINDEXED(dx2, dy2, x2, y2, r, g, b, a);
+    SET_TEXTURED_VERTEX_UNINDEXED(dx1, dy2, x1, y2, r, g, b, a);
+
+    #ifndef SDL_GPU_SKIP_BLIT_INDICES
+    // 6 Triangle indices
+    SET_INDEXED_VERTEX(0);
+    SET_INDEXED_VERTEX(1);
+    SET_INDEXED_VERTEX(2);
+
+    SET_INDEXED_VERTEX(0);
+    SET_INDEXED_VERTEX(2);
+    SET_INDEXED_VERTEX(3);
+    #else
+    (void)index_buffer;
+    (void)blit_buffer_starting_index;
+    #endif
+
+    cdata->blit_buffer_num_vertices += GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+}
+
+
+static void BlitRotate(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float degrees)
+{
+	float w, h;
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitRotate", GPU_ERROR_NULL_ARGUMENT, "image");
+        return;
+    }
+    if(target == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitRotate", GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+
+    w = (src_rect == NULL? image->w : src_rect->w);
+    h = (src_rect == NULL? image->h : src_rect->h);
+    renderer->impl->BlitTransformX(renderer, image, src_rect, target, x, y, w*image->anchor_x, h*image->anchor_y, degrees, 1.0f, 1.0f);
+}
+
+static void BlitScale(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float scaleX, float scaleY)
+{
+	float w, h;
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitScale", GPU_ERROR_NULL_ARGUMENT, "image");
+        return;
+    }
+    if(target == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitScale", GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+
+    w = (src_rect == NULL? image->w : src_rect->w);
+    h = (src_rect == NULL? image->h : src_rect->h);
+    renderer->impl->BlitTransformX(renderer, image, src_rect, target, x, y, w*image->anchor_x, h*image->anchor_y, 0.0f, scaleX, scaleY);
+}
+
+static void BlitTransform(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float degrees, float scaleX, float scaleY)
+{
+	float w, h;
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitTransform", GPU_ERROR_NULL_ARGUMENT, "image");
+        return;
+    }
+    if(target == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitTransform", GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+
+    w = (src_rect == NULL? image->w : src_rect->w);
+    h = (src_rect == NULL? image->h : src_rect->h);
+    renderer->impl->BlitTransformX(renderer, image, src_rect, target, x, y, w*image->anchor_x, h*image->anchor_y, degrees, scaleX, scaleY);
+}
+
+static void BlitTransformX(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float pivot_x, float pivot_y, float degrees, float scaleX, float scaleY)
 {
 	Uint32 tex_w, tex_h;
-	float w;
-	float h;
 	float x1, y1, x2, y2;
-	float dx1, dy1, dx2, dy2;
+	float dx1, dy1, dx2, dy2, dx3, dy3, dx4, dy4;
+	float w, h;
 	GPU_CONTEXT_DATA* cdata;
 	float* blit_buffer;
-	unsigned short* index_buffer;
-	unsigned short blit_buffer_starting_index;
+	GPU_BLIT_INDEX_TYPE* index_buffer;
+	GPU_BLIT_INDEX_TYPE blit_buffer_starting_index;
 	int vert_index;
 	int tex_index;
 	int color_index;
@@ -4294,39 +6580,22 @@ static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, G
 
     if(image == NULL)
     {
-        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_NULL_ARGUMENT, "image");
+        GPU_PushErrorCode("GPU_BlitTransformX", GPU_ERROR_NULL_ARGUMENT, "image");
         return;
     }
     if(target == NULL)
     {
-        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_NULL_ARGUMENT, "target");
+        GPU_PushErrorCode("GPU_BlitTransformX", GPU_ERROR_NULL_ARGUMENT, "target");
         return;
     }
     if(renderer != image->renderer || renderer != target->renderer)
     {
-        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_USER_ERROR, "Mismatched renderer");
-        return;
-    }
-
-    makeContextCurrent(renderer, target);
-    if(renderer->current_context_target == NULL)
-    {
-        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_USER_ERROR, "NULL context");
+        GPU_PushErrorCode("GPU_BlitTransformX", GPU_ERROR_USER_ERROR, "Mismatched renderer");
         return;
     }
 
-    prepareToRenderToTarget(renderer, target);
-    prepareToRenderImage(renderer, target, image);
-
-    // Bind the texture to which subsequent calls refer
-    bindTexture(renderer, image);
 
-    // Bind the FBO
-    if(!SetActiveTarget(renderer, target))
-    {
-        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
-        return;
-    }
+    makeContextCurrent(renderer, target);
 
     tex_w = image->texture_w;
     tex_h = image->texture_h;
@@ -4338,6 +6607,12 @@ static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, G
         y = floorf(y);
     }
 
+    /*
+        1,1 --- 3,3
+         |       |
+         |       |
+        4,4 --- 2,2
+    */
     if(src_rect == NULL)
     {
         // Scale tex coords according to actual texture dims
@@ -4368,14 +6643,15 @@ static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, G
         y2 *= image->base_h/(float)image->h;
     }
 
-    // Center the image on the given coords
-    dx1 = x - w * image->anchor_x;
-    dy1 = y - h * image->anchor_y;
-    dx2 = x + w * (1.0f - image->anchor_x);
-    dy2 = y + h * (1.0f - image->anchor_y);
+    // Create vertices about the anchor
+    dx1 = -pivot_x;
+    dy1 = -pivot_y;
+    dx2 = w - pivot_x;
+    dy2 = h - pivot_y;
 
     if(image->snap_mode == GPU_SNAP_DIMENSIONS || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
     {
+        // This is a little weird for rotating sprites, but oh well.
         float fractional;
         fractional = w/2.0f - floorf(w/2.0f);
         dx1 += fractional;
@@ -4385,25 +6661,116 @@ static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, G
         dy2 += fractional;
     }
 
-    if(renderer->coordinate_mode)
+    // Drop it before touching any state if it can't be seen.  Any rotation of the scaled quad stays within this radius of the anchor.
+    {
+        float far_x = (fabsf(dx1) > fabsf(dx2)? fabsf(dx1) : fabsf(dx2));
+        float far_y = (fabsf(dy1) > fabsf(dy2)? fabsf(dy1) : fabsf(dy2));
+        float scale = (fabsf(scaleX) > fabsf(scaleY)? fabsf(scaleX) : fabsf(scaleY));
+        float radius = sqrtf(far_x*far_x + far_y*far_y) * scale;
+        if(isCulled(renderer, target, GL_TRIANGLES, x - radius, y - radius, x + radius, y + radius))
+            return;
+    }
+
+    if(isRecordingSortedBatch(renderer->current_context_target->context, target))
+        renderer->impl->SetCamera(renderer, target, &target->camera);
+    else
+    {
+        prepareToRenderToTarget(renderer, target);
+        prepareToRenderImage(renderer, target, image);
+
+        // Bind the texture to which subsequent calls refer
+        bindTextureSlot(renderer, image);
+    }
+
+    // Bind the FBO
+    if(!SetActiveTarget(renderer, target))
+    {
+        GPU_PushErrorCode("GPU_BlitTransformX", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+        return;
+    }
+
+    #ifdef SDL_GPU_USE_INSTANCED_SPRITES
+    if(canUseInstancedSprites(renderer->current_context_target->context))
+    {
+        addInstancedSprite(renderer, x, y, w, h, -dx1, -dy1, degrees, scaleX, scaleY, x1, y1, x2, y2, get_complete_mod_color(renderer, target, image));
+        return;
+    }
+    #endif
+
+    if(renderer->coordinate_mode == 1)
     {
         float temp = dy1;
         dy1 = dy2;
         dy2 = temp;
     }
 
+    // Apply transforms
+
+    // Scale about the anchor
+    if(scaleX != 1.0f || scaleY != 1.0f)
+    {
+        dx1 *= scaleX;
+        dy1 *= scaleY;
+        dx2 *= scaleX;
+        dy2 *= scaleY;
+    }
+
+    // Get extra vertices for rotation
+    dx3 = dx2;
+    dy3 = dy1;
+    dx4 = dx1;
+    dy4 = dy2;
+
+    // Rotate about the anchor
+    if(degrees != 0.0f)
+    {
+        float cosA = cosf(degrees*RAD_PER_DEG);
+        float sinA = sinf(degrees*RAD_PER_DEG);
+        float tempX = dx1;
+        dx1 = dx1*cosA - dy1*sinA;
+        dy1 = tempX*sinA + dy1*cosA;
+        tempX = dx2;
+        dx2 = dx2*cosA - dy2*sinA;
+        dy2 = tempX*sinA + dy2*cosA;
+        tempX = dx3;
+        dx3 = dx3*cosA - dy3*sinA;
+        dy3 = tempX*sinA + dy3*cosA;
+        tempX = dx4;
+        dx4 = dx4*cosA - dy4*sinA;
+        dy4 = tempX*sinA + dy4*cosA;
+    }
+
+    // Translate to final position
+    dx1 += x;
+    dx2 += x;
+    dx3 += x;
+    dx4 += x;
+    dy1 += y;
+    dy2 += y;
+    dy3 += y;
+    dy4 += y;
+
     cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
 
+    #ifdef SDL_GPU_USE_INSTANCED_SPRITES
+    if(cdata->instance_buffer_num_sprites > 0)
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
+    #endif
+
     if(cdata->blit_buffer_num_vertices + 4 >= cdata->blit_buffer_max_num_vertices)
     {
         if(!growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + 4))
-            renderer->impl->FlushBlitBuffer(renderer);
+            flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL);
     }
+    #ifndef SDL_GPU_SKIP_BLIT_INDICES
     if(cdata->index_buffer_num_vertices + 6 >= cdata->index_buffer_max_num_vertices)
     {
         if(!growIndexBuffer(cdata, cdata->index_buffer_num_vertices + 6))
-            renderer->impl->FlushBlitBuffer(renderer);
+            flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL);
     }
+    #endif
+
+    recordSortedDraw(renderer, target, image, GL_TRIANGLES);
 
     blit_buffer = cdata->blit_buffer;
     index_buffer = cdata->index_buffer;
@@ -4413,6 +6780,7 @@ static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, G
     vert_index = GPU_BLIT_BUFFER_VERTEX_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
     tex_index = GPU_BLIT_BUFFER_TEX_COORD_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
     color_index = GPU_BLIT_BUFFER_COLOR_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+
     if(target->use_color)
     {
         r = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.r, image->color.r);
@@ -4428,299 +6796,666 @@ static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, G
         a = GET_ALPHA(image->color)/255.0f;
     }
 
-    // 4 Quad vertices
-    SET_TEXTURED_VERTEX_UNINDEXED(dx1, dy1, x1, y1, r, g, b, a);
-    SET_TEXTURED_VERTEX_UNINDEXED(dx2, dy1, x2, y1, r, g, b, a);
-    SET_TEXTURED_VERTEX_UNINDEXED(dx2, dy2, x2, y2, r, g, b, a);
-    SET_TEXTURED_VERTEX_UNINDEXED(dx1, dy2, x1, y2, r, g, b, a);
+    // 4 Quad vertices
+    SET_TEXTURED_VERTEX_UNINDEXED(dx1, dy1, x1, y1, r, g, b, a);
+    SET_TEXTURED_VERTEX_UNINDEXED(dx3, dy3, x2, y1, r, g, b, a);
+    SET_TEXTURED_VERTEX_UNINDEXED(dx2, dy2, x2, y2, r, g, b, a);
+    SET_TEXTURED_VERTEX_UNINDEXED(dx4, dy4, x1, y2, r, g, b, a);
+
+    #ifndef SDL_GPU_SKIP_BLIT_INDICES
+    // 6 Triangle indices
+    SET_INDEXED_VERTEX(0);
+    SET_INDEXED_VERTEX(1);
+    SET_INDEXED_VERTEX(2);
+
+    SET_INDEXED_VERTEX(0);
+    SET_INDEXED_VERTEX(2);
+    SET_INDEXED_VERTEX(3);
+    #else
+    (void)index_buffer;
+    (void)blit_buffer_starting_index;
+    #endif
+
+    cdata->blit_buffer_num_vertices += GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+}
+
+// Shared by BlitBatch() and BlitBatchSeparate().  Each array is read with its own stride (in floats per sprite), and NULL arrays use the defaults.
+static void blitSpriteBatch(GPU_Renderer* renderer, const char* function_name, GPU_Image* image, GPU_Target* target, unsigned int num_sprites,
+                            float* positions, int position_stride, float* src_rects, int rect_stride, float* colors, int color_stride, GPU_BlitFlagEnum flags)
+{
+	Uint32 tex_w, tex_h;
+	float x1, y1, x2, y2;
+	float dx1, dy1, dx2, dy2;
+	float w, h;
+	float r, g, b, a;
+	SDL_Color mod_color;
+	GPU_CONTEXT_DATA* cdata;
+	float* blit_buffer;
+	GPU_BLIT_INDEX_TYPE* index_buffer;
+	GPU_BLIT_INDEX_TYPE blit_buffer_starting_index;
+	int vert_index;
+	int tex_index;
+	int color_index;
+	unsigned int n;
+	GPU_bool pass_vertices = (positions != NULL && (flags & GPU_PASSTHROUGH_VERTICES));
+	GPU_bool pass_texcoords = (src_rects != NULL && (flags & GPU_PASSTHROUGH_TEXCOORDS));
+	GPU_bool pass_colors = (colors != NULL && (flags & GPU_PASSTHROUGH_COLORS));
+	GPU_bool use_instances = GPU_FALSE;
+	GPU_bool needs_record = GPU_TRUE;
+
+    if(image == NULL)
+    {
+        GPU_PushErrorCode(function_name, GPU_ERROR_NULL_ARGUMENT, "image");
+        return;
+    }
+    if(target == NULL)
+    {
+        GPU_PushErrorCode(function_name, GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+    if(renderer != image->renderer || renderer != target->renderer)
+    {
+        GPU_PushErrorCode(function_name, GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+    if(num_sprites == 0)
+        return;
+
+    // State setup happens once for the whole batch
+    makeContextCurrent(renderer, target);
+    if(renderer->current_context_target == NULL)
+    {
+        GPU_PushErrorCode(function_name, GPU_ERROR_USER_ERROR, "NULL context");
+        return;
+    }
+
+    if(isRecordingSortedBatch(renderer->current_context_target->context, target))
+        renderer->impl->SetCamera(renderer, target, &target->camera);
+    else
+    {
+        prepareToRenderToTarget(renderer, target);
+        prepareToRenderImage(renderer, target, image);
+
+        // Bind the texture to which subsequent calls refer
+        bindTextureSlot(renderer, image);
+    }
+
+    // Bind the FBO
+    if(!SetActiveTarget(renderer, target))
+    {
+        GPU_PushErrorCode(function_name, GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+        return;
+    }
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+
+    #ifdef SDL_GPU_USE_INSTANCED_SPRITES
+    // Instance records can't hold arbitrary per-vertex data
+    use_instances = (canUseInstancedSprites(renderer->current_context_target->context) && !pass_vertices && !pass_texcoords && !pass_colors);
+    if(!use_instances && cdata->instance_buffer_num_sprites > 0)
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
+    #endif
+
+    if(!use_instances)
+    {
+        // Make room for the whole batch up front if we can
+        growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + num_sprites*GPU_BLIT_BUFFER_VERTICES_PER_SPRITE);
+        #ifndef SDL_GPU_SKIP_BLIT_INDICES
+        growIndexBuffer(cdata, cdata->index_buffer_num_vertices + num_sprites*6);
+        #endif
+    }
+
+    tex_w = image->texture_w;
+    tex_h = image->texture_h;
+
+    mod_color = get_complete_mod_color(renderer, target, image);
+
+    for(n = 0; n < num_sprites; n++)
+    {
+        // Texture coords
+        if(src_rects == NULL)
+        {
+            x1 = 0.0f;
+            y1 = 0.0f;
+            x2 = ((float)image->w)/tex_w;
+            y2 = ((float)image->h)/tex_h;
+        }
+        else if(pass_texcoords)
+        {
+            // Corners 0 and 2 give the extent, which we need for positioning
+            x1 = src_rects[0];
+            y1 = src_rects[1];
+            x2 = src_rects[4];
+            y2 = src_rects[5];
+        }
+        else
+        {
+            x1 = src_rects[0]/(float)tex_w;
+            y1 = src_rects[1]/(float)tex_h;
+            x2 = (src_rects[0] + src_rects[2])/(float)tex_w;
+            y2 = (src_rects[1] + src_rects[3])/(float)tex_h;
+        }
+
+        w = (src_rects == NULL? image->w : (x2 - x1)*tex_w);
+        h = (src_rects == NULL? image->h : (y2 - y1)*tex_h);
+
+        if(image->using_virtual_resolution && !pass_texcoords)
+        {
+            // Scale texture coords to fit the original dims
+            x1 *= image->base_w/(float)image->w;
+            y1 *= image->base_h/(float)image->h;
+            x2 *= image->base_w/(float)image->w;
+            y2 *= image->base_h/(float)image->h;
+        }
+
+        // Color
+        if(colors == NULL)
+        {
+            r = mod_color.r/255.0f;
+            g = mod_color.g/255.0f;
+            b = mod_color.b/255.0f;
+            a = GET_ALPHA(mod_color)/255.0f;
+        }
+        else if(pass_colors)
+        {
+            r = colors[0];
+            g = colors[1];
+            b = colors[2];
+            a = colors[3];
+        }
+        else
+        {
+            r = colors[0]/255.0f;
+            g = colors[1]/255.0f;
+            b = colors[2]/255.0f;
+            a = colors[3]/255.0f;
+        }
+
+        // Position
+        if(!pass_vertices)
+        {
+            float x = 0.0f;
+            float y = 0.0f;
+            if(positions != NULL)
+            {
+                x = positions[0];
+                y = positions[1];
+            }
+
+            if(image->snap_mode == GPU_SNAP_POSITION || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
+            {
+                x = floorf(x);
+                y = floorf(y);
+            }
+
+            dx1 = x - w * image->anchor_x;
+            dy1 = y - h * image->anchor_y;
+            dx2 = x + w * (1.0f - image->anchor_x);
+            dy2 = y + h * (1.0f - image->anchor_y);
+
+            if(image->snap_mode == GPU_SNAP_DIMENSIONS || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
+            {
+                float fractional;
+                fractional = w/2.0f - floorf(w/2.0f);
+                dx1 += fractional;
+                dx2 += fractional;
+                fractional = h/2.0f - floorf(h/2.0f);
+                dy1 += fractional;
+                dy2 += fractional;
+            }
+
+            #ifdef SDL_GPU_USE_INSTANCED_SPRITES
+            if(use_instances)
+            {
+                SDL_Color color;
+                color.r = (Uint8)(r*255.0f + 0.5f);
+                color.g = (Uint8)(g*255.0f + 0.5f);
+                color.b = (Uint8)(b*255.0f + 0.5f);
+                GET_ALPHA(color) = (Uint8)(a*255.0f + 0.5f);
+                addInstancedSprite(renderer, x, y, w, h, x - dx1, y - dy1, 0.0f, 1.0f, 1.0f, x1, y1, x2, y2, color);
+
+                if(positions != NULL)
+                    positions += position_stride;
+                if(src_rects != NULL)
+                    src_rects += rect_stride;
+                if(colors != NULL)
+                    colors += color_stride;
+                continue;
+            }
+            #endif
+
+            if(renderer->coordinate_mode)
+            {
+                float temp = dy1;
+                dy1 = dy2;
+                dy2 = temp;
+            }
+        }
+        else
+        {
+            dx1 = dy1 = dx2 = dy2 = 0.0f;
+        }
+
+        if(cdata->blit_buffer_num_vertices + GPU_BLIT_BUFFER_VERTICES_PER_SPRITE >= cdata->blit_buffer_max_num_vertices)
+        {
+            flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL);
+            needs_record = GPU_TRUE;
+        }
+        #ifndef SDL_GPU_SKIP_BLIT_INDICES
+        if(cdata->index_buffer_num_vertices + 6 >= cdata->index_buffer_max_num_vertices)
+        {
+            flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL);
+            needs_record = GPU_TRUE;
+        }
+        #endif
+
+        // A flush emits the sorted batch, so the rest of the sprites start a new run
+        if(needs_record)
+        {
+            recordSortedDraw(renderer, target, image, GL_TRIANGLES);
+            needs_record = GPU_FALSE;
+        }
 
-    // 6 Triangle indices
-    SET_INDEXED_VERTEX(0);
-    SET_INDEXED_VERTEX(1);
-    SET_INDEXED_VERTEX(2);
+        blit_buffer = cdata->blit_buffer;
+        index_buffer = cdata->index_buffer;
 
-    SET_INDEXED_VERTEX(0);
-    SET_INDEXED_VERTEX(2);
-    SET_INDEXED_VERTEX(3);
+        blit_buffer_starting_index = cdata->blit_buffer_num_vertices;
 
-    cdata->blit_buffer_num_vertices += GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
-}
+        vert_index = GPU_BLIT_BUFFER_VERTEX_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+        tex_index = GPU_BLIT_BUFFER_TEX_COORD_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+        color_index = GPU_BLIT_BUFFER_COLOR_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
 
+        if(!pass_vertices && !pass_texcoords && !pass_colors)
+        {
+            SET_TEXTURED_VERTEX_UNINDEXED(dx1, dy1, x1, y1, r, g, b, a);
+            SET_TEXTURED_VERTEX_UNINDEXED(dx2, dy1, x2, y1, r, g, b, a);
+            SET_TEXTURED_VERTEX_UNINDEXED(dx2, dy2, x2, y2, r, g, b, a);
+            SET_TEXTURED_VERTEX_UNINDEXED(dx1, dy2, x1, y2, r, g, b, a);
+        }
+        else
+        {
+            // Some data is per-vertex, so write each corner separately
+            int i;
+            for(i = 0; i < GPU_BLIT_BUFFER_VERTICES_PER_SPRITE; i++)
+            {
+                float vx = (i == 0 || i == 3? dx1 : dx2);
+                float vy = (i < 2? dy1 : dy2);
+                float s = (i == 0 || i == 3? x1 : x2);
+                float t = (i < 2? y1 : y2);
+                if(pass_vertices)
+                {
+                    vx = positions[2*i];
+                    vy = positions[2*i+1];
+                }
+                if(pass_texcoords)
+                {
+                    s = src_rects[2*i];
+                    t = src_rects[2*i+1];
+                }
+                if(pass_colors)
+                {
+                    r = colors[4*i];
+                    g = colors[4*i+1];
+                    b = colors[4*i+2];
+                    a = colors[4*i+3];
+                }
+                SET_TEXTURED_VERTEX_UNINDEXED(vx, vy, s, t, r, g, b, a);
+            }
+        }
 
-static void BlitRotate(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float degrees)
-{
-	float w, h;
-    if(image == NULL)
-    {
-        GPU_PushErrorCode("GPU_BlitRotate", GPU_ERROR_NULL_ARGUMENT, "image");
-        return;
-    }
-    if(target == NULL)
-    {
-        GPU_PushErrorCode("GPU_BlitRotate", GPU_ERROR_NULL_ARGUMENT, "target");
-        return;
-    }
+        #ifndef SDL_GPU_SKIP_BLIT_INDICES
+        SET_INDEXED_VERTEX(0);
+        SET_INDEXED_VERTEX(1);
+        SET_INDEXED_VERTEX(2);
 
-    w = (src_rect == NULL? image->w : src_rect->w);
-    h = (src_rect == NULL? image->h : src_rect->h);
-    renderer->impl->BlitTransformX(renderer, image, src_rect, target, x, y, w*image->anchor_x, h*image->anchor_y, degrees, 1.0f, 1.0f);
-}
+        SET_INDEXED_VERTEX(0);
+        SET_INDEXED_VERTEX(2);
+        SET_INDEXED_VERTEX(3);
+        #else
+        (void)index_buffer;
+        (void)blit_buffer_starting_index;
+        #endif
 
-static void BlitScale(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float scaleX, float scaleY)
-{
-	float w, h;
-    if(image == NULL)
-    {
-        GPU_PushErrorCode("GPU_BlitScale", GPU_ERROR_NULL_ARGUMENT, "image");
-        return;
-    }
-    if(target == NULL)
-    {
-        GPU_PushErrorCode("GPU_BlitScale", GPU_ERROR_NULL_ARGUMENT, "target");
-        return;
+        cdata->blit_buffer_num_vertices += GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+
+        if(positions != NULL)
+            positions += position_stride;
+        if(src_rects != NULL)
+            src_rects += rect_stride;
+        if(colors != NULL)
+            colors += color_stride;
     }
 
-    w = (src_rect == NULL? image->w : src_rect->w);
-    h = (src_rect == NULL? image->h : src_rect->h);
-    renderer->impl->BlitTransformX(renderer, image, src_rect, target, x, y, w*image->anchor_x, h*image->anchor_y, 0.0f, scaleX, scaleY);
+    (void)use_instances;
 }
 
-static void BlitTransform(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float degrees, float scaleX, float scaleY)
+static void BlitBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* values, GPU_BlitFlagEnum flags)
 {
-	float w, h;
-    if(image == NULL)
-    {
-        GPU_PushErrorCode("GPU_BlitTransform", GPU_ERROR_NULL_ARGUMENT, "image");
-        return;
-    }
-    if(target == NULL)
-    {
-        GPU_PushErrorCode("GPU_BlitTransform", GPU_ERROR_NULL_ARGUMENT, "target");
-        return;
-    }
+    int position_floats = ((flags & GPU_PASSTHROUGH_VERTICES)? 8 : 2);
+    int rect_floats = ((flags & GPU_PASSTHROUGH_TEXCOORDS)? 8 : 4);
+    int color_floats = ((flags & GPU_PASSTHROUGH_COLORS)? 16 : 4);
+    float* positions = values;
+    float* src_rects;
+    float* colors;
+    int stride;
 
-    w = (src_rect == NULL? image->w : src_rect->w);
-    h = (src_rect == NULL? image->h : src_rect->h);
-    renderer->impl->BlitTransformX(renderer, image, src_rect, target, x, y, w*image->anchor_x, h*image->anchor_y, degrees, scaleX, scaleY);
+    // Defaults take no space in the interleaved data
+    if(values == NULL || (flags & GPU_USE_DEFAULT_POSITIONS))
+        position_floats = 0;
+    if(values == NULL || (flags & GPU_USE_DEFAULT_SRC_RECTS))
+        rect_floats = 0;
+    if(values == NULL || (flags & GPU_USE_DEFAULT_COLORS))
+        color_floats = 0;
+
+    stride = position_floats + rect_floats + color_floats;
+    src_rects = (values == NULL? NULL : values + position_floats);
+    colors = (values == NULL? NULL : values + position_floats + rect_floats);
+
+    blitSpriteBatch(renderer, "GPU_BlitBatch", image, target, num_sprites,
+                    (position_floats == 0? NULL : positions), stride,
+                    (rect_floats == 0? NULL : src_rects), stride,
+                    (color_floats == 0? NULL : colors), stride, flags);
 }
 
-static void BlitTransformX(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float pivot_x, float pivot_y, float degrees, float scaleX, float scaleY)
+// Sprites transformed per call to gpu_transform_quads()
+#define GPU_TRANSFORM_BATCH_CHUNK 64
+// Source rects that fit in the stack table before it has to be allocated
+#define GPU_TRANSFORM_BATCH_STACK_RECTS 16
+// Per source rect: tex coords (s1, t1, s2, t2), local quad (left, top, right, bottom), size (w, h), and pivot (x, y)
+#define GPU_TRANSFORM_BATCH_RECT_FLOATS 12
+
+static void BlitTransformBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* x, float* y, float* degrees, float* scale_x, float* scale_y,
+                               unsigned int num_src_rects, GPU_Rect* src_rects, Uint16* src_rect_indices, SDL_Color* colors)
 {
 	Uint32 tex_w, tex_h;
-	float x1, y1, x2, y2;
-	float dx1, dy1, dx2, dy2, dx3, dy3, dx4, dy4;
-	float w, h;
+	float rect_table_stack[GPU_TRANSFORM_BATCH_STACK_RECTS*GPU_TRANSFORM_BATCH_RECT_FLOATS];
+	float* rect_table;
+	float chunk_x[GPU_TRANSFORM_BATCH_CHUNK], chunk_y[GPU_TRANSFORM_BATCH_CHUNK];
+	float chunk_degrees[GPU_TRANSFORM_BATCH_CHUNK], chunk_scale_x[GPU_TRANSFORM_BATCH_CHUNK], chunk_scale_y[GPU_TRANSFORM_BATCH_CHUNK];
+	float chunk_left[GPU_TRANSFORM_BATCH_CHUNK], chunk_top[GPU_TRANSFORM_BATCH_CHUNK], chunk_right[GPU_TRANSFORM_BATCH_CHUNK], chunk_bottom[GPU_TRANSFORM_BATCH_CHUNK];
+	unsigned int chunk_sprite[GPU_TRANSFORM_BATCH_CHUNK];
+	float* chunk_rect[GPU_TRANSFORM_BATCH_CHUNK];
+	float corners_x[4*GPU_TRANSFORM_BATCH_CHUNK], corners_y[4*GPU_TRANSFORM_BATCH_CHUNK];
+	float r, g, b, a;
+	SDL_Color mod_color;
 	GPU_CONTEXT_DATA* cdata;
 	float* blit_buffer;
-	unsigned short* index_buffer;
-	unsigned short blit_buffer_starting_index;
+	GPU_BLIT_INDEX_TYPE* index_buffer;
+	GPU_BLIT_INDEX_TYPE blit_buffer_starting_index;
 	int vert_index;
 	int tex_index;
 	int color_index;
-	float r, g, b, a;
+	unsigned int num_rects;
+	unsigned int start, i;
+	GPU_bool snap_position = (image != NULL && (image->snap_mode == GPU_SNAP_POSITION || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS));
+	GPU_bool snap_dimensions = (image != NULL && (image->snap_mode == GPU_SNAP_DIMENSIONS || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS));
+	GPU_bool use_instances = GPU_FALSE;
+	GPU_bool needs_record = GPU_TRUE;
+	GPU_bool bad_index = GPU_FALSE;
 
     if(image == NULL)
     {
-        GPU_PushErrorCode("GPU_BlitTransformX", GPU_ERROR_NULL_ARGUMENT, "image");
+        GPU_PushErrorCode("GPU_BlitTransformBatch", GPU_ERROR_NULL_ARGUMENT, "image");
         return;
     }
     if(target == NULL)
     {
-        GPU_PushErrorCode("GPU_BlitTransformX", GPU_ERROR_NULL_ARGUMENT, "target");
+        GPU_PushErrorCode("GPU_BlitTransformBatch", GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+    if(x == NULL || y == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitTransformBatch", GPU_ERROR_NULL_ARGUMENT, (x == NULL? "x" : "y"));
         return;
     }
     if(renderer != image->renderer || renderer != target->renderer)
     {
-        GPU_PushErrorCode("GPU_BlitTransformX", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        GPU_PushErrorCode("GPU_BlitTransformBatch", GPU_ERROR_USER_ERROR, "Mismatched renderer");
         return;
     }
+    if(num_sprites == 0)
+        return;
 
-
+    // State setup happens once for the whole batch
     makeContextCurrent(renderer, target);
+    if(renderer->current_context_target == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitTransformBatch", GPU_ERROR_USER_ERROR, "NULL context");
+        return;
+    }
 
-    prepareToRenderToTarget(renderer, target);
-    prepareToRenderImage(renderer, target, image);
+    if(isRecordingSortedBatch(renderer->current_context_target->context, target))
+        renderer->impl->SetCamera(renderer, target, &target->camera);
+    else
+    {
+        prepareToRenderToTarget(renderer, target);
+        prepareToRenderImage(renderer, target, image);
 
-    // Bind the texture to which subsequent calls refer
-    bindTexture(renderer, image);
+        // Bind the texture to which subsequent calls refer
+        bindTextureSlot(renderer, image);
+    }
 
     // Bind the FBO
     if(!SetActiveTarget(renderer, target))
     {
-        GPU_PushErrorCode("GPU_BlitTransformX", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+        GPU_PushErrorCode("GPU_BlitTransformBatch", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
         return;
     }
 
-    tex_w = image->texture_w;
-    tex_h = image->texture_h;
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
 
-    if(image->snap_mode == GPU_SNAP_POSITION || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
-    {
-        // Avoid rounding errors in texture sampling by insisting on integral pixel positions
-        x = floorf(x);
-        y = floorf(y);
-    }
+    #ifdef SDL_GPU_USE_INSTANCED_SPRITES
+    use_instances = canUseInstancedSprites(renderer->current_context_target->context);
+    if(!use_instances && cdata->instance_buffer_num_sprites > 0)
+        flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
+    #endif
 
-    /*
-        1,1 --- 3,3
-         |       |
-         |       |
-        4,4 --- 2,2
-    */
-    if(src_rect == NULL)
-    {
-        // Scale tex coords according to actual texture dims
-        x1 = 0.0f;
-        y1 = 0.0f;
-        x2 = ((float)image->w)/tex_w;
-        y2 = ((float)image->h)/tex_h;
-        w = image->w;
-        h = image->h;
-    }
-    else
+    if(!use_instances)
     {
-        // Scale src_rect tex coords according to actual texture dims
-        x1 = src_rect->x/(float)tex_w;
-        y1 = src_rect->y/(float)tex_h;
-        x2 = (src_rect->x + src_rect->w)/(float)tex_w;
-        y2 = (src_rect->y + src_rect->h)/(float)tex_h;
-        w = src_rect->w;
-        h = src_rect->h;
+        // Make room for the whole batch up front if we can
+        growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + num_sprites*GPU_BLIT_BUFFER_VERTICES_PER_SPRITE);
+        #ifndef SDL_GPU_SKIP_BLIT_INDICES
+        growIndexBuffer(cdata, cdata->index_buffer_num_vertices + num_sprites*6);
+        #endif
     }
 
-    if(image->using_virtual_resolution)
-    {
-        // Scale texture coords to fit the original dims
-        x1 *= image->base_w/(float)image->w;
-        y1 *= image->base_h/(float)image->h;
-        x2 *= image->base_w/(float)image->w;
-        y2 *= image->base_h/(float)image->h;
-    }
+    // Everything that only depends on the source rect is worked out once per rect
+    num_rects = ((src_rects == NULL || num_src_rects == 0)? 1 : num_src_rects);
+    rect_table = rect_table_stack;
+    if(num_rects > GPU_TRANSFORM_BATCH_STACK_RECTS)
+        rect_table = (float*)SDL_malloc(num_rects*GPU_TRANSFORM_BATCH_RECT_FLOATS*sizeof(float));
 
-    // Create vertices about the anchor
-    dx1 = -pivot_x;
-    dy1 = -pivot_y;
-    dx2 = w - pivot_x;
-    dy2 = h - pivot_y;
+    tex_w = image->texture_w;
+    tex_h = image->texture_h;
 
-    if(image->snap_mode == GPU_SNAP_DIMENSIONS || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS)
+    for(i = 0; i < num_rects; i++)
     {
-        // This is a little weird for rotating sprites, but oh well.
-        float fractional;
-        fractional = w/2.0f - floorf(w/2.0f);
-        dx1 += fractional;
-        dx2 += fractional;
-        fractional = h/2.0f - floorf(h/2.0f);
-        dy1 += fractional;
-        dy2 += fractional;
-    }
+        float* rect = rect_table + i*GPU_TRANSFORM_BATCH_RECT_FLOATS;
+        float w, h;
 
-    if(renderer->coordinate_mode == 1)
-    {
-        float temp = dy1;
-        dy1 = dy2;
-        dy2 = temp;
-    }
+        if(src_rects == NULL || num_src_rects == 0)
+        {
+            rect[0] = 0.0f;
+            rect[1] = 0.0f;
+            rect[2] = ((float)image->w)/tex_w;
+            rect[3] = ((float)image->h)/tex_h;
+            w = image->w;
+            h = image->h;
+        }
+        else
+        {
+            rect[0] = src_rects[i].x/(float)tex_w;
+            rect[1] = src_rects[i].y/(float)tex_h;
+            rect[2] = (src_rects[i].x + src_rects[i].w)/(float)tex_w;
+            rect[3] = (src_rects[i].y + src_rects[i].h)/(float)tex_h;
+            w = src_rects[i].w;
+            h = src_rects[i].h;
+        }
 
-    // Apply transforms
+        if(image->using_virtual_resolution)
+        {
+            // Scale texture coords to fit the original dims
+            rect[0] *= image->base_w/(float)image->w;
+            rect[1] *= image->base_h/(float)image->h;
+            rect[2] *= image->base_w/(float)image->w;
+            rect[3] *= image->base_h/(float)image->h;
+        }
 
-    // Scale about the anchor
-    if(scaleX != 1.0f || scaleY != 1.0f)
-    {
-        dx1 *= scaleX;
-        dy1 *= scaleY;
-        dx2 *= scaleX;
-        dy2 *= scaleY;
+        // Quad about the image's anchor, like GPU_BlitTransform()
+        rect[4] = -w*image->anchor_x;
+        rect[5] = -h*image->anchor_y;
+        rect[6] = w - w*image->anchor_x;
+        rect[7] = h - h*image->anchor_y;
+
+        if(snap_dimensions)
+        {
+            float fractional;
+            fractional = w/2.0f - floorf(w/2.0f);
+            rect[4] += fractional;
+            rect[6] += fractional;
+            fractional = h/2.0f - floorf(h/2.0f);
+            rect[5] += fractional;
+            rect[7] += fractional;
+        }
+
+        rect[8] = w;
+        rect[9] = h;
+        rect[10] = -rect[4];
+        rect[11] = -rect[5];
+
+        if(renderer->coordinate_mode == 1)
+        {
+            float temp = rect[5];
+            rect[5] = rect[7];
+            rect[7] = temp;
+        }
     }
 
-    // Get extra vertices for rotation
-    dx3 = dx2;
-    dy3 = dy1;
-    dx4 = dx1;
-    dy4 = dy2;
+    mod_color = get_complete_mod_color(renderer, target, image);
+    r = mod_color.r/255.0f;
+    g = mod_color.g/255.0f;
+    b = mod_color.b/255.0f;
+    a = GET_ALPHA(mod_color)/255.0f;
 
-    // Rotate about the anchor
-    if(degrees != 0.0f)
+    for(start = 0; start < num_sprites; start += GPU_TRANSFORM_BATCH_CHUNK)
     {
-        float cosA = cosf(degrees*RAD_PER_DEG);
-        float sinA = sinf(degrees*RAD_PER_DEG);
-        float tempX = dx1;
-        dx1 = dx1*cosA - dy1*sinA;
-        dy1 = tempX*sinA + dy1*cosA;
-        tempX = dx2;
-        dx2 = dx2*cosA - dy2*sinA;
-        dy2 = tempX*sinA + dy2*cosA;
-        tempX = dx3;
-        dx3 = dx3*cosA - dy3*sinA;
-        dy3 = tempX*sinA + dy3*cosA;
-        tempX = dx4;
-        dx4 = dx4*cosA - dy4*sinA;
-        dy4 = tempX*sinA + dy4*cosA;
-    }
+        unsigned int count = num_sprites - start;
+        unsigned int n = 0;
+        if(count > GPU_TRANSFORM_BATCH_CHUNK)
+            count = GPU_TRANSFORM_BATCH_CHUNK;
 
-    // Translate to final position
-    dx1 += x;
-    dx2 += x;
-    dx3 += x;
-    dx4 += x;
-    dy1 += y;
-    dy2 += y;
-    dy3 += y;
-    dy4 += y;
+        // Gather this chunk into flat arrays
+        for(i = start; i < start + count; i++)
+        {
+            unsigned int rect_index = ((src_rects == NULL || src_rect_indices == NULL)? 0 : src_rect_indices[i]);
+            float* rect;
+            if(rect_index >= num_rects)
+            {
+                if(!bad_index)
+                    GPU_PushErrorCode("GPU_BlitTransformBatch", GPU_ERROR_USER_ERROR, "Source rect index %u is out of range (%u rects).  Skipping those sprites.", rect_index, num_rects);
+                bad_index = GPU_TRUE;
+                continue;
+            }
+
+            rect = rect_table + rect_index*GPU_TRANSFORM_BATCH_RECT_FLOATS;
+            chunk_x[n] = (snap_position? floorf(x[i]) : x[i]);
+            chunk_y[n] = (snap_position? floorf(y[i]) : y[i]);
+            chunk_degrees[n] = (degrees == NULL? 0.0f : degrees[i]);
+            chunk_scale_x[n] = (scale_x == NULL? 1.0f : scale_x[i]);
+            chunk_scale_y[n] = (scale_y == NULL? 1.0f : scale_y[i]);
+            chunk_left[n] = rect[4];
+            chunk_top[n] = rect[5];
+            chunk_right[n] = rect[6];
+            chunk_bottom[n] = rect[7];
+            chunk_rect[n] = rect;
+            chunk_sprite[n] = i;
+            n++;
+        }
+
+        #ifdef SDL_GPU_USE_INSTANCED_SPRITES
+        if(use_instances)
+        {
+            // The vertex shader does the transforms
+            for(i = 0; i < n; i++)
+            {
+                float* rect = chunk_rect[i];
+                addInstancedSprite(renderer, chunk_x[i], chunk_y[i], rect[8], rect[9], rect[10], rect[11], chunk_degrees[i], chunk_scale_x[i], chunk_scale_y[i],
+                                   rect[0], rect[1], rect[2], rect[3], (colors == NULL? mod_color : colors[chunk_sprite[i]]));
+            }
+            continue;
+        }
+        #endif
+
+        gpu_transform_quads(n, chunk_x, chunk_y, chunk_degrees, chunk_scale_x, chunk_scale_y, chunk_left, chunk_top, chunk_right, chunk_bottom, corners_x, corners_y);
+
+        for(i = 0; i < n; i++)
+        {
+            float* rect = chunk_rect[i];
+
+            if(cdata->blit_buffer_num_vertices + GPU_BLIT_BUFFER_VERTICES_PER_SPRITE >= cdata->blit_buffer_max_num_vertices)
+            {
+                flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL);
+                needs_record = GPU_TRUE;
+            }
+            #ifndef SDL_GPU_SKIP_BLIT_INDICES
+            if(cdata->index_buffer_num_vertices + 6 >= cdata->index_buffer_max_num_vertices)
+            {
+                flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL);
+                needs_record = GPU_TRUE;
+            }
+            #endif
+
+            // A flush emits the sorted batch, so the rest of the sprites start a new run
+            if(needs_record)
+            {
+                recordSortedDraw(renderer, target, image, GL_TRIANGLES);
+                needs_record = GPU_FALSE;
+            }
 
-    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+            if(colors != NULL)
+            {
+                SDL_Color color = colors[chunk_sprite[i]];
+                r = color.r/255.0f;
+                g = color.g/255.0f;
+                b = color.b/255.0f;
+                a = GET_ALPHA(color)/255.0f;
+            }
 
-    if(cdata->blit_buffer_num_vertices + 4 >= cdata->blit_buffer_max_num_vertices)
-    {
-        if(!growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + 4))
-            renderer->impl->FlushBlitBuffer(renderer);
-    }
-    if(cdata->index_buffer_num_vertices + 6 >= cdata->index_buffer_max_num_vertices)
-    {
-        if(!growIndexBuffer(cdata, cdata->index_buffer_num_vertices + 6))
-            renderer->impl->FlushBlitBuffer(renderer);
-    }
+            blit_buffer = cdata->blit_buffer;
+            index_buffer = cdata->index_buffer;
 
-    blit_buffer = cdata->blit_buffer;
-    index_buffer = cdata->index_buffer;
+            blit_buffer_starting_index = cdata->blit_buffer_num_vertices;
 
-    blit_buffer_starting_index = cdata->blit_buffer_num_vertices;
+            vert_index = GPU_BLIT_BUFFER_VERTEX_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+            tex_index = GPU_BLIT_BUFFER_TEX_COORD_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+            color_index = GPU_BLIT_BUFFER_COLOR_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
 
-    vert_index = GPU_BLIT_BUFFER_VERTEX_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
-    tex_index = GPU_BLIT_BUFFER_TEX_COORD_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
-    color_index = GPU_BLIT_BUFFER_COLOR_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+            SET_TEXTURED_VERTEX_UNINDEXED(corners_x[i], corners_y[i], rect[0], rect[1], r, g, b, a);
+            SET_TEXTURED_VERTEX_UNINDEXED(corners_x[n + i], corners_y[n + i], rect[2], rect[1], r, g, b, a);
+            SET_TEXTURED_VERTEX_UNINDEXED(corners_x[2*n + i], corners_y[2*n + i], rect[2], rect[3], r, g, b, a);
+            SET_TEXTURED_VERTEX_UNINDEXED(corners_x[3*n + i], corners_y[3*n + i], rect[0], rect[3], r, g, b, a);
 
-    if(target->use_color)
-    {
-        r = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.r, image->color.r);
-        g = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.g, image->color.g);
-        b = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.b, image->color.b);
-        a = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(GET_ALPHA(target->color), GET_ALPHA(image->color));
-    }
-    else
-    {
-        r = image->color.r/255.0f;
-        g = image->color.g/255.0f;
-        b = image->color.b/255.0f;
-        a = GET_ALPHA(image->color)/255.0f;
-    }
+            #ifndef SDL_GPU_SKIP_BLIT_INDICES
+            SET_INDEXED_VERTEX(0);
+            SET_INDEXED_VERTEX(1);
+            SET_INDEXED_VERTEX(2);
 
-    // 4 Quad vertices
-    SET_TEXTURED_VERTEX_UNINDEXED(dx1, dy1, x1, y1, r, g, b, a);
-    SET_TEXTURED_VERTEX_UNINDEXED(dx3, dy3, x2, y1, r, g, b, a);
-    SET_TEXTURED_VERTEX_UNINDEXED(dx2, dy2, x2, y2, r, g, b, a);
-    SET_TEXTURED_VERTEX_UNINDEXED(dx4, dy4, x1, y2, r, g, b, a);
+            SET_INDEXED_VERTEX(0);
+            SET_INDEXED_VERTEX(2);
+            SET_INDEXED_VERTEX(3);
+            #else
+            (void)index_buffer;
+            (void)blit_buffer_starting_index;
+            #endif
 
-    // 6 Triangle indices
-    SET_INDEXED_VERTEX(0);
-    SET_INDEXED_VERTEX(1);
-    SET_INDEXED_VERTEX(2);
+            cdata->blit_buffer_num_vertices += GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+        }
+    }
 
-    SET_INDEXED_VERTEX(0);
-    SET_INDEXED_VERTEX(2);
-    SET_INDEXED_VERTEX(3);
+    if(rect_table != rect_table_stack)
+        SDL_free(rect_table);
 
-    cdata->blit_buffer_num_vertices += GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+    (void)use_instances;
 }
 
 
@@ -4771,9 +7506,11 @@ static void refresh_attribute_data(GPU_CONTEXT_DATA* cdata)
     }
 }
 
-static void upload_attribute_data(GPU_CONTEXT_DATA* cdata, int num_vertices)
+// Returns the number of bytes uploaded
+static int upload_attribute_data(GPU_CONTEXT_DATA* cdata, int num_vertices)
 {
     int i;
+    int total_bytes = 0;
     for(i = 0; i < 16; i++)
     {
         GPU_AttributeSource* a = &cdata->shader_attributes[i];
@@ -4789,6 +7526,7 @@ static void upload_attribute_data(GPU_CONTEXT_DATA* cdata, int num_vertices)
 
             bytes_used = a->per_vertex_storage_stride_bytes * num_values_used;
             glBufferData(GL_ARRAY_BUFFER, bytes_used, a->next_value, GL_STREAM_DRAW);
+            total_bytes += bytes_used;
 
             glEnableVertexAttribArray(a->attribute.location);
             glVertexAttribPointer(a->attribute.location, a->attribute.format.num_elems_per_value, a->attribute.format.type, a->attribute.format.normalize, a->per_vertex_storage_stride_bytes, (void*)(intptr_t)a->per_vertex_storage_offset_bytes);
@@ -4802,6 +7540,7 @@ static void upload_attribute_data(GPU_CONTEXT_DATA* cdata, int num_vertices)
                 a->next_value = (void*)(((char*)a->next_value) + bytes_used);
         }
     }
+    return total_bytes;
 }
 
 static void disable_attribute_data(GPU_CONTEXT_DATA* cdata)
@@ -4820,9 +7559,9 @@ static void disable_attribute_data(GPU_CONTEXT_DATA* cdata)
 
 #endif
 
-static int get_lowest_attribute_num_values(GPU_CONTEXT_DATA* cdata, int cap)
+static unsigned int get_lowest_attribute_num_values(GPU_CONTEXT_DATA* cdata, unsigned int cap)
 {
-    int lowest = cap;
+    unsigned int lowest = cap;
 
 #ifdef SDL_GPU_USE_BUFFER_PIPELINE
     int i;
@@ -4831,8 +7570,10 @@ static int get_lowest_attribute_num_values(GPU_CONTEXT_DATA* cdata, int cap)
         GPU_AttributeSource* a = &cdata->shader_attributes[i];
         if(a->attribute.values != NULL && a->attribute.location >= 0)
         {
-            if(a->num_values < lowest)
-                lowest = a->num_values;
+            if(a->num_values <= 0)
+                lowest = 0;
+            else if((unsigned int)a->num_values < lowest)
+                lowest = (unsigned int)a->num_values;
         }
     }
 #else
@@ -4842,17 +7583,23 @@ static int get_lowest_attribute_num_values(GPU_CONTEXT_DATA* cdata, int cap)
     return lowest;
 }
 
-static_inline void submit_buffer_data(int bytes, float* values, int bytes_indices, unsigned short* indices)
+static_inline void submit_buffer_data(GPU_CONTEXT_DATA* cdata, int bytes, float* values, int bytes_indices, void* indices)
 {
     #ifdef SDL_GPU_USE_BUFFER_PIPELINE
-        #if defined(SDL_GPU_USE_BUFFER_RESET)
-        glBufferData(GL_ARRAY_BUFFER, bytes, values, GL_STREAM_DRAW);
-        if(indices != NULL)
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, bytes_indices, indices, GL_DYNAMIC_DRAW);
-        #elif defined(SDL_GPU_USE_BUFFER_MAPPING)
+    // Updates and mappings write into storage sized for the blit buffer, so bigger primitive batches have to reallocate it.
+    GPU_bool fits = (bytes <= (int)(GPU_BLIT_BUFFER_STRIDE * cdata->blit_buffer_max_num_vertices)
+                     && bytes_indices <= (int)(sizeof(GPU_BLIT_INDEX_TYPE) * cdata->index_buffer_max_num_vertices));
+    #ifdef SDL_GPU_HAS_BUFFER_MAPPING
+    if(fits && cdata->buffer_upload_method == GPU_BUFFER_UPLOAD_MAPPING)
+    {
         // NOTE: On the Raspberry Pi, you may have to use GL_DYNAMIC_DRAW instead of GL_STREAM_DRAW for buffers to work with glMapBuffer().
+        #ifdef SDL_GPU_USE_OPENGL
         float* data = (float*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-        unsigned short* data_i = (indices == NULL? NULL : (unsigned short*)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY));
+        void* data_i = (indices == NULL? NULL : glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY));
+        #else
+        float* data = (float*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        void* data_i = (indices == NULL? NULL : glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, bytes_indices, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+        #endif
         if(data != NULL)
         {
             memcpy(data, values, bytes);
@@ -4863,14 +7610,25 @@ static_inline void submit_buffer_data(int bytes, float* values, int bytes_indice
             memcpy(data_i, indices, bytes_indices);
             glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
         }
-        #elif defined(SDL_GPU_USE_BUFFER_UPDATE)
+    }
+    else
+    #endif
+    if(fits && cdata->buffer_upload_method == GPU_BUFFER_UPLOAD_UPDATE)
+    {
         glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, values);
         if(indices != NULL)
             glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, bytes_indices, indices);
-        #else
-            #error "SDL_gpu's VBO upload needs to choose SDL_GPU_USE_BUFFER_RESET, SDL_GPU_USE_BUFFER_MAPPING, or SDL_GPU_USE_BUFFER_UPDATE and none is defined!"
-        #endif
+    }
+    else
+    {
+        // GPU_BUFFER_UPLOAD_RESET.  The persistent ring only holds the blit buffer, so everything else is still uploaded like this.
+        // As a fallback for an oversized batch this only grows the storage, so the other methods keep working afterward.
+        glBufferData(GL_ARRAY_BUFFER, bytes, values, GL_STREAM_DRAW);
+        if(indices != NULL)
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, bytes_indices, indices, GL_DYNAMIC_DRAW);
+    }
 	#else
+	(void)cdata;
 	(void)indices;
     #endif
 }
@@ -4881,40 +7639,400 @@ static void SetAttributefv(GPU_Renderer* renderer, int location, int num_element
 #ifdef SDL_GPU_USE_BUFFER_PIPELINE
 static void gpu_upload_modelviewprojection(GPU_Target* dest, GPU_Context* context)
 {
-    if(context->current_shader_block.modelViewProjection_loc >= 0)
+    uploadModelViewProjection((GPU_CONTEXT_DATA*)context->data, dest, context->current_shader_program, context->current_shader_block.modelViewProjection_loc);
+}
+#endif
+
+
+static void doPrimitiveBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned int num_vertices, void* values, unsigned int num_indices, void* indices, GPU_bool use_32bit_indices, GPU_BatchFlagEnum flags);
+
+static void BeginCommandList(GPU_Renderer* renderer, GPU_Target* target)
+{
+    GPU_CONTEXT_DATA* cdata;
+    CommandListData* list;
+
+    if(target == NULL)
     {
-        float mvp[16];
-        
-        // MVP = P * V * M
-        
-        // P
-        GPU_MatrixCopy(mvp, GPU_GetTopMatrix(&dest->projection_matrix));
-        
-        
-        // V
-        if(dest->use_camera)
-        {
-            float cam_matrix[16];
-            get_camera_matrix(dest, cam_matrix);
-            
-            GPU_MultiplyAndAssign(mvp, cam_matrix);
-        }
-        else
+        GPU_PushErrorCode("GPU_BeginCommandList", GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+    if(renderer != target->renderer)
+    {
+        GPU_PushErrorCode("GPU_BeginCommandList", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+
+    makeContextCurrent(renderer, target);
+    if(renderer->current_context_target == NULL)
+    {
+        GPU_PushErrorCode("GPU_BeginCommandList", GPU_ERROR_USER_ERROR, "NULL context");
+        return;
+    }
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->sorted_batch != NULL && cdata->sorted_batch->target != NULL)
+    {
+        GPU_PushErrorCode("GPU_BeginCommandList", GPU_ERROR_USER_ERROR, "Can't record a command list during a sorted batch or another command list");
+        return;
+    }
+
+    renderer->impl->FlushBlitBuffer(renderer);
+
+    if(cdata->sorted_batch == NULL)
+    {
+        cdata->sorted_batch = (SortedBatchData*)SDL_malloc(sizeof(SortedBatchData));
+        memset(cdata->sorted_batch, 0, sizeof(SortedBatchData));
+    }
+
+    list = (CommandListData*)SDL_malloc(sizeof(CommandListData));
+    if(list == NULL)
+    {
+        GPU_PushErrorCode("GPU_BeginCommandList", GPU_ERROR_BACKEND_ERROR, "Failed to allocate command list");
+        return;
+    }
+    memset(list, 0, sizeof(CommandListData));
+    list->last_model = -1;
+
+    // Recording goes through the sorted batch, which hands its draws to the list instead of sorting them
+    cdata->sorted_batch->target = target;
+    cdata->sorted_batch->layer = 0;
+    cdata->sorted_batch->command_list = list;
+}
+
+static GPU_CommandList* EndCommandList(GPU_Renderer* renderer)
+{
+    GPU_CONTEXT_DATA* cdata;
+    SortedBatchData* batch;
+    GPU_CommandList* result;
+
+    if(renderer->current_context_target == NULL)
+        return NULL;
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    batch = cdata->sorted_batch;
+    if(batch == NULL || batch->command_list == NULL)
+        return NULL;
+
+    // Captures whatever is still buffered
+    renderer->impl->FlushBlitBuffer(renderer);
+
+    result = (GPU_CommandList*)SDL_malloc(sizeof(GPU_CommandList));
+    if(result == NULL)
+    {
+        GPU_PushErrorCode("GPU_EndCommandList", GPU_ERROR_BACKEND_ERROR, "Failed to allocate command list");
+        freeCommandListData(batch->command_list);
+    }
+    else
+    {
+        result->renderer = renderer;
+        result->data = batch->command_list;
+    }
+
+    batch->command_list = NULL;
+    batch->target = NULL;
+    return result;
+}
+
+static void ExecuteCommandList(GPU_Renderer* renderer, GPU_CommandList* list, GPU_Target* target, const float* transform)
+{
+    GPU_Context* context;
+    GPU_CONTEXT_DATA* cdata;
+    CommandListData* data;
+    SortedBatchData* batch;
+    unsigned int i, j;
+    Uint32 saved_program;
+    GPU_ShaderBlock saved_block;
+    GPU_bool saved_depth_test, saved_depth_write, saved_replaying;
+    GPU_ComparisonEnum saved_depth_function;
+    float base_model[16];
+    float model[16];
+
+    if(list == NULL)
+    {
+        GPU_PushErrorCode("GPU_ExecuteCommandList", GPU_ERROR_NULL_ARGUMENT, "list");
+        return;
+    }
+    if(target == NULL)
+    {
+        GPU_PushErrorCode("GPU_ExecuteCommandList", GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+    if(renderer != list->renderer || renderer != target->renderer)
+    {
+        GPU_PushErrorCode("GPU_ExecuteCommandList", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+
+    makeContextCurrent(renderer, target);
+    if(renderer->current_context_target == NULL)
+    {
+        GPU_PushErrorCode("GPU_ExecuteCommandList", GPU_ERROR_USER_ERROR, "NULL context");
+        return;
+    }
+
+    context = renderer->current_context_target->context;
+    cdata = (GPU_CONTEXT_DATA*)context->data;
+    if(cdata->sorted_batch != NULL && cdata->sorted_batch->command_list != NULL)
+    {
+        GPU_PushErrorCode("GPU_ExecuteCommandList", GPU_ERROR_USER_ERROR, "Can't execute a command list while recording one");
+        return;
+    }
+
+    if(!SetActiveTarget(renderer, target))
+    {
+        GPU_PushErrorCode("GPU_ExecuteCommandList", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+        return;
+    }
+
+    // The target's state is set up once for the whole list
+    prepareToRenderToTarget(renderer, target);
+    changeViewport(target);
+    changeCamera(target);
+    setClipRect(renderer, target);
+    renderer->impl->FlushBlitBuffer(renderer);
+
+    if(cdata->sorted_batch == NULL)
+    {
+        cdata->sorted_batch = (SortedBatchData*)SDL_malloc(sizeof(SortedBatchData));
+        memset(cdata->sorted_batch, 0, sizeof(SortedBatchData));
+    }
+    batch = cdata->sorted_batch;
+    data = (CommandListData*)list->data;
+
+    saved_program = context->current_shader_program;
+    saved_block = context->current_shader_block;
+    saved_depth_test = cdata->last_depth_test;
+    saved_depth_write = cdata->last_depth_write;
+    saved_depth_function = cdata->last_depth_function;
+    GPU_MatrixCopy(base_model, gpu_peek_top_matrix(&target->model_matrix));
+
+    // Draws go straight into the blit buffer, even into a target with an open sorted batch
+    saved_replaying = batch->replaying;
+    batch->replaying = GPU_TRUE;
+
+    for(i = 0; i < data->num_commands; i++)
+    {
+        RecordedCommand* command = &data->commands[i];
+        switch(command->type)
         {
-            GPU_MultiplyAndAssign(mvp, GPU_GetTopMatrix(&dest->view_matrix));
+        case COMMAND_MODEL:
+            if(transform != NULL)
+            {
+                GPU_MatrixMultiply(model, base_model, transform);
+                GPU_MultiplyAndAssign(model, (float*)(data->data + command->data_offset));
+            }
+            else
+                GPU_MatrixMultiply(model, base_model, (float*)(data->data + command->data_offset));
+            GPU_SetModel(model);
+            break;
+        case COMMAND_DRAW:
+            {
+                SortedDraw* draw = &command->draw;
+                GPU_BLIT_INDEX_TYPE base;
+
+                applySortedDrawState(renderer, draw);
+
+                if(cdata->blit_buffer_num_vertices + draw->num_vertices >= cdata->blit_buffer_max_num_vertices)
+                {
+                    if(!growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + draw->num_vertices))
+                        flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL);
+                }
+                if(cdata->index_buffer_num_vertices + draw->num_indices >= cdata->index_buffer_max_num_vertices)
+                {
+                    if(!growIndexBuffer(cdata, cdata->index_buffer_num_vertices + draw->num_indices))
+                        flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL);
+                }
+
+                base = (GPU_BLIT_INDEX_TYPE)cdata->blit_buffer_num_vertices;
+                memcpy(cdata->blit_buffer + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX,
+                       data->vertices + draw->first_vertex*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX, draw->num_vertices * GPU_BLIT_BUFFER_STRIDE);
+                for(j = 0; j < draw->num_indices; j++)
+                    cdata->index_buffer[cdata->index_buffer_num_vertices++] = base + data->indices[draw->first_index + j];
+                #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+                // The texture units are only known now
+                if(draw->image != NULL)
+                {
+                    float* slot = cdata->blit_buffer + base*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX + GPU_BLIT_BUFFER_TEX_SLOT_OFFSET;
+                    for(j = 0; j < draw->num_vertices; j++)
+                        slot[j*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX] = cdata->current_texture_slot;
+                }
+                #endif
+                cdata->blit_buffer_num_vertices += draw->num_vertices;
+            }
+            break;
+        case COMMAND_UNIFORM:
+            if(context->current_shader_program != command->shader_program)
+                renderer->impl->ActivateShaderProgram(renderer, command->shader_program, &command->shader_block);
+            switch(command->uniform_type)
+            {
+            case COMMAND_UNIFORM_INT:
+                renderer->impl->SetUniformiv(renderer, command->location, command->num_elements_per_value, command->num_values, (int*)(data->data + command->data_offset));
+                break;
+            case COMMAND_UNIFORM_UINT:
+                renderer->impl->SetUniformuiv(renderer, command->location, command->num_elements_per_value, command->num_values, (unsigned int*)(data->data + command->data_offset));
+                break;
+            case COMMAND_UNIFORM_FLOAT:
+                renderer->impl->SetUniformfv(renderer, command->location, command->num_elements_per_value, command->num_values, (float*)(data->data + command->data_offset));
+                break;
+            case COMMAND_UNIFORM_MATRIX:
+                renderer->impl->SetUniformMatrixfv(renderer, command->location, command->num_values, command->num_elements_per_value, command->num_columns, command->transpose, (float*)(data->data + command->data_offset));
+                break;
+            }
+            break;
+        case COMMAND_BATCH:
+            {
+                Uint8* bytes = data->data + command->data_offset;
+                unsigned int values_size = 0;
+                if(command->has_values)
+                    values_size = command->num_vertices * getBatchVertexSize(command->flags);
+
+                if(context->current_shader_program != command->shader_program)
+                    renderer->impl->ActivateShaderProgram(renderer, command->shader_program, &command->shader_block);
+                doPrimitiveBatch(renderer, command->image, target, command->primitive_type, command->num_vertices, (command->has_values? bytes : NULL),
+                                 command->num_indices, (command->has_indices? bytes + ((values_size + 7) & ~7u) : NULL), command->use_32bit_indices, command->flags);
+            }
+            break;
         }
-        
-        // M
-        GPU_MultiplyAndAssign(mvp, GPU_GetTopMatrix(&dest->model_matrix));
-        
-        glUniformMatrix4fv(context->current_shader_block.modelViewProjection_loc, 1, 0, mvp);
     }
+
+    flushBlitBufferFor(renderer, GPU_FLUSH_EXPLICIT);
+
+    // Put back the state that later draws expect
+    GPU_SetModel(base_model);
+    if(context->current_shader_program != saved_program)
+        renderer->impl->ActivateShaderProgram(renderer, saved_program, &saved_block);
+    changeDepthTest(renderer, saved_depth_test);
+    changeDepthWrite(renderer, saved_depth_write);
+    changeDepthFunction(renderer, saved_depth_function);
+
+    batch->replaying = saved_replaying;
+}
+
+static void FreeCommandList(GPU_Renderer* renderer, GPU_CommandList* list)
+{
+    CommandListData* data;
+    unsigned int i;
+
+    if(list == NULL)
+        return;
+
+    data = (CommandListData*)list->data;
+    for(i = 0; i < data->num_commands; i++)
+    {
+        GPU_Image* image = (data->commands[i].type == COMMAND_DRAW? data->commands[i].draw.image : data->commands[i].image);
+        if(image != NULL)
+            renderer->impl->FreeImage(renderer, image);
+    }
+
+    freeCommandListData(data);
+    SDL_free(list);
+}
+
+#ifndef SDL_GPU_DISABLE_SHADERS
+// Stores a uniform set in the command list being recorded.  Returns GPU_TRUE if it was recorded instead of set now.
+static GPU_bool recordUniform(GPU_Renderer* renderer, CommandUniformType type, int location, int num_elements_per_value, int num_columns, int num_values, GPU_bool transpose, const void* values, unsigned int size)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    SortedBatchData* batch = ((GPU_CONTEXT_DATA*)context->data)->sorted_batch;
+    RecordedCommand* command;
+    unsigned int offset;
+
+    if(batch == NULL || batch->command_list == NULL || batch->replaying)
+        return GPU_FALSE;
+
+    if(!addCommandData(batch->command_list, values, size, &offset))
+        return GPU_TRUE;
+    command = addCommand(batch->command_list, COMMAND_UNIFORM);
+    if(command == NULL)
+        return GPU_TRUE;
+
+    command->shader_program = context->current_shader_program;
+    command->shader_block = context->current_shader_block;
+    command->data_offset = offset;
+    command->uniform_type = type;
+    command->location = location;
+    command->num_elements_per_value = num_elements_per_value;
+    command->num_columns = num_columns;
+    command->num_values = num_values;
+    command->transpose = transpose;
+    return GPU_TRUE;
 }
 #endif
 
+static void recordPrimitiveBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned int num_vertices, void* values, unsigned int num_indices, void* indices, GPU_bool use_32bit_indices, GPU_BatchFlagEnum flags)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    CommandListData* list = ((GPU_CONTEXT_DATA*)context->data)->sorted_batch->command_list;
+    RecordedCommand* command;
+    unsigned int values_size = (values != NULL? num_vertices * getBatchVertexSize(flags) : 0);
+    unsigned int indices_size = (indices != NULL? num_indices * (use_32bit_indices? sizeof(unsigned int) : sizeof(unsigned short)) : 0);
+    unsigned int offset, indices_offset;
+
+    // Blits recorded before this draw first
+    flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
+    recordCommandModel(list, gpu_peek_top_matrix(&target->model_matrix));
+
+    if(!addCommandData(list, values, values_size, &offset) || !addCommandData(list, indices, indices_size, &indices_offset))
+        return;
+    command = addCommand(list, COMMAND_BATCH);
+    if(command == NULL)
+        return;
+
+    command->shader_program = context->current_shader_program;
+    command->shader_block = context->current_shader_block;
+    command->data_offset = offset;
+    command->image = image;
+    command->primitive_type = primitive_type;
+    command->flags = flags;
+    command->num_vertices = num_vertices;
+    command->num_indices = num_indices;
+    command->use_32bit_indices = use_32bit_indices;
+    command->has_values = (values != NULL);
+    command->has_indices = (indices != NULL);
+
+    // Keep the image alive for as long as the list
+    if(image != NULL)
+        image->refcount++;
+}
+
+// Sets up the state for drawing straight from a batch's own vertices, which don't go through the blit buffer.  Expects the context to be current.
+static GPU_bool prepareToRenderBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, const char* function)
+{
+    // Bind the texture to which subsequent calls refer
+    if(image != NULL)
+        bindTexture(renderer, image);
+
+    // Bind the FBO
+    if(!SetActiveTarget(renderer, target))
+    {
+        GPU_PushErrorCode(function, GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+        return GPU_FALSE;
+    }
+
+    prepareToRenderToTarget(renderer, target);
+    if(image != NULL)
+        prepareToRenderImage(renderer, target, image);
+    else
+        prepareToRenderShapes(renderer, primitive_type);
+    changeViewport(target);
+    changeCamera(target);
+
+    if(image != NULL)
+        changeTexturing(renderer, GPU_TRUE);
+
+    setClipRect(renderer, target);
 
-// Assumes the right format
-static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned short num_vertices, void* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags)
+    #ifdef SDL_GPU_APPLY_TRANSFORMS_TO_GL_STACK
+    if(!IsFeatureEnabled(renderer, GPU_FEATURE_VERTEX_SHADER))
+        applyTransforms(target);
+    #endif
+
+    flushBlitBufferFor(renderer, GPU_FLUSH_SHAPE_CHANGE);
+    return GPU_TRUE;
+}
+
+// Assumes the right format.  'indices' holds unsigned ints if use_32bit_indices is set, unsigned shorts otherwise.
+static void doPrimitiveBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned int num_vertices, void* values, unsigned int num_indices, void* indices, GPU_bool use_32bit_indices, GPU_BatchFlagEnum flags)
 {
     GPU_Context* context;
 	GPU_CONTEXT_DATA* cdata;
@@ -4922,13 +8040,17 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
 	intptr_t offset_texcoords, offset_colors;
 	int size_vertices, size_texcoords, size_colors;
 
-	GPU_bool using_texture = (image != NULL);
 	GPU_bool use_vertices = (flags & (GPU_BATCH_XY | GPU_BATCH_XYZ));
 	GPU_bool use_texcoords = (flags & GPU_BATCH_ST);
 	GPU_bool use_colors = (flags & (GPU_BATCH_RGB | GPU_BATCH_RGBA | GPU_BATCH_RGB8 | GPU_BATCH_RGBA8));
 	GPU_bool use_byte_colors = (flags & (GPU_BATCH_RGB8 | GPU_BATCH_RGBA8));
 	GPU_bool use_z = (flags & GPU_BATCH_XYZ);
 	GPU_bool use_a = (flags & (GPU_BATCH_RGBA | GPU_BATCH_RGBA8));
+	GLenum index_type = (use_32bit_indices? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT);
+	int index_size = (use_32bit_indices? sizeof(unsigned int) : sizeof(unsigned short));
+	#ifdef SDL_GPU_USE_BUFFER_PIPELINE
+	int attribute_bytes;
+	#endif
 
     if(num_vertices == 0)
         return;
@@ -4946,41 +8068,20 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
 
     makeContextCurrent(renderer, target);
 
-    // Bind the texture to which subsequent calls refer
-    if(using_texture)
-        bindTexture(renderer, image);
-
-    // Bind the FBO
-    if(!SetActiveTarget(renderer, target))
+    if(isRecordingSortedBatch(renderer->current_context_target->context, target)
+       && ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->sorted_batch->command_list != NULL)
     {
-        GPU_PushErrorCode("GPU_PrimitiveBatchX", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+        // Primitive batches aren't sorted, but a command list keeps them in order
+        recordPrimitiveBatch(renderer, image, target, primitive_type, num_vertices, values, num_indices, indices, use_32bit_indices, flags);
         return;
     }
 
-    prepareToRenderToTarget(renderer, target);
-    if(using_texture)
-        prepareToRenderImage(renderer, target, image);
-    else
-        prepareToRenderShapes(renderer, primitive_type);
-    changeViewport(target);
-    changeCamera(target);
-
-    if(using_texture)
-        changeTexturing(renderer, GPU_TRUE);
-
-    setClipRect(renderer, target);
-
-    #ifdef SDL_GPU_APPLY_TRANSFORMS_TO_GL_STACK
-    if(!IsFeatureEnabled(renderer, GPU_FEATURE_VERTEX_SHADER))
-        applyTransforms(target);
-    #endif
+    if(!prepareToRenderBatch(renderer, image, target, primitive_type, "GPU_PrimitiveBatchX"))
+        return;
 
-    
     context = renderer->current_context_target->context;
     cdata = (GPU_CONTEXT_DATA*)context->data;
 
-    renderer->impl->FlushBlitBuffer(renderer);
-
     if(cdata->index_buffer_num_vertices + num_indices >= cdata->index_buffer_max_num_vertices)
     {
         growBlitBuffer(cdata, cdata->index_buffer_num_vertices + num_indices);
@@ -5015,6 +8116,9 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
     if(indices == NULL)
         num_indices = num_vertices;
 
+    GPU_COUNT_FRAME_STAT(context, draw_calls, 1);
+    GPU_COUNT_FRAME_STAT(context, vertices, num_indices);
+
     (void)stride;
     (void)offset_texcoords;
     (void)offset_colors;
@@ -5102,7 +8206,7 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
         if(indices == NULL)
             glDrawArrays(primitive_type, 0, num_indices);
         else
-            glDrawElements(primitive_type, num_indices, GL_UNSIGNED_SHORT, indices);
+            glDrawElements(primitive_type, num_indices, index_type, indices);
 
         // Disable
         if(use_colors)
@@ -5133,8 +8237,10 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
             {
                 if(indices == NULL)
                     index = i*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+                else if(use_32bit_indices)
+                    index = ((unsigned int*)indices)[i]*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
                 else
-                    index = indices[i]*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+                    index = ((unsigned short*)indices)[i]*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
                 if(use_colors)
                 {
                     if(use_byte_colors)
@@ -5188,7 +8294,8 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
 
             // Copy the whole blit buffer to the GPU
-            submit_buffer_data(stride * num_vertices, values, sizeof(unsigned short)*num_indices, indices);  // Fills GPU buffer with data.
+            submit_buffer_data(cdata, stride * num_vertices, values, index_size*num_indices, indices);  // Fills GPU buffer with data.
+            GPU_COUNT_FRAME_STAT(context, bytes_uploaded, stride * num_vertices + (indices != NULL? index_size*num_indices : 0));
 
             // Specify the formatting of the blit buffer
             if(use_vertices)
@@ -5221,12 +8328,13 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
             }
         }
 
-        upload_attribute_data(cdata, num_indices);
+        attribute_bytes = upload_attribute_data(cdata, num_indices);
+        GPU_COUNT_FRAME_STAT(context, bytes_uploaded, attribute_bytes);
 
         if(indices == NULL)
             glDrawArrays(primitive_type, 0, num_indices);
         else
-            glDrawElements(primitive_type, num_indices, GL_UNSIGNED_SHORT, (void*)0);
+            glDrawElements(primitive_type, num_indices, index_type, (void*)0);
 
         // Disable the vertex arrays again
         if(use_vertices)
@@ -5249,67 +8357,350 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
     cdata->index_buffer_num_vertices = 0;
 
     unsetClipRect(renderer, target);
+
+    (void)index_type;
+    (void)index_size;
 }
 
-static void GenerateMipmaps(GPU_Renderer* renderer, GPU_Image* image)
+static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned short num_vertices, void* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags)
 {
-    #ifndef __IPHONEOS__
-    GLint filter;
-    if(image == NULL)
+    doPrimitiveBatch(renderer, image, target, primitive_type, num_vertices, values, num_indices, indices, GPU_FALSE, flags);
+}
+
+static void PrimitiveBatchV32(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned int num_vertices, void* values, unsigned int num_indices, unsigned int* indices, GPU_BatchFlagEnum flags)
+{
+    #ifdef SDL_GPU_USE_32BIT_INDICES
+    doPrimitiveBatch(renderer, image, target, primitive_type, num_vertices, values, num_indices, indices, GPU_TRUE, flags);
+    #else
+    // GL_UNSIGNED_INT indices are not guaranteed here, so narrow them.
+    unsigned short* short_indices = NULL;
+    unsigned int i;
+
+    if(num_vertices > 65536)
+    {
+        GPU_PushErrorCode("GPU_PrimitiveBatchV32", GPU_ERROR_UNSUPPORTED_FUNCTION, "This renderer only supports 16-bit indices (%u vertices given).", num_vertices);
         return;
+    }
 
-    if(image->target != NULL && isCurrentTarget(renderer, image->target))
-        renderer->impl->FlushBlitBuffer(renderer);
-    bindTexture(renderer, image);
-    glGenerateMipmapPROC(GL_TEXTURE_2D);
-    image->has_mipmaps = GPU_TRUE;
+    if(indices != NULL)
+    {
+        short_indices = (unsigned short*)SDL_malloc(num_indices * sizeof(unsigned short));
+        if(short_indices == NULL)
+        {
+            GPU_PushErrorCode("GPU_PrimitiveBatchV32", GPU_ERROR_BACKEND_ERROR, "Failed to allocate 16-bit indices");
+            return;
+        }
+        for(i = 0; i < num_indices; i++)
+            short_indices[i] = (unsigned short)indices[i];
+    }
 
-    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &filter);
-    if(filter == GL_LINEAR)
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+    doPrimitiveBatch(renderer, image, target, primitive_type, num_vertices, values, num_indices, short_indices, GPU_FALSE, flags);
+    SDL_free(short_indices);
+    #endif
+}
+
+typedef struct VertexBufferData
+{
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    GLuint VBO;
+    GLuint IBO;  // 0 if there are no indices
+    #endif
+    // Client-side copies, for the pipelines that draw from client memory
+    void* values;
+    void* indices;
+    GPU_bool use_32bit_indices;
+    unsigned int stride;
+} VertexBufferData;
+
+// True if this vertex buffer is drawn from client memory instead of GL buffer objects
+static GPU_bool usesClientVertexBuffer(GPU_Renderer* renderer)
+{
+    (void)renderer;
+    #if !defined(SDL_GPU_USE_BUFFER_PIPELINE)
+    return GPU_TRUE;
+    #elif defined(SDL_GPU_USE_BUFFER_PIPELINE_FALLBACK)
+    return !IsFeatureEnabled(renderer, GPU_FEATURE_VERTEX_SHADER);
+    #else
+    return GPU_FALSE;
     #endif
 }
 
+static GPU_VertexBuffer* CreateVertexBuffer(GPU_Renderer* renderer, GPU_BatchFlagEnum flags, unsigned int num_vertices, void* values, unsigned int num_indices, unsigned int* indices)
+{
+    GPU_VertexBuffer* result;
+    VertexBufferData* data;
+    void* index_data = indices;
+    GPU_bool use_32bit_indices = GPU_TRUE;
+    unsigned int index_size = sizeof(unsigned int);
+    unsigned int stride = getBatchVertexSize(flags);
+
+    if(stride == 0)
+    {
+        GPU_PushErrorCode("GPU_CreateVertexBuffer", GPU_ERROR_DATA_ERROR, "Flags give no vertex data");
+        return NULL;
+    }
+    if(indices == NULL)
+        num_indices = 0;
+
+    #ifndef SDL_GPU_USE_32BIT_INDICES
+    // GL_UNSIGNED_INT indices are not guaranteed here, so narrow them.
+    if(num_indices > 0)
+    {
+        unsigned int i;
+        if(num_vertices > 65536)
+        {
+            GPU_PushErrorCode("GPU_CreateVertexBuffer", GPU_ERROR_UNSUPPORTED_FUNCTION, "This renderer only supports 16-bit indices (%u vertices given).", num_vertices);
+            return NULL;
+        }
+
+        index_data = SDL_malloc(num_indices * sizeof(unsigned short));
+        for(i = 0; i < num_indices; i++)
+            ((unsigned short*)index_data)[i] = (unsigned short)indices[i];
+    }
+    use_32bit_indices = GPU_FALSE;
+    index_size = sizeof(unsigned short);
+    #endif
+
+    data = (VertexBufferData*)SDL_malloc(sizeof(VertexBufferData));
+    memset(data, 0, sizeof(VertexBufferData));
+    data->use_32bit_indices = use_32bit_indices;
+    data->stride = stride;
+
+    if(usesClientVertexBuffer(renderer))
+    {
+        data->values = SDL_malloc(num_vertices * stride);
+        if(values != NULL)
+            memcpy(data->values, values, num_vertices * stride);
+        else
+            memset(data->values, 0, num_vertices * stride);
+        if(num_indices > 0)
+        {
+            data->indices = SDL_malloc(num_indices * index_size);
+            memcpy(data->indices, index_data, num_indices * index_size);
+        }
+    }
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    else
+    {
+        glGenBuffers(1, &data->VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, data->VBO);
+        glBufferData(GL_ARRAY_BUFFER, num_vertices * stride, values, GL_STATIC_DRAW);
+        GPU_COUNT_FRAME_STAT(renderer->current_context_target->context, bytes_uploaded, (values != NULL? num_vertices * stride : 0));
+
+        if(num_indices > 0)
+        {
+            // The blit VAO gets its own IBO back when it's next used
+            #if !defined(SDL_GPU_NO_VAO)
+            glBindVertexArray(0);
+            #endif
+            glGenBuffers(1, &data->IBO);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data->IBO);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, num_indices * index_size, index_data, GL_STATIC_DRAW);
+            GPU_COUNT_FRAME_STAT(renderer->current_context_target->context, bytes_uploaded, num_indices * index_size);
+        }
+    }
+    #endif
 
+    if(index_data != indices)
+        SDL_free(index_data);
 
+    result = (GPU_VertexBuffer*)SDL_malloc(sizeof(GPU_VertexBuffer));
+    result->renderer = renderer;
+    result->flags = flags;
+    result->num_vertices = num_vertices;
+    result->num_indices = num_indices;
+    result->data = data;
+    return result;
+}
 
-static GPU_Rect SetClip(GPU_Renderer* renderer, GPU_Target* target, Sint16 x, Sint16 y, Uint16 w, Uint16 h)
+static void UpdateVertexBuffer(GPU_Renderer* renderer, GPU_VertexBuffer* buffer, unsigned int first_vertex, unsigned int num_vertices, void* values)
 {
-	GPU_Rect r;
-    if(target == NULL)
+    VertexBufferData* data = (VertexBufferData*)buffer->data;
+    (void)renderer;
+
+    if(data->values != NULL)
     {
-        r.x = r.y = r.w = r.h = 0;
-        return r;
+        memcpy((Uint8*)data->values + first_vertex * data->stride, values, num_vertices * data->stride);
+        return;
     }
 
-    if(isCurrentTarget(renderer, target))
-        renderer->impl->FlushBlitBuffer(renderer);
-    target->use_clip_rect = GPU_TRUE;
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    glBindBuffer(GL_ARRAY_BUFFER, data->VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, first_vertex * data->stride, num_vertices * data->stride, values);
+    if(renderer->current_context_target != NULL)
+        GPU_COUNT_FRAME_STAT(renderer->current_context_target->context, bytes_uploaded, num_vertices * data->stride);
+    #endif
+}
+
+static void DrawVertexBuffer(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_VertexBuffer* buffer, GPU_PrimitiveEnum primitive_type, unsigned int first, unsigned int count)
+{
+    VertexBufferData* data = (VertexBufferData*)buffer->data;
+    unsigned int index_size = (data->use_32bit_indices? sizeof(unsigned int) : sizeof(unsigned short));
+
+    if((image != NULL && renderer != image->renderer) || renderer != target->renderer || renderer != buffer->renderer)
+    {
+        GPU_PushErrorCode("GPU_DrawVertexBuffer", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+
+    if(data->values != NULL)
+    {
+        // Nothing to keep on the GPU, so it's a primitive batch
+        if(buffer->num_indices > 0)
+            doPrimitiveBatch(renderer, image, target, primitive_type, buffer->num_vertices, data->values, count, (Uint8*)data->indices + first*index_size, data->use_32bit_indices, buffer->flags);
+        else
+            doPrimitiveBatch(renderer, image, target, primitive_type, count, (Uint8*)data->values + first*data->stride, 0, NULL, data->use_32bit_indices, buffer->flags);
+        return;
+    }
+
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    {
+        GPU_Context* context;
+        GPU_CONTEXT_DATA* cdata;
+        GPU_BatchFlagEnum flags = buffer->flags;
+        GPU_bool use_vertices = (flags & (GPU_BATCH_XY | GPU_BATCH_XYZ));
+        GPU_bool use_texcoords = (flags & GPU_BATCH_ST);
+        GPU_bool use_colors = (flags & (GPU_BATCH_RGB | GPU_BATCH_RGBA | GPU_BATCH_RGB8 | GPU_BATCH_RGBA8));
+        GPU_bool use_byte_colors = (flags & (GPU_BATCH_RGB8 | GPU_BATCH_RGBA8));
+        int size_vertices = ((flags & GPU_BATCH_XYZ)? 3 : ((flags & GPU_BATCH_XY)? 2 : 0));
+        int size_texcoords = (use_texcoords? 2 : 0);
+        int size_colors = ((flags & (GPU_BATCH_RGBA | GPU_BATCH_RGBA8))? 4 : 3);
+        intptr_t offset_texcoords = size_vertices * sizeof(float);
+        intptr_t offset_colors = (size_vertices + size_texcoords) * sizeof(float);
+        int attribute_bytes;
+
+        makeContextCurrent(renderer, target);
+        if(isRecordingSortedBatch(renderer->current_context_target->context, target)
+           && ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->sorted_batch->command_list != NULL)
+        {
+            GPU_PushErrorCode("GPU_DrawVertexBuffer", GPU_ERROR_USER_ERROR, "Vertex buffers can't be recorded into a command list");
+            return;
+        }
+        if(!prepareToRenderBatch(renderer, image, target, primitive_type, "GPU_DrawVertexBuffer"))
+            return;
+
+        context = renderer->current_context_target->context;
+        cdata = (GPU_CONTEXT_DATA*)context->data;
+
+        GPU_COUNT_FRAME_STAT(context, draw_calls, 1);
+        GPU_COUNT_FRAME_STAT(context, vertices, count);
+
+        // Skip attributes that have no location
+        if(context->current_shader_block.position_loc < 0)
+            use_vertices = GPU_FALSE;
+        if(context->current_shader_block.texcoord_loc < 0)
+            use_texcoords = GPU_FALSE;
+        if(context->current_shader_block.color_loc < 0)
+            use_colors = GPU_FALSE;
+
+        #if !defined(SDL_GPU_NO_VAO)
+        glBindVertexArray(cdata->blit_VAO);
+        #endif
+
+        gpu_upload_modelviewprojection(target, context);
+
+        // Only the attribute pointers change.  The data is already there.
+        glBindBuffer(GL_ARRAY_BUFFER, data->VBO);
+        if(data->IBO != 0)
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data->IBO);
+
+        if(use_vertices)
+        {
+            glEnableVertexAttribArray(context->current_shader_block.position_loc);
+            glVertexAttribPointer(context->current_shader_block.position_loc, size_vertices, GL_FLOAT, GL_FALSE, data->stride, 0);
+        }
+        if(use_texcoords)
+        {
+            glEnableVertexAttribArray(context->current_shader_block.texcoord_loc);
+            glVertexAttribPointer(context->current_shader_block.texcoord_loc, size_texcoords, GL_FLOAT, GL_FALSE, data->stride, (void*)(offset_texcoords));
+        }
+        if(use_colors)
+        {
+            glEnableVertexAttribArray(context->current_shader_block.color_loc);
+            if(use_byte_colors)
+                glVertexAttribPointer(context->current_shader_block.color_loc, size_colors, GL_UNSIGNED_BYTE, GL_TRUE, data->stride, (void*)(offset_colors));
+            else
+                glVertexAttribPointer(context->current_shader_block.color_loc, size_colors, GL_FLOAT, GL_FALSE, data->stride, (void*)(offset_colors));
+        }
+        else
+        {
+            SDL_Color color = get_complete_mod_color(renderer, target, image);
+            float default_color[4] = {color.r/255.0f, color.g/255.0f, color.b/255.0f, GET_ALPHA(color)/255.0f};
+            SetAttributefv(renderer, context->current_shader_block.color_loc, 4, default_color);
+        }
+
+        attribute_bytes = upload_attribute_data(cdata, count);
+        GPU_COUNT_FRAME_STAT(context, bytes_uploaded, attribute_bytes);
+
+        if(data->IBO != 0)
+            glDrawElements(primitive_type, count, (data->use_32bit_indices? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT), (void*)(intptr_t)(first*index_size));
+        else
+            glDrawArrays(primitive_type, first, count);
+
+        if(use_vertices)
+            glDisableVertexAttribArray(context->current_shader_block.position_loc);
+        if(use_texcoords)
+            glDisableVertexAttribArray(context->current_shader_block.texcoord_loc);
+        if(use_colors)
+            glDisableVertexAttribArray(context->current_shader_block.color_loc);
 
-    r = target->clip_rect;
+        disable_attribute_data(cdata);
 
-    target->clip_rect.x = x;
-    target->clip_rect.y = y;
-    target->clip_rect.w = w;
-    target->clip_rect.h = h;
+        #if !defined(SDL_GPU_NO_VAO)
+        glBindVertexArray(0);
+        #endif
 
-    return r;
+        unsetClipRect(renderer, target);
+    }
+    #endif
 }
 
-static void UnsetClip(GPU_Renderer* renderer, GPU_Target* target)
+static void FreeVertexBuffer(GPU_Renderer* renderer, GPU_VertexBuffer* buffer)
 {
-    if(target == NULL)
+    VertexBufferData* data = (VertexBufferData*)buffer->data;
+
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    if(renderer->current_context_target != NULL)
+    {
+        if(data->VBO != 0)
+            glDeleteBuffers(1, &data->VBO);
+        if(data->IBO != 0)
+            glDeleteBuffers(1, &data->IBO);
+    }
+    #endif
+    (void)renderer;
+
+    SDL_free(data->values);
+    SDL_free(data->indices);
+    SDL_free(data);
+    SDL_free(buffer);
+}
+
+static void GenerateMipmaps(GPU_Renderer* renderer, GPU_Image* image)
+{
+    #ifndef __IPHONEOS__
+    GLint filter;
+    if(image == NULL)
         return;
 
-    if(isCurrentTarget(renderer, target))
-        renderer->impl->FlushBlitBuffer(renderer);
-    // Leave the clip rect values intact so they can still be useful as storage
-    target->use_clip_rect = GPU_FALSE;
+    if(image->target != NULL && isCurrentTarget(renderer, image->target))
+        flushBlitBufferFor(renderer, GPU_FLUSH_TEXTURE_CHANGE);
+    bindTexture(renderer, image);
+    glGenerateMipmapPROC(GL_TEXTURE_2D);
+    image->has_mipmaps = GPU_TRUE;
+
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &filter);
+    if(filter == GL_LINEAR)
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+    #endif
 }
 
 
 
 
+
+
+
 static void swizzle_for_format(SDL_Color* color, GLenum format, unsigned char pixel[4])
 {
     switch(format)
@@ -5384,7 +8775,7 @@ static SDL_Color GetPixel(GPU_Renderer* renderer, GPU_Target* target, Sint16 x,
         return result;
 
     if(isCurrentTarget(renderer, target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_READBACK);
     if(SetActiveTarget(renderer, target))
     {
         unsigned char pixels[4];
@@ -5394,7 +8785,79 @@ static SDL_Color GetPixel(GPU_Renderer* renderer, GPU_Target* target, Sint16 x,
         swizzle_for_format(&result, format, pixels);
     }
 
-    return result;
+    return result;
+}
+
+// Reads the bounding box of the points in one go, so there is only one sync point
+static void GetPixels(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_points, const Sint16* points, SDL_Color* colors)
+{
+    SDL_Color blank = {0,0,0,0};
+    GLenum format;
+    unsigned char* pixels;
+    int bytes_per_pixel, pitch;
+    int min_x, min_y, max_x, max_y;
+    int x, y;
+    unsigned int i;
+    GPU_bool found = GPU_FALSE;
+
+    for(i = 0; i < num_points; i++)
+        colors[i] = blank;
+    if(target == NULL || renderer != target->renderer)
+        return;
+
+    min_x = min_y = max_x = max_y = 0;
+    for(i = 0; i < num_points; i++)
+    {
+        x = points[2*i];
+        y = points[2*i+1];
+        // Same bounds as GetPixel()
+        if(x < 0 || y < 0 || x >= target->w || y >= target->h)
+            continue;
+
+        if(!found || x < min_x)
+            min_x = x;
+        if(!found || y < min_y)
+            min_y = y;
+        if(!found || x > max_x)
+            max_x = x;
+        if(!found || y > max_y)
+            max_y = y;
+        found = GPU_TRUE;
+    }
+    if(!found)
+        return;
+
+    if(isCurrentTarget(renderer, target))
+        flushBlitBufferFor(renderer, GPU_FLUSH_READBACK);
+    if(!SetActiveTarget(renderer, target))
+        return;
+
+    format = ((GPU_TARGET_DATA*)target->data)->format;
+    bytes_per_pixel = 4;
+    if(target->image != NULL)
+        bytes_per_pixel = target->image->bytes_per_pixel;
+    pitch = (max_x - min_x + 1)*bytes_per_pixel;
+
+    // swizzle_for_format() reads 4 bytes, so there is room past the last pixel
+    pixels = (unsigned char*)SDL_malloc(pitch*(max_y - min_y + 1) + 4);
+    if(pixels == NULL)
+        return;
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(min_x, min_y, max_x - min_x + 1, max_y - min_y + 1, format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    for(i = 0; i < num_points; i++)
+    {
+        x = points[2*i];
+        y = points[2*i+1];
+        if(x < 0 || y < 0 || x >= target->w || y >= target->h)
+            continue;
+
+        swizzle_for_format(&colors[i], format, pixels + (y - min_y)*pitch + (x - min_x)*bytes_per_pixel);
+    }
+
+    SDL_free(pixels);
 }
 
 static void SetImageFilter(GPU_Renderer* renderer, GPU_Image* image, GPU_FilterEnum filter)
@@ -5517,12 +8980,6 @@ static void SetWrapMode(GPU_Renderer* renderer, GPU_Image* image, GPU_WrapEnum w
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_y );
 }
 
-static GPU_TextureHandle GetTextureHandle(GPU_Renderer* renderer, GPU_Image* image)
-{
-	(void)renderer;
-    return ((GPU_IMAGE_DATA*)image->data)->handle;
-}
-
 
 
 static void ClearRGBA(GPU_Renderer* renderer, GPU_Target* target, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
@@ -5547,11 +9004,30 @@ static void ClearRGBA(GPU_Renderer* renderer, GPU_Target* target, Uint8 r, Uint8
     }
 }
 
-static void DoPartialFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Context* context, unsigned short num_vertices, float* blit_buffer, unsigned int num_indices, unsigned short* index_buffer)
+#ifdef SDL_GPU_USE_BUFFER_PIPELINE
+// Draws from the bound IBO.  'offset' is where the blit buffer starts in the bound VBO.  Flush VAOs point at the start of the VBO, so they reach it with a base vertex instead.
+static_inline void drawBlitBufferElements(GLenum shape, unsigned int num_indices, size_t offset)
+{
+    #if defined(SDL_GPU_USE_FLUSH_VAOS) && defined(SDL_GPU_USE_BUFFER_PERSISTENT)
+    if(offset > 0)
+    {
+        glDrawElementsBaseVertex(shape, num_indices, GPU_BLIT_INDEX_GL_TYPE, (void*)0, (GLint)(offset / GPU_BLIT_BUFFER_STRIDE));
+        return;
+    }
+    #endif
+    (void)offset;
+    glDrawElements(shape, num_indices, GPU_BLIT_INDEX_GL_TYPE, (void*)0);
+}
+#endif
+
+static void DoPartialFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Context* context, unsigned int num_vertices, float* blit_buffer, unsigned int num_indices, GPU_BLIT_INDEX_TYPE* index_buffer)
 {
     GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
 	(void)renderer;
     (void)num_vertices;
+
+    GPU_COUNT_FRAME_STAT(context, draw_calls, 1);
+    GPU_COUNT_FRAME_STAT(context, vertices, num_vertices);
 #ifdef SDL_GPU_USE_ARRAY_PIPELINE
     glEnableClientState(GL_VERTEX_ARRAY);
     glEnableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -5561,7 +9037,7 @@ static void DoPartialFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Context
     glTexCoordPointer(2, GL_FLOAT, GPU_BLIT_BUFFER_STRIDE, blit_buffer + GPU_BLIT_BUFFER_TEX_COORD_OFFSET);
     glColorPointer(4, GL_FLOAT, GPU_BLIT_BUFFER_STRIDE, blit_buffer + GPU_BLIT_BUFFER_COLOR_OFFSET);
 
-    glDrawElements(cdata->last_shape, num_indices, GL_UNSIGNED_SHORT, index_buffer);
+    glDrawElements(cdata->last_shape, num_indices, GPU_BLIT_INDEX_GL_TYPE, index_buffer);
 
     glDisableClientState(GL_COLOR_ARRAY);
     glDisableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -5576,7 +9052,7 @@ static void DoPartialFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Context
 #endif
 #ifdef SDL_GPU_USE_FIXED_FUNCTION_PIPELINE
     {
-        unsigned short i;
+        unsigned int i;
         unsigned int index;
         float* vertex_pointer = blit_buffer + GPU_BLIT_BUFFER_VERTEX_OFFSET;
         float* texcoord_pointer = blit_buffer + GPU_BLIT_BUFFER_TEX_COORD_OFFSET;
@@ -5600,42 +9076,82 @@ static void DoPartialFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Context
 
 #ifdef SDL_GPU_USE_BUFFER_PIPELINE
         {
-            // Update the vertex array object's buffers
-            #if !defined(SDL_GPU_NO_VAO)
-            glBindVertexArray(cdata->blit_VAO);
+            // Where the vertices start in the bound VBO
+            size_t offset = 0;
+            unsigned int vbo;
+            int attribute_bytes;
+            int texture_slot_loc = -1;
+            #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+            // Only the default textured shader reads the texture unit of each vertex
+            if(cdata->texture_slot_loc >= 0 && context->current_shader_program == context->default_textured_shader_program)
+                texture_slot_loc = cdata->texture_slot_loc;
             #endif
 
-            gpu_upload_modelviewprojection(dest, context);
+            #ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+            if(cdata->use_persistent_buffer)
+            {
+                // The vertices are already in the mapped ring
+                vbo = cdata->persistent_VBO;
+                offset = (char*)blit_buffer - (char*)cdata->persistent_buffer;
+            }
+            else
+            #endif
+            {
+                vbo = cdata->blit_VBO[cdata->blit_VBO_flop];
+                cdata->blit_VBO_flop = !cdata->blit_VBO_flop;
+            }
 
-            // Upload blit buffer to a single buffer object
-            glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[cdata->blit_VBO_flop]);
-            cdata->blit_VBO_flop = !cdata->blit_VBO_flop;
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
+            // Sprites are all quads, so the prebuilt indices cover them and only the vertices need uploading
+            #ifdef SDL_GPU_USE_FLUSH_VAOS
+            bindFlushVAO(cdata, context->current_shader_block.position_loc, context->current_shader_block.texcoord_loc, context->current_shader_block.color_loc, texture_slot_loc, vbo, cdata->blit_quad_IBO);
+            #else
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->blit_quad_IBO);
+            #endif
 
-            // Copy the whole blit buffer to the GPU
-            submit_buffer_data(GPU_BLIT_BUFFER_STRIDE * num_vertices, blit_buffer, sizeof(unsigned short)*num_indices, index_buffer);  // Fills GPU buffer with data.
+            gpu_upload_modelviewprojection(dest, context);
+
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            #ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+            if(!cdata->use_persistent_buffer)
+            #endif
+            {
+                // Copy the whole blit buffer to the GPU
+                submit_buffer_data(cdata, GPU_BLIT_BUFFER_STRIDE * num_vertices, blit_buffer, 0, NULL);  // Fills GPU buffer with data.
+            }
 
+            #ifndef SDL_GPU_USE_FLUSH_VAOS
             // Specify the formatting of the blit buffer
             if(context->current_shader_block.position_loc >= 0)
             {
                 glEnableVertexAttribArray(context->current_shader_block.position_loc);  // Tell GL to use client-side attribute data
-                glVertexAttribPointer(context->current_shader_block.position_loc, 2, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, 0);  // Tell how the data is formatted
+                glVertexAttribPointer(context->current_shader_block.position_loc, 2, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)offset);  // Tell how the data is formatted
             }
             if(context->current_shader_block.texcoord_loc >= 0)
             {
                 glEnableVertexAttribArray(context->current_shader_block.texcoord_loc);
-                glVertexAttribPointer(context->current_shader_block.texcoord_loc, 2, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)(GPU_BLIT_BUFFER_TEX_COORD_OFFSET * sizeof(float)));
+                glVertexAttribPointer(context->current_shader_block.texcoord_loc, 2, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)(offset + GPU_BLIT_BUFFER_TEX_COORD_OFFSET * sizeof(float)));
             }
             if(context->current_shader_block.color_loc >= 0)
             {
                 glEnableVertexAttribArray(context->current_shader_block.color_loc);
-                glVertexAttribPointer(context->current_shader_block.color_loc, 4, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)(GPU_BLIT_BUFFER_COLOR_OFFSET * sizeof(float)));
+                glVertexAttribPointer(context->current_shader_block.color_loc, 4, GPU_BLIT_BUFFER_COLOR_GL_TYPE, GPU_BLIT_BUFFER_COLOR_NORMALIZED, GPU_BLIT_BUFFER_STRIDE, (void*)(offset + GPU_BLIT_BUFFER_COLOR_OFFSET * sizeof(float)));
             }
+            #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+            if(texture_slot_loc >= 0)
+            {
+                glEnableVertexAttribArray(texture_slot_loc);
+                glVertexAttribPointer(texture_slot_loc, 1, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)(offset + GPU_BLIT_BUFFER_TEX_SLOT_OFFSET * sizeof(float)));
+            }
+            #endif
+            #endif
+            (void)texture_slot_loc;
 
-            upload_attribute_data(cdata, num_vertices);
+            attribute_bytes = upload_attribute_data(cdata, num_vertices);
+            GPU_COUNT_FRAME_STAT(context, bytes_uploaded, GPU_BLIT_BUFFER_STRIDE * num_vertices + attribute_bytes);
 
-            glDrawElements(cdata->last_shape, num_indices, GL_UNSIGNED_SHORT, (void*)0);
+            drawBlitBufferElements(cdata->last_shape, num_indices, offset);
 
+            #ifndef SDL_GPU_USE_FLUSH_VAOS
             // Disable the vertex arrays again
             if(context->current_shader_block.position_loc >= 0)
                 glDisableVertexAttribArray(context->current_shader_block.position_loc);
@@ -5643,6 +9159,11 @@ static void DoPartialFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Context
                 glDisableVertexAttribArray(context->current_shader_block.texcoord_loc);
             if(context->current_shader_block.color_loc >= 0)
                 glDisableVertexAttribArray(context->current_shader_block.color_loc);
+            #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+            if(texture_slot_loc >= 0)
+                glDisableVertexAttribArray(texture_slot_loc);
+            #endif
+            #endif
 
             disable_attribute_data(cdata);
 
@@ -5653,11 +9174,14 @@ static void DoPartialFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Context
 #endif
 }
 
-static void DoUntexturedFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Context* context, unsigned short num_vertices, float* blit_buffer, unsigned int num_indices, unsigned short* index_buffer)
+static void DoUntexturedFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Context* context, unsigned int num_vertices, float* blit_buffer, unsigned int num_indices, GPU_BLIT_INDEX_TYPE* index_buffer)
 {
     GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
 	(void)renderer;
     (void)num_vertices;
+
+    GPU_COUNT_FRAME_STAT(context, draw_calls, 1);
+    GPU_COUNT_FRAME_STAT(context, vertices, num_vertices);
 #ifdef SDL_GPU_USE_ARRAY_PIPELINE
     glEnableClientState(GL_VERTEX_ARRAY);
     glEnableClientState(GL_COLOR_ARRAY);
@@ -5665,7 +9189,7 @@ static void DoUntexturedFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Cont
     glVertexPointer(2, GL_FLOAT, GPU_BLIT_BUFFER_STRIDE, blit_buffer + GPU_BLIT_BUFFER_VERTEX_OFFSET);
     glColorPointer(4, GL_FLOAT, GPU_BLIT_BUFFER_STRIDE, blit_buffer + GPU_BLIT_BUFFER_COLOR_OFFSET);
 
-    glDrawElements(cdata->last_shape, num_indices, GL_UNSIGNED_SHORT, index_buffer);
+    glDrawElements(cdata->last_shape, num_indices, GPU_BLIT_INDEX_GL_TYPE, index_buffer);
 
     glDisableClientState(GL_COLOR_ARRAY);
     glDisableClientState(GL_VERTEX_ARRAY);
@@ -5677,7 +9201,7 @@ static void DoUntexturedFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Cont
 #endif
 #ifdef SDL_GPU_USE_FIXED_FUNCTION_PIPELINE
     {
-        unsigned short i;
+        unsigned int i;
         unsigned int index;
         float* vertex_pointer = blit_buffer + GPU_BLIT_BUFFER_VERTEX_OFFSET;
         float* color_pointer = blit_buffer + GPU_BLIT_BUFFER_COLOR_OFFSET;
@@ -5697,42 +9221,73 @@ static void DoUntexturedFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Cont
 
 #ifdef SDL_GPU_USE_BUFFER_PIPELINE
     {
-        // Update the vertex array object's buffers
-        #if !defined(SDL_GPU_NO_VAO)
-        glBindVertexArray(cdata->blit_VAO);
-        #endif
+        // Where the vertices start in the bound VBO
+        size_t offset = 0;
+        unsigned int vbo;
+        int attribute_bytes;
 
-        gpu_upload_modelviewprojection(dest, context);
+        #ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+        if(cdata->use_persistent_buffer)
+        {
+            // The vertices are already in the mapped ring
+            vbo = cdata->persistent_VBO;
+            offset = (char*)blit_buffer - (char*)cdata->persistent_buffer;
+        }
+        else
+        #endif
+        {
+            vbo = cdata->blit_VBO[cdata->blit_VBO_flop];
+            cdata->blit_VBO_flop = !cdata->blit_VBO_flop;
+        }
 
-        // Upload blit buffer to a single buffer object
-        glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[cdata->blit_VBO_flop]);
-        cdata->blit_VBO_flop = !cdata->blit_VBO_flop;
+        #ifdef SDL_GPU_USE_FLUSH_VAOS
+        bindFlushVAO(cdata, context->current_shader_block.position_loc, -1, context->current_shader_block.color_loc, -1, vbo, cdata->blit_IBO);
+        #else
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
+        #endif
+
+        gpu_upload_modelviewprojection(dest, context);
 
-        // Copy the whole blit buffer to the GPU
-        submit_buffer_data(GPU_BLIT_BUFFER_STRIDE * num_vertices, blit_buffer, sizeof(unsigned short)*num_indices, index_buffer);  // Fills GPU buffer with data.
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        #ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+        if(cdata->use_persistent_buffer)
+        {
+            // Only the indices need uploading
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GPU_BLIT_INDEX_TYPE)*num_indices, index_buffer, GL_DYNAMIC_DRAW);
+        }
+        else
+        #endif
+        {
+            // Copy the whole blit buffer to the GPU
+            submit_buffer_data(cdata, GPU_BLIT_BUFFER_STRIDE * num_vertices, blit_buffer, sizeof(GPU_BLIT_INDEX_TYPE)*num_indices, index_buffer);  // Fills GPU buffer with data.
+        }
 
+        #ifndef SDL_GPU_USE_FLUSH_VAOS
         // Specify the formatting of the blit buffer
         if(context->current_shader_block.position_loc >= 0)
         {
             glEnableVertexAttribArray(context->current_shader_block.position_loc);  // Tell GL to use client-side attribute data
-            glVertexAttribPointer(context->current_shader_block.position_loc, 2, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, 0);  // Tell how the data is formatted
+            glVertexAttribPointer(context->current_shader_block.position_loc, 2, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)offset);  // Tell how the data is formatted
         }
         if(context->current_shader_block.color_loc >= 0)
         {
             glEnableVertexAttribArray(context->current_shader_block.color_loc);
-            glVertexAttribPointer(context->current_shader_block.color_loc, 4, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)(GPU_BLIT_BUFFER_COLOR_OFFSET * sizeof(float)));
+            glVertexAttribPointer(context->current_shader_block.color_loc, 4, GPU_BLIT_BUFFER_COLOR_GL_TYPE, GPU_BLIT_BUFFER_COLOR_NORMALIZED, GPU_BLIT_BUFFER_STRIDE, (void*)(offset + GPU_BLIT_BUFFER_COLOR_OFFSET * sizeof(float)));
         }
+        #endif
 
-        upload_attribute_data(cdata, num_vertices);
+        attribute_bytes = upload_attribute_data(cdata, num_vertices);
+        GPU_COUNT_FRAME_STAT(context, bytes_uploaded, GPU_BLIT_BUFFER_STRIDE * num_vertices + sizeof(GPU_BLIT_INDEX_TYPE)*num_indices + attribute_bytes);
 
-        glDrawElements(cdata->last_shape, num_indices, GL_UNSIGNED_SHORT, (void*)0);
+        drawBlitBufferElements(cdata->last_shape, num_indices, offset);
 
+        #ifndef SDL_GPU_USE_FLUSH_VAOS
         // Disable the vertex arrays again
         if(context->current_shader_block.position_loc >= 0)
             glDisableVertexAttribArray(context->current_shader_block.position_loc);
         if(context->current_shader_block.color_loc >= 0)
             glDisableVertexAttribArray(context->current_shader_block.color_loc);
+        #endif
 
         disable_attribute_data(cdata);
 
@@ -5744,23 +9299,75 @@ static void DoUntexturedFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Cont
 }
 
 #define MAX(a, b) ((a) > (b)? (a) : (b))
+#define MIN(a, b) ((a) < (b)? (a) : (b))
+
+#ifdef SDL_GPU_USE_INSTANCED_SPRITES
+#define GPU_HAS_PENDING_SPRITE_INSTANCES(cdata) ((cdata)->instance_buffer_num_sprites > 0)
+
+// Draws the unit quad once per sprite record with the instanced program, then restores the current program.
+static void DoInstancedFlush(GPU_Target* dest, GPU_Context* context, unsigned int num_sprites, float* instance_buffer)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
+
+    glUseProgram(cdata->instanced_shader_program);
+    uploadModelViewProjection(cdata, dest, cdata->instanced_shader_program, cdata->instanced_modelViewProjection_loc);
+
+    glBindVertexArray(cdata->instanced_VAO);
+
+    // Orphan the old storage so we don't wait on the previous draw
+    glBindBuffer(GL_ARRAY_BUFFER, cdata->instance_VBO);
+    glBufferData(GL_ARRAY_BUFFER, GPU_INSTANCE_BUFFER_STRIDE * num_sprites, instance_buffer, GL_STREAM_DRAW);
+
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (void*)0, num_sprites);
+
+    GPU_COUNT_FRAME_STAT(context, draw_calls, 1);
+    GPU_COUNT_FRAME_STAT(context, vertices, num_sprites*4);
+    GPU_COUNT_FRAME_STAT(context, bytes_uploaded, GPU_INSTANCE_BUFFER_STRIDE * num_sprites);
+
+    glBindVertexArray(0);
+    glUseProgram(context->current_shader_program);
+}
+#else
+#define GPU_HAS_PENDING_SPRITE_INSTANCES(cdata) 0
+#endif
 
 static void FlushBlitBuffer(GPU_Renderer* renderer)
 {
     GPU_Context* context;
     GPU_CONTEXT_DATA* cdata;
+    GPU_FlushCauseEnum cause;
     if(renderer->current_context_target == NULL)
         return;
 
     context = renderer->current_context_target->context;
     cdata = (GPU_CONTEXT_DATA*)context->data;
-    if(cdata->blit_buffer_num_vertices > 0 && context->active_target != NULL)
+
+    // Anything that doesn't say otherwise is an explicit flush
+    cause = context->flush_cause;
+    context->flush_cause = GPU_FLUSH_EXPLICIT;
+
+    #ifdef SDL_GPU_USE_TIMER_QUERIES
+    // A timed frame starts with its first flush
+    if(cdata->gpu_timing != NULL && !cdata->gpu_timing->frame_open)
+        openTimerFrame(context, cdata->gpu_timing);
+    #endif
+
+    // Anything that needs a flush is a barrier for the sorted batch, so its draws go out first
+    if(hasSortedDraws(cdata))
+        emitSortedBatch(renderer, cause);
+
+    if((cdata->blit_buffer_num_vertices > 0 || GPU_HAS_PENDING_SPRITE_INSTANCES(cdata)) && context->active_target != NULL)
     {
 		GPU_Target* dest = context->active_target;
 		int num_vertices;
 		int num_indices;
 		float* blit_buffer;
-		unsigned short* index_buffer;
+		GPU_BLIT_INDEX_TYPE* index_buffer;
+		#ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+		unsigned int num_flushed_vertices = cdata->blit_buffer_num_vertices;
+		#endif
+
+        GPU_COUNT_FRAME_STAT(context, flushes[cause], 1);
 
         changeViewport(dest);
         changeCamera(dest);
@@ -5783,14 +9390,22 @@ static void FlushBlitBuffer(GPU_Renderer* renderer)
 
         if(cdata->last_use_texturing)
         {
+            #ifdef SDL_GPU_USE_INSTANCED_SPRITES
+            if(cdata->instance_buffer_num_sprites > 0)
+            {
+                DoInstancedFlush(dest, context, cdata->instance_buffer_num_sprites, cdata->instance_buffer);
+                cdata->instance_buffer_num_sprites = 0;
+            }
+            #endif
+
             while(cdata->blit_buffer_num_vertices > 0)
             {
                 num_vertices = MAX(cdata->blit_buffer_num_vertices, get_lowest_attribute_num_values(cdata, cdata->blit_buffer_num_vertices));
                 num_indices = num_vertices * 3 / 2;  // 6 indices per sprite / 4 vertices per sprite = 3/2
 
-                DoPartialFlush(renderer, dest, context, (unsigned short)num_vertices, blit_buffer, (unsigned int)num_indices, index_buffer);
+                DoPartialFlush(renderer, dest, context, (unsigned int)num_vertices, blit_buffer, (unsigned int)num_indices, index_buffer);
 
-                cdata->blit_buffer_num_vertices -= (unsigned short)num_vertices;
+                cdata->blit_buffer_num_vertices -= (unsigned int)num_vertices;
                 // Move our pointers ahead
                 blit_buffer += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX*num_vertices;
                 index_buffer += num_indices;
@@ -5804,10 +9419,191 @@ static void FlushBlitBuffer(GPU_Renderer* renderer)
         cdata->blit_buffer_num_vertices = 0;
         cdata->index_buffer_num_vertices = 0;
 
+        #ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+        // The GPU reads those vertices where they are, so the next ones go after them
+        if(cdata->use_persistent_buffer && num_flushed_vertices > 0)
+            advancePersistentBlitBuffer(cdata, num_flushed_vertices);
+        #endif
+
         unsetClipRect(renderer, dest);
     }
 }
 
+#ifdef SDL_GPU_USE_BUFFER_PIPELINE
+// Times a run of full untextured flushes with each supported upload method and keeps the fastest one.
+// The flushes go to a 1x1 scratch framebuffer, so the caller's targets, bindings and vertex attributes are left alone.
+// Only SDL2 has a timer fine enough for this, so SDL 1.2 builds keep the default method.
+static GPU_BufferUploadEnum calibrateBufferUpload(GPU_Renderer* renderer, GPU_Target* target)
+{
+#ifdef SDL_GPU_USE_SDL2
+    GPU_Context* context = target->context;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
+    GPU_BufferUploadEnum methods[4] = {GPU_BUFFER_UPLOAD_RESET, GPU_BUFFER_UPLOAD_UPDATE, GPU_BUFFER_UPLOAD_MAPPING, GPU_BUFFER_UPLOAD_PERSISTENT};
+    GPU_BufferUploadEnum best = cdata->buffer_upload_method;
+    Uint64 best_time = 0;
+    GPU_bool have_best = GPU_FALSE;
+    Uint32 old_program = context->current_shader_program;
+    GPU_ShaderBlock old_block = context->current_shader_block;
+    GLenum old_shape = cdata->last_shape;
+    GPU_AttributeSource old_attributes[16];
+    GLint old_framebuffer = 0;
+    GLint old_texture = 0;
+    GLuint scratch_framebuffer;
+    GLuint scratch_texture;
+    unsigned int num_vertices;
+    unsigned int i, j;
+
+    if(context->default_untextured_shader_program == 0 || cdata->blit_buffer_num_vertices > 0 || !(renderer->enabled_features & GPU_FEATURE_RENDER_TARGETS))
+        return cdata->buffer_upload_method;
+
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &old_framebuffer);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &old_texture);
+
+    glGenTextures(1, &scratch_texture);
+    glBindTexture(GL_TEXTURE_2D, scratch_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glGenFramebuffersPROC(1, &scratch_framebuffer);
+    glBindFramebufferPROC(GL_FRAMEBUFFER, scratch_framebuffer);
+    glFramebufferTexture2DPROC(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, scratch_texture, 0);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)old_texture);
+
+    if(glCheckFramebufferStatusPROC(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        glBindFramebufferPROC(GL_FRAMEBUFFER, (GLuint)old_framebuffer);
+        glDeleteFramebuffersPROC(1, &scratch_framebuffer);
+        glDeleteTextures(1, &scratch_texture);
+        return cdata->buffer_upload_method;
+    }
+
+    // Custom attribute values belong to the caller's next flush
+    memcpy(old_attributes, cdata->shader_attributes, sizeof(old_attributes));
+    memset(cdata->shader_attributes, 0, sizeof(old_attributes));
+
+    num_vertices = cdata->blit_buffer_max_num_vertices;
+    if(num_vertices > cdata->index_buffer_max_num_vertices)
+        num_vertices = cdata->index_buffer_max_num_vertices;
+    num_vertices -= num_vertices % 3;
+
+    // The MVP upload cache is keyed by the current program, so it has to name the one that is really bound
+    glUseProgram(context->default_untextured_shader_program);
+    context->current_shader_program = context->default_untextured_shader_program;
+    context->current_shader_block = context->default_untextured_shader_block;
+    cdata->last_shape = GL_TRIANGLES;
+
+    for(i = 0; i < num_vertices; i++)
+        cdata->index_buffer[i] = (GPU_BLIT_INDEX_TYPE)i;
+
+    for(i = 0; i < sizeof(methods)/sizeof(GPU_BufferUploadEnum); i++)
+    {
+        Uint64 start, elapsed;
+        if(!isBufferUploadMethodSupported(renderer, methods[i]) || !applyBufferUploadMethod(cdata, methods[i]))
+            continue;
+
+        // Warm up the driver's path for this method
+        memset(cdata->blit_buffer, 0, GPU_BLIT_BUFFER_STRIDE * num_vertices);
+        DoUntexturedFlush(renderer, target, context, num_vertices, cdata->blit_buffer, num_vertices, cdata->index_buffer);
+        #ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+        if(cdata->use_persistent_buffer)
+            advancePersistentBlitBuffer(cdata, num_vertices);
+        #endif
+        glFinish();
+
+        start = SDL_GetPerformanceCounter();
+        for(j = 0; j < GPU_BUFFER_CALIBRATION_NUM_FLUSHES; j++)
+        {
+            memset(cdata->blit_buffer, 0, GPU_BLIT_BUFFER_STRIDE * num_vertices);
+            DoUntexturedFlush(renderer, target, context, num_vertices, cdata->blit_buffer, num_vertices, cdata->index_buffer);
+            #ifdef SDL_GPU_USE_BUFFER_PERSISTENT
+            if(cdata->use_persistent_buffer)
+                advancePersistentBlitBuffer(cdata, num_vertices);
+            #endif
+        }
+        glFinish();
+        elapsed = SDL_GetPerformanceCounter() - start;
+
+        if(!have_best || elapsed < best_time)
+        {
+            best = methods[i];
+            best_time = elapsed;
+            have_best = GPU_TRUE;
+        }
+    }
+
+    applyBufferUploadMethod(cdata, best);
+
+    glUseProgram(old_program);
+    context->current_shader_program = old_program;
+    context->current_shader_block = old_block;
+    cdata->last_shape = old_shape;
+    memcpy(cdata->shader_attributes, old_attributes, sizeof(old_attributes));
+
+    glBindFramebufferPROC(GL_FRAMEBUFFER, (GLuint)old_framebuffer);
+    glDeleteFramebuffersPROC(1, &scratch_framebuffer);
+    glDeleteTextures(1, &scratch_texture);
+
+    return best;
+#else
+    (void)renderer;
+    return ((GPU_CONTEXT_DATA*)target->context->data)->buffer_upload_method;
+#endif
+}
+#endif
+
+static GPU_bool SetBufferUploadMethod(GPU_Renderer* renderer, GPU_BufferUploadEnum method)
+{
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    GPU_CONTEXT_DATA* cdata;
+    if(renderer->current_context_target == NULL)
+        return GPU_FALSE;
+
+    if(!isBufferUploadMethodSupported(renderer, method))
+    {
+        GPU_PushErrorCode("GPU_SetBufferUploadMethod", GPU_ERROR_UNSUPPORTED_FUNCTION, "Buffer upload method 0x%x is not supported by this renderer", method);
+        return GPU_FALSE;
+    }
+
+    renderer->impl->FlushBlitBuffer(renderer);
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    return applyBufferUploadMethod(cdata, method);
+    #else
+    (void)renderer;
+    if(method != GPU_BUFFER_UPLOAD_NONE)
+        GPU_PushErrorCode("GPU_SetBufferUploadMethod", GPU_ERROR_UNSUPPORTED_FUNCTION, "This renderer does not upload vertices through buffer objects");
+    return (method == GPU_BUFFER_UPLOAD_NONE);
+    #endif
+}
+
+static GPU_BufferUploadEnum GetBufferUploadMethod(GPU_Renderer* renderer)
+{
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    if(renderer->current_context_target == NULL)
+        return GPU_BUFFER_UPLOAD_NONE;
+    return ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->buffer_upload_method;
+    #else
+    (void)renderer;
+    return GPU_BUFFER_UPLOAD_NONE;
+    #endif
+}
+
+static GPU_BufferUploadEnum CalibrateBufferUpload(GPU_Renderer* renderer)
+{
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    if(renderer->current_context_target == NULL)
+        return GPU_BUFFER_UPLOAD_NONE;
+
+    #ifndef SDL_GPU_USE_SDL2
+    GPU_PushErrorCode("GPU_CalibrateBufferUpload", GPU_ERROR_UNSUPPORTED_FUNCTION, "SDL 1.2's millisecond timer is too coarse to compare upload methods");
+    #endif
+
+    renderer->impl->FlushBlitBuffer(renderer);
+    return calibrateBufferUpload(renderer, renderer->current_context_target);
+    #else
+    (void)renderer;
+    return GPU_BUFFER_UPLOAD_NONE;
+    #endif
+}
+
 static void Flip(GPU_Renderer* renderer, GPU_Target* target)
 {
     renderer->impl->FlushBlitBuffer(renderer);
@@ -5816,6 +9612,15 @@ static void Flip(GPU_Renderer* renderer, GPU_Target* target)
     {
         makeContextCurrent(renderer, target);
 
+        #ifdef SDL_GPU_USE_TIMER_QUERIES
+        {
+            // The frame's GPU time ends before the swap
+            GPUTimingData* timing = ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->gpu_timing;
+            if(timing != NULL && timing->frame_open)
+                closeTimerFrame(timing);
+        }
+        #endif
+
     #ifdef SDL_GPU_USE_SDL2
         SDL_GL_SwapWindow(SDL_GetWindowFromID(renderer->current_context_target->context->windowID));
     #else
@@ -5829,6 +9634,117 @@ static void Flip(GPU_Renderer* renderer, GPU_Target* target)
     #endif
 }
 
+static GPU_bool EnableGPUTiming(GPU_Renderer* renderer, GPU_bool enable)
+{
+    #ifdef SDL_GPU_USE_TIMER_QUERIES
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    GPUTimingData* timing;
+    int i;
+
+    if(!enable)
+    {
+        freeGPUTiming(cdata, GPU_TRUE);
+        return GPU_FALSE;
+    }
+    if(cdata->gpu_timing != NULL)
+        return GPU_TRUE;
+
+    if(!IsFeatureEnabled(renderer, GPU_FEATURE_TIMER_QUERIES))
+    {
+        GPU_PushErrorCode("GPU_EnableGPUTiming", GPU_ERROR_UNSUPPORTED_FUNCTION, "Timer queries are not supported");
+        return GPU_FALSE;
+    }
+
+    timing = (GPUTimingData*)SDL_malloc(sizeof(GPUTimingData));
+    memset(timing, 0, sizeof(GPUTimingData));
+    for(i = 0; i < GPU_TIMER_FRAMES; i++)
+        glGenQueriesPROC(GPU_TIMER_MAX_QUERIES, timing->frames[i].queries);
+    timing->target_span = -1;
+    timing->frame_ms = -1.0f;
+    cdata->gpu_timing = timing;
+    return GPU_TRUE;
+    #else
+    (void)renderer;
+    if(enable)
+        GPU_PushErrorCode("GPU_EnableGPUTiming", GPU_ERROR_UNSUPPORTED_FUNCTION, "Timer queries are not supported by this renderer");
+    return GPU_FALSE;
+    #endif
+}
+
+static void BeginGPUScope(GPU_Renderer* renderer, const char* name)
+{
+    #ifdef SDL_GPU_USE_TIMER_QUERIES
+    GPU_Context* context = renderer->current_context_target->context;
+    GPUTimingData* timing = ((GPU_CONTEXT_DATA*)context->data)->gpu_timing;
+    int span;
+    if(timing == NULL)
+        return;
+
+    // Blits from before the scope are drawn outside of it
+    renderer->impl->FlushBlitBuffer(renderer);
+    if(!timing->frame_open)
+        openTimerFrame(context, timing);
+
+    span = beginTimerSpan(timing, name, NULL, recordTimestamp(timing, GPU_FALSE));
+    if(timing->scope_depth < GPU_TIMER_MAX_DEPTH)
+        timing->scope_stack[timing->scope_depth] = span;
+    timing->scope_depth++;
+    #else
+    (void)renderer;
+    (void)name;
+    #endif
+}
+
+static void EndGPUScope(GPU_Renderer* renderer)
+{
+    #ifdef SDL_GPU_USE_TIMER_QUERIES
+    GPUTimingData* timing = ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->gpu_timing;
+    int query;
+    if(timing == NULL || !timing->frame_open || timing->scope_depth == 0)
+        return;
+
+    renderer->impl->FlushBlitBuffer(renderer);
+
+    query = recordTimestamp(timing, GPU_FALSE);
+    timing->scope_depth--;
+    if(timing->scope_depth < GPU_TIMER_MAX_DEPTH)
+        endTimerSpan(timing, timing->scope_stack[timing->scope_depth], query);
+    #else
+    (void)renderer;
+    #endif
+}
+
+static float GetGPUTime(GPU_Renderer* renderer, const char* scope_name, GPU_Target* target)
+{
+    #ifdef SDL_GPU_USE_TIMER_QUERIES
+    GPUTimingData* timing = ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->gpu_timing;
+    int i;
+    if(timing == NULL || timing->frame_ms < 0.0f)
+        return -1.0f;
+
+    if(scope_name == NULL && target == NULL)
+        return timing->frame_ms;
+
+    for(i = 0; i < timing->num_results; i++)
+    {
+        GPUTimerSpan* result = &timing->results[i];
+        if(scope_name != NULL)
+        {
+            if(result->target == NULL && strncmp(result->name, scope_name, GPU_TIMER_NAME_LENGTH - 1) == 0)
+                return result->ms;
+        }
+        else if(result->target == target)
+            return result->ms;
+    }
+    return -1.0f;
+    #else
+    (void)renderer;
+    (void)scope_name;
+    (void)target;
+    return -1.0f;
+    #endif
+}
+
 
 
 
@@ -6187,6 +10103,11 @@ static GPU_bool LinkShaderProgram(GPU_Renderer* renderer, Uint32 program_object)
     glBindAttribLocation(program_object, 0, "gpu_Vertex");
 	glLinkProgram(program_object);
 
+    // Linking resets the uniforms
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    forgetModelViewProjectionUploads(renderer, program_object);
+    #endif
+
 	glGetProgramiv(program_object, GL_LINK_STATUS, &linked);
 
 	if(!linked)
@@ -6223,7 +10144,12 @@ static void FreeShaderProgram(GPU_Renderer* renderer, Uint32 program_object)
 	(void)program_object;
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
+    {
+        #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+        forgetModelViewProjectionUploads(renderer, program_object);
+        #endif
         glDeleteProgram(program_object);
+    }
     #endif
 }
 
@@ -6266,7 +10192,11 @@ static void ActivateShaderProgram(GPU_Renderer* renderer, Uint32 program_object,
             program_object = target->context->default_untextured_shader_program;
         }
 
-        renderer->impl->FlushBlitBuffer(renderer);
+        // A sorted batch keeps the program with each recorded draw, so there's nothing to flush yet
+        if(!isRecordingSortedBatch(target->context, target->context->active_target))
+            flushBlitBufferFor(renderer, GPU_FLUSH_SHADER_CHANGE);
+        if(program_object != target->context->current_shader_program)
+            GPU_COUNT_FRAME_STAT(target->context, program_switches, 1);
         glUseProgram(program_object);
 
 		{
@@ -6296,17 +10226,6 @@ static void ActivateShaderProgram(GPU_Renderer* renderer, Uint32 program_object,
     target->context->current_shader_program = program_object;
 }
 
-static void DeactivateShaderProgram(GPU_Renderer* renderer)
-{
-    renderer->impl->ActivateShaderProgram(renderer, 0, NULL);
-}
-
-static const char* GetShaderMessage(GPU_Renderer* renderer)
-{
-	(void)renderer;
-    return shader_message;
-}
-
 static int GetAttributeLocation(GPU_Renderer* renderer, Uint32 program_object, const char* attrib_name)
 {
     #ifndef SDL_GPU_DISABLE_SHADERS
@@ -6386,7 +10305,7 @@ static void SetShaderImage(GPU_Renderer* renderer, GPU_Image* image, int locatio
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
 
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
     if(renderer->current_context_target->context->current_shader_program == 0 || image_unit < 0)
         return;
 
@@ -6402,6 +10321,11 @@ static void SetShaderImage(GPU_Renderer* renderer, GPU_Image* image, int locatio
     if(image_unit != 0)
         glActiveTexture(GL_TEXTURE0);
 
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    // That unit might have been holding a blit image
+    ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->num_bound_slots = 0;
+    #endif
+
 	#endif
 
 	(void)renderer;
@@ -6436,7 +10360,9 @@ static void SetUniformi(GPU_Renderer* renderer, int location, int value)
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+    if(recordUniform(renderer, COMMAND_UNIFORM_INT, location, 1, 0, 1, GPU_FALSE, &value, sizeof(int)))
+        return;
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     glUniform1i(location, value);
@@ -6454,7 +10380,9 @@ static void SetUniformiv(GPU_Renderer* renderer, int location, int num_elements_
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+    if(recordUniform(renderer, COMMAND_UNIFORM_INT, location, num_elements_per_value, 0, num_values, GPU_FALSE, values, num_elements_per_value*num_values*sizeof(int)))
+        return;
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     switch(num_elements_per_value)
@@ -6505,7 +10433,9 @@ static void SetUniformui(GPU_Renderer* renderer, int location, unsigned int valu
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+    if(recordUniform(renderer, COMMAND_UNIFORM_UINT, location, 1, 0, 1, GPU_FALSE, &value, sizeof(unsigned int)))
+        return;
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     #if defined(SDL_GPU_USE_GLES) && SDL_GPU_GLES_MAJOR_VERSION < 3
@@ -6527,7 +10457,9 @@ static void SetUniformuiv(GPU_Renderer* renderer, int location, int num_elements
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+    if(recordUniform(renderer, COMMAND_UNIFORM_UINT, location, num_elements_per_value, 0, num_values, GPU_FALSE, values, num_elements_per_value*num_values*sizeof(unsigned int)))
+        return;
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     #if defined(SDL_GPU_USE_GLES) && SDL_GPU_GLES_MAJOR_VERSION < 3
@@ -6592,7 +10524,9 @@ static void SetUniformf(GPU_Renderer* renderer, int location, float value)
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+    if(recordUniform(renderer, COMMAND_UNIFORM_FLOAT, location, 1, 0, 1, GPU_FALSE, &value, sizeof(float)))
+        return;
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     glUniform1f(location, value);
@@ -6610,7 +10544,9 @@ static void SetUniformfv(GPU_Renderer* renderer, int location, int num_elements_
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+    if(recordUniform(renderer, COMMAND_UNIFORM_FLOAT, location, num_elements_per_value, 0, num_values, GPU_FALSE, values, num_elements_per_value*num_values*sizeof(float)))
+        return;
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     switch(num_elements_per_value)
@@ -6644,7 +10580,9 @@ static void SetUniformMatrixfv(GPU_Renderer* renderer, int location, int num_mat
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
+    if(recordUniform(renderer, COMMAND_UNIFORM_MATRIX, location, num_rows, num_columns, num_matrices, transpose, values, num_rows*num_columns*num_matrices*sizeof(float)))
+        return;
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     if(num_rows < 2 || num_rows > 4 || num_columns < 2 || num_columns > 4)
@@ -6667,6 +10605,12 @@ static void SetUniformMatrixfv(GPU_Renderer* renderer, int location, int num_mat
     }
     #endif
 
+    // Overwriting the MVP by hand means the next flush has to send it again
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    if(location >= 0 && location == renderer->current_context_target->context->current_shader_block.modelViewProjection_loc)
+        forgetModelViewProjectionUploads(renderer, renderer->current_context_target->context->current_shader_program);
+    #endif
+
     switch(num_rows)
     {
     case 2:
@@ -6707,7 +10651,7 @@ static void SetAttributef(GPU_Renderer* renderer, int location, float value)
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
 
@@ -6734,7 +10678,7 @@ static void SetAttributei(GPU_Renderer* renderer, int location, int value)
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
 
@@ -6761,7 +10705,7 @@ static void SetAttributeui(GPU_Renderer* renderer, int location, unsigned int va
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
 
@@ -6790,7 +10734,7 @@ static void SetAttributefv(GPU_Renderer* renderer, int location, int num_element
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
 
@@ -6831,7 +10775,7 @@ static void SetAttributeiv(GPU_Renderer* renderer, int location, int num_element
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
 
@@ -6873,7 +10817,7 @@ static void SetAttributeuiv(GPU_Renderer* renderer, int location, int num_elemen
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_UNIFORM_SET);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
 
@@ -6989,11 +10933,16 @@ static void SetAttributeSource(GPU_Renderer* renderer, int num_values, GPU_Attri
     impl->CopyImage = &CopyImage; \
     impl->UpdateImage = &UpdateImage; \
     impl->UpdateImageBytes = &UpdateImageBytes; \
+    impl->UpdateImageBytesAsync = &UpdateImageBytesAsync; \
     impl->ReplaceImage = &ReplaceImage; \
     impl->CopyImageFromSurface = &CopyImageFromSurface; \
     impl->CopyImageFromTarget = &CopyImageFromTarget; \
     impl->CopySurfaceFromTarget = &CopySurfaceFromTarget; \
     impl->CopySurfaceFromImage = &CopySurfaceFromImage; \
+    impl->ReadPixelsAsync = &ReadPixelsAsync; \
+    impl->IsReadbackReady = &IsReadbackReady; \
+    impl->MapReadback = &MapReadback; \
+    impl->FreeReadback = &FreeReadback; \
     impl->FreeImage = &FreeImage; \
  \
     impl->GetTarget = &GetTarget; \
@@ -7004,7 +10953,15 @@ static void SetAttributeSource(GPU_Renderer* renderer, int num_values, GPU_Attri
     impl->BlitScale = &BlitScale; \
     impl->BlitTransform = &BlitTransform; \
     impl->BlitTransformX = &BlitTransformX; \
+    impl->BlitBatch = &BlitBatch; \
+    impl->BlitBatchSeparate = &BlitBatchSeparate; \
+    impl->BlitTransformBatch = &BlitTransformBatch; \
     impl->PrimitiveBatchV = &PrimitiveBatchV; \
+    impl->PrimitiveBatchV32 = &PrimitiveBatchV32; \
+    impl->CreateVertexBuffer = &CreateVertexBuffer; \
+    impl->UpdateVertexBuffer = &UpdateVertexBuffer; \
+    impl->DrawVertexBuffer = &DrawVertexBuffer; \
+    impl->FreeVertexBuffer = &FreeVertexBuffer; \
  \
     impl->GenerateMipmaps = &GenerateMipmaps; \
  \
@@ -7012,13 +10969,28 @@ static void SetAttributeSource(GPU_Renderer* renderer, int num_values, GPU_Attri
     impl->UnsetClip = &UnsetClip; \
      \
     impl->GetPixel = &GetPixel; \
+    impl->GetPixels = &GetPixels; \
     impl->SetImageFilter = &SetImageFilter; \
     impl->SetWrapMode = &SetWrapMode; \
     impl->GetTextureHandle = &GetTextureHandle; \
  \
     impl->ClearRGBA = &ClearRGBA; \
     impl->FlushBlitBuffer = &FlushBlitBuffer; \
+    impl->BeginSortedBatch = &BeginSortedBatch; \
+    impl->EndSortedBatch = &EndSortedBatch; \
+    impl->SetSortedBatchLayer = &SetSortedBatchLayer; \
+    impl->BeginCommandList = &BeginCommandList; \
+    impl->EndCommandList = &EndCommandList; \
+    impl->ExecuteCommandList = &ExecuteCommandList; \
+    impl->FreeCommandList = &FreeCommandList; \
+    impl->SetBufferUploadMethod = &SetBufferUploadMethod; \
+    impl->GetBufferUploadMethod = &GetBufferUploadMethod; \
+    impl->CalibrateBufferUpload = &CalibrateBufferUpload; \
     impl->Flip = &Flip; \
+    impl->EnableGPUTiming = &EnableGPUTiming; \
+    impl->BeginGPUScope = &BeginGPUScope; \
+    impl->EndGPUScope = &EndGPUScope; \
+    impl->GetGPUTime = &GetGPUTime; \
      \
     impl->CompileShader_RW = &CompileShader_RW; \
     impl->CompileShader = &CompileShader; \
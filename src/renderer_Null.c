@@ -0,0 +1,60 @@
+#include "SDL_gpu_Null.h"
+#include "SDL_gpu_RendererImpl.h"
+
+
+#if defined(SDL_GPU_DISABLE_NULL)
+
+// Dummy implementations
+GPU_Renderer* GPU_CreateRenderer_Null(GPU_RendererID request) {return NULL;}
+void GPU_FreeRenderer_Null(GPU_Renderer* renderer) {}
+
+#else
+
+
+/* The null renderer draws nothing.  It does the CPU-side work of a frame, counted in the context's GPU_FrameStats,
+so it can be used to measure the CPU overhead of a frame on machines (e.g. CI servers) that have no GPU. */
+#include "renderer_CPU_common.inl"
+#include "renderer_shapes_GL_common.inl"
+
+
+GPU_Renderer* GPU_CreateRenderer_Null(GPU_RendererID request)
+{
+    GPU_RendererImpl* impl;
+    GPU_Renderer* renderer = (GPU_Renderer*)SDL_malloc(sizeof(GPU_Renderer));
+    if(renderer == NULL)
+        return NULL;
+
+    memset(renderer, 0, sizeof(GPU_Renderer));
+
+    renderer->id = request;
+    renderer->id.renderer = GPU_RENDERER_NULL;
+    // Shader sources are accepted without being compiled, so report the language that shader loading code expects most
+    renderer->shader_language = GPU_LANGUAGE_GLSL;
+    renderer->min_shader_version = 110;
+    renderer->max_shader_version = 330;
+
+    renderer->default_image_anchor_x = 0.5f;
+    renderer->default_image_anchor_y = 0.5f;
+
+    renderer->current_context_target = NULL;
+
+    impl = (GPU_RendererImpl*)SDL_malloc(sizeof(GPU_RendererImpl));
+    memset(impl, 0, sizeof(GPU_RendererImpl));
+    renderer->impl = impl;
+
+    SET_COMMON_FUNCTIONS(impl);
+
+    return renderer;
+}
+
+void GPU_FreeRenderer_Null(GPU_Renderer* renderer)
+{
+    if(renderer == NULL)
+        return;
+
+    SDL_free(renderer->impl);
+    SDL_free(renderer);
+}
+
+
+#endif
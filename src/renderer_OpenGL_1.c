@@ -15,6 +15,7 @@ void GPU_FreeRenderer_OpenGL_1(GPU_Renderer* renderer) {}
 #define SDL_GPU_USE_FIXED_FUNCTION_PIPELINE
 #define SDL_GPU_USE_BUFFER_PIPELINE
 #define SDL_GPU_USE_BUFFER_PIPELINE_FALLBACK
+#define SDL_GPU_USE_32BIT_INDICES
 #define SDL_GPU_GLSL_VERSION 110
 #define SDL_GPU_GL_MAJOR_VERSION 1
 #define SDL_GPU_APPLY_TRANSFORMS_TO_GL_STACK
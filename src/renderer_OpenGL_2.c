@@ -13,6 +13,7 @@ void GPU_FreeRenderer_OpenGL_2(GPU_Renderer* renderer) {}
 // Most of the code pulled in from here...
 #define SDL_GPU_USE_OPENGL
 #define SDL_GPU_USE_BUFFER_PIPELINE
+#define SDL_GPU_USE_32BIT_INDICES
 #define SDL_GPU_ASSUME_SHADERS
 #define SDL_GPU_GLSL_VERSION 120
 #define SDL_GPU_GL_MAJOR_VERSION 2
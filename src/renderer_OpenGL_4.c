@@ -14,6 +14,10 @@ void GPU_FreeRenderer_OpenGL_4(GPU_Renderer* renderer) {}
 // Most of the code pulled in from here...
 #define SDL_GPU_USE_OPENGL
 #define SDL_GPU_USE_BUFFER_PIPELINE
+#define SDL_GPU_USE_INSTANCED_SPRITES
+#define SDL_GPU_USE_32BIT_INDICES
+// Blit straight into a persistently mapped VBO ring (GL 4.4 or ARB_buffer_storage) unless USE_BUFFER_UPDATE or USE_BUFFER_MAPPING picks another default
+#define SDL_GPU_USE_BUFFER_PERSISTENT
 #define SDL_GPU_ASSUME_CORE_FBO
 #define SDL_GPU_ASSUME_SHADERS
 #define SDL_GPU_SKIP_ENABLE_TEXTURE_2D
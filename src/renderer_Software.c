@@ -0,0 +1,872 @@
+#include "SDL_gpu_Software.h"
+#include "SDL_gpu_RendererImpl.h"
+
+
+#if defined(SDL_GPU_DISABLE_SOFTWARE)
+
+// Dummy implementations
+GPU_Renderer* GPU_CreateRenderer_Software(GPU_RendererID request) {return NULL;}
+void GPU_FreeRenderer_Software(GPU_Renderer* renderer) {}
+
+#else
+
+
+/* The software renderer rasterizes into SDL_Surfaces on the CPU, for machines without a GPU (e.g. servers that
+make thumbnails).  Images, image targets, and the window's framebuffer are all 32-bit RGBA surfaces.  GPU_Flip()
+copies the framebuffer to the window surface.
+
+Flushed vertices are transformed and set up as triangles (lines and points become quads), binned into screen tiles,
+and the tiles are shaded by a pool of worker threads.  Custom shaders and depth testing are not supported. */
+#define SDL_GPU_CPU_RASTERIZE
+#define SDL_GPU_DISABLE_SHADERS
+#include "renderer_CPU_common.inl"
+#include "renderer_shapes_GL_common.inl"
+
+
+void gpu_blend_span_normal(Uint32* dest, const Uint32* src, int count);
+
+#define GPU_RASTER_TILE_SIZE 64
+#define GPU_RASTER_MAX_THREADS 16
+// Draws covering fewer pixels than this are shaded on the calling thread
+#define GPU_RASTER_MIN_PARALLEL_PIXELS (GPU_RASTER_TILE_SIZE*GPU_RASTER_TILE_SIZE*4)
+
+// Interpolated vertex attributes
+enum
+{
+    GPU_RASTER_S, GPU_RASTER_T, GPU_RASTER_R, GPU_RASTER_G, GPU_RASTER_B, GPU_RASTER_A, GPU_RASTER_NUM_ATTRIBUTES
+};
+
+// A vertex in surface pixels, with rows going down
+typedef struct GPU_RasterVertex
+{
+    float x, y;
+    float attributes[GPU_RASTER_NUM_ATTRIBUTES];
+    GPU_bool visible;  // Behind the eye (w <= 0) otherwise
+} GPU_RasterVertex;
+
+typedef struct GPU_RasterTriangle
+{
+    // Edge functions a*x + b*y + c, positive inside
+    float edge_a[3];
+    float edge_b[3];
+    float edge_c[3];
+    // Attribute planes: value = dx*x + dy*y + c, at pixel centers
+    float attribute_dx[GPU_RASTER_NUM_ATTRIBUTES];
+    float attribute_dy[GPU_RASTER_NUM_ATTRIBUTES];
+    float attribute_c[GPU_RASTER_NUM_ATTRIBUTES];
+    // Covered pixels, clipped.  The max is exclusive.
+    int min_x, min_y, max_x, max_y;
+    // The color is constant, so it doesn't need interpolating
+    GPU_bool flat_color;
+    Uint8 color[4];
+} GPU_RasterTriangle;
+
+struct GPU_Rasterizer;
+
+typedef struct GPU_RasterWorker
+{
+    struct GPU_Rasterizer* rasterizer;
+    Uint32 span[GPU_RASTER_TILE_SIZE];
+    #ifdef SDL_GPU_USE_SDL2
+    SDL_Thread* thread;
+    #endif
+} GPU_RasterWorker;
+
+typedef struct GPU_Rasterizer
+{
+    GPU_RasterVertex* vertices;
+    unsigned int max_vertices;
+
+    GPU_RasterTriangle* triangles;
+    unsigned int num_triangles;
+    unsigned int max_triangles;
+
+    // Triangle indices per tile, in submission order.  Tile i's triangles are bin_items[bin_starts[i]] to bin_items[bin_starts[i+1] - 1].
+    unsigned int* bin_starts;
+    unsigned int* bin_fill;
+    unsigned int max_bins;
+    unsigned int* bin_items;
+    unsigned int max_bin_items;
+    int tiles_x, tiles_y;
+
+    // State of the draw being shaded
+    SDL_Surface* surface;
+    SDL_Surface* texture;
+    GPU_FilterEnum filter;
+    GPU_WrapEnum wrap_x, wrap_y;
+    GPU_bool use_blending;
+    GPU_BlendMode blend_mode;
+    GPU_bool normal_blending;
+
+    // workers[0] is the calling thread
+    GPU_RasterWorker workers[GPU_RASTER_MAX_THREADS + 1];
+    int num_threads;
+    #ifdef SDL_GPU_USE_SDL2
+    GPU_bool started;
+    GPU_bool quitting;
+    SDL_sem* start;
+    SDL_sem* done;
+    SDL_atomic_t next_tile;
+    #endif
+} GPU_Rasterizer;
+
+
+static_inline Uint8 toByte(float value)
+{
+    if(value <= 0.0f)
+        return 0;
+    if(value >= 1.0f)
+        return 255;
+    return (Uint8)(value*255.0f + 0.5f);
+}
+
+static_inline int wrapCoordinate(int i, int size, GPU_WrapEnum wrap)
+{
+    switch(wrap)
+    {
+        case GPU_WRAP_REPEAT:
+            i %= size;
+            return (i < 0? i + size : i);
+        case GPU_WRAP_MIRRORED:
+            i %= 2*size;
+            if(i < 0)
+                i += 2*size;
+            return (i < size? i : 2*size - 1 - i);
+        default:
+            // GL_CLAMP_TO_EDGE
+            return (i < 0? 0 : (i >= size? size - 1 : i));
+    }
+}
+
+static_inline const Uint8* getTexel(SDL_Surface* texture, int x, int y)
+{
+    return (const Uint8*)(getPixelRow(texture, y) + x);
+}
+
+static void sampleTexture(GPU_Rasterizer* r, float s, float t, Uint8* result)
+{
+    SDL_Surface* texture = r->texture;
+    float u = s*texture->w;
+    float v = t*texture->h;
+
+    if(r->filter == GPU_FILTER_NEAREST)
+    {
+        int x = wrapCoordinate((int)floorf(u), texture->w, r->wrap_x);
+        int y = wrapCoordinate((int)floorf(v), texture->h, r->wrap_y);
+        memcpy(result, getTexel(texture, x, y), 4);
+    }
+    else
+    {
+        // Bilinear, with 8 bits of subpixel weight.  There are no mipmaps, so GPU_FILTER_LINEAR_MIPMAP is the same.
+        float fu = floorf(u - 0.5f);
+        float fv = floorf(v - 0.5f);
+        int wx = (int)((u - 0.5f - fu)*256.0f);
+        int wy = (int)((v - 0.5f - fv)*256.0f);
+        int x0 = wrapCoordinate((int)fu, texture->w, r->wrap_x);
+        int x1 = wrapCoordinate((int)fu + 1, texture->w, r->wrap_x);
+        int y0 = wrapCoordinate((int)fv, texture->h, r->wrap_y);
+        int y1 = wrapCoordinate((int)fv + 1, texture->h, r->wrap_y);
+        const Uint8* p00 = getTexel(texture, x0, y0);
+        const Uint8* p10 = getTexel(texture, x1, y0);
+        const Uint8* p01 = getTexel(texture, x0, y1);
+        const Uint8* p11 = getTexel(texture, x1, y1);
+        int c;
+        for(c = 0; c < 4; c++)
+        {
+            int top = p00[c]*(256 - wx) + p10[c]*wx;
+            int bottom = p01[c]*(256 - wx) + p11[c]*wx;
+            result[c] = (Uint8)((top*(256 - wy) + bottom*wy + 32768) >> 16);
+        }
+    }
+}
+
+static_inline int blendFactor(GPU_BlendFuncEnum factor, const Uint8* src, const Uint8* dest, int channel)
+{
+    switch(factor)
+    {
+        case GPU_FUNC_ZERO:
+            return 0;
+        case GPU_FUNC_ONE:
+            return 255;
+        case GPU_FUNC_SRC_COLOR:
+            return src[channel];
+        case GPU_FUNC_ONE_MINUS_SRC:
+            return 255 - src[channel];
+        case GPU_FUNC_SRC_ALPHA:
+            return src[3];
+        case GPU_FUNC_ONE_MINUS_SRC_ALPHA:
+            return 255 - src[3];
+        case GPU_FUNC_DST_ALPHA:
+            return dest[3];
+        case GPU_FUNC_ONE_MINUS_DST_ALPHA:
+            return 255 - dest[3];
+        case GPU_FUNC_DST_COLOR:
+            return dest[channel];
+        case GPU_FUNC_ONE_MINUS_DST:
+            return 255 - dest[channel];
+    }
+    return 255;
+}
+
+// Any blend mode, a channel at a time
+static void blendSpan(GPU_BlendMode* mode, Uint32* dest, const Uint32* src, int count)
+{
+    int i, c;
+    for(i = 0; i < count; i++)
+    {
+        const Uint8* s = (const Uint8*)(src + i);
+        Uint8* d = (Uint8*)(dest + i);
+        Uint8 result[4];
+
+        for(c = 0; c < 4; c++)
+        {
+            GPU_bool is_alpha = (c == 3);
+            int sv = s[c]*blendFactor(is_alpha? mode->source_alpha : mode->source_color, s, d, c);
+            int dv = d[c]*blendFactor(is_alpha? mode->dest_alpha : mode->dest_color, s, d, c);
+            int value;
+            switch(is_alpha? mode->alpha_equation : mode->color_equation)
+            {
+                case GPU_EQ_SUBTRACT:
+                    value = sv - dv;
+                    break;
+                case GPU_EQ_REVERSE_SUBTRACT:
+                    value = dv - sv;
+                    break;
+                default:
+                    value = sv + dv;
+                    break;
+            }
+            value = (value < 0? 0 : (value + 128 + ((value + 128) >> 8)) >> 8);
+            result[c] = (Uint8)(value > 255? 255 : value);
+        }
+        memcpy(d, result, 4);
+    }
+}
+
+// Shades the pixels of one triangle between x1 and x2 on row y into the span buffer, then writes them out
+static void shadeSpan(GPU_Rasterizer* r, GPU_RasterTriangle* tri, int x1, int x2, int y, Uint32* span)
+{
+    int count = x2 - x1;
+    Uint32* dest = getPixelRow(r->surface, y) + x1;
+    float px = x1 + 0.5f;
+    float py = y + 0.5f;
+    int i;
+
+    if(r->texture == NULL && tri->flat_color)
+    {
+        Uint32 color = packPixel(tri->color[0], tri->color[1], tri->color[2], tri->color[3]);
+        if(!r->use_blending || (tri->color[3] == 255 && r->normal_blending))
+        {
+            gpu_fill_span(dest, color, count);
+            return;
+        }
+        gpu_fill_span(span, color, count);
+    }
+    else
+    {
+        float values[GPU_RASTER_NUM_ATTRIBUTES];
+        int first = (r->texture != NULL? GPU_RASTER_S : GPU_RASTER_R);
+        int last = (tri->flat_color? GPU_RASTER_T : GPU_RASTER_A);
+        int a;
+        Uint8* out = (Uint8*)span;
+
+        for(a = first; a <= last; a++)
+            values[a] = tri->attribute_dx[a]*px + tri->attribute_dy[a]*py + tri->attribute_c[a];
+
+        // Affine interpolation, like the 2D projections that SDL_gpu sets up
+        for(i = 0; i < count; i++, out += 4)
+        {
+            if(r->texture != NULL)
+            {
+                sampleTexture(r, values[GPU_RASTER_S], values[GPU_RASTER_T], out);
+                if(tri->flat_color)
+                {
+                    if(tri->color[0] != 255 || tri->color[1] != 255 || tri->color[2] != 255 || tri->color[3] != 255)
+                    {
+                        out[0] = (Uint8)((out[0]*tri->color[0] + 127)/255);
+                        out[1] = (Uint8)((out[1]*tri->color[1] + 127)/255);
+                        out[2] = (Uint8)((out[2]*tri->color[2] + 127)/255);
+                        out[3] = (Uint8)((out[3]*tri->color[3] + 127)/255);
+                    }
+                }
+                else
+                {
+                    out[0] = toByte(out[0]/255.0f*values[GPU_RASTER_R]);
+                    out[1] = toByte(out[1]/255.0f*values[GPU_RASTER_G]);
+                    out[2] = toByte(out[2]/255.0f*values[GPU_RASTER_B]);
+                    out[3] = toByte(out[3]/255.0f*values[GPU_RASTER_A]);
+                }
+            }
+            else
+            {
+                out[0] = toByte(values[GPU_RASTER_R]);
+                out[1] = toByte(values[GPU_RASTER_G]);
+                out[2] = toByte(values[GPU_RASTER_B]);
+                out[3] = toByte(values[GPU_RASTER_A]);
+            }
+
+            for(a = first; a <= last; a++)
+                values[a] += tri->attribute_dx[a];
+        }
+    }
+
+    if(!r->use_blending)
+        memcpy(dest, span, count*sizeof(Uint32));
+    else if(r->normal_blending)
+        gpu_blend_span_normal(dest, span, count);
+    else
+        blendSpan(&r->blend_mode, dest, span, count);
+}
+
+/* Finds the pixels of the row whose centers are inside the triangle.  Centers on an edge belong to the triangle on
+   the edge's right (a > 0) or below it (a == 0, b > 0), so triangles that share an edge never both draw a pixel. */
+static GPU_bool getSpan(GPU_RasterTriangle* tri, int y, int* x1, int* x2)
+{
+    float py = y + 0.5f;
+    int e;
+
+    for(e = 0; e < 3; e++)
+    {
+        float a = tri->edge_a[e];
+        float k = tri->edge_b[e]*py + tri->edge_c[e];
+        if(a > 0.0f)
+        {
+            float bound = ceilf(-k/a - 0.5f);
+            if(bound > *x1)
+                *x1 = (bound >= *x2? *x2 : (int)bound);
+        }
+        else if(a < 0.0f)
+        {
+            float bound = ceilf(-k/a - 0.5f);
+            if(bound < *x2)
+                *x2 = (bound <= *x1? *x1 : (int)bound);
+        }
+        else if(k < 0.0f || (k == 0.0f && tri->edge_b[e] <= 0.0f))
+            return GPU_FALSE;
+    }
+    return (*x1 < *x2);
+}
+
+static void rasterizeTile(GPU_Rasterizer* r, unsigned int tile, Uint32* span)
+{
+    int tile_x1 = (int)(tile % r->tiles_x)*GPU_RASTER_TILE_SIZE;
+    int tile_y1 = (int)(tile / r->tiles_x)*GPU_RASTER_TILE_SIZE;
+    int tile_x2 = MIN(tile_x1 + GPU_RASTER_TILE_SIZE, r->surface->w);
+    int tile_y2 = MIN(tile_y1 + GPU_RASTER_TILE_SIZE, r->surface->h);
+    unsigned int i;
+
+    for(i = r->bin_starts[tile]; i < r->bin_starts[tile + 1]; i++)
+    {
+        GPU_RasterTriangle* tri = &r->triangles[r->bin_items[i]];
+        int y1 = MAX(tile_y1, tri->min_y);
+        int y2 = MIN(tile_y2, tri->max_y);
+        int y;
+        for(y = y1; y < y2; y++)
+        {
+            int x1 = MAX(tile_x1, tri->min_x);
+            int x2 = MIN(tile_x2, tri->max_x);
+            if(getSpan(tri, y, &x1, &x2))
+                shadeSpan(r, tri, x1, x2, y, span);
+        }
+    }
+}
+
+#ifdef SDL_GPU_USE_SDL2
+static void rasterizeTiles(GPU_Rasterizer* r, Uint32* span)
+{
+    int num_tiles = r->tiles_x*r->tiles_y;
+    int tile;
+    while((tile = SDL_AtomicAdd(&r->next_tile, 1)) < num_tiles)
+        rasterizeTile(r, (unsigned int)tile, span);
+}
+
+static int workerThread(void* data)
+{
+    GPU_RasterWorker* worker = (GPU_RasterWorker*)data;
+    GPU_Rasterizer* r = worker->rasterizer;
+    while(1)
+    {
+        SDL_SemWait(r->start);
+        if(r->quitting)
+            break;
+
+        rasterizeTiles(r, worker->span);
+        SDL_SemPost(r->done);
+    }
+    return 0;
+}
+
+// Threads are started with the first draw that is worth splitting up
+static void startWorkers(GPU_Rasterizer* r)
+{
+    int i;
+
+    r->started = GPU_TRUE;
+    r->num_threads = MIN(SDL_GetCPUCount() - 1, GPU_RASTER_MAX_THREADS);
+    if(r->num_threads <= 0)
+    {
+        r->num_threads = 0;
+        return;
+    }
+
+    r->start = SDL_CreateSemaphore(0);
+    r->done = SDL_CreateSemaphore(0);
+    if(r->start == NULL || r->done == NULL)
+    {
+        r->num_threads = 0;
+        return;
+    }
+
+    for(i = 1; i <= r->num_threads; i++)
+    {
+        r->workers[i].thread = SDL_CreateThread(&workerThread, "GPU_Rasterizer", &r->workers[i]);
+        if(r->workers[i].thread == NULL)
+        {
+            r->num_threads = i - 1;
+            break;
+        }
+    }
+}
+#endif
+
+static void rasterizeBins(GPU_Rasterizer* r, unsigned int num_pixels)
+{
+    unsigned int num_tiles = (unsigned int)(r->tiles_x*r->tiles_y);
+    unsigned int i;
+
+    #ifdef SDL_GPU_USE_SDL2
+    if(num_pixels >= GPU_RASTER_MIN_PARALLEL_PIXELS && num_tiles > 1)
+    {
+        if(!r->started)
+            startWorkers(r);
+
+        if(r->num_threads > 0)
+        {
+            int n = MIN(r->num_threads, (int)num_tiles - 1);
+            SDL_AtomicSet(&r->next_tile, 0);
+            for(i = 0; i < (unsigned int)n; i++)
+                SDL_SemPost(r->start);
+
+            rasterizeTiles(r, r->workers[0].span);
+
+            for(i = 0; i < (unsigned int)n; i++)
+                SDL_SemWait(r->done);
+            return;
+        }
+    }
+    #else
+    (void)num_pixels;
+    #endif
+
+    for(i = 0; i < num_tiles; i++)
+        rasterizeTile(r, i, r->workers[0].span);
+}
+
+static GPU_bool growArray(void** data, unsigned int* capacity, unsigned int needed, size_t element_size)
+{
+    void* new_data;
+    unsigned int new_capacity;
+
+    if(needed <= *capacity)
+        return GPU_TRUE;
+
+    new_capacity = MAX(needed, *capacity*2);
+    new_data = SDL_realloc(*data, new_capacity*element_size);
+    if(new_data == NULL)
+        return GPU_FALSE;
+
+    *data = new_data;
+    *capacity = new_capacity;
+    return GPU_TRUE;
+}
+
+static void setupTriangle(GPU_Rasterizer* r, const GPU_RasterVertex* v0, const GPU_RasterVertex* v1, const GPU_RasterVertex* v2, int clip_x1, int clip_y1, int clip_x2, int clip_y2)
+{
+    const GPU_RasterVertex* v[3];
+    GPU_RasterTriangle* tri;
+    float area, sign;
+    int e, a;
+
+    if(!v0->visible || !v1->visible || !v2->visible)
+        return;
+
+    area = (v1->x - v0->x)*(v2->y - v0->y) - (v2->x - v0->x)*(v1->y - v0->y);
+    if(area == 0.0f || area != area)
+        return;
+
+    if(!growArray((void**)&r->triangles, &r->max_triangles, r->num_triangles + 1, sizeof(GPU_RasterTriangle)))
+        return;
+    tri = &r->triangles[r->num_triangles];
+
+    tri->min_x = MAX(clip_x1, (int)floorf(MIN(v0->x, MIN(v1->x, v2->x))));
+    tri->min_y = MAX(clip_y1, (int)floorf(MIN(v0->y, MIN(v1->y, v2->y))));
+    tri->max_x = MIN(clip_x2, (int)ceilf(MAX(v0->x, MAX(v1->x, v2->x))));
+    tri->max_y = MIN(clip_y2, (int)ceilf(MAX(v0->y, MAX(v1->y, v2->y))));
+    if(tri->min_x >= tri->max_x || tri->min_y >= tri->max_y)
+        return;
+
+    // Either winding is drawn
+    v[0] = v0;
+    v[1] = v1;
+    v[2] = v2;
+    sign = (area > 0.0f? 1.0f : -1.0f);
+    for(e = 0; e < 3; e++)
+    {
+        const GPU_RasterVertex* p = v[e];
+        const GPU_RasterVertex* q = v[(e + 1) % 3];
+        tri->edge_a[e] = sign*(p->y - q->y);
+        tri->edge_b[e] = sign*(q->x - p->x);
+        tri->edge_c[e] = sign*(p->x*q->y - q->x*p->y);
+    }
+
+    for(a = 0; a < GPU_RASTER_NUM_ATTRIBUTES; a++)
+    {
+        float d1 = v1->attributes[a] - v0->attributes[a];
+        float d2 = v2->attributes[a] - v0->attributes[a];
+        tri->attribute_dx[a] = (d1*(v2->y - v0->y) - d2*(v1->y - v0->y))/area;
+        tri->attribute_dy[a] = (d2*(v1->x - v0->x) - d1*(v2->x - v0->x))/area;
+        tri->attribute_c[a] = v0->attributes[a] - tri->attribute_dx[a]*v0->x - tri->attribute_dy[a]*v0->y;
+    }
+
+    tri->flat_color = GPU_TRUE;
+    for(a = GPU_RASTER_R; a <= GPU_RASTER_A; a++)
+    {
+        if(v0->attributes[a] != v1->attributes[a] || v0->attributes[a] != v2->attributes[a])
+            tri->flat_color = GPU_FALSE;
+        tri->color[a - GPU_RASTER_R] = toByte(v0->attributes[a]);
+    }
+
+    r->num_triangles++;
+}
+
+// Lines are quads of the context's line thickness, in pixels, like glLineWidth()
+static void setupLine(GPU_Rasterizer* r, const GPU_RasterVertex* v0, const GPU_RasterVertex* v1, float thickness, int clip_x1, int clip_y1, int clip_x2, int clip_y2)
+{
+    GPU_RasterVertex corners[4];
+    float dx = v1->x - v0->x;
+    float dy = v1->y - v0->y;
+    float length = sqrtf(dx*dx + dy*dy);
+    float nx, ny;
+
+    if(length == 0.0f)
+        return;
+
+    nx = -dy/length*thickness*0.5f;
+    ny = dx/length*thickness*0.5f;
+
+    corners[0] = *v0;
+    corners[1] = *v1;
+    corners[2] = *v1;
+    corners[3] = *v0;
+    corners[0].x += nx;
+    corners[0].y += ny;
+    corners[1].x += nx;
+    corners[1].y += ny;
+    corners[2].x -= nx;
+    corners[2].y -= ny;
+    corners[3].x -= nx;
+    corners[3].y -= ny;
+    setupTriangle(r, &corners[0], &corners[1], &corners[2], clip_x1, clip_y1, clip_x2, clip_y2);
+    setupTriangle(r, &corners[0], &corners[2], &corners[3], clip_x1, clip_y1, clip_x2, clip_y2);
+}
+
+// Points are one-pixel squares
+static void setupPoint(GPU_Rasterizer* r, const GPU_RasterVertex* v, int clip_x1, int clip_y1, int clip_x2, int clip_y2)
+{
+    GPU_RasterVertex corners[4];
+    int i;
+
+    for(i = 0; i < 4; i++)
+    {
+        corners[i] = *v;
+        corners[i].x += ((i == 1 || i == 2)? 0.5f : -0.5f);
+        corners[i].y += (i >= 2? 0.5f : -0.5f);
+    }
+    setupTriangle(r, &corners[0], &corners[1], &corners[2], clip_x1, clip_y1, clip_x2, clip_y2);
+    setupTriangle(r, &corners[0], &corners[2], &corners[3], clip_x1, clip_y1, clip_x2, clip_y2);
+}
+
+// Sorts the triangles into tiles, keeping them in submission order within each tile
+static GPU_bool binTriangles(GPU_Rasterizer* r, unsigned int* num_pixels)
+{
+    unsigned int num_tiles = (unsigned int)(r->tiles_x*r->tiles_y);
+    unsigned int i, total;
+    int x, y;
+
+    if(!growArray((void**)&r->bin_starts, &r->max_bins, num_tiles + 1, sizeof(unsigned int)))
+        return GPU_FALSE;
+    r->bin_fill = (unsigned int*)SDL_realloc(r->bin_fill, r->max_bins*sizeof(unsigned int));
+    if(r->bin_fill == NULL)
+        return GPU_FALSE;
+
+    memset(r->bin_fill, 0, num_tiles*sizeof(unsigned int));
+    *num_pixels = 0;
+    for(i = 0; i < r->num_triangles; i++)
+    {
+        GPU_RasterTriangle* tri = &r->triangles[i];
+        *num_pixels += (unsigned int)((tri->max_x - tri->min_x)*(tri->max_y - tri->min_y));
+        for(y = tri->min_y/GPU_RASTER_TILE_SIZE; y <= (tri->max_y - 1)/GPU_RASTER_TILE_SIZE; y++)
+        {
+            for(x = tri->min_x/GPU_RASTER_TILE_SIZE; x <= (tri->max_x - 1)/GPU_RASTER_TILE_SIZE; x++)
+                r->bin_fill[y*r->tiles_x + x]++;
+        }
+    }
+
+    total = 0;
+    for(i = 0; i < num_tiles; i++)
+    {
+        r->bin_starts[i] = total;
+        total += r->bin_fill[i];
+        r->bin_fill[i] = r->bin_starts[i];
+    }
+    r->bin_starts[num_tiles] = total;
+
+    if(!growArray((void**)&r->bin_items, &r->max_bin_items, total, sizeof(unsigned int)))
+        return GPU_FALSE;
+
+    for(i = 0; i < r->num_triangles; i++)
+    {
+        GPU_RasterTriangle* tri = &r->triangles[i];
+        for(y = tri->min_y/GPU_RASTER_TILE_SIZE; y <= (tri->max_y - 1)/GPU_RASTER_TILE_SIZE; y++)
+        {
+            for(x = tri->min_x/GPU_RASTER_TILE_SIZE; x <= (tri->max_x - 1)/GPU_RASTER_TILE_SIZE; x++)
+                r->bin_items[r->bin_fill[y*r->tiles_x + x]++] = i;
+        }
+    }
+    return GPU_TRUE;
+}
+
+// Maps the vertices through the MVP and the viewport to surface pixels, as glViewport() would
+static GPU_bool transformVertices(GPU_Rasterizer* r, GPU_Renderer* renderer, GPU_Target* dest, const float* mvp, const float* vertices, unsigned int num_vertices)
+{
+    GPU_Rect viewport = dest->viewport;
+    float surface_h = (float)r->surface->h;
+    float viewport_y = viewport.y;
+    unsigned int i;
+    int a;
+
+    if(!growArray((void**)&r->vertices, &r->max_vertices, num_vertices, sizeof(GPU_RasterVertex)))
+        return GPU_FALSE;
+
+    if(renderer->coordinate_mode == 0)
+        viewport_y = surface_h - viewport.h - viewport.y;
+
+    for(i = 0; i < num_vertices; i++)
+    {
+        const float* in = vertices + i*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+        GPU_RasterVertex* out = &r->vertices[i];
+        float x = mvp[0]*in[0] + mvp[4]*in[1] + mvp[12];
+        float y = mvp[1]*in[0] + mvp[5]*in[1] + mvp[13];
+        float w = mvp[3]*in[0] + mvp[7]*in[1] + mvp[15];
+        float gl_y;
+
+        out->visible = (w > 0.0f);
+        if(!out->visible)
+            continue;
+
+        out->x = viewport.x + (x/w + 1.0f)*0.5f*viewport.w;
+        gl_y = viewport_y + (y/w + 1.0f)*0.5f*viewport.h;
+        // Texture rows go up from GL's origin and window rows go down
+        out->y = (dest->image != NULL? gl_y : surface_h - gl_y);
+        for(a = 0; a < GPU_RASTER_NUM_ATTRIBUTES; a++)
+            out->attributes[a] = in[GPU_BLIT_BUFFER_TEX_COORD_OFFSET + a];
+    }
+    return GPU_TRUE;
+}
+
+static_inline unsigned int getIndex(const void* indices, int index_size, unsigned int i)
+{
+    if(indices == NULL)
+        return i;
+    if(index_size == sizeof(unsigned short))
+        return ((const unsigned short*)indices)[i];
+    return ((const unsigned int*)indices)[i];
+}
+
+static void rasterizeVertices(GPU_Renderer* renderer, GPU_Target* dest, GPU_Image* image, unsigned int shape,
+                              const float* vertices, unsigned int num_vertices, const void* indices, int index_size, unsigned int num_indices)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
+    GPU_Rasterizer* r = cdata->rasterizer;
+    int clip_x1, clip_y1, clip_x2, clip_y2;
+    unsigned int num_pixels;
+    unsigned int i, count;
+
+    if(r == NULL || num_vertices == 0)
+        return;
+
+    r->surface = getTargetSurface(dest);
+    if(r->surface == NULL)
+        return;
+
+    if(indices == NULL)
+        num_indices = num_vertices;
+
+    if(!transformVertices(r, renderer, dest, cdata->last_mvp, vertices, num_vertices))
+    {
+        GPU_PushErrorCode("GPU_FlushBlitBuffer", GPU_ERROR_BACKEND_ERROR, "Failed to allocate rasterizer vertices");
+        return;
+    }
+
+    getClipPixels(renderer, dest, r->surface, &clip_x1, &clip_y1, &clip_x2, &clip_y2);
+    if(clip_x1 >= clip_x2 || clip_y1 >= clip_y2)
+        return;
+
+    // Assemble the primitives
+    r->num_triangles = 0;
+    count = num_indices;
+    switch(shape)
+    {
+        case GL_TRIANGLES:
+            for(i = 0; i + 2 < count; i += 3)
+                setupTriangle(r, &r->vertices[getIndex(indices, index_size, i)], &r->vertices[getIndex(indices, index_size, i + 1)], &r->vertices[getIndex(indices, index_size, i + 2)],
+                              clip_x1, clip_y1, clip_x2, clip_y2);
+            break;
+        case GL_TRIANGLE_STRIP:
+            for(i = 0; i + 2 < count; i++)
+                setupTriangle(r, &r->vertices[getIndex(indices, index_size, i)], &r->vertices[getIndex(indices, index_size, i + 1)], &r->vertices[getIndex(indices, index_size, i + 2)],
+                              clip_x1, clip_y1, clip_x2, clip_y2);
+            break;
+        case GL_TRIANGLE_FAN:
+            for(i = 1; i + 1 < count; i++)
+                setupTriangle(r, &r->vertices[getIndex(indices, index_size, 0)], &r->vertices[getIndex(indices, index_size, i)], &r->vertices[getIndex(indices, index_size, i + 1)],
+                              clip_x1, clip_y1, clip_x2, clip_y2);
+            break;
+        case GL_LINES:
+            for(i = 0; i + 1 < count; i += 2)
+                setupLine(r, &r->vertices[getIndex(indices, index_size, i)], &r->vertices[getIndex(indices, index_size, i + 1)], context->line_thickness,
+                          clip_x1, clip_y1, clip_x2, clip_y2);
+            break;
+        case GL_LINE_STRIP:
+        case GL_LINE_LOOP:
+            for(i = 0; i + 1 < count; i++)
+                setupLine(r, &r->vertices[getIndex(indices, index_size, i)], &r->vertices[getIndex(indices, index_size, i + 1)], context->line_thickness,
+                          clip_x1, clip_y1, clip_x2, clip_y2);
+            if(shape == GL_LINE_LOOP && count > 2)
+                setupLine(r, &r->vertices[getIndex(indices, index_size, count - 1)], &r->vertices[getIndex(indices, index_size, 0)], context->line_thickness,
+                          clip_x1, clip_y1, clip_x2, clip_y2);
+            break;
+        case GL_POINTS:
+            for(i = 0; i < count; i++)
+            {
+                GPU_RasterVertex* v = &r->vertices[getIndex(indices, index_size, i)];
+                if(v->visible)
+                    setupPoint(r, v, clip_x1, clip_y1, clip_x2, clip_y2);
+            }
+            break;
+    }
+
+    if(r->num_triangles == 0)
+        return;
+
+    r->tiles_x = (r->surface->w + GPU_RASTER_TILE_SIZE - 1)/GPU_RASTER_TILE_SIZE;
+    r->tiles_y = (r->surface->h + GPU_RASTER_TILE_SIZE - 1)/GPU_RASTER_TILE_SIZE;
+    if(!binTriangles(r, &num_pixels))
+    {
+        GPU_PushErrorCode("GPU_FlushBlitBuffer", GPU_ERROR_BACKEND_ERROR, "Failed to allocate rasterizer bins");
+        return;
+    }
+
+    r->texture = (image != NULL? ((GPU_IMAGE_DATA*)image->data)->pixels : NULL);
+    if(image != NULL)
+    {
+        r->filter = image->filter_mode;
+        r->wrap_x = image->wrap_mode_x;
+        r->wrap_y = image->wrap_mode_y;
+    }
+    r->use_blending = cdata->last_use_blending;
+    r->blend_mode = cdata->last_blend_mode;
+    r->normal_blending = (r->blend_mode.source_color == GPU_FUNC_SRC_ALPHA && r->blend_mode.dest_color == GPU_FUNC_ONE_MINUS_SRC_ALPHA
+                          && r->blend_mode.source_alpha == GPU_FUNC_SRC_ALPHA && r->blend_mode.dest_alpha == GPU_FUNC_ONE_MINUS_SRC_ALPHA
+                          && r->blend_mode.color_equation == GPU_EQ_ADD && r->blend_mode.alpha_equation == GPU_EQ_ADD);
+
+    rasterizeBins(r, num_pixels);
+}
+
+static void createRasterizer(GPU_CONTEXT_DATA* cdata)
+{
+    GPU_Rasterizer* r = (GPU_Rasterizer*)SDL_malloc(sizeof(GPU_Rasterizer));
+    int i;
+
+    cdata->rasterizer = r;
+    if(r == NULL)
+        return;
+
+    memset(r, 0, sizeof(GPU_Rasterizer));
+    for(i = 0; i <= GPU_RASTER_MAX_THREADS; i++)
+        r->workers[i].rasterizer = r;
+}
+
+static void freeRasterizer(GPU_CONTEXT_DATA* cdata)
+{
+    GPU_Rasterizer* r = cdata->rasterizer;
+    if(r == NULL)
+        return;
+
+    #ifdef SDL_GPU_USE_SDL2
+    if(r->num_threads > 0)
+    {
+        int i;
+        r->quitting = GPU_TRUE;
+        for(i = 1; i <= r->num_threads; i++)
+            SDL_SemPost(r->start);
+        for(i = 1; i <= r->num_threads; i++)
+            SDL_WaitThread(r->workers[i].thread, NULL);
+    }
+    if(r->start != NULL)
+        SDL_DestroySemaphore(r->start);
+    if(r->done != NULL)
+        SDL_DestroySemaphore(r->done);
+    #endif
+
+    SDL_free(r->vertices);
+    SDL_free(r->triangles);
+    SDL_free(r->bin_starts);
+    SDL_free(r->bin_fill);
+    SDL_free(r->bin_items);
+    SDL_free(r);
+    cdata->rasterizer = NULL;
+}
+
+
+GPU_Renderer* GPU_CreateRenderer_Software(GPU_RendererID request)
+{
+    GPU_RendererImpl* impl;
+    GPU_Renderer* renderer = (GPU_Renderer*)SDL_malloc(sizeof(GPU_Renderer));
+    if(renderer == NULL)
+        return NULL;
+
+    memset(renderer, 0, sizeof(GPU_Renderer));
+
+    renderer->id = request;
+    renderer->id.renderer = GPU_RENDERER_SOFTWARE;
+    renderer->shader_language = GPU_LANGUAGE_NONE;
+    renderer->min_shader_version = 0;
+    renderer->max_shader_version = 0;
+
+    renderer->default_image_anchor_x = 0.5f;
+    renderer->default_image_anchor_y = 0.5f;
+
+    renderer->current_context_target = NULL;
+
+    impl = (GPU_RendererImpl*)SDL_malloc(sizeof(GPU_RendererImpl));
+    memset(impl, 0, sizeof(GPU_RendererImpl));
+    renderer->impl = impl;
+
+    SET_COMMON_FUNCTIONS(impl);
+
+    return renderer;
+}
+
+void GPU_FreeRenderer_Software(GPU_Renderer* renderer)
+{
+    if(renderer == NULL)
+        return;
+
+    SDL_free(renderer->impl);
+    SDL_free(renderer);
+}
+
+
+#endif
@@ -0,0 +1,341 @@
+/* This is an implementation file to be included after certain #defines have been set.
+See a particular renderer's *.c file for specifics.
+
+The parts of renderer_GL_common.inl and renderer_CPU_common.inl that don't touch GL: frame statistics, culling,
+and the render state and aliasing that only live in GPU_Target and GPU_Image. */
+
+
+// Frame statistics cost one flag test per counter unless they are compiled out
+#ifdef SDL_GPU_DISABLE_FRAME_STATS
+#define GPU_COUNT_FRAME_STAT(context, field, amount) do{ (void)(amount); }while(0)
+#else
+#define GPU_COUNT_FRAME_STAT(context, field, amount) do{ if((context)->use_frame_stats) (context)->frame_stats.field += (amount); }while(0)
+#endif
+
+#define MIX_COLOR_COMPONENT_NORMALIZED_RESULT(a, b) ((a)/255.0f * (b)/255.0f)
+#define MIX_COLOR_COMPONENT(a, b) ((Uint8)(((a)/255.0f * (b)/255.0f)*255))
+
+
+// Each renderer defines these.  getTargetModelViewProjection() returns the target's model-view-projection matrix, in 'storage' unless the renderer keeps a current copy.
+static float* getTargetModelViewProjection(GPU_Renderer* renderer, GPU_Target* target, float* storage);
+static void blitSpriteBatch(GPU_Renderer* renderer, const char* function_name, GPU_Image* image, GPU_Target* target, unsigned int num_sprites,
+                            float* positions, int position_stride, float* src_rects, int rect_stride, float* colors, int color_stride, GPU_BlitFlagEnum flags);
+
+
+// Flushes the blit buffer, recording why for the frame statistics
+static void flushBlitBufferFor(GPU_Renderer* renderer, GPU_FlushCauseEnum cause)
+{
+    if(renderer->current_context_target == NULL)
+        return;
+
+    renderer->current_context_target->context->flush_cause = cause;
+    renderer->impl->FlushBlitBuffer(renderer);
+}
+
+static_inline GPU_bool isCurrentTarget(GPU_Renderer* renderer, GPU_Target* target)
+{
+    return (target == renderer->current_context_target->context->active_target
+            || renderer->current_context_target->context->active_target == NULL);
+}
+
+static GPU_bool equal_cameras(GPU_Camera a, GPU_Camera b)
+{
+    return (a.x == b.x && a.y == b.y && a.z == b.z && a.angle == b.angle && a.zoom_x == b.zoom_x && a.zoom_y == b.zoom_y && a.use_centered_origin == b.use_centered_origin);
+}
+
+static SDL_Color get_complete_mod_color(GPU_Renderer* renderer, GPU_Target* target, GPU_Image* image)
+{
+	(void)renderer;
+	SDL_Color color = { 255, 255, 255, 255 };
+	if(target->use_color)
+	{
+		if ( image != NULL )
+		{
+			color.r = MIX_COLOR_COMPONENT(target->color.r, image->color.r);
+			color.g = MIX_COLOR_COMPONENT(target->color.g, image->color.g);
+			color.b = MIX_COLOR_COMPONENT(target->color.b, image->color.b);
+			GET_ALPHA(color) = MIX_COLOR_COMPONENT(GET_ALPHA(target->color), GET_ALPHA(image->color));
+		} else {
+			color = target->color;
+		}
+		
+		return color;
+	}
+	else if ( image != NULL )
+		return image->color;
+	else
+		return color;
+}
+
+// Conservatively tests whether the given box (in the target's model space) would land outside of the target's viewport and clip rect.
+// Mirrors the viewport and scissor math of the GL renderers' forceChangeViewport() and setClipRect(), so everything is compared in GL window coordinates.
+static GPU_bool isCulled(GPU_Renderer* renderer, GPU_Target* target, unsigned int shape, float min_x, float min_y, float max_x, float max_y)
+{
+    GPU_Context* context;
+    float* mvp;
+    float mvp_storage[16];
+    float corners[8];
+    float win_min_x, win_min_y, win_max_x, win_max_y;
+    float visible_x1, visible_y1, visible_x2, visible_y2;
+    float margin;
+    GPU_Rect viewport;
+    int i;
+
+    if(renderer->current_context_target == NULL)
+        return GPU_FALSE;
+
+    context = renderer->current_context_target->context;
+    context->num_submitted_primitives++;
+    if(!target->use_culling)
+        return GPU_FALSE;
+
+    mvp = getTargetModelViewProjection(renderer, target, mvp_storage);
+
+    corners[0] = min_x;
+    corners[1] = min_y;
+    corners[2] = max_x;
+    corners[3] = min_y;
+    corners[4] = max_x;
+    corners[5] = max_y;
+    corners[6] = min_x;
+    corners[7] = max_y;
+
+    // Viewport in GL window coordinates
+    viewport = target->viewport;
+    if(renderer->coordinate_mode == 0)
+    {
+        if(target->image != NULL)
+            viewport.y = target->image->texture_h - viewport.h - viewport.y;
+        else if(target->context != NULL)
+            viewport.y = target->context->drawable_h - viewport.h - viewport.y;
+    }
+
+    win_min_x = win_min_y = win_max_x = win_max_y = 0.0f;
+    for(i = 0; i < 8; i += 2)
+    {
+        // Column-major, with z = 0 and w = 1
+        float clip_x = mvp[0]*corners[i] + mvp[4]*corners[i+1] + mvp[12];
+        float clip_y = mvp[1]*corners[i] + mvp[5]*corners[i+1] + mvp[13];
+        float clip_w = mvp[3]*corners[i] + mvp[7]*corners[i+1] + mvp[15];
+        float wx, wy;
+
+        // Behind the eye in a perspective projection.  Don't guess.
+        if(clip_w <= 0.0f)
+            return GPU_FALSE;
+
+        wx = viewport.x + (clip_x/clip_w + 1.0f)*0.5f*viewport.w;
+        wy = viewport.y + (clip_y/clip_w + 1.0f)*0.5f*viewport.h;
+        if(i == 0 || wx < win_min_x)
+            win_min_x = wx;
+        if(i == 0 || wx > win_max_x)
+            win_max_x = wx;
+        if(i == 0 || wy < win_min_y)
+            win_min_y = wy;
+        if(i == 0 || wy > win_max_y)
+            win_max_y = wy;
+    }
+
+    // Leave room for rasterization rounding, and for GL points and lines which are sized in pixels
+    margin = 1.0f;
+    if(shape == GL_POINTS || shape == GL_LINES)
+        margin += context->line_thickness;
+
+    visible_x1 = viewport.x;
+    visible_y1 = viewport.y;
+    visible_x2 = viewport.x + viewport.w;
+    visible_y2 = viewport.y + viewport.h;
+
+    if(target->use_clip_rect)
+    {
+        GPU_Rect scissor = target->clip_rect;
+        if(target->context != NULL)
+        {
+            GPU_Target* context_target = renderer->current_context_target;
+            float xFactor = ((float)context_target->context->drawable_w)/context_target->w;
+            float yFactor = ((float)context_target->context->drawable_h)/context_target->h;
+            if(renderer->coordinate_mode == 0)
+                scissor.y = context_target->h - (target->clip_rect.y + target->clip_rect.h);
+            scissor.x *= xFactor;
+            scissor.y *= yFactor;
+            scissor.w *= xFactor;
+            scissor.h *= yFactor;
+        }
+
+        if(scissor.x > visible_x1)
+            visible_x1 = scissor.x;
+        if(scissor.y > visible_y1)
+            visible_y1 = scissor.y;
+        if(scissor.x + scissor.w < visible_x2)
+            visible_x2 = scissor.x + scissor.w;
+        if(scissor.y + scissor.h < visible_y2)
+            visible_y2 = scissor.y + scissor.h;
+    }
+
+    if(win_max_x + margin < visible_x1 || win_min_x - margin > visible_x2
+       || win_max_y + margin < visible_y1 || win_min_y - margin > visible_y2)
+    {
+        context->num_culled_primitives++;
+        return GPU_TRUE;
+    }
+    return GPU_FALSE;
+}
+
+
+static void Quit(GPU_Renderer* renderer)
+{
+    renderer->impl->FreeTarget(renderer, renderer->current_context_target);
+    renderer->current_context_target = NULL;
+}
+
+static void SetAsCurrent(GPU_Renderer* renderer)
+{
+    if(renderer->current_context_target == NULL)
+        return;
+
+    renderer->impl->MakeCurrent(renderer, renderer->current_context_target, renderer->current_context_target->context->windowID);
+}
+
+static GPU_Target* CreateAliasTarget(GPU_Renderer* renderer, GPU_Target* target)
+{
+	GPU_Target* result;
+	(void)renderer;
+
+    if(target == NULL)
+        return NULL;
+
+    result = (GPU_Target*)SDL_malloc(sizeof(GPU_Target));
+
+    // Copy the members
+    *result = *target;
+
+	// Deep copies
+	result->projection_matrix.matrix = NULL;
+	result->view_matrix.matrix = NULL;
+	result->model_matrix.matrix = NULL;
+	result->projection_matrix.size = result->projection_matrix.storage_size = 0;
+	result->view_matrix.size = result->view_matrix.storage_size = 0;
+	result->model_matrix.size = result->model_matrix.storage_size = 0;
+	GPU_CopyMatrixStack(&target->projection_matrix, &result->projection_matrix);
+	GPU_CopyMatrixStack(&target->view_matrix, &result->view_matrix);
+	GPU_CopyMatrixStack(&target->model_matrix, &result->model_matrix);
+
+    // Alias info
+    if(target->image != NULL)
+        target->image->refcount++;
+    if(target->context != NULL)
+        target->context->refcount++;
+    ((GPU_TARGET_DATA*)target->data)->refcount++;
+    result->refcount = 1;
+    result->is_alias = GPU_TRUE;
+
+    return result;
+}
+
+static GPU_Image* CreateAliasImage(GPU_Renderer* renderer, GPU_Image* image)
+{
+	GPU_Image* result;
+	(void)renderer;
+
+    if(image == NULL)
+        return NULL;
+
+    result = (GPU_Image*)SDL_malloc(sizeof(GPU_Image));
+    // Copy the members
+    *result = *image;
+
+    // Alias info
+    ((GPU_IMAGE_DATA*)image->data)->refcount++;
+    result->refcount = 1;
+    result->is_alias = GPU_TRUE;
+
+    return result;
+}
+
+static GPU_Camera SetCamera(GPU_Renderer* renderer, GPU_Target* target, GPU_Camera* cam)
+{
+    GPU_Camera new_camera;
+	GPU_Camera old_camera;
+
+    if(target == NULL)
+    {
+        GPU_PushErrorCode("GPU_SetCamera", GPU_ERROR_NULL_ARGUMENT, "target");
+        return GPU_GetDefaultCamera();
+    }
+
+    if(cam == NULL)
+        new_camera = GPU_GetDefaultCamera();
+    else
+        new_camera = *cam;
+
+    old_camera = target->camera;
+
+    if(!equal_cameras(new_camera, old_camera))
+    {
+        if(isCurrentTarget(renderer, target))
+            flushBlitBufferFor(renderer, GPU_FLUSH_MATRIX_CHANGE);
+
+        new_camera.generation = gpu_next_matrix_generation();
+        target->camera = new_camera;
+    }
+
+    return old_camera;
+}
+
+static GPU_Rect SetClip(GPU_Renderer* renderer, GPU_Target* target, Sint16 x, Sint16 y, Uint16 w, Uint16 h)
+{
+	GPU_Rect r;
+    if(target == NULL)
+    {
+        r.x = r.y = r.w = r.h = 0;
+        return r;
+    }
+
+    if(isCurrentTarget(renderer, target))
+        flushBlitBufferFor(renderer, GPU_FLUSH_CLIP_CHANGE);
+    target->use_clip_rect = GPU_TRUE;
+
+    r = target->clip_rect;
+
+    target->clip_rect.x = x;
+    target->clip_rect.y = y;
+    target->clip_rect.w = w;
+    target->clip_rect.h = h;
+
+    return r;
+}
+
+static void UnsetClip(GPU_Renderer* renderer, GPU_Target* target)
+{
+    if(target == NULL)
+        return;
+
+    if(isCurrentTarget(renderer, target))
+        flushBlitBufferFor(renderer, GPU_FLUSH_CLIP_CHANGE);
+    // Leave the clip rect values intact so they can still be useful as storage
+    target->use_clip_rect = GPU_FALSE;
+}
+
+static void BlitBatchSeparate(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* positions, float* src_rects, float* colors, GPU_BlitFlagEnum flags)
+{
+    blitSpriteBatch(renderer, "GPU_BlitBatchSeparate", image, target, num_sprites,
+                    positions, ((flags & GPU_PASSTHROUGH_VERTICES)? 8 : 2),
+                    src_rects, ((flags & GPU_PASSTHROUGH_TEXCOORDS)? 8 : 4),
+                    colors, ((flags & GPU_PASSTHROUGH_COLORS)? 16 : 4), flags);
+}
+
+static GPU_TextureHandle GetTextureHandle(GPU_Renderer* renderer, GPU_Image* image)
+{
+	(void)renderer;
+    return ((GPU_IMAGE_DATA*)image->data)->handle;
+}
+
+static void DeactivateShaderProgram(GPU_Renderer* renderer)
+{
+    renderer->impl->ActivateShaderProgram(renderer, 0, NULL);
+}
+
+static const char* GetShaderMessage(GPU_Renderer* renderer)
+{
+	(void)renderer;
+    return shader_message;
+}
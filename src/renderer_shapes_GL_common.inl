@@ -2,15 +2,16 @@
 See a particular renderer's *.c file for specifics. */
 
 
-// All shapes start this way for setup and so they can access the blit buffer properly
-#define BEGIN_UNTEXTURED(function_name, shape, num_additional_vertices, num_additional_indices) \
+// All shapes start this way for setup and so they can access the blit buffer properly.
+// min_x, min_y, max_x, and max_y bound the shape for culling (see GPU_SetCulling()).
+#define BEGIN_UNTEXTURED(function_name, shape, num_additional_vertices, num_additional_indices, min_x, min_y, max_x, max_y) \
 	GPU_CONTEXT_DATA* cdata; \
 	float* blit_buffer; \
-	unsigned short* index_buffer; \
+	GPU_BLIT_INDEX_TYPE* index_buffer; \
 	int vert_index; \
 	int color_index; \
 	float r, g, b, a; \
-	unsigned short blit_buffer_starting_index; \
+	GPU_BLIT_INDEX_TYPE blit_buffer_starting_index; \
     if(target == NULL) \
     { \
         GPU_PushErrorCode(function_name, GPU_ERROR_NULL_ARGUMENT, "target"); \
@@ -29,27 +30,36 @@ See a particular renderer's *.c file for specifics. */
         return; \
     } \
      \
+    if(isCulled(renderer, target, shape, (min_x), (min_y), (max_x), (max_y))) \
+        return; \
+     \
     if(!SetActiveTarget(renderer, target)) \
     { \
         GPU_PushErrorCode(function_name, GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer."); \
         return; \
     } \
      \
-    prepareToRenderToTarget(renderer, target); \
-    prepareToRenderShapes(renderer, shape); \
+    if(isRecordingSortedBatch(renderer->current_context_target->context, target)) \
+        renderer->impl->SetCamera(renderer, target, &target->camera); \
+    else \
+    { \
+        prepareToRenderToTarget(renderer, target); \
+        prepareToRenderShapes(renderer, shape); \
+    } \
      \
     cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data; \
      \
     if(cdata->blit_buffer_num_vertices + (num_additional_vertices) >= cdata->blit_buffer_max_num_vertices) \
     { \
         if(!growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + (num_additional_vertices))) \
-            renderer->impl->FlushBlitBuffer(renderer); \
+            flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL); \
     } \
     if(cdata->index_buffer_num_vertices + (num_additional_indices) >= cdata->index_buffer_max_num_vertices) \
     { \
         if(!growIndexBuffer(cdata, cdata->index_buffer_num_vertices + (num_additional_indices))) \
-            renderer->impl->FlushBlitBuffer(renderer); \
+            flushBlitBufferFor(renderer, GPU_FLUSH_BUFFER_FULL); \
     } \
+    recordSortedDraw(renderer, target, NULL, shape); \
      \
     blit_buffer = cdata->blit_buffer; \
     index_buffer = cdata->index_buffer; \
@@ -79,6 +89,37 @@ See a particular renderer's *.c file for specifics. */
 #define SDL_GPU_CIRCLE_SEGMENT_ANGLE_FACTOR 0.625f
 
 
+// Bounding box of a vertex list, for culling.  Skipped when the target doesn't cull.
+static GPU_Rect getVertexBounds(GPU_Target* target, unsigned int num_vertices, float* vertices)
+{
+    GPU_Rect result = {0.0f, 0.0f, 0.0f, 0.0f};
+    float max_x, max_y;
+    unsigned int i;
+
+    if(target == NULL || !target->use_culling || num_vertices == 0)
+        return result;
+
+    result.x = max_x = vertices[0];
+    result.y = max_y = vertices[1];
+    for(i = 1; i < num_vertices; i++)
+    {
+        float x = vertices[2*i];
+        float y = vertices[2*i + 1];
+        if(x < result.x)
+            result.x = x;
+        else if(x > max_x)
+            max_x = x;
+        if(y < result.y)
+            result.y = y;
+        else if(y > max_y)
+            max_y = y;
+    }
+    result.w = max_x - result.x;
+    result.h = max_y - result.y;
+    return result;
+}
+
+
 #define CALCULATE_CIRCLE_DT_AND_SEGMENTS(radius) \
 	dt = SDL_GPU_CIRCLE_SEGMENT_ANGLE_FACTOR/sqrtf(radius);  /* s = rA, so dA = ds/r.  ds of 1.25*sqrt(radius) is good */ \
 	numSegments = (int)(2*PI/dt) + 1; \
@@ -99,7 +140,7 @@ static float SetLineThickness(GPU_Renderer* renderer, float thickness)
     
 	old = renderer->current_context_target->context->line_thickness;
 	if(old != thickness)
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_STATE_CHANGE);
     
 	renderer->current_context_target->context->line_thickness = thickness;
 	#ifndef SDL_GPU_SKIP_LINE_WIDTH
@@ -115,7 +156,7 @@ static float GetLineThickness(GPU_Renderer* renderer)
 
 static void Pixel(GPU_Renderer* renderer, GPU_Target* target, float x, float y, SDL_Color color)
 {
-    BEGIN_UNTEXTURED("GPU_Pixel", GL_POINTS, 1, 1);
+    BEGIN_UNTEXTURED("GPU_Pixel", GL_POINTS, 1, 1, x, y, x, y);
     
     SET_UNTEXTURED_VERTEX(x, y, r, g, b, a);
 }
@@ -129,7 +170,7 @@ static void Line(GPU_Renderer* renderer, GPU_Target* target, float x1, float y1,
     float tc = t*cosf(line_angle);
     float ts = t*sinf(line_angle);
 
-    BEGIN_UNTEXTURED("GPU_Line", GL_TRIANGLES, 4, 6);
+    BEGIN_UNTEXTURED("GPU_Line", GL_TRIANGLES, 4, 6, MIN(x1, x2) - t, MIN(y1, y2) - t, MAX(x1, x2) + t, MAX(y1, y2) + t);
     
     SET_UNTEXTURED_VERTEX(x1 + ts, y1 - tc, r, g, b, a);
     SET_UNTEXTURED_VERTEX(x1 - ts, y1 + tc, r, g, b, a);
@@ -197,7 +238,7 @@ static void Arc(GPU_Renderer* renderer, GPU_Target* target, float x, float y, fl
 		return;
     
 	{
-		BEGIN_UNTEXTURED("GPU_Arc", GL_TRIANGLES, 2*(numSegments), 6*(numSegments));
+		BEGIN_UNTEXTURED("GPU_Arc", GL_TRIANGLES, 2*(numSegments), 6*(numSegments), x - outer_radius, y - outer_radius, x + outer_radius, y + outer_radius);
 		
         c = cosf(dt);
         s = sinf(dt);
@@ -274,7 +315,7 @@ static void ArcFilled(GPU_Renderer* renderer, GPU_Target* target, float x, float
 		return;
 
 	{
-		BEGIN_UNTEXTURED("GPU_ArcFilled", GL_TRIANGLES, 3 + (numSegments - 1) + 1, 3 + (numSegments - 1) * 3 + 3);
+		BEGIN_UNTEXTURED("GPU_ArcFilled", GL_TRIANGLES, 3 + (numSegments - 1) + 1, 3 + (numSegments - 1) * 3 + 3, x - radius, y - radius, x + radius, y + radius);
         
         c = cosf(dt);
         s = sinf(dt);
@@ -335,7 +376,7 @@ static void Circle(GPU_Renderer* renderer, GPU_Target* target, float x, float y,
     float c = cosf(dt);
     float s = sinf(dt);
     
-    BEGIN_UNTEXTURED("GPU_Circle", GL_TRIANGLES, 2*(numSegments), 6*(numSegments));
+    BEGIN_UNTEXTURED("GPU_Circle", GL_TRIANGLES, 2*(numSegments), 6*(numSegments), x - outer_radius, y - outer_radius, x + outer_radius, y + outer_radius);
     
     if(inner_radius < 0.0f)
         inner_radius = 0.0f;
@@ -370,7 +411,7 @@ static void CircleFilled(GPU_Renderer* renderer, GPU_Target* target, float x, fl
     float c = cosf(dt);
     float s = sinf(dt);
     
-    BEGIN_UNTEXTURED("GPU_CircleFilled", GL_TRIANGLES, 3 + (numSegments-2), 3 + (numSegments-2)*3 + 3);
+    BEGIN_UNTEXTURED("GPU_CircleFilled", GL_TRIANGLES, 3 + (numSegments-2), 3 + (numSegments-2)*3 + 3, x - radius, y - radius, x + radius, y + radius);
     
     // First triangle
     SET_UNTEXTURED_VERTEX(x, y, r, g, b, a);  // Center
@@ -422,7 +463,7 @@ static void Ellipse(GPU_Renderer* renderer, GPU_Target* target, float x, float y
     float inner_trans_x, inner_trans_y;
     float outer_trans_x, outer_trans_y;
     
-    BEGIN_UNTEXTURED("GPU_Ellipse", GL_TRIANGLES, 2*(numSegments), 6*(numSegments));
+    BEGIN_UNTEXTURED("GPU_Ellipse", GL_TRIANGLES, 2*(numSegments), 6*(numSegments), x - MAX(outer_radius_x, outer_radius_y), y - MAX(outer_radius_x, outer_radius_y), x + MAX(outer_radius_x, outer_radius_y), y + MAX(outer_radius_x, outer_radius_y));
     
     if(inner_radius_x < 0.0f)
         inner_radius_x = 0.0f;
@@ -469,7 +510,7 @@ static void EllipseFilled(GPU_Renderer* renderer, GPU_Target* target, float x, f
     float s = sinf(dt);
     float trans_x, trans_y;
     
-    BEGIN_UNTEXTURED("GPU_EllipseFilled", GL_TRIANGLES, 3 + (numSegments-2), 3 + (numSegments-2)*3 + 3);
+    BEGIN_UNTEXTURED("GPU_EllipseFilled", GL_TRIANGLES, 3 + (numSegments-2), 3 + (numSegments-2)*3 + 3, x - MAX(rx, ry), y - MAX(rx, ry), x + MAX(rx, ry), y + MAX(rx, ry));
     
     // First triangle
     SET_UNTEXTURED_VERTEX(x, y, r, g, b, a);  // Center
@@ -614,7 +655,7 @@ static void SectorFilled(GPU_Renderer* renderer, GPU_Target* target, float x, fl
 	{
 		int i;
 		GPU_bool use_inner;
-		BEGIN_UNTEXTURED("GPU_SectorFilled", GL_TRIANGLES, 3 + (numSegments - 1) + 1, 3 + (numSegments - 1) * 3 + 3);
+		BEGIN_UNTEXTURED("GPU_SectorFilled", GL_TRIANGLES, 3 + (numSegments - 1) + 1, 3 + (numSegments - 1) * 3 + 3, x - outer_radius, y - outer_radius, x + outer_radius, y + outer_radius);
 
 		use_inner = GPU_FALSE;  // Switches between the radii for the next point
 
@@ -687,7 +728,7 @@ static void SectorFilled(GPU_Renderer* renderer, GPU_Target* target, float x, fl
 
 static void Tri(GPU_Renderer* renderer, GPU_Target* target, float x1, float y1, float x2, float y2, float x3, float y3, SDL_Color color)
 {
-    BEGIN_UNTEXTURED("GPU_Tri", GL_LINES, 3, 6);
+    BEGIN_UNTEXTURED("GPU_Tri", GL_LINES, 3, 6, MIN(x1, MIN(x2, x3)), MIN(y1, MIN(y2, y3)), MAX(x1, MAX(x2, x3)), MAX(y1, MAX(y2, y3)));
     
     SET_UNTEXTURED_VERTEX(x1, y1, r, g, b, a);
     SET_UNTEXTURED_VERTEX(x2, y2, r, g, b, a);
@@ -701,7 +742,7 @@ static void Tri(GPU_Renderer* renderer, GPU_Target* target, float x1, float y1,
 
 static void TriFilled(GPU_Renderer* renderer, GPU_Target* target, float x1, float y1, float x2, float y2, float x3, float y3, SDL_Color color)
 {
-    BEGIN_UNTEXTURED("GPU_TriFilled", GL_TRIANGLES, 3, 3);
+    BEGIN_UNTEXTURED("GPU_TriFilled", GL_TRIANGLES, 3, 3, MIN(x1, MIN(x2, x3)), MIN(y1, MIN(y2, y3)), MAX(x1, MAX(x2, x3)), MAX(y1, MAX(y2, y3)));
     
     SET_UNTEXTURED_VERTEX(x1, y1, r, g, b, a);
     SET_UNTEXTURED_VERTEX(x2, y2, r, g, b, a);
@@ -733,7 +774,7 @@ static void Rectangle(GPU_Renderer* renderer, GPU_Target* target, float x1, floa
 
 		// Thick lines via filled triangles
 
-		BEGIN_UNTEXTURED("GPU_Rectangle", GL_TRIANGLES, 12, 24);
+		BEGIN_UNTEXTURED("GPU_Rectangle", GL_TRIANGLES, 12, 24, x1 - outer, y1 - outer, x2 + outer, y2 + outer);
 		
 		// Adjust inner thickness offsets to avoid overdraw on narrow/small rects
 		if(x1 + inner_x > x2 - inner_x)
@@ -778,7 +819,7 @@ static void Rectangle(GPU_Renderer* renderer, GPU_Target* target, float x1, floa
 
 static void RectangleFilled(GPU_Renderer* renderer, GPU_Target* target, float x1, float y1, float x2, float y2, SDL_Color color)
 {
-    BEGIN_UNTEXTURED("GPU_RectangleFilled", GL_TRIANGLES, 4, 6);
+    BEGIN_UNTEXTURED("GPU_RectangleFilled", GL_TRIANGLES, 4, 6, MIN(x1, x2), MIN(y1, y2), MAX(x1, x2), MAX(y1, y2));
 
     SET_UNTEXTURED_VERTEX(x1, y1, r, g, b, a);
     SET_UNTEXTURED_VERTEX(x1, y2, r, g, b, a);
@@ -847,7 +888,7 @@ static void RectangleRound(GPU_Renderer* renderer, GPU_Target* target, float x1,
             float s = sinf(dt);
             
             // Add another 4 for the extra corner vertices
-            BEGIN_UNTEXTURED("GPU_RectangleRound", GL_TRIANGLES, 2*(numSegments + 4), 6*(numSegments + 4));
+            BEGIN_UNTEXTURED("GPU_RectangleRound", GL_TRIANGLES, 2*(numSegments + 4), 6*(numSegments + 4), x1 - outer_radius, y1 - outer_radius, x2 + outer_radius, y2 + outer_radius);
             
             if(inner_radius < 0.0f)
                 inner_radius = 0.0f;
@@ -938,7 +979,7 @@ static void RectangleRoundFilled(GPU_Renderer* renderer, GPU_Target* target, flo
 		int last_index = 2;
 		int i;
 
-		BEGIN_UNTEXTURED("GPU_RectangleRoundFilled", GL_TRIANGLES, 6 + 4 * (verts_per_corner - 1) - 1, 15 + 4 * (verts_per_corner - 1) * 3 - 3);
+		BEGIN_UNTEXTURED("GPU_RectangleRoundFilled", GL_TRIANGLES, 6 + 4 * (verts_per_corner - 1) - 1, 15 + 4 * (verts_per_corner - 1) * 3 - 3, x1, y1, x2, y2);
 
 
 		// First triangle
@@ -1005,8 +1046,9 @@ static void Polygon(GPU_Renderer* renderer, GPU_Target* target, unsigned int num
 		int numSegments = 2 * num_vertices;
 		int last_index = 0;
 		int i;
+		GPU_Rect bounds = getVertexBounds(target, num_vertices, vertices);
 
-		BEGIN_UNTEXTURED("GPU_Polygon", GL_LINES, num_vertices, numSegments);
+		BEGIN_UNTEXTURED("GPU_Polygon", GL_LINES, num_vertices, numSegments, bounds.x, bounds.y, bounds.x + bounds.w, bounds.y + bounds.h);
 
 		SET_UNTEXTURED_VERTEX(vertices[0], vertices[1], r, g, b, a);
 		for (i = 2; i < numSegments; i += 2)
@@ -1025,6 +1067,7 @@ static void Polyline(GPU_Renderer* renderer, GPU_Target* target, unsigned int nu
 	
 	float t = GetLineThickness(renderer) * 0.5f;
 	float x1, x2, y1, y2, line_angle, tc, ts;
+	GPU_Rect bounds = getVertexBounds(target, num_vertices, vertices);
 	
 	int num_v = num_vertices * 4;
 	int num_i = num_v + 2;
@@ -1037,7 +1080,7 @@ static void Polyline(GPU_Renderer* renderer, GPU_Target* target, unsigned int nu
 		last_vert--;
 	}
 	
-	BEGIN_UNTEXTURED("GPU_Polygon", GL_TRIANGLE_STRIP, num_v, num_i );
+	BEGIN_UNTEXTURED("GPU_Polygon", GL_TRIANGLE_STRIP, num_v, num_i, bounds.x - t, bounds.y - t, bounds.x + bounds.w + t, bounds.y + bounds.h + t);
 	
 	int i = 0;
 	do
@@ -1082,9 +1125,10 @@ static void PolygonFilled(GPU_Renderer* renderer, GPU_Target* target, unsigned i
 
 	{
 		int numSegments = 2 * num_vertices;
+		GPU_Rect bounds = getVertexBounds(target, num_vertices, vertices);
 
 		// Using a fan of triangles assumes that the polygon is convex
-		BEGIN_UNTEXTURED("GPU_PolygonFilled", GL_TRIANGLES, num_vertices, 3 + (num_vertices - 3) * 3);
+		BEGIN_UNTEXTURED("GPU_PolygonFilled", GL_TRIANGLES, num_vertices, 3 + (num_vertices - 3) * 3, bounds.x, bounds.y, bounds.x + bounds.w, bounds.y + bounds.h);
 
 		// First triangle
 		SET_UNTEXTURED_VERTEX(vertices[0], vertices[1], r, g, b, a);
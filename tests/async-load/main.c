@@ -0,0 +1,141 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include <stdlib.h>
+
+#define NUM_FILES 9
+
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	screen = initialize_demo(argc, argv, 800, 600);
+	if(screen == NULL)
+		return -1;
+
+	{
+		// The last one doesn't exist, to show a failed load
+		const char* filenames[NUM_FILES] = {"data/big_test.png", "data/test3.png", "data/test2.png", "data/test.bmp", "data/npot1.png",
+			"data/small_test.png", "data/test_24bit.bmp", "data/test_gray.bmp", "data/missing.png"};
+		GPU_PendingImage* pending[NUM_FILES];
+		GPU_Image* images[NUM_FILES];
+		Uint32 budget;
+		int i;
+		Uint32 startTime;
+		Uint8 done;
+		SDL_Event event;
+
+		budget = 256*1024;
+
+		GPU_LogError("Space: Load again\n+/-: Change the upload budget per frame\n");
+
+		for(i = 0; i < NUM_FILES; i++)
+		{
+			pending[i] = NULL;
+			images[i] = NULL;
+		}
+
+		startTime = 0;
+		done = 0;
+		while(!done)
+		{
+			GPU_bool reload = (startTime == 0);
+
+			while(SDL_PollEvent(&event))
+			{
+				if(event.type == SDL_QUIT)
+					done = 1;
+				else if(event.type == SDL_KEYDOWN)
+				{
+					if(event.key.keysym.sym == SDLK_ESCAPE)
+						done = 1;
+					else if(event.key.keysym.sym == SDLK_SPACE)
+						reload = GPU_TRUE;
+					else if(event.key.keysym.sym == SDLK_EQUALS || event.key.keysym.sym == SDLK_PLUS)
+					{
+						budget *= 2;
+						GPU_LogError("Upload budget: %u bytes\n", budget);
+					}
+					else if(event.key.keysym.sym == SDLK_MINUS)
+					{
+						if(budget > 1024)
+							budget /= 2;
+						GPU_LogError("Upload budget: %u bytes\n", budget);
+					}
+				}
+			}
+
+			if(reload)
+			{
+				for(i = 0; i < NUM_FILES; i++)
+				{
+					GPU_FreePendingImage(pending[i]);
+					GPU_FreeImage(images[i]);
+					images[i] = NULL;
+					pending[i] = GPU_LoadImageAsync(filenames[i]);
+				}
+				startTime = SDL_GetTicks();
+			}
+
+			// Upload a little of the decoded data each frame instead of stalling on it
+			if(GPU_ProcessPendingUploads(budget, 0) > 0)
+			{
+				for(i = 0; i < NUM_FILES; i++)
+				{
+					if(pending[i] == NULL)
+						continue;
+
+					if(GPU_GetPendingImageStatus(pending[i]) == GPU_PENDING_DONE)
+					{
+						images[i] = GPU_GetPendingImage(pending[i]);
+						GPU_LogError("Loaded %s after %u ms\n", filenames[i], SDL_GetTicks() - startTime);
+						GPU_FreePendingImage(pending[i]);
+						pending[i] = NULL;
+					}
+				}
+			}
+			for(i = 0; i < NUM_FILES; i++)
+			{
+				if(pending[i] != NULL && GPU_GetPendingImageStatus(pending[i]) == GPU_PENDING_FAILED)
+				{
+					GPU_LogError("Failed to load %s\n", filenames[i]);
+					GPU_FreePendingImage(pending[i]);
+					pending[i] = NULL;
+				}
+			}
+
+			GPU_Clear(screen);
+
+			for(i = 0; i < NUM_FILES; i++)
+			{
+				float x = 20 + (i%3)*260;
+				float y = 20 + (i/3)*195;
+				if(images[i] != NULL)
+				{
+					GPU_Rect dest = {x, y, 240, 175};
+					GPU_BlitRect(images[i], NULL, screen, &dest);
+				}
+				else if(pending[i] != NULL)
+				{
+					// Still loading
+					float t = (SDL_GetTicks()%1000)/1000.0f;
+					GPU_RectangleFilled(screen, x, y + 80, x + 240*t, y + 95, GPU_MakeColor(100, 100, 255, 255));
+				}
+				GPU_Rectangle(screen, x, y, x + 240, y + 175, GPU_MakeColor(255, 255, 255, 255));
+			}
+
+			GPU_Flip(screen);
+		}
+
+		for(i = 0; i < NUM_FILES; i++)
+		{
+			GPU_FreePendingImage(pending[i]);
+			GPU_FreeImage(images[i]);
+		}
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
@@ -0,0 +1,147 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include <stdlib.h>
+
+#define NUM_FRAMES 300
+#define NUM_SPRITES 10000
+
+
+// Runs the frames of a blit batch benchmark on the null renderer, so the CPU cost of a frame can be measured without a GPU.
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	// No window is needed, since nothing is drawn
+	screen = GPU_InitRenderer(GPU_RENDERER_NULL, 800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+	{
+		GPU_LogError("Failed to initialize the null renderer.\n");
+		return -1;
+	}
+
+	printCurrentRenderer();
+
+	{
+		GPU_Image* image;
+		GPU_FrameStats stats;
+		GPU_FrameStats total;
+		int floats_per_sprite;
+		float* sprite_values;
+		float* velx;
+		float* vely;
+		float dt;
+		Uint32 startTime;
+		int frame;
+		int i, j;
+		int val_n;
+		int return_value;
+
+		// The null renderer keeps a copy of the pixels, so this works like it does anywhere else
+		image = GPU_LoadImage("data/small_test.png");
+		if(image == NULL)
+			return -1;
+
+		return_value = 0;
+
+		dt = 0.010f;
+
+		floats_per_sprite = 2 + 4 + 4;
+		sprite_values = (float*)malloc(sizeof(float)*NUM_SPRITES*floats_per_sprite);
+		velx = (float*)malloc(sizeof(float)*NUM_SPRITES);
+		vely = (float*)malloc(sizeof(float)*NUM_SPRITES);
+		val_n = 0;
+		for(i = 0; i < NUM_SPRITES; i++)
+		{
+			sprite_values[val_n++] = rand()%screen->w;
+			sprite_values[val_n++] = rand()%screen->h;
+			sprite_values[val_n++] = 0;
+			sprite_values[val_n++] = 0;
+			sprite_values[val_n++] = image->w;
+			sprite_values[val_n++] = image->h;
+			sprite_values[val_n++] = rand()%256;
+			sprite_values[val_n++] = rand()%256;
+			sprite_values[val_n++] = rand()%256;
+			sprite_values[val_n++] = rand()%256;
+			velx[i] = 10 + rand()%screen->w/10;
+			vely[i] = 10 + rand()%screen->h/10;
+			if(rand()%2)
+				velx[i] = -velx[i];
+			if(rand()%2)
+				vely[i] = -vely[i];
+		}
+
+		memset(&total, 0, sizeof(GPU_FrameStats));
+
+		GPU_EnableFrameStats(GPU_TRUE);
+		GPU_ResetFrameStats();
+
+		startTime = SDL_GetTicks();
+		for(frame = 0; frame < NUM_FRAMES; frame++)
+		{
+			for(i = 0; i < NUM_SPRITES; i++)
+			{
+				val_n = floats_per_sprite*i;
+				sprite_values[val_n] += velx[i]*dt;
+				sprite_values[val_n+1] += vely[i]*dt;
+				if(sprite_values[val_n] < 0 || sprite_values[val_n] > screen->w)
+					velx[i] = -velx[i];
+				if(sprite_values[val_n+1] < 0 || sprite_values[val_n+1] > screen->h)
+					vely[i] = -vely[i];
+			}
+
+			GPU_Clear(screen);
+
+			GPU_BlitBatch(image, screen, NUM_SPRITES, sprite_values, 0);
+
+			// Some shapes between blits, which split the batch
+			GPU_RectangleFilled(screen, 10, 10, 110, 60, GPU_MakeColor(255, 0, 0, 255));
+			GPU_Blit(image, NULL, screen, screen->w/2, screen->h/2);
+			GPU_CircleFilled(screen, 200, 200, 50, GPU_MakeColor(0, 255, 0, 255));
+
+			GPU_Flip(screen);
+
+			GPU_GetFrameStats(&stats);
+			GPU_ResetFrameStats();
+
+			// Nothing is counted if SDL_gpu was built with SDL_GPU_DISABLE_FRAME_STATS
+			if(stats.draw_calls > 0 && stats.vertices < NUM_SPRITES*4)
+			{
+				GPU_LogError("Frame %d: Expected at least %d vertices, but counted %u in %u draw calls.\n", frame, NUM_SPRITES*4, stats.vertices, stats.draw_calls);
+				return_value = -2;
+			}
+
+			total.draw_calls += stats.draw_calls;
+			total.vertices += stats.vertices;
+			total.bytes_uploaded += stats.bytes_uploaded;
+			total.texture_binds += stats.texture_binds;
+			total.program_switches += stats.program_switches;
+			total.target_switches += stats.target_switches;
+			for(j = 0; j < GPU_FLUSH_NUM_CAUSES; j++)
+				total.flushes[j] += stats.flushes[j];
+		}
+
+		GPU_Log("%d frames of %d sprites in %u ms\n", NUM_FRAMES, NUM_SPRITES, SDL_GetTicks() - startTime);
+		GPU_Log("Per frame:\n");
+		GPU_Log(" Draw calls: %.1f\n", total.draw_calls/(float)NUM_FRAMES);
+		GPU_Log(" Vertices: %.1f\n", total.vertices/(float)NUM_FRAMES);
+		GPU_Log(" Bytes uploaded: %.1f\n", total.bytes_uploaded/(float)NUM_FRAMES);
+		GPU_Log(" Texture binds: %.1f\n", total.texture_binds/(float)NUM_FRAMES);
+		GPU_Log(" Program switches: %.1f\n", total.program_switches/(float)NUM_FRAMES);
+		GPU_Log(" Target switches: %.1f\n", total.target_switches/(float)NUM_FRAMES);
+		for(j = 0; j < GPU_FLUSH_NUM_CAUSES; j++)
+			GPU_Log(" Flushes (cause %d): %.1f\n", j, total.flushes[j]/(float)NUM_FRAMES);
+
+		free(sprite_values);
+		free(velx);
+		free(vely);
+
+		GPU_FreeImage(image);
+
+		GPU_Quit();
+
+		return return_value;
+	}
+}
@@ -0,0 +1,112 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include <stdlib.h>
+#include <math.h>
+
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	screen = initialize_demo(argc, argv, 800, 600);
+	if(screen == NULL)
+		return -1;
+
+	{
+		GPU_Image* image;
+		GPU_Image* thumbnail;
+		GPU_Readback* readback;
+		GPU_Rect rect;
+		long frame;
+		long readback_frame;
+		Uint8 done;
+		SDL_Event event;
+
+		image = GPU_LoadImage("data/test3.png");
+		if(image == NULL)
+			return -1;
+
+		thumbnail = NULL;
+		readback = NULL;
+		readback_frame = 0;
+
+		// The middle of the screen
+		rect.x = screen->w/4;
+		rect.y = screen->h/4;
+		rect.w = screen->w/2;
+		rect.h = screen->h/2;
+
+		GPU_LogError("Reading back the middle of the screen once a second.\n");
+
+		frame = 0;
+		done = 0;
+		while(!done)
+		{
+			while(SDL_PollEvent(&event))
+			{
+				if(event.type == SDL_QUIT)
+					done = 1;
+				else if(event.type == SDL_KEYDOWN)
+				{
+					if(event.key.keysym.sym == SDLK_ESCAPE)
+						done = 1;
+				}
+			}
+
+			GPU_Clear(screen);
+
+			GPU_BlitRotate(image, NULL, screen, screen->w/2, screen->h/2, frame*0.5f);
+			GPU_CircleFilled(screen, screen->w/2 + 200*cos(frame*0.02f), screen->h/2 + 150*sin(frame*0.03f), 40, GPU_MakeColor(255, 100, 100, 255));
+
+			// Start a readback after drawing, then keep rendering while the GPU copies it
+			if(readback == NULL && frame%60 == 0)
+			{
+				readback = GPU_ReadPixelsAsync(screen, &rect);
+				readback_frame = frame;
+			}
+			else if(readback != NULL && GPU_IsReadbackReady(readback))
+			{
+				int bytes_per_row;
+				const unsigned char* pixels = GPU_MapReadback(readback, &bytes_per_row);
+				if(pixels != NULL)
+				{
+					const unsigned char* center = pixels + (readback->h/2)*bytes_per_row + (readback->w/2)*4;
+					GPU_LogError("Readback ready after %ld frames.  Center pixel: (%d, %d, %d, %d)\n", frame - readback_frame, center[0], center[1], center[2], center[3]);
+				}
+
+				{
+					SDL_Surface* surface = GPU_CopySurfaceFromReadback(readback);
+					if(surface != NULL)
+					{
+						GPU_FreeImage(thumbnail);
+						thumbnail = GPU_CopyImageFromSurface(surface);
+						SDL_FreeSurface(surface);
+					}
+				}
+
+				GPU_FreeReadback(readback);
+				readback = NULL;
+			}
+
+			// The last readback, in the corner
+			if(thumbnail != NULL)
+			{
+				GPU_Rect dest = {10, 10, thumbnail->w/2, thumbnail->h/2};
+				GPU_BlitRect(thumbnail, NULL, screen, &dest);
+				GPU_Rectangle(screen, dest.x, dest.y, dest.x + dest.w, dest.y + dest.h, GPU_MakeColor(255, 255, 255, 255));
+			}
+
+			GPU_Flip(screen);
+			frame++;
+		}
+
+		GPU_FreeReadback(readback);
+		GPU_FreeImage(thumbnail);
+		GPU_FreeImage(image);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
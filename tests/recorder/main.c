@@ -0,0 +1,213 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include <stdlib.h>
+
+#define NUM_RECORDERS 4
+#define MAX_SPRITES 20000
+
+
+typedef struct Band
+{
+	GPU_Recorder* recorder;
+	GPU_Image* image;
+	float* x;
+	float* y;
+	float* velx;
+	float* vely;
+	int num_sprites;
+	float degrees;
+	int w, h;
+	int index;
+	SDL_Color color;
+} Band;
+
+// Moves one band of sprites and records them.  Touches no GPU state, so it can run on any thread.
+int record_band(void* data)
+{
+	Band* band = (Band*)data;
+	float dt = 0.010f;
+	int i;
+
+	GPU_ResetRecorder(band->recorder);
+
+	for(i = 0; i < band->num_sprites; i++)
+	{
+		band->x[i] += band->velx[i]*dt;
+		band->y[i] += band->vely[i]*dt;
+		if(band->x[i] < 0)
+		{
+			band->x[i] = 0;
+			band->velx[i] = -band->velx[i];
+		}
+		else if(band->x[i] > band->w)
+		{
+			band->x[i] = band->w;
+			band->velx[i] = -band->velx[i];
+		}
+
+		if(band->y[i] < 0)
+		{
+			band->y[i] = 0;
+			band->vely[i] = -band->vely[i];
+		}
+		else if(band->y[i] > band->h)
+		{
+			band->y[i] = band->h;
+			band->vely[i] = -band->vely[i];
+		}
+
+		if(i%2 == 0)
+			GPU_RecordBlit(band->recorder, band->image, NULL, band->x[i], band->y[i]);
+		else
+			GPU_RecordBlitTransformX(band->recorder, band->image, NULL, band->x[i], band->y[i], band->image->w/2, band->image->h/2, band->degrees, 0.5f, 0.5f);
+	}
+
+	// A marker for each recorder, which GPU_SubmitRecorders() draws in array order
+	GPU_RecordRectangleFilled(band->recorder, 10 + 30*band->index, 10, 30 + 30*band->index, 30, band->color);
+
+	band->degrees += 90*dt;
+	return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	screen = initialize_demo(argc, argv, 800, 600);
+	if(screen == NULL)
+		return -1;
+
+	{
+		GPU_Image* image;
+		Band bands[NUM_RECORDERS];
+		GPU_Recorder* recorders[NUM_RECORDERS];
+		int numSprites;
+		int i, j;
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+		image = GPU_LoadImage("data/small_test.png");
+		if(image == NULL)
+			return -1;
+
+		numSprites = 1000;
+
+		for(i = 0; i < NUM_RECORDERS; i++)
+		{
+			bands[i].recorder = recorders[i] = GPU_CreateRecorder();
+			bands[i].image = image;
+			bands[i].x = (float*)malloc(sizeof(float)*MAX_SPRITES);
+			bands[i].y = (float*)malloc(sizeof(float)*MAX_SPRITES);
+			bands[i].velx = (float*)malloc(sizeof(float)*MAX_SPRITES);
+			bands[i].vely = (float*)malloc(sizeof(float)*MAX_SPRITES);
+			bands[i].num_sprites = numSprites/NUM_RECORDERS;
+			bands[i].degrees = 0;
+			bands[i].w = screen->w;
+			bands[i].h = screen->h;
+			bands[i].index = i;
+			bands[i].color = GPU_MakeColor(255*(i%2), 255*(i/2%2), 255, 255);
+			for(j = 0; j < MAX_SPRITES; j++)
+			{
+				bands[i].x[j] = rand()%screen->w;
+				bands[i].y[j] = rand()%screen->h;
+				bands[i].velx[j] = 10 + rand()%screen->w/10;
+				bands[i].vely[j] = 10 + rand()%screen->h/10;
+				if(rand()%2)
+					bands[i].velx[j] = -bands[i].velx[j];
+				if(rand()%2)
+					bands[i].vely[j] = -bands[i].vely[j];
+			}
+		}
+
+		startTime = SDL_GetTicks();
+		frameCount = 0;
+
+		done = 0;
+		while(!done)
+		{
+			while(SDL_PollEvent(&event))
+			{
+				if(event.type == SDL_QUIT)
+					done = 1;
+				else if(event.type == SDL_KEYDOWN)
+				{
+					if(event.key.keysym.sym == SDLK_ESCAPE)
+						done = 1;
+					else if(event.key.keysym.sym == SDLK_EQUALS || event.key.keysym.sym == SDLK_PLUS)
+					{
+						if(numSprites < NUM_RECORDERS*MAX_SPRITES)
+							numSprites += 1000;
+						GPU_LogError("Sprites: %d\n", numSprites);
+						frameCount = 0;
+						startTime = SDL_GetTicks();
+					}
+					else if(event.key.keysym.sym == SDLK_MINUS)
+					{
+						if(numSprites > 1000)
+							numSprites -= 1000;
+						GPU_LogError("Sprites: %d\n", numSprites);
+						frameCount = 0;
+						startTime = SDL_GetTicks();
+					}
+				}
+			}
+
+			for(i = 0; i < NUM_RECORDERS; i++)
+				bands[i].num_sprites = numSprites/NUM_RECORDERS;
+
+			// Record every band at once, then draw them all from this thread
+			#ifdef SDL_GPU_USE_SDL2
+			{
+				SDL_Thread* threads[NUM_RECORDERS];
+				for(i = 0; i < NUM_RECORDERS; i++)
+					threads[i] = SDL_CreateThread(&record_band, "record_band", &bands[i]);
+				for(i = 0; i < NUM_RECORDERS; i++)
+				{
+					if(threads[i] != NULL)
+						SDL_WaitThread(threads[i], NULL);
+					else
+						record_band(&bands[i]);
+				}
+			}
+			#else
+			for(i = 0; i < NUM_RECORDERS; i++)
+				record_band(&bands[i]);
+			#endif
+
+			GPU_Clear(screen);
+
+			GPU_SubmitRecorders(screen, recorders, NUM_RECORDERS);
+
+			GPU_Flip(screen);
+
+			frameCount++;
+			if(SDL_GetTicks() - startTime > 5000)
+			{
+				printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+				frameCount = 0;
+				startTime = SDL_GetTicks();
+			}
+		}
+
+		printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+		for(i = 0; i < NUM_RECORDERS; i++)
+		{
+			GPU_FreeRecorder(bands[i].recorder);
+			free(bands[i].x);
+			free(bands[i].y);
+			free(bands[i].velx);
+			free(bands[i].vely);
+		}
+
+		GPU_FreeImage(image);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
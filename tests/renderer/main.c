@@ -556,6 +556,11 @@ static void UpdateImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU
     GPU_Log(" %s (dummy)\n", __func__);
 }
 
+static void UpdateImageBytesAsync(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
 static GPU_bool ReplaceImage(GPU_Renderer* renderer, GPU_Image* image, SDL_Surface* surface, const GPU_Rect* surface_rect)
 {
     GPU_Log(" %s (dummy)\n", __func__);
@@ -609,6 +614,29 @@ static SDL_Surface* CopySurfaceFromImage(GPU_Renderer* renderer, GPU_Image* imag
     return SDL_CreateRGBSurface(SDL_SWSURFACE, image->texture_w, image->texture_h, 32, 0, 0, 0, 0);
 }
 
+static GPU_Readback* ReadPixelsAsync(GPU_Renderer* renderer, GPU_Target* target, const GPU_Rect* rect)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+    return NULL;
+}
+
+static GPU_bool IsReadbackReady(GPU_Renderer* renderer, GPU_Readback* readback)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+    return GPU_TRUE;
+}
+
+static const unsigned char* MapReadback(GPU_Renderer* renderer, GPU_Readback* readback, int* bytes_per_row)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+    return NULL;
+}
+
+static void FreeReadback(GPU_Renderer* renderer, GPU_Readback* readback)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
 
 static void FreeImage(GPU_Renderer* renderer, GPU_Image* image)
 {
@@ -763,11 +791,53 @@ static void BlitTransformX(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* s
 }
 
 
+static void BlitBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* values, GPU_BlitFlagEnum flags)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
+static void BlitBatchSeparate(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* positions, float* src_rects, float* colors, GPU_BlitFlagEnum flags)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
+static void BlitTransformBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* x, float* y, float* degrees, float* scale_x, float* scale_y, unsigned int num_src_rects, GPU_Rect* src_rects, Uint16* src_rect_indices, SDL_Color* colors)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
+
 static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned short num_vertices, void* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags)
 {
     GPU_Log(" %s (dummy)\n", __func__);
 }
 
+static void PrimitiveBatchV32(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned int num_vertices, void* values, unsigned int num_indices, unsigned int* indices, GPU_BatchFlagEnum flags)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
+static GPU_VertexBuffer* CreateVertexBuffer(GPU_Renderer* renderer, GPU_BatchFlagEnum flags, unsigned int num_vertices, void* values, unsigned int num_indices, unsigned int* indices)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+    return NULL;
+}
+
+static void UpdateVertexBuffer(GPU_Renderer* renderer, GPU_VertexBuffer* buffer, unsigned int first_vertex, unsigned int num_vertices, void* values)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
+static void DrawVertexBuffer(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_VertexBuffer* buffer, GPU_PrimitiveEnum primitive_type, unsigned int first, unsigned int count)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
+static void FreeVertexBuffer(GPU_Renderer* renderer, GPU_VertexBuffer* buffer)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
 
 static void GenerateMipmaps(GPU_Renderer* renderer, GPU_Image* image)
 {
@@ -815,6 +885,11 @@ static SDL_Color GetPixel(GPU_Renderer* renderer, GPU_Target* target, Sint16 x,
     return GPU_MakeColor(0, 0, 0, 0);
 }
 
+static void GetPixels(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_points, const Sint16* points, SDL_Color* colors)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
 
 static void SetImageFilter(GPU_Renderer* renderer, GPU_Image* image, GPU_FilterEnum filter)
 {
@@ -848,11 +923,87 @@ static void FlushBlitBuffer(GPU_Renderer* renderer)
     GPU_Log(" %s (dummy)\n", __func__);
 }
 
+static void BeginSortedBatch(GPU_Renderer* renderer, GPU_Target* target)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
+static void EndSortedBatch(GPU_Renderer* renderer)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
+static void SetSortedBatchLayer(GPU_Renderer* renderer, int layer)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
+static void BeginCommandList(GPU_Renderer* renderer, GPU_Target* target)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
+static GPU_CommandList* EndCommandList(GPU_Renderer* renderer)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+    return NULL;
+}
+
+static void ExecuteCommandList(GPU_Renderer* renderer, GPU_CommandList* list, GPU_Target* target, const float* transform)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
+static void FreeCommandList(GPU_Renderer* renderer, GPU_CommandList* list)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
+static GPU_bool SetBufferUploadMethod(GPU_Renderer* renderer, GPU_BufferUploadEnum method)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+    return GPU_FALSE;
+}
+
+static GPU_BufferUploadEnum GetBufferUploadMethod(GPU_Renderer* renderer)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+    return GPU_BUFFER_UPLOAD_NONE;
+}
+
+static GPU_BufferUploadEnum CalibrateBufferUpload(GPU_Renderer* renderer)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+    return GPU_BUFFER_UPLOAD_NONE;
+}
+
 static void Flip(GPU_Renderer* renderer, GPU_Target* target)
 {
     GPU_Log(" %s (dummy)\n", __func__);
 }
 
+static GPU_bool EnableGPUTiming(GPU_Renderer* renderer, GPU_bool enable)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+    return GPU_FALSE;
+}
+
+static void BeginGPUScope(GPU_Renderer* renderer, const char* name)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
+static void EndGPUScope(GPU_Renderer* renderer)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+}
+
+static float GetGPUTime(GPU_Renderer* renderer, const char* scope_name, GPU_Target* target)
+{
+    GPU_Log(" %s (dummy)\n", __func__);
+    return -1.0f;
+}
+
 static Uint32 CreateShaderProgram(GPU_Renderer* renderer)
 {
     GPU_Log(" %s (dummy)\n", __func__);
@@ -1229,11 +1380,16 @@ void set_renderer_functions(GPU_RendererImpl* impl)
     impl->CopyImage = &CopyImage;
     impl->UpdateImage = &UpdateImage;
     impl->UpdateImageBytes = &UpdateImageBytes;
+    impl->UpdateImageBytesAsync = &UpdateImageBytesAsync;
     impl->ReplaceImage = &ReplaceImage;
     impl->CopyImageFromSurface = &CopyImageFromSurface;
     impl->CopyImageFromTarget = &CopyImageFromTarget;
     impl->CopySurfaceFromTarget = &CopySurfaceFromTarget;
     impl->CopySurfaceFromImage = &CopySurfaceFromImage;
+    impl->ReadPixelsAsync = &ReadPixelsAsync;
+    impl->IsReadbackReady = &IsReadbackReady;
+    impl->MapReadback = &MapReadback;
+    impl->FreeReadback = &FreeReadback;
     impl->FreeImage = &FreeImage;
 
     impl->GetTarget = &GetTarget;
@@ -1244,7 +1400,15 @@ void set_renderer_functions(GPU_RendererImpl* impl)
     impl->BlitScale = &BlitScale;
     impl->BlitTransform = &BlitTransform;
     impl->BlitTransformX = &BlitTransformX;
+    impl->BlitBatch = &BlitBatch;
+    impl->BlitBatchSeparate = &BlitBatchSeparate;
+    impl->BlitTransformBatch = &BlitTransformBatch;
     impl->PrimitiveBatchV = &PrimitiveBatchV;
+    impl->PrimitiveBatchV32 = &PrimitiveBatchV32;
+    impl->CreateVertexBuffer = &CreateVertexBuffer;
+    impl->UpdateVertexBuffer = &UpdateVertexBuffer;
+    impl->DrawVertexBuffer = &DrawVertexBuffer;
+    impl->FreeVertexBuffer = &FreeVertexBuffer;
 
     impl->GenerateMipmaps = &GenerateMipmaps;
 
@@ -1252,13 +1416,28 @@ void set_renderer_functions(GPU_RendererImpl* impl)
     impl->UnsetClip = &UnsetClip;
     
     impl->GetPixel = &GetPixel;
+    impl->GetPixels = &GetPixels;
     impl->SetImageFilter = &SetImageFilter;
     impl->SetWrapMode = &SetWrapMode;
     impl->GetTextureHandle = &GetTextureHandle;
 
     impl->ClearRGBA = &ClearRGBA;
     impl->FlushBlitBuffer = &FlushBlitBuffer;
+    impl->BeginSortedBatch = &BeginSortedBatch;
+    impl->EndSortedBatch = &EndSortedBatch;
+    impl->SetSortedBatchLayer = &SetSortedBatchLayer;
+    impl->BeginCommandList = &BeginCommandList;
+    impl->EndCommandList = &EndCommandList;
+    impl->ExecuteCommandList = &ExecuteCommandList;
+    impl->FreeCommandList = &FreeCommandList;
+    impl->SetBufferUploadMethod = &SetBufferUploadMethod;
+    impl->GetBufferUploadMethod = &GetBufferUploadMethod;
+    impl->CalibrateBufferUpload = &CalibrateBufferUpload;
     impl->Flip = &Flip;
+    impl->EnableGPUTiming = &EnableGPUTiming;
+    impl->BeginGPUScope = &BeginGPUScope;
+    impl->EndGPUScope = &EndGPUScope;
+    impl->GetGPUTime = &GetGPUTime;
     
     impl->CreateShaderProgram = &CreateShaderProgram;
     impl->FreeShaderProgram = &FreeShaderProgram;
@@ -0,0 +1,172 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include <stdlib.h>
+
+#define TILE_SIZE 16
+#define MAP_COLUMNS 200
+#define MAP_ROWS 150
+
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	screen = initialize_demo(argc, argv, 800, 600);
+	if(screen == NULL)
+		return -1;
+
+	{
+		GPU_Image* tileset;
+		GPU_Tilemap* tilemap;
+		int num_tiles;
+		int* tiles;
+		int i;
+		float x, y;
+		float velx, vely;
+		int changes_per_frame;
+		float dt;
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+		tileset = GPU_LoadImage("data/test3.png");
+		if(tileset == NULL)
+			return -1;
+
+		num_tiles = (tileset->w/TILE_SIZE)*(tileset->h/TILE_SIZE);
+
+		tilemap = GPU_CreateTilemap(tileset, TILE_SIZE, TILE_SIZE, MAP_COLUMNS, MAP_ROWS);
+		if(tilemap == NULL)
+		{
+			GPU_FreeImage(tileset);
+			return -2;
+		}
+
+		// Fill the whole grid at once, leaving some cells empty
+		tiles = (int*)malloc(sizeof(int)*MAP_COLUMNS*MAP_ROWS);
+		for(i = 0; i < MAP_COLUMNS*MAP_ROWS; i++)
+			tiles[i] = (rand()%8 == 0? -1 : rand()%num_tiles);
+		GPU_SetTiles(tilemap, tiles);
+		free(tiles);
+
+		// A border, one tile at a time
+		for(i = 0; i < MAP_COLUMNS; i++)
+		{
+			GPU_SetTile(tilemap, i, 0, 0);
+			GPU_SetTile(tilemap, i, MAP_ROWS-1, 0);
+		}
+		for(i = 0; i < MAP_ROWS; i++)
+		{
+			GPU_SetTile(tilemap, 0, i, 0);
+			GPU_SetTile(tilemap, MAP_COLUMNS-1, i, 0);
+		}
+		if(GPU_GetTile(tilemap, MAP_COLUMNS-1, MAP_ROWS-1) != 0 || GPU_GetTile(tilemap, MAP_COLUMNS, 0) != -1)
+			GPU_LogError("GPU_GetTile() returned the wrong tile.\n");
+
+		x = 0;
+		y = 0;
+		velx = 120;
+		vely = 90;
+		changes_per_frame = 10;
+
+		dt = 0.010f;
+
+		startTime = SDL_GetTicks();
+		frameCount = 0;
+
+		GPU_LogError("Arrow keys: Scroll\n+/-: Change tiles per frame (rebuilds their chunks)\n");
+
+		done = 0;
+		while(!done)
+		{
+			while(SDL_PollEvent(&event))
+			{
+				if(event.type == SDL_QUIT)
+					done = 1;
+				else if(event.type == SDL_KEYDOWN)
+				{
+					if(event.key.keysym.sym == SDLK_ESCAPE)
+						done = 1;
+					else if(event.key.keysym.sym == SDLK_LEFT)
+						velx = 120;
+					else if(event.key.keysym.sym == SDLK_RIGHT)
+						velx = -120;
+					else if(event.key.keysym.sym == SDLK_UP)
+						vely = 90;
+					else if(event.key.keysym.sym == SDLK_DOWN)
+						vely = -90;
+					else if(event.key.keysym.sym == SDLK_EQUALS || event.key.keysym.sym == SDLK_PLUS)
+					{
+						changes_per_frame += 10;
+						GPU_LogError("Tile changes per frame: %d\n", changes_per_frame);
+					}
+					else if(event.key.keysym.sym == SDLK_MINUS)
+					{
+						if(changes_per_frame > 0)
+							changes_per_frame -= 10;
+						GPU_LogError("Tile changes per frame: %d\n", changes_per_frame);
+					}
+				}
+			}
+
+			// Scroll back and forth across the map, which is bigger than the screen
+			x += velx*dt;
+			y += vely*dt;
+			if(x > 0)
+			{
+				x = 0;
+				velx = -velx;
+			}
+			else if(x < screen->w - MAP_COLUMNS*TILE_SIZE)
+			{
+				x = screen->w - MAP_COLUMNS*TILE_SIZE;
+				velx = -velx;
+			}
+			if(y > 0)
+			{
+				y = 0;
+				vely = -vely;
+			}
+			else if(y < screen->h - MAP_ROWS*TILE_SIZE)
+			{
+				y = screen->h - MAP_ROWS*TILE_SIZE;
+				vely = -vely;
+			}
+
+			// Each change marks its chunk for a rebuild on the next draw
+			for(i = 0; i < changes_per_frame; i++)
+				GPU_SetTile(tilemap, 1 + rand()%(MAP_COLUMNS-2), 1 + rand()%(MAP_ROWS-2), rand()%num_tiles);
+
+			GPU_Clear(screen);
+
+			GPU_DrawTilemap(tilemap, screen, x, y);
+
+			// A second copy through a clipped window, scrolling slower
+			GPU_SetClip(screen, 10, 10, 200, 150);
+			GPU_DrawTilemap(tilemap, screen, 10 + x/4, 10 + y/4);
+			GPU_UnsetClip(screen);
+			GPU_Rectangle(screen, 10, 10, 210, 160, GPU_MakeColor(255, 255, 255, 255));
+
+			GPU_Flip(screen);
+
+			frameCount++;
+			if(SDL_GetTicks() - startTime > 5000)
+			{
+				printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+				frameCount = 0;
+				startTime = SDL_GetTicks();
+			}
+		}
+
+		printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+		GPU_FreeTilemap(tilemap);
+		GPU_FreeImage(tileset);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}